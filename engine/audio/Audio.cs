@@ -1 +1,588 @@
-// Audio system placeholder
+/*
+ * PyFlare Engine - Audio System
+ * Managed front end for the native mixer thread: clips decoded whole, music streamed through
+ * decode jobs, and voices driven through the mixer's lock-free command queue
+ */
+
+using System;
+using System.Buffers.Binary;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+using PyFlare.Engine.Core;
+using PyFlare.Engine.Platform;
+
+namespace PyFlare.Engine.Audio
+{
+    /// <summary>
+    /// Handle to one playing sound. Stays safe to use after the voice ends: the mixer ignores
+    /// commands for voices it no longer has. Main thread only, like the rest of the mixer API.
+    /// </summary>
+    public readonly struct Voice
+    {
+        public readonly uint Id;
+
+        internal Voice(uint id) { Id = id; }
+
+        public bool IsValid => Id != 0;
+
+        /// <summary>True from Play until the voice finishes, is stopped or was rejected</summary>
+        public unsafe bool IsPlaying => Id != 0 && NativeCalls.AudioVoiceActive(Id) != 0;
+
+        public void Stop(float fadeSeconds = 0.0f) =>
+            AudioMixer.Send(new AudioCommand { type = AudioCommandType.Stop, voice = Id, fade = fadeSeconds });
+
+        public void SetVolume(float volume) =>
+            AudioMixer.Send(new AudioCommand { type = AudioCommandType.Volume, voice = Id, volume = volume });
+
+        /// <summary>-1 left .. 1 right, equal power</summary>
+        public void SetPan(float pan) =>
+            AudioMixer.Send(new AudioCommand { type = AudioCommandType.Pan, voice = Id, pan = pan });
+
+        /// <summary>Playback rate multiplier, 1/16 to 16</summary>
+        public void SetPitch(float pitch) =>
+            AudioMixer.Send(new AudioCommand { type = AudioCommandType.Pitch, voice = Id, pitch = pitch });
+
+        public void Pause() =>
+            AudioMixer.Send(new AudioCommand { type = AudioCommandType.Pause, voice = Id, flags = (AudioPlayFlags)1 });
+
+        public void Resume() =>
+            AudioMixer.Send(new AudioCommand { type = AudioCommandType.Pause, voice = Id });
+    }
+
+    /// <summary>
+    /// The native mixer. Commands go through a single-producer queue, so every call here (and
+    /// on Voice, Sound.Play and Music.Play) belongs on the main thread. Update must run once
+    /// per frame: it refills music streams and frees released sounds.
+    /// </summary>
+    public static unsafe class AudioMixer
+    {
+        private static bool initialized;
+        private static AudioBackend backend;
+        private static uint nextVoice;
+        private static float masterVolume = 1.0f;
+        private static readonly List<MusicStream> streams = new List<MusicStream>();
+        // Releases that found the command queue full; sounds positive, streams negated
+        private static readonly List<int> pendingReleases = new List<int>();
+
+        /// <summary>
+        /// Opens the default device (WASAPI, ALSA or CoreAudio) and starts the mixer thread.
+        /// latencyMs is how far the mixer renders ahead (0 = 20 ms). nullDevice runs without
+        /// hardware, for headless tools; it is also the fallback when no device opens.
+        /// </summary>
+        public static bool Initialize(int latencyMs = 0, bool nullDevice = false)
+        {
+            if (initialized) return true;
+
+            backend = (AudioBackend)NativePlatform.native_audio_init(latencyMs, nullDevice ? 1 : 0);
+            if (backend == AudioBackend.None)
+            {
+                Console.WriteLine("Failed to initialize audio");
+                return false;
+            }
+
+            initialized = true;
+            AudioStats stats = GetStats();
+            Console.WriteLine($"Audio: {backend}, {stats.sampleRate} Hz, {stats.latencyFrames * 1000.0 / stats.sampleRate:F1} ms ahead");
+            return true;
+        }
+
+        /// <summary>Stops every voice and frees all native sounds; Sound handles become invalid</summary>
+        public static void Shutdown()
+        {
+            if (!initialized) return;
+
+            foreach (MusicStream stream in streams)
+                stream.Close();
+            streams.Clear();
+            pendingReleases.Clear();
+
+            NativePlatform.native_audio_shutdown();
+            initialized = false;
+            backend = AudioBackend.None;
+        }
+
+        public static void Update()
+        {
+            if (!initialized) return;
+
+            for (int i = pendingReleases.Count - 1; i >= 0; i--)
+            {
+                int handle = pendingReleases[i];
+                int done = handle > 0
+                    ? NativePlatform.native_audio_sound_release(handle)
+                    : NativePlatform.native_audio_stream_release(-handle);
+                if (done != 0) pendingReleases.RemoveAt(i);
+            }
+
+            for (int i = streams.Count - 1; i >= 0; i--)
+            {
+                if (!streams[i].Pump())
+                    streams.RemoveAt(i);
+            }
+
+            NativePlatform.native_audio_update();
+        }
+
+        public static bool IsInitialized => initialized;
+        public static AudioBackend Backend => backend;
+
+        public static float MasterVolume
+        {
+            get => masterVolume;
+            set
+            {
+                masterVolume = value;
+                Send(new AudioCommand { type = AudioCommandType.MasterVolume, volume = value });
+            }
+        }
+
+        public static void StopAll(float fadeSeconds = 0.0f) =>
+            Send(new AudioCommand { type = AudioCommandType.StopAll, fade = fadeSeconds });
+
+        /// <summary>An invalid Voice if the sound isn't loaded or the command queue is full</summary>
+        public static Voice Play(Sound sound, float volume = 1.0f, float pan = 0.0f, float pitch = 1.0f, bool loop = false)
+        {
+            if (sound == null || sound.Handle == 0) return default;
+            return Start(sound.Handle, loop ? AudioPlayFlags.Loop : AudioPlayFlags.None, volume, pan, pitch);
+        }
+
+        internal static Voice Start(int source, AudioPlayFlags flags, float volume, float pan, float pitch)
+        {
+            if (++nextVoice == 0) nextVoice = 1;
+            var command = new AudioCommand
+            {
+                type = AudioCommandType.Play,
+                voice = nextVoice,
+                source = source,
+                flags = flags,
+                volume = volume,
+                pan = pan,
+                pitch = pitch
+            };
+            return Send(command) ? new Voice(nextVoice) : default;
+        }
+
+        internal static bool Send(AudioCommand command)
+        {
+            if (!initialized) return false;
+            return NativeCalls.AudioPush(&command) == 1;
+        }
+
+        internal static void AddStream(MusicStream stream) => streams.Add(stream);
+
+        internal static void ReleaseSound(int handle)
+        {
+            if (NativePlatform.native_audio_sound_release(handle) == 0)
+                pendingReleases.Add(handle);
+        }
+
+        internal static void ReleaseStream(int handle)
+        {
+            if (NativePlatform.native_audio_stream_release(handle) == 0)
+                pendingReleases.Add(-handle);
+        }
+
+        public static AudioStats GetStats()
+        {
+            NativePlatform.native_audio_get_stats(out AudioStats stats);
+            return stats;
+        }
+
+        public static void PrintStats()
+        {
+            AudioStats stats = GetStats();
+            Console.WriteLine("=== Audio ===");
+            Console.WriteLine($"Backend: {stats.backend}, {stats.sampleRate} Hz, {stats.latencyFrames} frames ahead");
+            Console.WriteLine($"Voices: {stats.activeVoices} active, {stats.voicesRejected} rejected");
+            Console.WriteLine($"Mix: {stats.mixAvgUs:F1} us avg, {stats.mixPeakUs:F1} us peak per block");
+            Console.WriteLine($"Underruns: {stats.underruns}, stream starvation: {stats.streamStarved} frames");
+            Console.WriteLine($"Commands: {stats.commands} ({stats.commandsDropped} dropped)");
+            Console.WriteLine("=============");
+        }
+    }
+
+    /// <summary>
+    /// A clip decoded whole and handed to the mixer, which keeps its own copy. Loads through
+    /// ResourceLoader like any resource, so decoding runs off the main thread. WAV only.
+    /// </summary>
+    public class Sound : Resource
+    {
+        private float[] samples;
+        private int frames;
+        private int channels;
+        private int sampleRate;
+        private int soundHandle;
+
+        public int Handle => soundHandle;
+        public int Channels => channels;
+        public int SampleRate => sampleRate;
+        public double Duration => sampleRate > 0 ? (double)frames / sampleRate : 0.0;
+
+        public override void LoadData(string path, CancellationToken token)
+        {
+            base.LoadData(path, token);
+
+            using Stream stream = ResourceLoader.OpenStream(path)
+                ?? throw new FileNotFoundException($"Sound not found: {path}");
+            var decoder = new WavDecoder(stream, path);
+            channels = decoder.Channels;
+            sampleRate = decoder.SampleRate;
+            samples = GC.AllocateUninitializedArray<float>(checked((int)(decoder.FrameCount * channels)));
+            frames = decoder.Read(samples, (int)decoder.FrameCount);
+            Interlocked.Exchange(ref memoryUsage, (long)frames * channels * sizeof(float));
+        }
+
+        public override unsafe void Upload()
+        {
+            fixed (float* ptr = samples)
+                soundHandle = NativePlatform.native_audio_sound_create(ptr, frames, channels, sampleRate);
+            if (soundHandle == 0)
+                throw new InvalidOperationException($"Failed to create sound: {resourcePath}");
+
+            samples = null;     // the mixer has its copy
+            base.Upload();
+        }
+
+        public override void Unload()
+        {
+            if (soundHandle != 0)
+            {
+                AudioMixer.ReleaseSound(soundHandle);
+                soundHandle = 0;
+            }
+            samples = null;
+            base.Unload();
+        }
+
+        /// <summary>Takes fresh's decoded samples; voices still playing the old clip stop</summary>
+        protected internal override void ApplyReload(Resource fresh)
+        {
+            var next = (Sound)fresh;
+            Unload();
+            samples = next.samples;
+            frames = next.frames;
+            channels = next.channels;
+            sampleRate = next.sampleRate;
+            next.samples = null;
+            Upload();
+            Interlocked.Exchange(ref memoryUsage, (long)frames * channels * sizeof(float));
+        }
+
+        public Voice Play(float volume = 1.0f, float pan = 0.0f, float pitch = 1.0f, bool loop = false) =>
+            AudioMixer.Play(this, volume, pan, pitch, loop);
+    }
+
+    /// <summary>
+    /// Music streamed from disk or an archive. Each Play gets its own decoder and native ring,
+    /// which a decode job refills whenever the mixer has drained half of it; nothing is decoded
+    /// on the main thread or the mixer thread.
+    /// </summary>
+    public sealed class Music
+    {
+        public readonly string Path;
+
+        public Music(string path)
+        {
+            Path = path;
+        }
+
+        /// <summary>An invalid Voice if the file can't be opened; the voice starts once the first decode lands</summary>
+        public Voice Play(float volume = 1.0f, bool loop = true)
+        {
+            if (!AudioMixer.IsInitialized) return default;
+
+            Stream source = ResourceLoader.OpenStream(Path);
+            if (source == null)
+            {
+                Console.WriteLine($"Music not found: {Path}");
+                return default;
+            }
+
+            WavDecoder decoder;
+            try
+            {
+                decoder = new WavDecoder(source, Path);
+            }
+            catch (InvalidDataException e)
+            {
+                Console.WriteLine(e.Message);
+                source.Dispose();
+                return default;
+            }
+
+            var stream = MusicStream.Open(Path, source, decoder, loop);
+            if (stream == null) return default;
+
+            // Paused until the ring has data, so the mixer doesn't count the start as starvation
+            Voice voice = AudioMixer.Start(stream.handle, AudioPlayFlags.Stream | AudioPlayFlags.Paused, volume, 0.0f, 1.0f);
+            if (!voice.IsValid)
+            {
+                stream.Close();
+                return default;
+            }
+            stream.voice = voice;
+            AudioMixer.AddStream(stream);
+            return voice;
+        }
+    }
+
+    /// <summary>One playback of a Music: the decoder, its native ring and the job that fills it</summary>
+    internal sealed class MusicStream
+    {
+        private const double BufferSeconds = 1.0;
+        private const int ChunkFrames = 4096;
+
+        public readonly int handle;
+        public Voice voice;
+        private readonly string path;
+        private readonly Stream source;
+        private readonly WavDecoder decoder;
+        private readonly bool loop;
+        private readonly int capacity;
+        private readonly float[] chunk;     // decode job only
+        private int decoding;               // 1 while a decode job is queued or running
+        private volatile bool primed;       // the first decode has landed
+        private volatile bool finished;     // the decoder reached the end or failed
+        private bool started;
+
+        private MusicStream(int handle, string path, Stream source, WavDecoder decoder, bool loop)
+        {
+            this.handle = handle;
+            this.path = path;
+            this.source = source;
+            this.decoder = decoder;
+            this.loop = loop;
+            capacity = NativePlatform.native_audio_stream_space(handle);
+            chunk = new float[ChunkFrames * decoder.Channels];
+        }
+
+        public static MusicStream Open(string path, Stream source, WavDecoder decoder, bool loop)
+        {
+            int handle = NativePlatform.native_audio_stream_create(decoder.Channels, decoder.SampleRate,
+                (int)(decoder.SampleRate * BufferSeconds));
+            if (handle == 0)
+            {
+                source.Dispose();
+                return null;
+            }
+
+            var stream = new MusicStream(handle, path, source, decoder, loop);
+            stream.Refill();
+            return stream;
+        }
+
+        /// <summary>Main thread, from AudioMixer.Update. Returns false once released.</summary>
+        public bool Pump()
+        {
+            if (!started && primed)
+            {
+                started = true;
+                voice.Resume();
+            }
+
+            if (started && !voice.IsPlaying)
+            {
+                // Finished or stopped; the ring can go once no job writes to it
+                if (Volatile.Read(ref decoding) != 0) return true;
+                Release();
+                return false;
+            }
+
+            if (!finished && Volatile.Read(ref decoding) == 0 &&
+                NativePlatform.native_audio_stream_space(handle) >= capacity / 2)
+                Refill();
+            return true;
+        }
+
+        /// <summary>Stops at once; waits for the decode job so nothing writes to the freed ring</summary>
+        public void Close()
+        {
+            voice.Stop();
+            while (Volatile.Read(ref decoding) != 0)
+            {
+                if (!Jobs.TryRunOne())
+                    Thread.Yield();
+            }
+            Release();
+        }
+
+        private void Release()
+        {
+            AudioMixer.ReleaseStream(handle);
+            source.Dispose();
+        }
+
+        private void Refill()
+        {
+            Volatile.Write(ref decoding, 1);
+            Jobs.Run(Decode, null, JobPin.Background);
+        }
+
+        private unsafe void Decode()
+        {
+            try
+            {
+                while (true)
+                {
+                    int space = NativePlatform.native_audio_stream_space(handle);
+                    if (space < ChunkFrames) break;
+
+                    int got = decoder.Read(chunk, ChunkFrames);
+                    if (got > 0)
+                    {
+                        fixed (float* ptr = chunk)
+                            NativePlatform.native_audio_stream_write(handle, ptr, got);
+                    }
+                    if (got < ChunkFrames)
+                    {
+                        if (loop && decoder.FrameCount > 0)
+                        {
+                            decoder.Rewind();
+                            continue;
+                        }
+                        NativePlatform.native_audio_stream_end(handle);
+                        finished = true;
+                        break;
+                    }
+                }
+            }
+            catch (Exception e)
+            {
+                Console.WriteLine($"Music decode failed: {path}: {e.Message}");
+                NativePlatform.native_audio_stream_end(handle);
+                finished = true;
+            }
+            finally
+            {
+                primed = true;
+                Volatile.Write(ref decoding, 0);
+            }
+        }
+    }
+
+    /// <summary>
+    /// RIFF WAVE reader: integer PCM of 8, 16, 24 or 32 bits, or 32-bit float, mono or stereo,
+    /// converted to interleaved float as it reads. Needs a seekable stream.
+    /// </summary>
+    internal sealed class WavDecoder
+    {
+        public readonly int Channels;
+        public readonly int SampleRate;
+
+        private readonly Stream stream;
+        private readonly long dataStart;
+        private readonly long dataLength;
+        private readonly int bytesPerSample;
+        private readonly bool isFloat;
+        private long position;              // bytes into the data chunk
+        private byte[] scratch = Array.Empty<byte>();
+
+        private const ushort FormatPcm = 1;
+        private const ushort FormatFloat = 3;
+        private const ushort FormatExtensible = 0xFFFE;
+
+        public WavDecoder(Stream stream, string path)
+        {
+            this.stream = stream;
+            Span<byte> header = stackalloc byte[40];
+            if (stream.ReadAtLeast(header.Slice(0, 12), 12, false) < 12 ||
+                BinaryPrimitives.ReadUInt32LittleEndian(header) != 0x46464952 ||          // "RIFF"
+                BinaryPrimitives.ReadUInt32LittleEndian(header.Slice(8)) != 0x45564157)   // "WAVE"
+                throw new InvalidDataException($"Not a WAV file: {path}");
+
+            ushort format = 0;
+            int bits = 0;
+            while (stream.ReadAtLeast(header.Slice(0, 8), 8, false) == 8)
+            {
+                uint id = BinaryPrimitives.ReadUInt32LittleEndian(header);
+                long size = BinaryPrimitives.ReadUInt32LittleEndian(header.Slice(4));
+
+                if (id == 0x20746D66 && size >= 16)        // "fmt "
+                {
+                    int length = (int)Math.Min(size, header.Length);
+                    stream.ReadAtLeast(header.Slice(0, length), length, false);
+                    format = BinaryPrimitives.ReadUInt16LittleEndian(header);
+                    Channels = BinaryPrimitives.ReadUInt16LittleEndian(header.Slice(2));
+                    SampleRate = (int)BinaryPrimitives.ReadUInt32LittleEndian(header.Slice(4));
+                    bits = BinaryPrimitives.ReadUInt16LittleEndian(header.Slice(14));
+                    // WAVE_FORMAT_EXTENSIBLE: the real tag opens the SubFormat GUID
+                    if (format == FormatExtensible && length >= 26)
+                        format = BinaryPrimitives.ReadUInt16LittleEndian(header.Slice(24));
+                    stream.Seek(size - length + (size & 1), SeekOrigin.Current);
+                }
+                else if (id == 0x61746164 && format != 0)   // "data", after "fmt "
+                {
+                    dataStart = stream.Position;
+                    dataLength = Math.Min(size, stream.Length - dataStart);
+                    break;
+                }
+                else
+                {
+                    stream.Seek(size + (size & 1), SeekOrigin.Current);   // chunks are word aligned
+                }
+            }
+
+            isFloat = format == FormatFloat;
+            bytesPerSample = bits / 8;
+            bool supported = (format == FormatPcm && bits >= 8 && bits <= 32 && bits % 8 == 0) ||
+                             (format == FormatFloat && bits == 32);
+            if (!supported || Channels < 1 || Channels > 2 || SampleRate <= 0 || dataStart == 0)
+                throw new InvalidDataException($"Unsupported WAV (format {format}, {bits} bits, {Channels} channels): {path}");
+        }
+
+        public long FrameCount => dataLength / (bytesPerSample * Channels);
+
+        public void Rewind()
+        {
+            position = 0;
+            stream.Position = dataStart;
+        }
+
+        /// <summary>Decodes up to frames into dest; returns how many, fewer only at the end</summary>
+        public int Read(Span<float> dest, int frames)
+        {
+            int frameBytes = bytesPerSample * Channels;
+            frames = (int)Math.Min(frames, (dataLength - position) / frameBytes);
+            if (frames <= 0) return 0;
+
+            int bytes = frames * frameBytes;
+            if (scratch.Length < bytes)
+                scratch = new byte[bytes];
+            int got = stream.ReadAtLeast(scratch.AsSpan(0, bytes), bytes, false);
+            frames = got / frameBytes;
+            position += (long)frames * frameBytes;
+
+            ReadOnlySpan<byte> src = scratch.AsSpan(0, frames * frameBytes);
+            int count = frames * Channels;
+            switch (bytesPerSample)
+            {
+                case 1:
+                    for (int i = 0; i < count; i++)
+                        dest[i] = (src[i] - 128) * (1.0f / 128.0f);
+                    break;
+                case 2:
+                    for (int i = 0; i < count; i++)
+                        dest[i] = BinaryPrimitives.ReadInt16LittleEndian(src.Slice(i * 2)) * (1.0f / 32768.0f);
+                    break;
+                case 3:
+                    for (int i = 0; i < count; i++)
+                        dest[i] = (src[i * 3] | src[i * 3 + 1] << 8 | (sbyte)src[i * 3 + 2] << 16) * (1.0f / 8388608.0f);
+                    break;
+                default:
+                    if (isFloat)
+                    {
+                        for (int i = 0; i < count; i++)
+                            dest[i] = BinaryPrimitives.ReadSingleLittleEndian(src.Slice(i * 4));
+                    }
+                    else
+                    {
+                        for (int i = 0; i < count; i++)
+                            dest[i] = BinaryPrimitives.ReadInt32LittleEndian(src.Slice(i * 4)) * (1.0f / 2147483648.0f);
+                    }
+                    break;
+            }
+            return frames;
+        }
+    }
+}
@@ -1,12 +1,18 @@
 /*
  * PyFlare Engine - Core System
- * Foundation: Memory management, object system, scene tree
+ * Foundation: Memory management, object system (scene storage in Scene.cs, jobs in Jobs.cs,
+ * spatial index in Spatial.cs)
  * Optimized for weak hardware (256-512MB RAM target)
  */
 
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Numerics;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
+using System.Threading;
 
 namespace PyFlare.Engine.Core
 {
@@ -15,393 +21,2037 @@ namespace PyFlare.Engine.Core
     // ============================================================================
     
     /// <summary>
-    /// Fixed-size memory pool to prevent fragmentation on weak hardware
+    /// Handle to a block of pooled memory outside the GC heap.
+    /// Contents are uninitialized; the block stays valid until freed.
+    /// </summary>
+    public readonly struct PoolBlock
+    {
+        public readonly IntPtr Pointer;
+        public readonly int Size;
+
+        public PoolBlock(IntPtr pointer, int size)
+        {
+            Pointer = pointer;
+            Size = size;
+        }
+
+        public bool IsValid => Pointer != IntPtr.Zero;
+
+        public unsafe Span<byte> AsSpan() => new Span<byte>((void*)Pointer, Size);
+    }
+
+    /// <summary>
+    /// Fixed-size memory pool to prevent fragmentation on weak hardware.
+    /// Backed by a native slab allocator: contiguous pages, intrusive free list, O(1) alloc/free.
     /// </summary>
     public class MemoryPool
     {
         private int blockSize;
-        private Queue<byte[]> freeBlocks;
-        private HashSet<IntPtr> allocatedBlocks;
-        private int totalAllocated;
+        private int handle;
+        private int allocatedBlocks;
+
+        public MemoryPool(int blockSize, int initialBlocks = 32)
+        {
+            this.blockSize = blockSize;
+            this.handle = Platform.NativePlatform.native_pool_create(blockSize, initialBlocks);
+            this.allocatedBlocks = 0;
+
+            if (handle == 0)
+                Console.WriteLine($"Failed to create {blockSize} byte memory pool");
+        }
+
+        public PoolBlock Allocate()
+        {
+            if (handle == 0) return default;
+
+            IntPtr ptr = Platform.NativePlatform.native_pool_alloc(handle);
+            if (ptr == IntPtr.Zero) return default;
+
+            allocatedBlocks++;
+            return new PoolBlock(ptr, blockSize);
+        }
+
+        public void Free(PoolBlock block)
+        {
+            if (handle == 0 || !block.IsValid) return;
+
+            Platform.NativePlatform.native_pool_free(handle, block.Pointer);
+            allocatedBlocks--;
+        }
+
+        public void Dispose()
+        {
+            if (handle != 0)
+            {
+                Platform.NativePlatform.native_pool_destroy(handle);
+                handle = 0;
+                allocatedBlocks = 0;
+            }
+        }
+
+        public int GetBlockSize() => blockSize;
+        public int GetTotalAllocated() => allocatedBlocks * blockSize;
+        public int GetAllocatedBlocks() => allocatedBlocks;
+
+        public int GetFreeBlocks()
+        {
+            if (handle == 0) return 0;
+            Platform.NativePlatform.native_pool_get_stats(handle, out Platform.PoolStats stats);
+            return stats.freeBlocks;
+        }
+
+        public long GetReservedBytes()
+        {
+            if (handle == 0) return 0;
+            Platform.NativePlatform.native_pool_get_stats(handle, out Platform.PoolStats stats);
+            return stats.reservedBytes;
+        }
+    }
+
+    /// <summary>
+    /// Bump-pointer arena for transient per-frame data. Everything is released at once by Reset,
+    /// which Engine.Update calls at the start of each frame. Allocations are pure pointer arithmetic.
+    /// </summary>
+    public class FrameArena
+    {
+        private IntPtr buffer;
+        private int capacity;
+        private int offset;
+        private int highWater;
+        private List<IntPtr> overflow;
+        private int overflowBytes;
+
+        public FrameArena(int capacity = 1024 * 1024)
+        {
+            this.capacity = 0;
+            this.offset = 0;
+            this.highWater = 0;
+            this.overflow = new List<IntPtr>();
+            this.overflowBytes = 0;
+            Reserve(capacity);
+        }
+
+        private unsafe void Reserve(int bytes)
+        {
+            if (buffer != IntPtr.Zero)
+                NativeMemory.AlignedFree((void*)buffer);
+
+            buffer = (IntPtr)NativeMemory.AlignedAlloc((nuint)bytes, 64);
+            capacity = bytes;
+        }
+
+        /// <summary>
+        /// Memory valid until the next Reset. Alignment must be a power of two
+        /// </summary>
+        public unsafe PoolBlock Allocate(int size, int alignment = 16)
+        {
+            int aligned = (offset + alignment - 1) & ~(alignment - 1);
+            if (aligned + size <= capacity)
+            {
+                offset = aligned + size;
+                return new PoolBlock(buffer + aligned, size);
+            }
+
+            // Spill for the rest of this frame; Reset grows the arena to fit next time
+            IntPtr spill = (IntPtr)NativeMemory.AlignedAlloc((nuint)size, (nuint)Math.Max(alignment, 16));
+            overflow.Add(spill);
+            overflowBytes += size;
+            return new PoolBlock(spill, size);
+        }
+
+        public Span<T> Allocate<T>(int count) where T : unmanaged
+        {
+            unsafe
+            {
+                PoolBlock block = Allocate(count * sizeof(T), 16);
+                return new Span<T>((void*)block.Pointer, count);
+            }
+        }
+
+        public unsafe void Reset()
+        {
+            int used = offset + overflowBytes;
+            highWater = Math.Max(highWater, used);
+
+            if (overflow.Count > 0)
+            {
+                foreach (IntPtr spill in overflow)
+                    NativeMemory.AlignedFree((void*)spill);
+                overflow.Clear();
+                overflowBytes = 0;
+
+                int newCapacity = capacity;
+                while (newCapacity < highWater)
+                    newCapacity *= 2;
+                Reserve(newCapacity);
+            }
+
+            offset = 0;
+        }
+
+        public int GetUsed() => offset + overflowBytes;
+        public int GetCapacity() => capacity;
+        public int GetHighWater() => highWater;
+    }
+
+    /// <summary>
+    /// Central memory manager with multiple pools for different allocation sizes
+    /// </summary>
+    public class MemoryManager
+    {
+        // Sizes grow by 4x, so the class index is half the power of two above 64: see SizeClass
+        private static readonly int[] POOL_SIZES = { 64, 256, 1024, 4096, 16384 };
+        private const int MAX_POOLED_SIZE = 16384;
+
+        private MemoryPool[] pools;
+        private FrameArena frameArena;
+        private int totalAllocations;
+        private long currentMemory;
+        private long peakMemory;
+
+        private static volatile MemoryManager instance;
+        private static readonly object instanceLock = new object();
+        public static MemoryManager Instance
+        {
+            get
+            {
+                // Startup may first touch it from a worker
+                if (instance == null)
+                {
+                    lock (instanceLock)
+                    {
+                        if (instance == null)
+                            instance = new MemoryManager();
+                    }
+                }
+                return instance;
+            }
+        }
+
+        // Pools are created on first use, or all at once by ReservePools during startup
+        private MemoryManager()
+        {
+            pools = new MemoryPool[POOL_SIZES.Length];
+            frameArena = new FrameArena();
+            totalAllocations = 0;
+            currentMemory = 0;
+            peakMemory = 0;
+        }
+
+        /// <summary>
+        /// Pool index for a request of `size` bytes (1..16384) without a loop:
+        /// 1-64 -> 0, 65-256 -> 1, 257-1024 -> 2, 1025-4096 -> 3, 4097-16384 -> 4
+        /// </summary>
+        private static int SizeClass(int size)
+        {
+            return (BitOperations.Log2((uint)(size - 1) | 63u) - 4) >> 1;
+        }
+
+        private MemoryPool GetPool(int sizeClass)
+        {
+            return pools[sizeClass] ?? (pools[sizeClass] = new MemoryPool(POOL_SIZES[sizeClass]));
+        }
+
+        /// <summary>
+        /// Creates every pool with its initial blocks now rather than on first allocation.
+        /// Startup runs this on a worker; nothing may allocate from the manager meanwhile.
+        /// </summary>
+        public void ReservePools()
+        {
+            for (int i = 0; i < pools.Length; i++)
+                GetPool(i);
+        }
+
+        public PoolBlock Allocate(int size)
+        {
+            if (size <= 0) size = 1;
+
+            PoolBlock block;
+            if (size <= MAX_POOLED_SIZE)
+            {
+                block = GetPool(SizeClass(size)).Allocate();
+            }
+            else
+            {
+                long blockSize = Platform.NativePlatform.native_large_block_size(size);
+                IntPtr ptr = blockSize > 0 ? Platform.NativePlatform.native_large_alloc(blockSize) : IntPtr.Zero;
+                block = ptr != IntPtr.Zero ? new PoolBlock(ptr, (int)blockSize) : default;
+            }
+
+            if (!block.IsValid) return block;
+
+            totalAllocations++;
+            currentMemory += block.Size;
+            if (currentMemory > peakMemory)
+                peakMemory = currentMemory;
+            return block;
+        }
+
+        public void Free(PoolBlock block)
+        {
+            if (!block.IsValid) return;
+
+            if (block.Size <= MAX_POOLED_SIZE)
+                GetPool(SizeClass(block.Size)).Free(block);
+            else
+                Platform.NativePlatform.native_large_free(block.Pointer, block.Size);
+
+            totalAllocations--;
+            currentMemory -= block.Size;
+        }
+
+        /// <summary>
+        /// Transient memory that lives until the next frame starts
+        /// </summary>
+        public PoolBlock AllocateFrame(int size, int alignment = 16) => frameArena.Allocate(size, alignment);
+        public Span<T> AllocateFrame<T>(int count) where T : unmanaged => frameArena.Allocate<T>(count);
+        public void ResetFrameArena() => frameArena.Reset();
+        public FrameArena GetFrameArena() => frameArena;
+
+        public long GetTotalMemoryUsed() => currentMemory;
+        public long GetPeakMemory() => peakMemory;
+
+        public void PrintMemoryReport()
+        {
+            Console.WriteLine("\n=== PyFlare Memory Report ===");
+            Console.WriteLine($"Total Allocations: {totalAllocations}");
+            Console.WriteLine($"Memory Used: {GetTotalMemoryUsed() / 1024.0:F2} KB");
+            Console.WriteLine($"Peak Memory: {peakMemory / 1024.0:F2} KB");
+            Console.WriteLine("\nPool Statistics:");
+
+            foreach (var pool in pools)
+            {
+                if (pool == null) continue;
+                int size = pool.GetBlockSize();
+                int allocated = pool.GetAllocatedBlocks();
+                int free = pool.GetFreeBlocks();
+                float efficiency = (allocated + free) > 0 
+                    ? (allocated / (float)(allocated + free)) * 100 
+                    : 0;
+
+                Console.WriteLine($"  {size,5} byte pool: {allocated,3} used, {free,3} free, {efficiency:F1}% efficiency");
+            }
+
+            Platform.NativePlatform.native_large_get_stats(out long largeLive, out long largeCached);
+            Console.WriteLine($"  Large blocks: {largeLive / 1024.0:F2} KB live, {largeCached / 1024.0:F2} KB cached");
+            Console.WriteLine($"  Frame arena: {frameArena.GetHighWater() / 1024.0:F2} KB high water of {frameArena.GetCapacity() / 1024.0:F2} KB");
+            Console.WriteLine("==============================\n");
+        }
+    }
+
+    // ============================================================================
+    // OBJECT SYSTEM
+    // ============================================================================
+
+    /// <summary>
+    /// Interned signal name. Declare once per class, e.g.
+    /// <c>public static readonly SignalId TransformChanged = SignalId.Intern("transform_changed");</c>
+    /// </summary>
+    public readonly struct SignalId : IEquatable<SignalId>
+    {
+        private static readonly object internLock = new object();
+        private static readonly Dictionary<string, int> ids = new Dictionary<string, int>();
+        private static readonly List<string> names = new List<string> { "" };
+
+        public readonly int Value;
+
+        internal SignalId(int value)
+        {
+            Value = value;
+        }
+
+        public static SignalId Intern(string name)
+        {
+            lock (internLock)
+            {
+                if (!ids.TryGetValue(name, out int id))
+                {
+                    id = names.Count;
+                    names.Add(name);
+                    ids[name] = id;
+                }
+                return new SignalId(id);
+            }
+        }
+
+        public string Name
+        {
+            get
+            {
+                lock (internLock)
+                {
+                    return Value > 0 && Value < names.Count ? names[Value] : "";
+                }
+            }
+        }
+
+        public bool IsValid => Value > 0;
+        public bool Equals(SignalId other) => Value == other.Value;
+        public override bool Equals(object obj) => obj is SignalId other && Equals(other);
+        public override int GetHashCode() => Value;
+        public override string ToString() => Name;
+    }
+
+    /// <summary>
+    /// Generational reference to a PyFlareObject: slot index in the low 32 bits, generation
+    /// in the high 32. A handle goes stale when the object is cleaned up, and lookups through
+    /// it fail even after the slot is reused. Value is what crosses into native code.
+    /// </summary>
+    public readonly struct ObjectHandle : IEquatable<ObjectHandle>
+    {
+        public readonly ulong Value;
+
+        public ObjectHandle(ulong value) { Value = value; }
+        internal ObjectHandle(int index, uint generation) { Value = ((ulong)generation << 32) | (uint)index; }
+
+        public int Index => (int)(uint)Value;
+        public uint Generation => (uint)(Value >> 32);
+        public bool IsNull => Value == 0;
+
+        public PyFlareObject Get() => ObjectDatabase.Get(this);
+        public bool IsAlive => ObjectDatabase.Get(this) != null;
+
+        public bool Equals(ObjectHandle other) => Value == other.Value;
+        public override bool Equals(object obj) => obj is ObjectHandle other && Equals(other);
+        public override int GetHashCode() => Value.GetHashCode();
+        public override string ToString() => $"#{Index}:{Generation}";
+    }
+
+    /// <summary>
+    /// Dense slot table of live objects. The table holds the object until its reference
+    /// count drops to zero, so there is no per-object WeakReference. Slot 0 is never used,
+    /// which keeps handle value 0 as null.
+    /// </summary>
+    public static class ObjectDatabase
+    {
+        internal struct Slot
+        {
+            public PyFlareObject obj;
+            public uint generation;
+            public int nextFree;
+        }
+
+        private static readonly object allocLock = new object();
+        private static Slot[] slots = new Slot[1024];
+        private static int highWater = 1;
+        private static int freeHead = -1;
+        private static int liveCount = 0;
+
+        internal static ObjectHandle Add(PyFlareObject obj)
+        {
+            lock (allocLock)
+            {
+                int index;
+                if (freeHead >= 0)
+                {
+                    index = freeHead;
+                    freeHead = slots[index].nextFree;
+                }
+                else
+                {
+                    if (highWater == slots.Length)
+                    {
+                        Slot[] grown = new Slot[slots.Length * 2];
+                        Array.Copy(slots, grown, highWater);
+                        Volatile.Write(ref slots, grown);
+                    }
+                    index = highWater++;
+                    slots[index].generation = 1;
+                }
+
+                slots[index].obj = obj;
+                slots[index].nextFree = -1;
+                liveCount++;
+                return new ObjectHandle(index, slots[index].generation);
+            }
+        }
+
+        internal static void Remove(ObjectHandle handle)
+        {
+            lock (allocLock)
+            {
+                int index = handle.Index;
+                if (index <= 0 || index >= highWater || slots[index].generation != handle.Generation)
+                    return;
+
+                slots[index].obj = null;
+                // Skip generation 0 on wrap so a stale handle can never read as valid
+                uint next = slots[index].generation + 1;
+                slots[index].generation = next == 0 ? 1u : next;
+                slots[index].nextFree = freeHead;
+                freeHead = index;
+                liveCount--;
+            }
+        }
+
+        /// <summary>O(1) lookup; returns null for stale or null handles.</summary>
+        public static PyFlareObject Get(ObjectHandle handle)
+        {
+            Slot[] table = Volatile.Read(ref slots);
+            int index = handle.Index;
+            if ((uint)index >= (uint)table.Length)
+                return null;
+
+            ref Slot slot = ref table[index];
+            return slot.generation == handle.Generation ? slot.obj : null;
+        }
+
+        public static T Get<T>(ObjectHandle handle) where T : PyFlareObject => Get(handle) as T;
+
+        public static int Count => liveCount;
+        public static int Capacity => slots.Length;
+
+        public static Enumerable All => new Enumerable();
+
+        public readonly struct Enumerable
+        {
+            public Enumerator GetEnumerator() => new Enumerator(Volatile.Read(ref slots), highWater);
+        }
+
+        /// <summary>Walks the slot table in index order, skipping free slots; allocation-free.</summary>
+        public struct Enumerator
+        {
+            private readonly Slot[] table;
+            private readonly int end;
+            private int index;
+
+            internal Enumerator(Slot[] table, int end)
+            {
+                this.table = table;
+                this.end = Math.Min(end, table.Length);
+                this.index = 0;
+            }
+
+            public bool MoveNext()
+            {
+                while (++index < end)
+                {
+                    if (table[index].obj != null)
+                        return true;
+                }
+                return false;
+            }
+
+            public PyFlareObject Current => table[index].obj;
+        }
+    }
+
+    /// <summary>
+    /// Class names to types and factories, for scripts and scene files. The table is written at
+    /// build time by `build.py registry` (ClassRegistry.g.cs) and filled on the first lookup, so
+    /// startup does no reflection and no per-class registration. Builds without the generated
+    /// file only know the engine's own types and what RegisterClass adds.
+    /// </summary>
+    public static partial class ClassRegistry
+    {
+        private static readonly object registryLock = new object();
+        private static Dictionary<string, Type> types;
+        private static Dictionary<string, Func<PyFlareObject>> factories;
+
+        // Implemented in the generated ClassRegistry.g.cs
+        static partial void RegisterGenerated();
+
+        private static void EnsureLoaded()
+        {
+            if (Volatile.Read(ref types) != null) return;
+            lock (registryLock)
+            {
+                if (types != null) return;
+                // Published before filling; every reader takes the lock, so none sees it half done
+                factories = new Dictionary<string, Func<PyFlareObject>>();
+                Volatile.Write(ref types, new Dictionary<string, Type>());
+                Add(typeof(PyFlareObject), () => new PyFlareObject());
+                Add(typeof(Resource), () => new Resource());
+                RegisterGenerated();
+            }
+        }
+
+        /// <summary>factory may be null for abstract types or types without a parameterless constructor</summary>
+        public static void Add(Type type, Func<PyFlareObject> factory)
+        {
+            EnsureLoaded();
+            lock (registryLock)
+            {
+                types[type.Name] = type;
+                if (factory != null) factories[type.Name] = factory;
+                else factories.Remove(type.Name);
+            }
+        }
+
+        public static Type Find(string className)
+        {
+            EnsureLoaded();
+            lock (registryLock)
+                return types.TryGetValue(className, out Type type) ? type : null;
+        }
+
+        /// <summary>New instance of a registered class, or null if it has no factory</summary>
+        public static PyFlareObject Create(string className)
+        {
+            EnsureLoaded();
+            Func<PyFlareObject> factory;
+            lock (registryLock)
+                factories.TryGetValue(className, out factory);
+            return factory?.Invoke();
+        }
+
+        public static int Count
+        {
+            get
+            {
+                EnsureLoaded();
+                lock (registryLock) return types.Count;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Base class for all PyFlare engine objects
+    /// Provides reference counting, signals, and metadata
+    /// </summary>
+    public class PyFlareObject
+    {
+        private static int nextObjectId = 0;
+
+        /// <summary>
+        /// Listeners for one signal. The array is replaced, never mutated, so a dispatch
+        /// in progress keeps iterating its snapshot while callbacks connect or disconnect.
+        /// </summary>
+        private sealed class SignalSlot
+        {
+            public readonly int id;
+            public Delegate[] listeners;
+
+            public SignalSlot(int id)
+            {
+                this.id = id;
+                this.listeners = Array.Empty<Delegate>();
+            }
+        }
+
+        protected int objectId;
+        protected ObjectHandle handle;
+        protected int refCount;
+        protected Dictionary<string, object> metadata;   // created on first SetMeta
+        protected object attachedScript;
+        private SignalSlot[] signalSlots;                 // created on first AddSignal/Connect
+        private int signalCount;
+
+        public PyFlareObject()
+        {
+            objectId = Interlocked.Increment(ref nextObjectId);
+            refCount = 1;
+            metadata = null;
+            signalSlots = null;
+            signalCount = 0;
+            attachedScript = null;
+
+            handle = ObjectDatabase.Add(this);
+        }
+
+        // Class registry (see ClassRegistry; generated at build time)
+        public static void RegisterClass(Type type)
+        {
+            Func<PyFlareObject> factory = null;
+            if (!type.IsAbstract && type.GetConstructor(Type.EmptyTypes) != null)
+                factory = () => (PyFlareObject)Activator.CreateInstance(type);
+            ClassRegistry.Add(type, factory);
+        }
+
+        public static Type GetClass(string className) => ClassRegistry.Find(className);
+
+        // Reference counting; loader and job threads take and drop references too
+        public void Reference()
+        {
+            Interlocked.Increment(ref refCount);
+        }
+
+        public void Unreference()
+        {
+            // Only the release that takes the count from 1 to 0 cleans up
+            if (Interlocked.Decrement(ref refCount) == 0)
+                Cleanup();
+        }
+
+        public int GetReferenceCount() => Volatile.Read(ref refCount);
+
+        protected virtual void Cleanup()
+        {
+            signalSlots = null;
+            signalCount = 0;
+            metadata = null;
+            ObjectDatabase.Remove(handle);
+        }
+
+        // Signal system
+
+        // Objects carry a handful of signals at most, so a linear scan beats hashing
+        private SignalSlot FindSlot(int id)
+        {
+            SignalSlot[] slots = signalSlots;
+            for (int i = 0; i < signalCount; i++)
+            {
+                if (slots[i].id == id)
+                    return slots[i];
+            }
+            return null;
+        }
+
+        private SignalSlot GetOrAddSlot(int id)
+        {
+            SignalSlot slot = FindSlot(id);
+            if (slot != null) return slot;
+
+            if (signalSlots == null)
+                signalSlots = new SignalSlot[2];
+            else if (signalCount == signalSlots.Length)
+                Array.Resize(ref signalSlots, signalCount * 2);
+
+            slot = new SignalSlot(id);
+            signalSlots[signalCount++] = slot;
+            return slot;
+        }
+
+        public void AddSignal(SignalId signal) => GetOrAddSlot(signal.Value);
+        public void AddSignal(string signalName) => AddSignal(SignalId.Intern(signalName));
+
+        public bool HasSignal(SignalId signal) => FindSlot(signal.Value) != null;
+
+        private void ConnectDelegate(SignalId signal, Delegate callback)
+        {
+            if (callback == null) return;
+            SignalSlot slot = GetOrAddSlot(signal.Value);
+
+            Delegate[] current = slot.listeners;
+            if (Array.IndexOf(current, callback) >= 0) return;
+
+            Delegate[] next = new Delegate[current.Length + 1];
+            Array.Copy(current, next, current.Length);
+            next[current.Length] = callback;
+            slot.listeners = next;
+        }
+
+        private void DisconnectDelegate(SignalId signal, Delegate callback)
+        {
+            SignalSlot slot = FindSlot(signal.Value);
+            if (slot == null) return;
+
+            Delegate[] current = slot.listeners;
+            int index = Array.IndexOf(current, callback);
+            if (index < 0) return;
+
+            Delegate[] next = new Delegate[current.Length - 1];
+            Array.Copy(current, 0, next, 0, index);
+            Array.Copy(current, index + 1, next, index, current.Length - index - 1);
+            slot.listeners = next;
+        }
+
+        public void Connect(SignalId signal, Action callback) => ConnectDelegate(signal, callback);
+        public void Connect<T>(SignalId signal, Action<T> callback) => ConnectDelegate(signal, callback);
+        public void Connect<T1, T2>(SignalId signal, Action<T1, T2> callback) => ConnectDelegate(signal, callback);
+        public void Connect<T1, T2, T3>(SignalId signal, Action<T1, T2, T3> callback) => ConnectDelegate(signal, callback);
+        public void Connect(SignalId signal, Action<object[]> callback) => ConnectDelegate(signal, callback);
+        public void Connect(string signalName, Action<object[]> callback) => ConnectDelegate(SignalId.Intern(signalName), callback);
+
+        public void Disconnect(SignalId signal, Delegate callback) => DisconnectDelegate(signal, callback);
+        public void Disconnect(string signalName, Action<object[]> callback) => DisconnectDelegate(SignalId.Intern(signalName), callback);
+
+        private Delegate[] GetListeners(int id)
+        {
+            if (signalCount == 0) return null;
+            SignalSlot slot = FindSlot(id);
+            return slot?.listeners;
+        }
+
+        private static void ReportSignalError(SignalId signal, Exception e)
+        {
+            Console.WriteLine($"Error in signal '{signal.Name}': {e.Message}");
+        }
+
+        /*
+         * Typed emits never allocate for matching typed listeners. Listeners connected with
+         * Action<object[]> still work but get their arguments boxed into a new array.
+         */
+
+        public void EmitSignal(SignalId signal)
+        {
+            Delegate[] listeners = GetListeners(signal.Value);
+            if (listeners == null) return;
+
+            foreach (Delegate d in listeners)
+            {
+                try
+                {
+                    if (d is Action a) a();
+                    else if (d is Action<object[]> legacy) legacy(Array.Empty<object>());
+                }
+                catch (Exception e)
+                {
+                    ReportSignalError(signal, e);
+                }
+            }
+        }
+
+        public void EmitSignal<T>(SignalId signal, T arg)
+        {
+            Delegate[] listeners = GetListeners(signal.Value);
+            if (listeners == null) return;
+
+            foreach (Delegate d in listeners)
+            {
+                try
+                {
+                    if (d is Action<T> a) a(arg);
+                    else if (d is Action none) none();
+                    else if (d is Action<object[]> legacy) legacy(new object[] { arg });
+                }
+                catch (Exception e)
+                {
+                    ReportSignalError(signal, e);
+                }
+            }
+        }
+
+        public void EmitSignal<T1, T2>(SignalId signal, T1 arg1, T2 arg2)
+        {
+            Delegate[] listeners = GetListeners(signal.Value);
+            if (listeners == null) return;
+
+            foreach (Delegate d in listeners)
+            {
+                try
+                {
+                    if (d is Action<T1, T2> a) a(arg1, arg2);
+                    else if (d is Action none) none();
+                    else if (d is Action<object[]> legacy) legacy(new object[] { arg1, arg2 });
+                }
+                catch (Exception e)
+                {
+                    ReportSignalError(signal, e);
+                }
+            }
+        }
+
+        public void EmitSignal<T1, T2, T3>(SignalId signal, T1 arg1, T2 arg2, T3 arg3)
+        {
+            Delegate[] listeners = GetListeners(signal.Value);
+            if (listeners == null) return;
+
+            foreach (Delegate d in listeners)
+            {
+                try
+                {
+                    if (d is Action<T1, T2, T3> a) a(arg1, arg2, arg3);
+                    else if (d is Action none) none();
+                    else if (d is Action<object[]> legacy) legacy(new object[] { arg1, arg2, arg3 });
+                }
+                catch (Exception e)
+                {
+                    ReportSignalError(signal, e);
+                }
+            }
+        }
+
+        /// <summary>
+        /// String-keyed emit kept for scripting; reaches Action and Action&lt;object[]&gt; listeners
+        /// </summary>
+        public void EmitSignal(string signalName, params object[] args)
+        {
+            SignalId signal = SignalId.Intern(signalName);
+            Delegate[] listeners = GetListeners(signal.Value);
+            if (listeners == null) return;
+
+            foreach (Delegate d in listeners)
+            {
+                try
+                {
+                    if (d is Action<object[]> legacy) legacy(args);
+                    else if (d is Action none) none();
+                }
+                catch (Exception e)
+                {
+                    ReportSignalError(signal, e);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Queues the signal for SignalQueue.Flush. Repeated deferred emits of the same signal
+        /// on the same object before the flush collapse into one delivery with the latest arguments.
+        /// </summary>
+        public void EmitDeferred(SignalId signal) => SignalQueue.Enqueue(this, signal);
+        public void EmitDeferred<T>(SignalId signal, T arg) => SignalQueue.Enqueue(this, signal, arg);
+
+        internal bool IsAlive() => Volatile.Read(ref refCount) > 0;
+
+        public List<string> GetSignalList()
+        {
+            var result = new List<string>(signalCount);
+            for (int i = 0; i < signalCount; i++)
+                result.Add(new SignalId(signalSlots[i].id).Name);
+            return result;
+        }
+
+        // Metadata
+        public void SetMeta(string key, object value)
+        {
+            if (metadata == null)
+                metadata = new Dictionary<string, object>();
+            metadata[key] = value;
+        }
+
+        public object GetMeta(string key, object defaultValue = null)
+        {
+            if (metadata == null) return defaultValue;
+            return metadata.TryGetValue(key, out object value) ? value : defaultValue;
+        }
+
+        public bool HasMeta(string key) => metadata != null && metadata.ContainsKey(key);
+
+        // Properties
+        public int GetObjectId() => objectId;
+        public ObjectHandle GetHandle() => handle;
+        public string GetClassName() => GetType().Name;
+
+        // Static utilities
+        public static int GetObjectCount() => ObjectDatabase.Count;
+        public static ObjectDatabase.Enumerable GetAllObjects() => ObjectDatabase.All;
+        public static PyFlareObject FromHandle(ulong handle) => ObjectDatabase.Get(new ObjectHandle(handle));
+    }
+
+    /// <summary>
+    /// Deferred signal delivery, flushed once per frame by Engine.Update.
+    /// Entries are plain structs in a flat array; typed payloads live in per-type arrays,
+    /// so queuing and flushing don't box. Main thread only.
+    /// </summary>
+    public static class SignalQueue
+    {
+        private interface IPayloadStore
+        {
+            void Dispatch(PyFlareObject target, SignalId signal, int index);
+            void Clear();
+        }
+
+        private sealed class PayloadStore<T> : IPayloadStore
+        {
+            // One store per T per queue buffer; the generic static holds both
+            public static readonly PayloadStore<T>[] Buffers = { new PayloadStore<T>(), new PayloadStore<T>() };
+
+            private T[] values = new T[16];
+            private int count;
+
+            public int Add(T value)
+            {
+                if (count == values.Length)
+                    Array.Resize(ref values, count * 2);
+                values[count] = value;
+                return count++;
+            }
+
+            public void Set(int index, T value) => values[index] = value;
+
+            public void Dispatch(PyFlareObject target, SignalId signal, int index)
+            {
+                target.EmitSignal(signal, values[index]);
+            }
+
+            public void Clear()
+            {
+                // Drop references so queued payloads don't outlive the frame
+                if (RuntimeHelpers.IsReferenceOrContainsReferences<T>())
+                    Array.Clear(values, 0, count);
+                count = 0;
+            }
+        }
+
+        private struct Entry
+        {
+            public PyFlareObject target;
+            public SignalId signal;
+            public IPayloadStore store;   // null = no arguments
+            public int payload;
+        }
+
+        private sealed class Buffer
+        {
+            public Entry[] entries = new Entry[256];
+            public int count;
+            public readonly Dictionary<long, int> index = new Dictionary<long, int>(256);
+            public readonly List<IPayloadStore> stores = new List<IPayloadStore>();
+        }
+
+        private static readonly Buffer[] buffers = { new Buffer(), new Buffer() };
+        private static int pending = 0;
+        private static int coalesced = 0;
+        private static int delivered = 0;
+
+        private static long Key(PyFlareObject target, SignalId signal)
+        {
+            return ((long)target.GetObjectId() << 32) | (uint)signal.Value;
+        }
+
+        private static ref Entry Slot(Buffer buffer, PyFlareObject target, SignalId signal, out bool existing)
+        {
+            long key = Key(target, signal);
+            if (buffer.index.TryGetValue(key, out int i))
+            {
+                existing = true;
+                coalesced++;
+                return ref buffer.entries[i];
+            }
+
+            if (buffer.count == buffer.entries.Length)
+                Array.Resize(ref buffer.entries, buffer.count * 2);
+
+            i = buffer.count++;
+            buffer.index[key] = i;
+            existing = false;
+            return ref buffer.entries[i];
+        }
+
+        public static void Enqueue(PyFlareObject target, SignalId signal)
+        {
+            Buffer buffer = buffers[pending];
+            ref Entry e = ref Slot(buffer, target, signal, out _);
+            e.target = target;
+            e.signal = signal;
+            e.store = null;
+            e.payload = -1;
+        }
+
+        public static void Enqueue<T>(PyFlareObject target, SignalId signal, T arg)
+        {
+            Buffer buffer = buffers[pending];
+            PayloadStore<T> store = PayloadStore<T>.Buffers[pending];
+            ref Entry e = ref Slot(buffer, target, signal, out bool existing);
+
+            // Latest arguments win; reuse the payload slot when the type matches
+            if (existing && e.store == store)
+            {
+                store.Set(e.payload, arg);
+                return;
+            }
+
+            if (!buffer.stores.Contains(store))
+                buffer.stores.Add(store);
+
+            e.target = target;
+            e.signal = signal;
+            e.store = store;
+            e.payload = store.Add(arg);
+        }
+
+        /// <summary>
+        /// Delivers everything queued, in first-emit order. Signals deferred by callbacks during
+        /// the flush run in a further pass, up to maxPasses; the rest wait for the next frame.
+        /// </summary>
+        public static int Flush(int maxPasses = 4)
+        {
+            int total = 0;
+            for (int pass = 0; pass < maxPasses && buffers[pending].count > 0; pass++)
+            {
+                Buffer current = buffers[pending];
+                pending ^= 1;
+
+                for (int i = 0; i < current.count; i++)
+                {
+                    ref Entry e = ref current.entries[i];
+                    if (e.target.IsAlive())
+                    {
+                        if (e.store == null)
+                            e.target.EmitSignal(e.signal);
+                        else
+                            e.store.Dispatch(e.target, e.signal, e.payload);
+                        total++;
+                    }
+                    e.target = null;
+                    e.store = null;
+                }
+
+                current.count = 0;
+                current.index.Clear();
+                foreach (IPayloadStore store in current.stores)
+                    store.Clear();
+                current.stores.Clear();
+            }
+
+            delivered += total;
+            return total;
+        }
+
+        public static int GetPendingCount() => buffers[pending].count;
+        public static int GetCoalescedCount() => coalesced;
+        public static int GetDeliveredCount() => delivered;
+
+        public static void ResetStats()
+        {
+            coalesced = 0;
+            delivered = 0;
+        }
+    }
+
+    // ============================================================================
+    // RESOURCE SYSTEM
+    // ============================================================================
+
+    /// <summary>
+    /// Base class for all loadable resources (textures, sounds, meshes, etc.)
+    /// Loading is split in two: LoadData reads and decodes on a loader thread,
+    /// Upload then runs on the main (GL) thread to create GPU objects.
+    /// </summary>
+    public class Resource : PyFlareObject
+    {
+        protected string resourcePath;
+        protected volatile bool isLoaded;
+        protected long memoryUsage;
+
+        public Resource()
+        {
+            resourcePath = "";
+            isLoaded = false;
+            memoryUsage = 0;
+        }
+
+        /// <summary>Synchronous load: both phases on the calling thread.</summary>
+        public virtual void Load(string path)
+        {
+            LoadData(path, CancellationToken.None);
+            Upload();
+        }
+
+        /// <summary>
+        /// File I/O and decoding. Runs on a loader thread for async loads, so it must not
+        /// touch GL or engine state. Long decodes should poll the token.
+        /// </summary>
+        public virtual void LoadData(string path, CancellationToken token)
+        {
+            resourcePath = path;
+        }
+
+        /// <summary>Main-thread half of the load; decoded data goes to the GPU here.</summary>
+        public virtual void Upload()
+        {
+            isLoaded = true;
+        }
+
+        public virtual void Unload()
+        {
+            isLoaded = false;
+            memoryUsage = 0;
+        }
+
+        /// <summary>
+        /// Hot reload, on the main thread at a frame boundary. fresh is a new instance of the same
+        /// type whose LoadData already ran on the changed file, off the main thread; this object
+        /// takes over the new content and keeps its identity, handle and cache entry. The default
+        /// unloads and loads again in place, so fresh only proved the file loads; override to adopt
+        /// fresh's decoded data instead. fresh is released afterwards.
+        /// </summary>
+        protected internal virtual void ApplyReload(Resource fresh)
+        {
+            Unload();
+            Load(resourcePath);
+        }
+
+        /// <summary>Emitted after a hot reload has replaced the resource's content</summary>
+        public static readonly SignalId Reloaded = SignalId.Intern("reloaded");
+
+        public string GetPath() => resourcePath;
+        public bool IsLoaded() => isLoaded;
+        public long GetMemoryUsage() => Interlocked.Read(ref memoryUsage);
+
+        protected override void Cleanup()
+        {
+            if (isLoaded)
+                Unload();
+            base.Cleanup();
+        }
+    }
+
+    public enum LoadPriority
+    {
+        Background = 0,
+        Normal = 1,
+        High = 2,
+        Immediate = 3
+    }
+
+    public enum LoadState
+    {
+        Queued,
+        Loading,
+        WaitingUpload,
+        Ready,
+        Failed,
+        Cancelled
+    }
+
+    /// <summary>
+    /// One in-flight load, shared by every caller that asked for the same path and type.
+    /// </summary>
+    public sealed class ResourceRequest
+    {
+        public readonly string Path;
+        public readonly Type ResourceType;
+        internal readonly Resource resource;
+        internal readonly CancellationTokenSource cancel = new CancellationTokenSource();
+        private readonly ManualResetEventSlim done = new ManualResetEventSlim(false);
+        private readonly ManualResetEventSlim dataReady = new ManualResetEventSlim(false);
+        private int state;
+        internal int priority;
+        internal int waiters;             // callers holding this request, guarded by the queue lock
+        internal Action<Resource> completed;
+        public Exception Error { get; internal set; }
+
+        internal ResourceRequest(string path, Type type, Resource resource, LoadPriority priority)
+        {
+            Path = path;
+            ResourceType = type;
+            this.resource = resource;
+            this.priority = (int)priority;
+            waiters = 1;
+            state = (int)LoadState.Queued;
+        }
+
+        internal static ResourceRequest Completed(string path, Resource resource)
+        {
+            var request = new ResourceRequest(path, resource.GetType(), resource, LoadPriority.Normal);
+            request.state = (int)LoadState.Ready;
+            request.dataReady.Set();
+            request.done.Set();
+            return request;
+        }
+
+        public LoadState State => (LoadState)Volatile.Read(ref state);
+        public bool IsDone => done.IsSet;
+        public LoadPriority Priority => (LoadPriority)priority;
+
+        /// <summary>The resource once State is Ready, otherwise null.</summary>
+        public Resource Resource => State == LoadState.Ready ? resource : null;
+
+        internal bool TryTransition(LoadState from, LoadState to)
+        {
+            return Interlocked.CompareExchange(ref state, (int)to, (int)from) == (int)from;
+        }
+
+        internal void MarkDataReady() => dataReady.Set();
+
+        internal void Finish(LoadState final)
+        {
+            Volatile.Write(ref state, (int)final);
+            dataReady.Set();
+            done.Set();
+        }
+
+        /// <summary>
+        /// Blocks until the load finishes. Called on the main thread it performs the
+        /// upload itself instead of waiting for the next pump.
+        /// </summary>
+        public Resource Wait()
+        {
+            // Help with queued jobs rather than sleep; loads themselves stay on the workers
+            while (!dataReady.IsSet)
+            {
+                if (!Jobs.TryRunOne())
+                    dataReady.Wait(1);
+            }
+            if (!done.IsSet && ResourceLoader.IsUploadThread)
+                ResourceLoader.CompleteUpload(this);
+            done.Wait();
+            return Resource;
+        }
+
+        public void Cancel() => ResourceLoader.Cancel(this);
+    }
+
+    /// <summary>
+    /// Typed view of a ResourceRequest, returned by LoadAsync.
+    /// </summary>
+    public readonly struct ResourceFuture<T> where T : Resource
+    {
+        public readonly ResourceRequest Request;
+
+        internal ResourceFuture(ResourceRequest request) { Request = request; }
+
+        public bool IsValid => Request != null;
+        public bool IsDone => Request.IsDone;
+        public bool IsReady => Request.State == LoadState.Ready;
+        public LoadState State => Request.State;
+        public T Result => Request.Resource as T;
+        public T Wait() => Request.Wait() as T;
+        public void Cancel() => Request.Cancel();
+
+        /// <summary>Runs on the main thread when the load completes; immediately if it already has.</summary>
+        public void OnCompleted(Action<T> callback) => ResourceLoader.OnCompleted(Request, r => callback(r as T));
+    }
+
+    public struct ResourceCacheStats
+    {
+        public long hits;
+        public long misses;
+        public long evictions;
+        public long residentBytes;      // everything the cache holds
+        public long referencedBytes;    // held by someone besides the cache
+        public long budgetBytes;
+        public int entries;
+
+        public double HitRate => hits + misses > 0 ? (double)hits / (hits + misses) : 0.0;
+    }
+
+    /// <summary>
+    /// Strong, byte-budgeted LRU cache. The cache owns one reference to every entry; an entry
+    /// becomes evictable once that is the only reference left. Sizes come from
+    /// Resource.GetMemoryUsage, sampled on insert and on every hit. Thread-safe.
+    /// </summary>
+    public class ResourceCache
+    {
+        private sealed class Entry
+        {
+            public string path;
+            public Resource resource;
+            public long bytes;
+        }
+
+        private readonly object cacheLock = new object();
+        private readonly Dictionary<string, LinkedListNode<Entry>> entries = new Dictionary<string, LinkedListNode<Entry>>();
+        private readonly LinkedList<Entry> lru = new LinkedList<Entry>();   // most recent first
+        private long budgetBytes;
+        private long residentBytes;
+        private long hits;
+        private long misses;
+        private long evictions;
+
+        public ResourceCache(long budgetBytes)
+        {
+            this.budgetBytes = budgetBytes;
+        }
+
+        /// <summary>On a hit, adds a reference for the caller and marks the entry most recent.</summary>
+        public bool TryGet<T>(string path, out T resource) where T : Resource
+        {
+            lock (cacheLock)
+            {
+                if (entries.TryGetValue(path, out LinkedListNode<Entry> node) &&
+                    node.Value.resource is T hit && hit.IsLoaded())
+                {
+                    hit.Reference();
+                    Touch(node);
+                    hits++;
+                    resource = hit;
+                    return true;
+                }
+                misses++;
+            }
+            resource = null;
+            return false;
+        }
+
+        public void Add(string path, Resource resource)
+        {
+            lock (cacheLock)
+            {
+                if (entries.TryGetValue(path, out LinkedListNode<Entry> existing))
+                {
+                    if (existing.Value.resource == resource)
+                    {
+                        Touch(existing);
+                        return;
+                    }
+                    RemoveNode(existing);
+                }
+
+                resource.Reference();
+                var entry = new Entry { path = path, resource = resource, bytes = resource.GetMemoryUsage() };
+                entries[path] = lru.AddFirst(entry);
+                residentBytes += entry.bytes;
+                TrimLocked();
+            }
+        }
+
+        private void Touch(LinkedListNode<Entry> node)
+        {
+            // Sizes can change after load (lazy uploads, mip streaming)
+            long bytes = node.Value.resource.GetMemoryUsage();
+            residentBytes += bytes - node.Value.bytes;
+            node.Value.bytes = bytes;
+
+            if (node != lru.First)
+            {
+                lru.Remove(node);
+                lru.AddFirst(node);
+            }
+        }
+
+        private void RemoveNode(LinkedListNode<Entry> node)
+        {
+            lru.Remove(node);
+            entries.Remove(node.Value.path);
+            residentBytes -= node.Value.bytes;
+            node.Value.resource.Unreference();
+        }
+
+        // Walk from the least recent end, dropping entries nobody else holds
+        private void TrimLocked()
+        {
+            LinkedListNode<Entry> node = lru.Last;
+            while (residentBytes > budgetBytes && node != null)
+            {
+                LinkedListNode<Entry> prev = node.Previous;
+                if (node.Value.resource.GetReferenceCount() <= 1)
+                {
+                    RemoveNode(node);
+                    evictions++;
+                }
+                node = prev;
+            }
+        }
+
+        public void Trim()
+        {
+            lock (cacheLock)
+            {
+                TrimLocked();
+            }
+        }
+
+        public void SetBudget(long bytes)
+        {
+            lock (cacheLock)
+            {
+                budgetBytes = bytes;
+                TrimLocked();
+            }
+        }
 
-        public MemoryPool(int blockSize, int initialBlocks = 32)
+        public long GetBudget() => budgetBytes;
+
+        /// <summary>Drops the cache's references; resources still in use stay alive with their owners.</summary>
+        public void Clear()
         {
-            this.blockSize = blockSize;
-            this.freeBlocks = new Queue<byte[]>(initialBlocks);
-            this.allocatedBlocks = new HashSet<IntPtr>();
-            this.totalAllocated = 0;
+            lock (cacheLock)
+            {
+                while (lru.Last != null)
+                    RemoveNode(lru.Last);
+            }
+        }
 
-            GrowPool(initialBlocks);
+        public int Count
+        {
+            get { lock (cacheLock) { return entries.Count; } }
         }
 
-        private void GrowPool(int count)
+        /// <summary>Snapshot of the cached keys, for hot reload</summary>
+        public void CollectPaths(List<string> paths)
         {
-            for (int i = 0; i < count; i++)
+            lock (cacheLock)
             {
-                byte[] block = new byte[blockSize];
-                freeBlocks.Enqueue(block);
+                foreach (Entry entry in lru)
+                    paths.Add(entry.path);
             }
         }
 
-        public byte[] Allocate()
+        /// <summary>Adds the cached resources whose key names the same file as fullPath</summary>
+        public void FindByFile(string fullPath, List<Resource> results)
         {
-            if (freeBlocks.Count == 0)
+            lock (cacheLock)
             {
-                int growSize = Math.Max(8, allocatedBlocks.Count / 2);
-                GrowPool(growSize);
+                foreach (Entry entry in lru)
+                {
+                    if (HotReload.IsSameFile(entry.path, fullPath))
+                        results.Add(entry.resource);
+                }
             }
+        }
 
-            byte[] block = freeBlocks.Dequeue();
-            IntPtr ptr = Marshal.UnsafeAddrOfPinnedArrayElement(block, 0);
-            allocatedBlocks.Add(ptr);
-            totalAllocated += blockSize;
-            return block;
+        public ResourceCacheStats GetStats()
+        {
+            lock (cacheLock)
+            {
+                long referenced = 0;
+                foreach (Entry entry in lru)
+                {
+                    if (entry.resource.GetReferenceCount() > 1)
+                        referenced += entry.bytes;
+                }
+
+                return new ResourceCacheStats
+                {
+                    hits = hits,
+                    misses = misses,
+                    evictions = evictions,
+                    residentBytes = residentBytes,
+                    referencedBytes = referenced,
+                    budgetBytes = budgetBytes,
+                    entries = entries.Count
+                };
+            }
         }
 
-        public void Free(byte[] block)
+        public void ResetStats()
         {
-            IntPtr ptr = Marshal.UnsafeAddrOfPinnedArrayElement(block, 0);
-            if (allocatedBlocks.Contains(ptr))
+            lock (cacheLock)
             {
-                allocatedBlocks.Remove(ptr);
-                totalAllocated -= blockSize;
-                Array.Clear(block, 0, block.Length);
-                freeBlocks.Enqueue(block);
+                hits = misses = evictions = 0;
             }
         }
+    }
+
+    /// <summary>
+    /// Bytes of one asset. Points into a mounted archive when the asset is packed (no copy),
+    /// or owns an array read from a loose file. Mapped data lives until the archive is unmounted.
+    /// </summary>
+    public readonly struct ResourceData
+    {
+        private readonly IntPtr pointer;
+        internal readonly byte[] array;     // null when mapped
+        public readonly int Length;
+
+        internal ResourceData(IntPtr pointer, int length)
+        {
+            this.pointer = pointer;
+            this.array = null;
+            Length = length;
+        }
+
+        internal ResourceData(byte[] array)
+        {
+            this.pointer = IntPtr.Zero;
+            this.array = array;
+            Length = array.Length;
+        }
+
+        public bool IsValid => pointer != IntPtr.Zero || array != null;
+        public bool IsMapped => pointer != IntPtr.Zero;
 
-        public int GetTotalAllocated() => totalAllocated;
-        public int GetFreeBlocks() => freeBlocks.Count;
-        public int GetAllocatedBlocks() => allocatedBlocks.Count;
+        public unsafe ReadOnlySpan<byte> Span => pointer != IntPtr.Zero
+            ? new ReadOnlySpan<byte>((void*)pointer, Length)
+            : new ReadOnlySpan<byte>(array);
     }
 
     /// <summary>
-    /// Central memory manager with multiple pools for different allocation sizes
+    /// Resource loader with caching, prioritized background loading and deduplication.
+    /// Loader threads run LoadData; Upload and completion callbacks run in PumpUploads,
+    /// which Engine.Update calls once per frame.
     /// </summary>
-    public class MemoryManager
+    public class ResourceLoader
     {
-        private static readonly int[] POOL_SIZES = { 64, 256, 1024, 4096, 16384 };
-        private Dictionary<int, MemoryPool> pools;
-        private int totalAllocations;
-        private long peakMemory;
+        // 64MB default suits the 256-512MB target; games tune it with SetCacheBudget
+        private static readonly ResourceCache cache = new ResourceCache(64L * 1024 * 1024);
 
-        private static MemoryManager instance;
-        public static MemoryManager Instance
+        private static readonly object queueLock = new object();
+        private static readonly PriorityQueue<ResourceRequest, long> queue = new PriorityQueue<ResourceRequest, long>();
+        private static readonly Dictionary<(string, Type), ResourceRequest> inFlight = new Dictionary<(string, Type), ResourceRequest>();
+        private static readonly Queue<ResourceRequest> uploads = new Queue<ResourceRequest>();
+        private static long sequence = 0;
+        private static bool initialized = false;
+        private static volatile bool stopping = false;
+        private static int uploadThreadId = -1;
+
+        // Loads run as jobs; capping them keeps blocking I/O from occupying every worker
+        private static int maxConcurrentLoads;
+        private static int activeLoads;             // guarded by queueLock
+        private static JobCounter loadJobs;
+
+        public static double UploadBudgetMs = 4.0;
+
+        public static bool IsUploadThread => Environment.CurrentManagedThreadId == uploadThreadId;
+
+        // Replaced wholesale on mount so loader threads can read it without locking
+        private static Platform.AssetArchive[] archives = Array.Empty<Platform.AssetArchive>();
+        private static readonly object mountLock = new object();
+
+        /// <summary>
+        /// Maps an archive built by `build.py pack`. Later mounts take precedence, so patch
+        /// archives can override entries in the base pack.
+        /// </summary>
+        public static bool MountArchive(string path)
         {
-            get
+            Platform.AssetArchive archive = Platform.AssetArchive.Open(path);
+            if (archive == null)
             {
-                if (instance == null)
-                    instance = new MemoryManager();
-                return instance;
+                Console.WriteLine($"Failed to mount archive: {path}");
+                return false;
             }
-        }
 
-        private MemoryManager()
-        {
-            pools = new Dictionary<int, MemoryPool>();
-            foreach (int size in POOL_SIZES)
+            lock (mountLock)
             {
-                pools[size] = new MemoryPool(size);
+                var mounted = new Platform.AssetArchive[archives.Length + 1];
+                mounted[0] = archive;
+                Array.Copy(archives, 0, mounted, 1, archives.Length);
+                Volatile.Write(ref archives, mounted);
             }
-            totalAllocations = 0;
-            peakMemory = 0;
+            Console.WriteLine($"Mounted {path} ({archive.GetEntryCount()} entries)");
+            return true;
         }
 
-        public byte[] Allocate(int size)
+        /// <summary>
+        /// Mounts several archives, opening (and index-checking) them in parallel; that is disk
+        /// bound on cold starts. Precedence is as if mounted one by one in the given order.
+        /// Returns how many mounted.
+        /// </summary>
+        public static int MountArchives(IReadOnlyList<string> paths)
         {
-            int poolSize = -1;
-            foreach (int ps in POOL_SIZES)
+            var opened = new Platform.AssetArchive[paths.Count];
+            Jobs.ParallelFor(paths.Count, i => opened[i] = Platform.AssetArchive.Open(paths[i]));
+
+            int mounted = 0;
+            lock (mountLock)
             {
-                if (ps >= size)
+                var list = new List<Platform.AssetArchive>(archives.Length + paths.Count);
+                for (int i = paths.Count - 1; i >= 0; i--)
                 {
-                    poolSize = ps;
-                    break;
+                    if (opened[i] == null)
+                    {
+                        Console.WriteLine($"Failed to mount archive: {paths[i]}");
+                        continue;
+                    }
+                    list.Add(opened[i]);
+                    mounted++;
                 }
+                list.AddRange(archives);
+                Volatile.Write(ref archives, list.ToArray());
             }
+            Console.WriteLine($"Mounted {mounted} of {paths.Count} archives");
+            return mounted;
+        }
+
+        // Below this many chunks the fan-out costs more than it saves
+        private const int ParallelDecodeMinChunks = 4;
 
-            if (poolSize == -1)
+        private static ResourceData Decompress(Platform.AssetArchive archive, Platform.ArchiveEntryInfo info, string path)
+        {
+            if (info.compression != Platform.AssetArchive.CompressionLz4Chunked)
             {
-                Console.WriteLine($"Warning: Large allocation ({size} bytes) bypassing pools");
-                return new byte[size];
+                Console.WriteLine($"Unsupported compression {info.compression} for '{path}'");
+                return default;
             }
 
-            totalAllocations++;
-            UpdatePeakMemory();
-            return pools[poolSize].Allocate();
-        }
+            byte[] output = GC.AllocateUninitializedArray<byte>(checked((int)info.rawSize));
+            int chunks = archive.GetChunkCount(info);
+            bool ok;
 
-        public void Free(byte[] block, int poolSize)
-        {
-            if (pools.ContainsKey(poolSize))
+            if (chunks < ParallelDecodeMinChunks)
+            {
+                ok = archive.DecodeChunks(info, 0, chunks, output);
+            }
+            else
+            {
+                // Chunks are independent LZ4 blocks writing disjoint ranges of output
+                int failed = 0;
+                int batches = Math.Min(chunks, Jobs.WorkerCount);
+                Jobs.ParallelFor(batches, b =>
+                {
+                    int first = (int)((long)chunks * b / batches);
+                    int last = (int)((long)chunks * (b + 1) / batches);
+                    if (!archive.DecodeChunks(info, first, last - first, output))
+                        Interlocked.Exchange(ref failed, 1);
+                });
+                ok = failed == 0;
+            }
+
+            if (!ok)
             {
-                pools[poolSize].Free(block);
-                totalAllocations--;
+                Console.WriteLine($"Corrupt compressed entry '{path}'");
+                return default;
             }
+            return new ResourceData(output);
         }
 
-        private void UpdatePeakMemory()
+        /// <summary>Only safe once no loads are running and no ResourceData spans are held.</summary>
+        public static void UnmountAll()
         {
-            long current = GetTotalMemoryUsed();
-            if (current > peakMemory)
-                peakMemory = current;
+            lock (mountLock)
+            {
+                foreach (Platform.AssetArchive archive in archives)
+                    archive.Dispose();
+                Volatile.Write(ref archives, Array.Empty<Platform.AssetArchive>());
+            }
         }
 
-        public long GetTotalMemoryUsed()
+        /// <summary>
+        /// Finds an asset's bytes: mounted archives first, newest mount first, then the
+        /// loose file on disk. Stored entries come back as a span into the mapping; compressed
+        /// ones are decoded into a new array, large ones across cores. Safe to call from LoadData.
+        /// </summary>
+        public static ResourceData OpenData(string path)
         {
-            long total = 0;
-            foreach (var pool in pools.Values)
+            foreach (Platform.AssetArchive archive in Volatile.Read(ref archives))
             {
-                total += pool.GetTotalAllocated();
+                if (!archive.TryGetEntry(path, out Platform.ArchiveEntryInfo info))
+                    continue;
+
+                if (info.compression == Platform.AssetArchive.CompressionNone)
+                    return new ResourceData(info.data, checked((int)info.size));
+                return Decompress(archive, info, path);
             }
-            return total;
+
+            return File.Exists(path) ? new ResourceData(File.ReadAllBytes(path)) : default;
         }
 
-        public void PrintMemoryReport()
+        /// <summary>
+        /// Sequential access for long assets such as music: stored archive entries are read from
+        /// the mapping as they go and loose files from disk; compressed entries are decoded whole
+        /// first. Null if the asset is missing. Like OpenData spans, archive streams must not
+        /// outlive UnmountAll.
+        /// </summary>
+        public static unsafe Stream OpenStream(string path)
         {
-            Console.WriteLine("\n=== PyFlare Memory Report ===");
-            Console.WriteLine($"Total Allocations: {totalAllocations}");
-            Console.WriteLine($"Memory Used: {GetTotalMemoryUsed() / 1024.0:F2} KB");
-            Console.WriteLine($"Peak Memory: {peakMemory / 1024.0:F2} KB");
-            Console.WriteLine("\nPool Statistics:");
-
-            foreach (var kvp in pools)
+            foreach (Platform.AssetArchive archive in Volatile.Read(ref archives))
             {
-                int size = kvp.Key;
-                var pool = kvp.Value;
-                int allocated = pool.GetAllocatedBlocks();
-                int free = pool.GetFreeBlocks();
-                float efficiency = (allocated + free) > 0 
-                    ? (allocated / (float)(allocated + free)) * 100 
-                    : 0;
+                if (!archive.TryGetEntry(path, out Platform.ArchiveEntryInfo info))
+                    continue;
 
-                Console.WriteLine($"  {size,5} byte pool: {allocated,3} used, {free,3} free, {efficiency:F1}% efficiency");
+                if (info.compression == Platform.AssetArchive.CompressionNone)
+                    return new UnmanagedMemoryStream((byte*)info.data, info.size);
+                ResourceData data = Decompress(archive, info, path);
+                return data.IsValid ? new MemoryStream(data.array, false) : null;
             }
-            Console.WriteLine("==============================\n");
+
+            return File.Exists(path)
+                ? new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.Read, 64 * 1024, FileOptions.SequentialScan)
+                : null;
         }
-    }
 
-    // ============================================================================
-    // OBJECT SYSTEM
-    // ============================================================================
+        /// <summary>
+        /// Makes the calling thread the upload thread. Loads run on the job system, at most
+        /// maxConcurrentLoads at a time (0 = one fewer than the workers, up to 4).
+        /// </summary>
+        public static void Initialize(int maxConcurrentLoads = 0)
+        {
+            uploadThreadId = Environment.CurrentManagedThreadId;
+            if (initialized)
+                return;
 
-    /// <summary>
-    /// Base class for all PyFlare engine objects
-    /// Provides reference counting, signals, and metadata
-    /// </summary>
-    public class PyFlareObject
-    {
-        private static int nextObjectId = 1;
-        private static Dictionary<string, Type> classRegistry = new Dictionary<string, Type>();
-        private static Dictionary<int, WeakReference> objectDatabase = new Dictionary<int, WeakReference>();
+            Jobs.Initialize();
+            if (maxConcurrentLoads <= 0)
+                maxConcurrentLoads = Math.Clamp(Jobs.WorkerCount - 1, 1, 4);
 
-        protected int objectId;
-        protected int refCount;
-        protected Dictionary<string, List<Action<object[]>>> signals;
-        protected Dictionary<string, object> metadata;
-        protected object attachedScript;
+            ResourceLoader.maxConcurrentLoads = maxConcurrentLoads;
+            stopping = false;
+            activeLoads = 0;
+            loadJobs = new JobCounter();
+            initialized = true;
+        }
 
-        public PyFlareObject()
+        public static void Shutdown()
         {
-            objectId = nextObjectId++;
-            refCount = 1;
-            signals = new Dictionary<string, List<Action<object[]>>>();
-            metadata = new Dictionary<string, object>();
-            attachedScript = null;
+            if (!initialized)
+                return;
 
-            objectDatabase[objectId] = new WeakReference(this);
+            lock (queueLock)
+            {
+                stopping = true;
+                foreach (ResourceRequest request in inFlight.Values)
+                    request.cancel.Cancel();
+            }
+            loadJobs.Dispose();
+
+            lock (queueLock)
+            {
+                foreach (ResourceRequest request in inFlight.Values)
+                {
+                    request.resource.Unreference();
+                    request.Finish(LoadState.Cancelled);
+                }
+                inFlight.Clear();
+                queue.Clear();
+                uploads.Clear();
+                loadJobs = null;
+                initialized = false;
+            }
         }
 
-        // Class registry
-        public static void RegisterClass(Type type)
+        private static bool TryGetCached<T>(string path, out T cached) where T : Resource
         {
-            classRegistry[type.Name] = type;
+            return cache.TryGet(path, out cached);
         }
 
-        public static Type GetClass(string className)
+        private static void AddToCache(string path, Resource resource)
         {
-            return classRegistry.ContainsKey(className) ? classRegistry[className] : null;
+            cache.Add(path, resource);
         }
 
-        // Reference counting
-        public void Reference()
+        public static T Load<T>(string path) where T : Resource, new()
         {
-            refCount++;
+            // Check cache first
+            if (TryGetCached(path, out T cached))
+                return cached;
+
+            // Join a pending async load of the same path rather than loading twice
+            ResourceRequest pending = null;
+            lock (queueLock)
+            {
+                if (inFlight.TryGetValue((path, typeof(T)), out pending))
+                    pending.waiters++;
+            }
+            if (pending != null)
+                return pending.Wait() as T;
+
+            // Load new resource
+            T resource = new T();
+            resource.Load(path);
+            AddToCache(path, resource);
+            return resource;
         }
 
-        public void Unreference()
+        /// <summary>
+        /// Queues a background load. Requests for a path already loading share that load,
+        /// and the higher of the two priorities applies.
+        /// </summary>
+        public static ResourceFuture<T> LoadAsync<T>(string path, LoadPriority priority = LoadPriority.Normal)
+            where T : Resource, new()
         {
-            refCount--;
-            if (refCount <= 0)
-                Cleanup();
-        }
+            if (TryGetCached(path, out T cached))
+                return new ResourceFuture<T>(ResourceRequest.Completed(path, cached));
 
-        public int GetReferenceCount() => refCount;
+            if (!initialized)
+                Initialize();
 
-        protected virtual void Cleanup()
-        {
-            signals.Clear();
-            metadata.Clear();
-            if (objectDatabase.ContainsKey(objectId))
-                objectDatabase.Remove(objectId);
+            ResourceRequest request;
+            bool startJob = false;
+            lock (queueLock)
+            {
+                if (inFlight.TryGetValue((path, typeof(T)), out request))
+                {
+                    request.waiters++;
+                    if ((int)priority > request.priority)
+                    {
+                        request.priority = (int)priority;
+                        // Stale queue entries are skipped by the load jobs
+                        if (request.State == LoadState.Queued)
+                            startJob = Enqueue(request);
+                    }
+                }
+                else
+                {
+                    request = new ResourceRequest(path, typeof(T), new T(), priority);
+                    inFlight[(path, typeof(T))] = request;
+                    startJob = Enqueue(request);
+                }
+            }
+
+            // Submitted outside the lock: a job may run inline if the scheduler is full
+            if (startJob)
+                Jobs.Run(LoadJob, loadJobs, JobPin.Background);
+            return new ResourceFuture<T>(request);
         }
 
-        // Signal system
-        public void AddSignal(string signalName)
+        // Higher priority first, FIFO within a priority. Caller holds queueLock.
+        // Returns true if the caller should start another load job.
+        private static bool Enqueue(ResourceRequest request)
         {
-            if (!signals.ContainsKey(signalName))
-                signals[signalName] = new List<Action<object[]>>();
+            long key = ((long)(3 - request.priority) << 48) | sequence++;
+            queue.Enqueue(request, key);
+            if (activeLoads >= maxConcurrentLoads)
+                return false;
+            activeLoads++;
+            return true;
         }
 
-        public void Connect(string signalName, Action<object[]> callback)
+        internal static void Cancel(ResourceRequest request)
         {
-            if (!signals.ContainsKey(signalName))
-                AddSignal(signalName);
+            lock (queueLock)
+            {
+                if (request.IsDone || --request.waiters > 0)
+                    return;
+                request.cancel.Cancel();
+                inFlight.Remove((request.Path, request.ResourceType));
+            }
 
-            if (!signals[signalName].Contains(callback))
-                signals[signalName].Add(callback);
+            // Not started yet: finish it here. Otherwise the worker or pump sees the token.
+            if (request.TryTransition(LoadState.Queued, LoadState.Cancelled) ||
+                request.TryTransition(LoadState.WaitingUpload, LoadState.Cancelled))
+            {
+                request.resource.Unreference();
+                request.Finish(LoadState.Cancelled);
+            }
         }
 
-        public void Disconnect(string signalName, Action<object[]> callback)
+        internal static void OnCompleted(ResourceRequest request, Action<Resource> callback)
         {
-            if (signals.ContainsKey(signalName))
-                signals[signalName].Remove(callback);
+            lock (queueLock)
+            {
+                if (!request.IsDone)
+                {
+                    request.completed += callback;
+                    return;
+                }
+            }
+            callback(request.Resource);
         }
 
-        public void EmitSignal(string signalName, params object[] args)
+        /// <summary>
+        /// Loads the highest-priority queued request, then resubmits itself while work remains.
+        /// One load per job keeps a thread that picks it up while waiting from running a whole queue.
+        /// </summary>
+        private static void LoadJob()
         {
-            if (signals.ContainsKey(signalName))
+            ResourceRequest request = null;
+            lock (queueLock)
+            {
+                if (!stopping && queue.Count > 0)
+                    request = queue.Dequeue();
+                else
+                    activeLoads--;
+            }
+            if (request == null)
+                return;
+
+            // Skips cancelled requests and duplicate entries left by a priority bump
+            if (request.TryTransition(LoadState.Queued, LoadState.Loading))
             {
-                foreach (var callback in signals[signalName])
+                try
+                {
+                    request.resource.LoadData(request.Path, request.cancel.Token);
+                }
+                catch (Exception e)
                 {
-                    try
+                    if (!(e is OperationCanceledException))
                     {
-                        callback(args);
+                        request.Error = e;
+                        Console.WriteLine($"Failed to load '{request.Path}': {e.Message}");
                     }
-                    catch (Exception e)
+                }
+
+                if (request.TryTransition(LoadState.Loading, LoadState.WaitingUpload))
+                {
+                    lock (queueLock)
                     {
-                        Console.WriteLine($"Error in signal '{signalName}': {e.Message}");
+                        uploads.Enqueue(request);
                     }
+                    request.MarkDataReady();
                 }
             }
-        }
-
-        public List<string> GetSignalList()
-        {
-            return new List<string>(signals.Keys);
-        }
 
-        // Metadata
-        public void SetMeta(string key, object value)
-        {
-            metadata[key] = value;
+            Jobs.Run(LoadJob, loadJobs, JobPin.Background);
         }
 
-        public object GetMeta(string key, object defaultValue = null)
+        /// <summary>
+        /// Uploads finished loads on the main thread until the time budget is spent.
+        /// Returns the number of requests completed.
+        /// </summary>
+        public static int PumpUploads(double budgetMs = -1)
         {
-            return metadata.ContainsKey(key) ? metadata[key] : defaultValue;
-        }
+            if (uploadThreadId < 0)
+                uploadThreadId = Environment.CurrentManagedThreadId;
+            if (budgetMs < 0)
+                budgetMs = UploadBudgetMs;
 
-        public bool HasMeta(string key) => metadata.ContainsKey(key);
-
-        // Properties
-        public int GetObjectId() => objectId;
-        public string GetClassName() => GetType().Name;
+            long start = Stopwatch.GetTimestamp();
+            long budget = (long)(budgetMs * Stopwatch.Frequency / 1000.0);
+            int completed = 0;
 
-        // Static utilities
-        public static int GetObjectCount() => objectDatabase.Count;
-        public static List<PyFlareObject> GetAllObjects()
-        {
-            List<PyFlareObject> result = new List<PyFlareObject>();
-            foreach (var wr in objectDatabase.Values)
+            while (true)
             {
-                if (wr.IsAlive)
-                    result.Add(wr.Target as PyFlareObject);
-            }
-            return result;
-        }
-    }
+                ResourceRequest request;
+                lock (queueLock)
+                {
+                    if (uploads.Count == 0)
+                        break;
+                    request = uploads.Dequeue();
+                }
 
-    // ============================================================================
-    // RESOURCE SYSTEM
-    // ============================================================================
+                if (CompleteUpload(request))
+                    completed++;
 
-    /// <summary>
-    /// Base class for all loadable resources (textures, sounds, meshes, etc.)
-    /// </summary>
-    public class Resource : PyFlareObject
-    {
-        protected string resourcePath;
-        protected bool isLoaded;
-        protected long memoryUsage;
+                // Always make progress by at least one upload per frame
+                if (Stopwatch.GetTimestamp() - start >= budget)
+                    break;
+            }
 
-        public Resource()
-        {
-            resourcePath = "";
-            isLoaded = false;
-            memoryUsage = 0;
+            // Entries released since last frame may now be evictable
+            cache.Trim();
+            return completed;
         }
 
-        public virtual void Load(string path)
+        internal static bool CompleteUpload(ResourceRequest request)
         {
-            resourcePath = path;
-            isLoaded = true;
-        }
+            // Wait() may already have uploaded this request inline
+            if (request.IsDone)
+                return false;
 
-        public virtual void Unload()
-        {
-            isLoaded = false;
-            memoryUsage = 0;
-        }
+            LoadState final = LoadState.Failed;
+            if (request.Error == null && !request.cancel.IsCancellationRequested &&
+                request.TryTransition(LoadState.WaitingUpload, LoadState.Loading))
+            {
+                try
+                {
+                    request.resource.Upload();
+                    final = LoadState.Ready;
+                }
+                catch (Exception e)
+                {
+                    request.Error = e;
+                    Console.WriteLine($"Failed to upload '{request.Path}': {e.Message}");
+                }
+            }
+            else if (request.cancel.IsCancellationRequested)
+            {
+                final = LoadState.Cancelled;
+            }
 
-        public string GetPath() => resourcePath;
-        public bool IsLoaded() => isLoaded;
-        public long GetMemoryUsage() => memoryUsage;
+            Action<Resource> callbacks;
+            lock (queueLock)
+            {
+                inFlight.Remove((request.Path, request.ResourceType));
+                if (final == LoadState.Ready)
+                {
+                    // Every caller that joined this load owns one reference
+                    for (int i = 1; i < request.waiters; i++)
+                        request.resource.Reference();
+                }
+                callbacks = request.completed;
+                request.completed = null;
+            }
 
-        protected override void Cleanup()
-        {
-            if (isLoaded)
-                Unload();
-            base.Cleanup();
-        }
-    }
+            if (final == LoadState.Ready)
+                AddToCache(request.Path, request.resource);
+            else if (request.State != LoadState.Cancelled)
+                request.resource.Unreference();
 
-    /// <summary>
-    /// Resource loader with caching and lazy loading
-    /// </summary>
-    public class ResourceLoader
-    {
-        private static Dictionary<string, WeakReference> resourceCache = new Dictionary<string, WeakReference>();
+            request.Finish(final);
 
-        public static T Load<T>(string path) where T : Resource, new()
-        {
-            // Check cache first
-            if (resourceCache.ContainsKey(path))
+            if (callbacks != null)
             {
-                WeakReference wr = resourceCache[path];
-                if (wr.IsAlive)
+                try
                 {
-                    T cached = wr.Target as T;
-                    if (cached != null)
-                    {
-                        cached.Reference();
-                        return cached;
-                    }
+                    callbacks(request.Resource);
+                }
+                catch (Exception e)
+                {
+                    Console.WriteLine($"Error in load callback for '{request.Path}': {e.Message}");
                 }
             }
-
-            // Load new resource
-            T resource = new T();
-            resource.Load(path);
-            resourceCache[path] = new WeakReference(resource);
-            return resource;
+            return true;
         }
 
-        public static void ClearCache()
+        public static int GetPendingCount()
         {
-            resourceCache.Clear();
+            lock (queueLock)
+            {
+                return inFlight.Count;
+            }
         }
 
-        public static int GetCacheSize() => resourceCache.Count;
+        public static void ClearCache() => cache.Clear();
+
+        internal static void FindLoaded(string fullPath, List<Resource> results) => cache.FindByFile(fullPath, results);
+        internal static void CollectCachedPaths(List<string> paths) => cache.CollectPaths(paths);
+        public static int GetCacheSize() => cache.Count;
+        public static void SetCacheBudget(long bytes) => cache.SetBudget(bytes);
+        public static ResourceCacheStats GetCacheStats() => cache.GetStats();
+
+        public static void PrintCacheStats()
+        {
+            ResourceCacheStats stats = cache.GetStats();
+            Console.WriteLine("=== Resource Cache ===");
+            Console.WriteLine($"Entries: {stats.entries}");
+            Console.WriteLine($"Resident: {stats.residentBytes / (1024.0 * 1024.0):F2} / {stats.budgetBytes / (1024.0 * 1024.0):F2} MB");
+            Console.WriteLine($"Referenced: {stats.referencedBytes / (1024.0 * 1024.0):F2} MB");
+            Console.WriteLine($"Hit rate: {stats.HitRate * 100.0:F1}% ({stats.hits} hits, {stats.misses} misses)");
+            Console.WriteLine($"Evictions: {stats.evictions}");
+            Console.WriteLine("======================");
+        }
     }
 
     // ============================================================================
@@ -428,6 +2078,7 @@ namespace PyFlare.Engine.Core
         private double targetFPS;
         private double deltaTime;
         private long frameCount;
+        private Platform.ProfilerMarker updateMarker;
 
         private Engine()
         {
@@ -441,12 +2092,18 @@ namespace PyFlare.Engine.Core
         {
             Console.WriteLine("PyFlare Engine Initializing...");
             
-            // Initialize memory manager
+            // Memory pools and the class registry come up on first use (see Startup for the
+            // parallel path that warms them on workers)
             var memMgr = MemoryManager.Instance;
-            
-            // Register core classes
-            PyFlareObject.RegisterClass(typeof(PyFlareObject));
-            PyFlareObject.RegisterClass(typeof(Resource));
+
+            // Frame limiter (takes effect once the platform window exists)
+            Platform.Platform.SetTargetFPS(targetFPS);
+
+            updateMarker = Platform.Profiler.RegisterMarker("Engine.Update");
+
+            // Shared worker threads, then loading on top of them; uploads happen on this thread
+            Jobs.Initialize();
+            ResourceLoader.Initialize();
             
             Console.WriteLine("PyFlare Engine Initialized");
             isRunning = true;
@@ -458,8 +2115,13 @@ namespace PyFlare.Engine.Core
             
             isRunning = false;
             
-            // Clear resource cache
+            // Stop watching, stop loads, then the workers, and clear resource cache
+            HotReload.Shutdown();
+            ResourceLoader.Shutdown();
+            Jobs.Shutdown();
+            ResourceLoader.PrintCacheStats();
             ResourceLoader.ClearCache();
+            ResourceLoader.UnmountAll();
             
             // Print final memory report
             MemoryManager.Instance.PrintMemoryReport();
@@ -469,14 +2131,32 @@ namespace PyFlare.Engine.Core
 
         public void Update(double dt)
         {
+            Platform.Profiler.Begin(updateMarker);
+            MemoryManager.Instance.ResetFrameArena();
             deltaTime = dt;
             frameCount++;
+
+            // Finish background loads: GPU upload and completion callbacks
+            ResourceLoader.PumpUploads();
+            Jobs.RunMainThreadJobs();
+
+            // Changed assets swap in here, between frames
+            HotReload.Update();
+            Startup.Update();
+
+            // Deferred signals from this frame's simulation are delivered here
+            SignalQueue.Flush();
+            Platform.Profiler.End(updateMarker);
         }
 
         public bool IsRunning() => isRunning;
         public double GetDeltaTime() => deltaTime;
         public long GetFrameCount() => frameCount;
         public double GetTargetFPS() => targetFPS;
-        public void SetTargetFPS(double fps) => targetFPS = fps;
+        public void SetTargetFPS(double fps)
+        {
+            targetFPS = fps;
+            Platform.Platform.SetTargetFPS(fps);
+        }
     }
 }
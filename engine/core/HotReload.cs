@@ -0,0 +1,526 @@
+/*
+ * PyFlare Engine - Hot Reload
+ * Watches asset directories and swaps changed files into the running game: cached resources
+ * are reloaded in place (same objects, same handles) and shaders keep their program ids.
+ * Files decode on the job system; results are applied between frames in Engine.Update
+ */
+
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+using PyFlare.Engine.Platform;
+
+namespace PyFlare.Engine.Core
+{
+    public struct HotReloadStats
+    {
+        public int watches;             // native watches; 0 while polling
+        public bool polling;
+        public long changes;            // debounced file changes handled
+        public long reloads;            // resources replaced
+        public long shaderReloads;      // shader swaps completed
+        public long failures;           // loads, applies or shader builds that kept the old version
+    }
+
+    /// <summary>
+    /// Development-time asset reloading. Only what the changed file affects is touched: resources
+    /// loaded through ResourceLoader under that path, and shaders registered with LoadShader or
+    /// TrackShader. A file that fails to load or compile leaves the previous version in use.
+    /// Loose files only; an entry in a mounted archive shadows the loose file of the same path.
+    /// </summary>
+    public static class HotReload
+    {
+        private sealed class ShaderFiles
+        {
+            public Shader shader;
+            public string vertexPath;
+            public string fragmentPath;
+        }
+
+        private readonly struct LoadResult
+        {
+            public readonly Resource target;
+            public readonly Resource fresh;
+            public readonly Exception error;
+
+            public LoadResult(Resource target, Resource fresh, Exception error)
+            {
+                this.target = target;
+                this.fresh = fresh;
+                this.error = error;
+            }
+        }
+
+        private readonly struct ShaderSources
+        {
+            public readonly ShaderFiles files;
+            public readonly string vertex;
+            public readonly string fragment;
+            public readonly Exception error;
+
+            public ShaderSources(ShaderFiles files, string vertex, string fragment, Exception error)
+            {
+                this.files = files;
+                this.vertex = vertex;
+                this.fragment = fragment;
+                this.error = error;
+            }
+        }
+
+        /// <summary>Quiet time after the last event for a file before it is reloaded</summary>
+        public static double DebounceMs = 100.0;
+
+        /// <summary>Timestamp scan interval where the platform has no native watcher</summary>
+        public static double PollIntervalMs = 500.0;
+
+        // Editors may still hold the file open when the debounce ends
+        private const int MaxRetries = 3;
+
+        /// <summary>Raised on the main thread for every debounced change, before any reload</summary>
+        public static event Action<string> FileChanged;
+
+        private static readonly StringComparer PathComparer =
+            OperatingSystem.IsWindows() || OperatingSystem.IsMacOS() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+
+        // Main thread only
+        private static readonly List<int> watches = new List<int>();
+        private static readonly List<string> pollRoots = new List<string>();
+        private static readonly Dictionary<string, long> due = new Dictionary<string, long>(PathComparer);
+        private static readonly Dictionary<string, int> retries = new Dictionary<string, int>(PathComparer);
+        private static readonly HashSet<Resource> reloading = new HashSet<Resource>();
+        // Changed again while reloading; the job may have read the file before the last save
+        private static readonly HashSet<Resource> reloadPending = new HashSet<Resource>();
+        private static readonly List<ShaderFiles> shaders = new List<ShaderFiles>();
+        private static readonly List<ShaderFiles> shadersBuilding = new List<ShaderFiles>();
+        private static readonly List<string> readyPaths = new List<string>();
+        private static readonly List<Resource> affected = new List<Resource>();
+        private static readonly WatchEvent[] events = new WatchEvent[32];
+        private static long nextPollTicks;
+        private static HotReloadStats stats;
+
+        // Filled by jobs
+        private static readonly ConcurrentQueue<LoadResult> loaded = new ConcurrentQueue<LoadResult>();
+        private static readonly ConcurrentQueue<ShaderSources> shaderSources = new ConcurrentQueue<ShaderSources>();
+        private static readonly ConcurrentQueue<string> polledChanges = new ConcurrentQueue<string>();
+        private static readonly Dictionary<string, DateTime> writeTimes = new Dictionary<string, DateTime>(PathComparer);
+        private static int scanning;
+        private static JobCounter jobs;     // every job above; created with the first one
+
+        public static bool IsActive => watches.Count > 0 || pollRoots.Count > 0;
+
+        /// <summary>Absolute, '/' separated form used for every comparison</summary>
+        public static string NormalizePath(string path) => Path.GetFullPath(path).Replace('\\', '/');
+
+        public static bool IsSameFile(string path, string fullPath)
+        {
+            if (string.IsNullOrEmpty(path)) return false;
+            return PathComparer.Equals(NormalizePath(path), fullPath);
+        }
+
+        /// <summary>
+        /// Starts watching a directory. Uses the native watcher where there is one, and falls
+        /// back to scanning the timestamps of loaded resources and tracked shaders.
+        /// </summary>
+        public static bool Watch(string directory, bool recursive = true)
+        {
+            string root = NormalizePath(directory);
+            if (!Directory.Exists(root))
+            {
+                Console.WriteLine($"Hot reload: no such directory {root}");
+                return false;
+            }
+
+            int watch = FileWatcher.IsSupported ? FileWatcher.Add(root, recursive) : 0;
+            if (watch != 0)
+            {
+                watches.Add(watch);
+                Console.WriteLine($"Hot reload: watching {root}");
+            }
+            else
+            {
+                pollRoots.Add(root.EndsWith("/") ? root : root + "/");
+                Console.WriteLine($"Hot reload: polling {root} every {PollIntervalMs:F0} ms");
+            }
+            return true;
+        }
+
+        /// <summary>Stops watching; waits for reloads already decoding, then drops them</summary>
+        public static void Shutdown()
+        {
+            // A job still running would enqueue a fresh resource after the drain below
+            if (jobs != null)
+            {
+                jobs.Dispose();
+                jobs = null;
+            }
+            if (watches.Count > 0)
+                FileWatcher.Shutdown();
+            watches.Clear();
+            pollRoots.Clear();
+            due.Clear();
+            retries.Clear();
+            shaders.Clear();
+            shadersBuilding.Clear();
+            reloading.Clear();
+            reloadPending.Clear();
+            lock (writeTimes) writeTimes.Clear();
+            while (loaded.TryDequeue(out LoadResult result))
+                result.fresh?.Unreference();
+            shaderSources.Clear();
+            polledChanges.Clear();
+        }
+
+        /// <summary>Creates a shader from two files and reloads it whenever either changes</summary>
+        public static Shader LoadShader(string vertexPath, string fragmentPath)
+        {
+            var shader = new Shader(File.ReadAllText(vertexPath), File.ReadAllText(fragmentPath));
+            if (shader.IsValid())
+                TrackShader(shader, vertexPath, fragmentPath);
+            return shader;
+        }
+
+        public static void TrackShader(Shader shader, string vertexPath, string fragmentPath)
+        {
+            shaders.Add(new ShaderFiles
+            {
+                shader = shader,
+                vertexPath = NormalizePath(vertexPath),
+                fragmentPath = NormalizePath(fragmentPath)
+            });
+        }
+
+        public static void UntrackShader(Shader shader)
+        {
+            shaders.RemoveAll(s => s.shader == shader);
+            shadersBuilding.RemoveAll(s => s.shader == shader);
+        }
+
+        public static HotReloadStats GetStats()
+        {
+            HotReloadStats result = stats;
+            result.watches = watches.Count;
+            result.polling = pollRoots.Count > 0;
+            return result;
+        }
+
+        /// <summary>Marks a file changed, as if the watcher had reported it</summary>
+        public static void NotifyChanged(string path) => Schedule(NormalizePath(path), Platform.Platform.GetTicks());
+
+        private static void Schedule(string fullPath, long ticks)
+        {
+            due[fullPath] = ticks + (long)(DebounceMs * Platform.Platform.GetTickFrequency() / 1000.0);
+        }
+
+        /// <summary>
+        /// Main thread, between frames (Engine.Update). Collects changes, starts reloads for the
+        /// files that have settled and applies the reloads that finished decoding.
+        /// </summary>
+        public static void Update()
+        {
+            if (!IsActive && due.Count == 0 && reloading.Count == 0 && shadersBuilding.Count == 0)
+                return;
+
+            long now = Platform.Platform.GetTicks();
+            CollectChanges(now);
+
+            if (due.Count > 0)
+            {
+                readyPaths.Clear();
+                foreach (KeyValuePair<string, long> pending in due)
+                {
+                    if (pending.Value <= now)
+                        readyPaths.Add(pending.Key);
+                }
+                foreach (string path in readyPaths)
+                {
+                    due.Remove(path);
+                    Dispatch(path);
+                }
+            }
+
+            ApplyLoaded(now);
+            ApplyShaderSources();
+            CheckShaders();
+        }
+
+        private static void CollectChanges(long now)
+        {
+            if (watches.Count > 0)
+            {
+                int count;
+                do
+                {
+                    count = FileWatcher.Poll(events);
+                    for (int i = 0; i < count; i++)
+                    {
+                        // Deletions keep the loaded version; the file usually comes straight back
+                        if (events[i].action == WatchAction.Modified)
+                            Schedule(events[i].GetPath(), now);
+                        else if (events[i].action == WatchAction.Overflow)
+                            ScheduleEverything(now);
+                    }
+                } while (count == events.Length);
+            }
+
+            while (polledChanges.TryDequeue(out string path))
+                Schedule(path, now);
+
+            if (pollRoots.Count > 0 && now >= nextPollTicks && Interlocked.CompareExchange(ref scanning, 1, 0) == 0)
+            {
+                nextPollTicks = now + (long)(PollIntervalMs * Platform.Platform.GetTickFrequency() / 1000.0);
+                List<string> paths = TrackedPaths();
+                string[] roots = pollRoots.ToArray();
+                RunJob(() => Scan(paths, roots));
+            }
+        }
+
+        // Background workers only, so file IO never holds up frame jobs; Shutdown waits on the counter
+        private static void RunJob(Action action)
+        {
+            jobs ??= new JobCounter();
+            Jobs.Run(action, jobs, JobPin.Background);
+        }
+
+        // Lost events: treat every tracked file as changed
+        private static void ScheduleEverything(long now)
+        {
+            foreach (string path in TrackedPaths())
+                Schedule(path, now);
+        }
+
+        private static List<string> TrackedPaths()
+        {
+            var paths = new List<string>();
+            ResourceLoader.CollectCachedPaths(paths);
+            for (int i = 0; i < paths.Count; i++)
+                paths[i] = NormalizePath(paths[i]);
+            foreach (ShaderFiles files in shaders)
+            {
+                paths.Add(files.vertexPath);
+                paths.Add(files.fragmentPath);
+            }
+            return paths;
+        }
+
+        // Job: compares write times against the previous scan; the first sighting is the baseline
+        private static void Scan(List<string> paths, string[] roots)
+        {
+            try
+            {
+                foreach (string path in paths)
+                {
+                    if (!UnderRoot(path, roots) || !File.Exists(path)) continue;
+                    DateTime written = File.GetLastWriteTimeUtc(path);
+                    lock (writeTimes)
+                    {
+                        if (writeTimes.TryGetValue(path, out DateTime previous) && previous != written)
+                            polledChanges.Enqueue(path);
+                        writeTimes[path] = written;
+                    }
+                }
+            }
+            finally
+            {
+                Volatile.Write(ref scanning, 0);
+            }
+        }
+
+        private static bool UnderRoot(string path, string[] roots)
+        {
+            StringComparison comparison = PathComparer == StringComparer.Ordinal
+                ? StringComparison.Ordinal : StringComparison.OrdinalIgnoreCase;
+            foreach (string root in roots)
+            {
+                if (path.StartsWith(root, comparison)) return true;
+            }
+            return false;
+        }
+
+        private static void Dispatch(string path)
+        {
+            stats.changes++;
+            try
+            {
+                FileChanged?.Invoke(path);
+            }
+            catch (Exception e)
+            {
+                Console.WriteLine($"Hot reload: FileChanged handler failed: {e}");
+            }
+
+            affected.Clear();
+            ResourceLoader.FindLoaded(path, affected);
+            foreach (Resource resource in affected)
+                StartReload(resource);
+
+            foreach (ShaderFiles files in shaders)
+            {
+                if (PathComparer.Equals(files.vertexPath, path) || PathComparer.Equals(files.fragmentPath, path))
+                    StartShaderReload(files);
+            }
+        }
+
+        private static void StartReload(Resource target)
+        {
+            if (!target.IsLoaded()) return;
+            if (!reloading.Add(target))
+            {
+                reloadPending.Add(target);
+                return;
+            }
+
+            Resource fresh;
+            try
+            {
+                fresh = (Resource)Activator.CreateInstance(target.GetType());
+            }
+            catch (Exception e)
+            {
+                reloading.Remove(target);
+                stats.failures++;
+                Console.WriteLine($"Hot reload: cannot create a {target.GetType().Name} ({e.Message})");
+                return;
+            }
+
+            string path = target.GetPath();
+            RunJob(() =>
+            {
+                try
+                {
+                    fresh.LoadData(path, CancellationToken.None);
+                    loaded.Enqueue(new LoadResult(target, fresh, null));
+                }
+                catch (Exception e)
+                {
+                    loaded.Enqueue(new LoadResult(target, fresh, e));
+                }
+            });
+        }
+
+        private static void ApplyLoaded(long now)
+        {
+            while (loaded.TryDequeue(out LoadResult result))
+            {
+                Resource target = result.target;
+                reloading.Remove(target);
+                ApplyResult(result, now);
+
+                if (reloadPending.Remove(target))
+                    StartReload(target);
+            }
+        }
+
+        private static void ApplyResult(LoadResult result, long now)
+        {
+            Resource target = result.target;
+            string path = target.GetPath();
+            string fullPath = NormalizePath(path);
+
+            if (result.error != null)
+            {
+                result.fresh.Unreference();
+                if (result.error is IOException && Retry(fullPath, now)) return;
+                retries.Remove(fullPath);
+                stats.failures++;
+                Console.WriteLine($"Hot reload: {path} failed to load, keeping the previous version: {result.error.Message}");
+                return;
+            }
+
+            retries.Remove(fullPath);
+            try
+            {
+                target.ApplyReload(result.fresh);
+                stats.reloads++;
+                Console.WriteLine($"Hot reload: {path}");
+                target.EmitSignal(Resource.Reloaded);
+            }
+            catch (Exception e)
+            {
+                stats.failures++;
+                Console.WriteLine($"Hot reload: applying {path} failed: {e.Message}");
+            }
+            finally
+            {
+                result.fresh.Unreference();
+            }
+        }
+
+        private static bool Retry(string fullPath, long now)
+        {
+            retries.TryGetValue(fullPath, out int attempts);
+            if (attempts >= MaxRetries) return false;
+            retries[fullPath] = attempts + 1;
+            Schedule(fullPath, now);
+            return true;
+        }
+
+        private static void StartShaderReload(ShaderFiles files)
+        {
+            RunJob(() =>
+            {
+                try
+                {
+                    shaderSources.Enqueue(new ShaderSources(files,
+                        File.ReadAllText(files.vertexPath), File.ReadAllText(files.fragmentPath), null));
+                }
+                catch (Exception e)
+                {
+                    shaderSources.Enqueue(new ShaderSources(files, null, null, e));
+                }
+            });
+        }
+
+        private static void ApplyShaderSources()
+        {
+            while (shaderSources.TryDequeue(out ShaderSources sources))
+            {
+                ShaderFiles files = sources.files;
+                if (!shaders.Contains(files)) continue;
+
+                if (sources.error != null)
+                {
+                    if (sources.error is IOException && Retry(files.vertexPath, Platform.Platform.GetTicks())) continue;
+                    stats.failures++;
+                    Console.WriteLine($"Hot reload: cannot read shader sources: {sources.error.Message}");
+                    continue;
+                }
+
+                // Compiled natively in the background; swapped in after a later Present
+                if (files.shader.Reload(sources.vertex, sources.fragment))
+                {
+                    if (!shadersBuilding.Contains(files))
+                        shadersBuilding.Add(files);
+                }
+                else
+                {
+                    stats.failures++;
+                    Console.WriteLine($"Hot reload: could not queue {files.fragmentPath}");
+                }
+            }
+        }
+
+        private static void CheckShaders()
+        {
+            for (int i = shadersBuilding.Count - 1; i >= 0; i--)
+            {
+                ShaderFiles files = shadersBuilding[i];
+                ShaderReloadStatus status = files.shader.GetReloadStatus();
+                if (status == ShaderReloadStatus.Pending) continue;
+
+                shadersBuilding.RemoveAt(i);
+                if (status == ShaderReloadStatus.Applied)
+                {
+                    stats.shaderReloads++;
+                    Console.WriteLine($"Hot reload: shader {files.vertexPath} + {files.fragmentPath}");
+                }
+                else if (status == ShaderReloadStatus.Failed)
+                {
+                    stats.failures++;
+                    Console.WriteLine($"Hot reload: shader kept its previous version: {files.shader.GetReloadError()}");
+                }
+            }
+        }
+    }
+}
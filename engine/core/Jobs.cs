@@ -0,0 +1,229 @@
+/*
+ * PyFlare Engine - Job System
+ * Managed front end for the native work-stealing scheduler: one worker per core,
+ * shared by loading, decompression, scene updates and culling
+ */
+
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+using PyFlare.Engine.Platform;
+
+namespace PyFlare.Engine.Core
+{
+    public enum JobPin
+    {
+        Any = 0,
+        /// <summary>Runs on the main thread, in its waits or in Jobs.RunMainThreadJobs</summary>
+        MainThread = 1,
+        /// <summary>
+        /// Never runs on the main thread, not even in its waits: for jobs that block on file IO
+        /// or long decodes, which would stall the frame if a waiting main thread picked them up
+        /// </summary>
+        Background = 2
+    }
+
+    /// <summary>
+    /// Number of unfinished jobs submitted against it, children included. Waiting runs jobs
+    /// instead of blocking. Dispose waits for the jobs before freeing the native counter.
+    /// </summary>
+    public sealed class JobCounter : IDisposable
+    {
+        internal IntPtr handle;
+
+        public JobCounter()
+        {
+            handle = NativePlatform.native_job_counter_create();
+            if (handle == IntPtr.Zero)
+                throw new OutOfMemoryException("Failed to allocate job counter");
+        }
+
+        public int Pending => handle == IntPtr.Zero ? 0 : NativePlatform.native_job_counter_value(handle);
+        public bool IsDone => Pending == 0;
+
+        public void Wait()
+        {
+            if (handle != IntPtr.Zero)
+                NativePlatform.native_job_wait(handle);
+        }
+
+        public void Dispose()
+        {
+            if (handle == IntPtr.Zero) return;
+            Wait();
+            NativePlatform.native_job_counter_destroy(handle);
+            handle = IntPtr.Zero;
+        }
+    }
+
+    /// <summary>
+    /// Managed work reaches native workers as a GCHandle passed through one trampoline
+    /// </summary>
+    internal abstract class JobPayload
+    {
+        public abstract void Run(int index);
+        public virtual void Fail(Exception e) => Console.WriteLine($"Job failed: {e}");
+        public virtual bool OneShot => true;
+    }
+
+    internal sealed class ActionJob : JobPayload
+    {
+        private readonly Action action;
+        public ActionJob(Action action) { this.action = action; }
+        public override void Run(int index) => action();
+    }
+
+    internal sealed class ParallelForJob : JobPayload
+    {
+        private readonly Action<int> body;
+        private readonly int count;
+        private readonly int batches;
+        private ExceptionDispatchInfo error;
+
+        public ParallelForJob(Action<int> body, int count, int batches)
+        {
+            this.body = body;
+            this.count = count;
+            this.batches = batches;
+        }
+
+        // Job index b covers a contiguous slice of the iteration space
+        public override void Run(int index)
+        {
+            int first = (int)((long)count * index / batches);
+            int last = (int)((long)count * (index + 1) / batches);
+            for (int i = first; i < last; i++)
+                body(i);
+        }
+
+        public override void Fail(Exception e) => Interlocked.CompareExchange(ref error, ExceptionDispatchInfo.Capture(e), null);
+        public override bool OneShot => false;   // one handle shared by every index
+        public void ThrowIfFailed() => error?.Throw();
+    }
+
+    public static unsafe class Jobs
+    {
+        private static readonly IntPtr trampoline =
+            (IntPtr)(delegate* unmanaged[Cdecl]<IntPtr, int, void>)&Execute;
+
+        private static int workerCount;
+
+        // Slices per worker in ParallelFor: enough to balance uneven iterations, few enough to stay cheap
+        private const int BatchesPerWorker = 4;
+
+        /// <summary>
+        /// Starts the workers (0 = one per core). The calling thread becomes the main thread.
+        /// </summary>
+        public static void Initialize(int workers = 0)
+        {
+            if (workerCount > 0) return;
+            workerCount = NativePlatform.native_jobs_init(workers);
+            Console.WriteLine($"Job system: {workerCount} workers");
+        }
+
+        /// <summary>Runs what is still queued, then stops the workers. Main thread only.</summary>
+        public static void Shutdown()
+        {
+            if (workerCount == 0) return;
+            NativePlatform.native_jobs_shutdown();
+            workerCount = 0;
+        }
+
+        /// <summary>Workers including the main thread; 1 before Initialize (jobs then run inline)</summary>
+        public static int WorkerCount => Math.Max(1, workerCount);
+
+        /// <summary>0 on the main thread, 1.. on workers, -1 elsewhere</summary>
+        public static int CurrentWorker => NativePlatform.native_jobs_current_worker();
+
+        public static bool IsMainThread => CurrentWorker == 0;
+
+        [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
+        private static void Execute(IntPtr data, int index)
+        {
+            GCHandle handle = GCHandle.FromIntPtr(data);
+            var payload = (JobPayload)handle.Target;
+            try
+            {
+                payload.Run(index);
+            }
+            catch (Exception e)
+            {
+                // Exceptions cannot unwind through native frames
+                payload.Fail(e);
+            }
+            finally
+            {
+                if (payload.OneShot)
+                    handle.Free();
+            }
+        }
+
+        /// <summary>
+        /// Queues an action. With a counter, the counter stays above zero until it (and any job it
+        /// submits without a counter of its own) has run. Exceptions are logged, not rethrown.
+        /// </summary>
+        public static void Run(Action action, JobCounter counter = null, JobPin pin = JobPin.Any)
+        {
+            IntPtr data = GCHandle.ToIntPtr(GCHandle.Alloc(new ActionJob(action)));
+            NativePlatform.native_job_submit(trampoline, data, 0,
+                counter?.handle ?? IntPtr.Zero, (int)pin);
+        }
+
+        /// <summary>Queues a native function, called as fn(data, index) with no managed transition</summary>
+        public static void Run(delegate* unmanaged[Cdecl]<IntPtr, int, void> fn, IntPtr data, int index = 0,
+            JobCounter counter = null, JobPin pin = JobPin.Any)
+        {
+            NativePlatform.native_job_submit((IntPtr)fn, data, index,
+                counter?.handle ?? IntPtr.Zero, (int)pin);
+        }
+
+        /// <summary>
+        /// Runs body(0..count-1) across the workers and returns when all are done; the caller
+        /// takes part. The first exception thrown by body is rethrown here.
+        /// </summary>
+        public static void ParallelFor(int count, Action<int> body)
+        {
+            if (count <= 0) return;
+            if (count == 1 || workerCount <= 1)
+            {
+                for (int i = 0; i < count; i++)
+                    body(i);
+                return;
+            }
+
+            int batches = Math.Min(count, workerCount * BatchesPerWorker);
+            var job = new ParallelForJob(body, count, batches);
+            GCHandle handle = GCHandle.Alloc(job);
+            using (var counter = new JobCounter())
+            {
+                NativePlatform.native_job_submit_range(trampoline, GCHandle.ToIntPtr(handle), batches, counter.handle);
+                counter.Wait();
+            }
+            handle.Free();
+            job.ThrowIfFailed();
+        }
+
+        /// <summary>
+        /// Runs one queued job on this thread if any; for loops that wait on other things.
+        /// On the main thread this skips JobPin.Background jobs.
+        /// </summary>
+        public static bool TryRunOne() => workerCount > 0 && NativePlatform.native_jobs_try_run() == 1;
+
+        /// <summary>
+        /// Runs jobs pinned to the main thread, for up to maxMs (0 = all). Engine.Update calls this.
+        /// </summary>
+        public static int RunMainThreadJobs(double maxMs = 0)
+        {
+            if (workerCount == 0) return 0;
+            return NativePlatform.native_jobs_run_main(maxMs);
+        }
+
+        public static JobStats GetStats()
+        {
+            NativePlatform.native_jobs_get_stats(out JobStats stats);
+            return stats;
+        }
+    }
+}
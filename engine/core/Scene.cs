@@ -0,0 +1,732 @@
+/*
+ * PyFlare Engine - Scene Storage
+ * Archetype/SoA entity store with chunked component columns, and the Node tree on top
+ * Component data stays in contiguous native chunks so systems stream over it
+ */
+
+using System;
+using System.Collections.Generic;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+
+namespace PyFlare.Engine.Core
+{
+    // ============================================================================
+    // COMPONENTS
+    // ============================================================================
+
+    public struct Transform2D
+    {
+        public Vector2 Position;
+        public Vector2 Scale;
+        public float Rotation;
+
+        public static Transform2D Identity => new Transform2D { Scale = Vector2.One };
+    }
+
+    public struct Velocity2D
+    {
+        public Vector2 Linear;
+        public float Angular;
+    }
+
+    public struct SpriteComponent
+    {
+        public Vector2 Size;
+        public Vector4 UV;         // u0, v0, u1, v1
+        public uint Color;         // packed 0xAABBGGRR (R in the low byte, GL byte order), see SpriteInstance.PackColor
+        public uint Texture;
+        public uint Shader;
+        public int Layer;
+    }
+
+    /// <summary>
+    /// Process-wide numbering of component types. Ids index a 64-bit archetype mask,
+    /// so at most 64 component types can exist.
+    /// </summary>
+    public static class ComponentRegistry
+    {
+        public const int MaxComponents = 64;
+
+        private static readonly object registerLock = new object();
+        private static readonly int[] sizes = new int[MaxComponents];
+        private static readonly Type[] types = new Type[MaxComponents];
+        private static int count = 0;
+
+        internal static int Register(Type type, int size)
+        {
+            lock (registerLock)
+            {
+                if (count == MaxComponents)
+                    throw new InvalidOperationException($"Too many component types (max {MaxComponents}): {type.Name}");
+                // A row of one column padded to 16 bytes must fit in a chunk
+                if (size > World.ChunkBytes - 16)
+                    throw new InvalidOperationException(
+                        $"Component {type.Name} is {size} bytes; the limit is {World.ChunkBytes - 16}");
+                sizes[count] = size;
+                types[count] = type;
+                return count++;
+            }
+        }
+
+        public static int GetSize(int id) => sizes[id];
+        public static Type GetType(int id) => types[id];
+        public static int Count => count;
+    }
+
+    public static class ComponentType<T> where T : unmanaged
+    {
+        public static readonly int Id = ComponentRegistry.Register(typeof(T), Unsafe.SizeOf<T>());
+        public static readonly ulong Bit = 1UL << Id;
+    }
+
+    // ============================================================================
+    // ENTITIES AND ARCHETYPES
+    // ============================================================================
+
+    public readonly struct Entity : IEquatable<Entity>
+    {
+        public readonly int Index;
+        public readonly uint Generation;
+
+        internal Entity(int index, uint generation)
+        {
+            Index = index;
+            Generation = generation;
+        }
+
+        public static Entity Null => default;
+        public bool IsNull => Generation == 0;
+
+        public bool Equals(Entity other) => Index == other.Index && Generation == other.Generation;
+        public override bool Equals(object obj) => obj is Entity other && Equals(other);
+        public override int GetHashCode() => Index ^ (int)(Generation << 20);
+        public override string ToString() => $"Entity({Index}:{Generation})";
+    }
+
+    /// <summary>
+    /// One fixed-size block holding up to Capacity rows of an archetype. Each component
+    /// is a contiguous column inside the block.
+    /// </summary>
+    public sealed class Chunk
+    {
+        public readonly Archetype Archetype;
+        internal readonly PoolBlock block;
+        internal readonly int[] entities;   // entity index per row
+        internal int count;
+
+        internal Chunk(Archetype archetype, PoolBlock block)
+        {
+            Archetype = archetype;
+            this.block = block;
+            entities = new int[archetype.Capacity];
+            count = 0;
+        }
+
+        public int Count => count;
+
+        public unsafe Span<T> GetSpan<T>() where T : unmanaged
+        {
+            int column = Archetype.ColumnOf(ComponentType<T>.Id);
+            if (column < 0)
+                return Span<T>.Empty;
+            return new Span<T>((byte*)block.Pointer + Archetype.offsets[column], count);
+        }
+
+        internal unsafe byte* RowPointer(int column, int row)
+        {
+            return (byte*)block.Pointer + Archetype.offsets[column] + row * Archetype.sizes[column];
+        }
+    }
+
+    /// <summary>
+    /// All entities with exactly the same component set. Rows are kept dense: removing a row
+    /// moves the archetype's last row into the hole.
+    /// </summary>
+    public sealed class Archetype
+    {
+        public readonly ulong Mask;
+        internal readonly int[] components;   // component ids in ascending order
+        internal readonly int[] offsets;      // column byte offset within a chunk
+        internal readonly int[] sizes;
+        private readonly sbyte[] columnOf = new sbyte[ComponentRegistry.MaxComponents];
+        internal readonly List<Chunk> chunks = new List<Chunk>();
+        public readonly int Capacity;
+        private int entityCount;
+
+        internal Archetype(ulong mask, int chunkBytes)
+        {
+            Mask = mask;
+            int n = BitOperations.PopCount(mask);
+            components = new int[n];
+            offsets = new int[n];
+            sizes = new int[n];
+
+            int rowBytes = 0;
+            int column = 0;
+            for (int id = 0; id < ComponentRegistry.MaxComponents; id++)
+            {
+                columnOf[id] = -1;
+                if ((mask & (1UL << id)) == 0)
+                    continue;
+                components[column] = id;
+                sizes[column] = ComponentRegistry.GetSize(id);
+                columnOf[id] = (sbyte)column;
+                rowBytes += sizes[column];
+                column++;
+            }
+
+            // Leave room for each column to start on a 16-byte boundary
+            Capacity = rowBytes == 0 ? 1024 : (chunkBytes - 16 * n) / rowBytes;
+            if (Capacity < 1)
+                throw new InvalidOperationException(
+                    $"Archetype rows are {rowBytes} bytes across {n} components; a {chunkBytes} byte chunk can't hold one");
+
+            int offset = 0;
+            for (int c = 0; c < n; c++)
+            {
+                offsets[c] = offset;
+                offset = (offset + sizes[c] * Capacity + 15) & ~15;
+            }
+        }
+
+        public int ColumnOf(int componentId) => columnOf[componentId];
+        public bool Has(int componentId) => columnOf[componentId] >= 0;
+        public int EntityCount => entityCount;
+        public IReadOnlyList<Chunk> Chunks => chunks;
+
+        internal Chunk AllocateRow(World world, out int row)
+        {
+            Chunk last = chunks.Count > 0 ? chunks[chunks.Count - 1] : null;
+            if (last == null || last.count == Capacity)
+            {
+                last = new Chunk(this, world.AllocateChunk());
+                chunks.Add(last);
+            }
+            row = last.count++;
+            entityCount++;
+            return last;
+        }
+
+        /// <summary>
+        /// Fills (chunk, row) with the archetype's last row. Returns the entity index that moved,
+        /// or -1 if the removed row was itself the last one.
+        /// </summary>
+        internal unsafe int RemoveRow(World world, Chunk chunk, int row)
+        {
+            Chunk last = chunks[chunks.Count - 1];
+            int lastRow = last.count - 1;
+            int moved = -1;
+
+            if (last != chunk || lastRow != row)
+            {
+                for (int c = 0; c < components.Length; c++)
+                    Buffer.MemoryCopy(last.RowPointer(c, lastRow), chunk.RowPointer(c, row), sizes[c], sizes[c]);
+                moved = last.entities[lastRow];
+                chunk.entities[row] = moved;
+            }
+
+            last.count--;
+            entityCount--;
+            if (last.count == 0)
+            {
+                chunks.RemoveAt(chunks.Count - 1);
+                world.FreeChunk(last.block);
+            }
+            return moved;
+        }
+
+        internal void Release(World world)
+        {
+            foreach (Chunk chunk in chunks)
+                world.FreeChunk(chunk.block);
+            chunks.Clear();
+            entityCount = 0;
+        }
+    }
+
+    // ============================================================================
+    // WORLD
+    // ============================================================================
+
+    public delegate void ChunkAction<T1>(Span<T1> a) where T1 : unmanaged;
+    public delegate void ChunkAction<T1, T2>(Span<T1> a, Span<T2> b) where T1 : unmanaged where T2 : unmanaged;
+    public delegate void ChunkAction<T1, T2, T3>(Span<T1> a, Span<T2> b, Span<T3> c)
+        where T1 : unmanaged where T2 : unmanaged where T3 : unmanaged;
+
+    /// <summary>
+    /// Entity and component storage. Component types must be unmanaged structs; anything that
+    /// needs managed references belongs on a Node. Not thread-safe, and entities must not gain
+    /// or lose components while a query over their archetype is running.
+    /// </summary>
+    public class World : IDisposable
+    {
+        public const int ChunkBytes = 16 * 1024;
+
+        private struct EntityRecord
+        {
+            public Archetype archetype;
+            public Chunk chunk;
+            public int row;
+            public uint generation;
+            public int nextFree;
+        }
+
+        private readonly MemoryPool chunkPool;
+        private readonly Dictionary<ulong, Archetype> archetypes = new Dictionary<ulong, Archetype>();
+        private readonly List<Archetype> archetypeList = new List<Archetype>();
+        private EntityRecord[] records = new EntityRecord[1024];
+        private int highWater = 0;
+        private int freeHead = -1;
+        private int aliveCount = 0;
+
+        public World(int initialChunks = 8)
+        {
+            chunkPool = new MemoryPool(ChunkBytes, initialChunks);
+        }
+
+        internal PoolBlock AllocateChunk() => chunkPool.Allocate();
+        internal void FreeChunk(PoolBlock block) => chunkPool.Free(block);
+
+        public Archetype GetArchetype(ulong mask)
+        {
+            if (!archetypes.TryGetValue(mask, out Archetype archetype))
+            {
+                archetype = new Archetype(mask, ChunkBytes);
+                archetypes[mask] = archetype;
+                archetypeList.Add(archetype);
+            }
+            return archetype;
+        }
+
+        public int ArchetypeCount => archetypeList.Count;
+        public int EntityCount => aliveCount;
+
+        // Entity lifetime
+
+        private Entity Place(Archetype archetype)
+        {
+            int index;
+            if (freeHead >= 0)
+            {
+                index = freeHead;
+                freeHead = records[index].nextFree;
+            }
+            else
+            {
+                if (highWater == records.Length)
+                    Array.Resize(ref records, records.Length * 2);
+                index = highWater++;
+                records[index].generation = 1;
+            }
+
+            ref EntityRecord rec = ref records[index];
+            Chunk chunk = archetype.AllocateRow(this, out int row);
+            chunk.entities[row] = index;
+            rec.archetype = archetype;
+            rec.chunk = chunk;
+            rec.row = row;
+            rec.nextFree = -1;
+            aliveCount++;
+            return new Entity(index, rec.generation);
+        }
+
+        public Entity CreateEntity() => Place(GetArchetype(0));
+
+        public Entity CreateEntity<T1>(in T1 a) where T1 : unmanaged
+        {
+            Entity e = Place(GetArchetype(ComponentType<T1>.Bit));
+            Write(e, a);
+            return e;
+        }
+
+        public Entity CreateEntity<T1, T2>(in T1 a, in T2 b) where T1 : unmanaged where T2 : unmanaged
+        {
+            Entity e = Place(GetArchetype(ComponentType<T1>.Bit | ComponentType<T2>.Bit));
+            Write(e, a);
+            Write(e, b);
+            return e;
+        }
+
+        public Entity CreateEntity<T1, T2, T3>(in T1 a, in T2 b, in T3 c)
+            where T1 : unmanaged where T2 : unmanaged where T3 : unmanaged
+        {
+            Entity e = Place(GetArchetype(ComponentType<T1>.Bit | ComponentType<T2>.Bit | ComponentType<T3>.Bit));
+            Write(e, a);
+            Write(e, b);
+            Write(e, c);
+            return e;
+        }
+
+        /// <summary>Where the live entity in slot index is stored; false if the slot is free</summary>
+        internal bool TryLocate(int index, out Chunk chunk, out int row)
+        {
+            if ((uint)index >= (uint)highWater || records[index].archetype == null)
+            {
+                chunk = null;
+                row = 0;
+                return false;
+            }
+            chunk = records[index].chunk;
+            row = records[index].row;
+            return true;
+        }
+
+        public bool IsAlive(Entity entity)
+        {
+            return (uint)entity.Index < (uint)highWater && records[entity.Index].generation == entity.Generation
+                && records[entity.Index].archetype != null;
+        }
+
+        public void DestroyEntity(Entity entity)
+        {
+            if (!IsAlive(entity))
+                return;
+
+            ref EntityRecord rec = ref records[entity.Index];
+            int moved = rec.archetype.RemoveRow(this, rec.chunk, rec.row);
+            if (moved >= 0)
+            {
+                records[moved].chunk = rec.chunk;
+                records[moved].row = rec.row;
+            }
+
+            rec.archetype = null;
+            rec.chunk = null;
+            uint next = rec.generation + 1;
+            rec.generation = next == 0 ? 1u : next;
+            rec.nextFree = freeHead;
+            freeHead = entity.Index;
+            aliveCount--;
+        }
+
+        // Component access
+
+        public bool Has<T>(Entity entity) where T : unmanaged
+        {
+            return IsAlive(entity) && records[entity.Index].archetype.Has(ComponentType<T>.Id);
+        }
+
+        /// <summary>
+        /// Reference into the component column. Valid until the entity's component set changes.
+        /// </summary>
+        public unsafe ref T Get<T>(Entity entity) where T : unmanaged
+        {
+            if (!IsAlive(entity))
+                throw new InvalidOperationException($"{entity} is not alive");
+
+            ref EntityRecord rec = ref records[entity.Index];
+            int column = rec.archetype.ColumnOf(ComponentType<T>.Id);
+            if (column < 0)
+                throw new InvalidOperationException($"{entity} has no {typeof(T).Name}");
+            return ref Unsafe.AsRef<T>(rec.chunk.RowPointer(column, rec.row));
+        }
+
+        private unsafe void Write<T>(Entity entity, in T value) where T : unmanaged
+        {
+            ref EntityRecord rec = ref records[entity.Index];
+            int column = rec.archetype.ColumnOf(ComponentType<T>.Id);
+            *(T*)rec.chunk.RowPointer(column, rec.row) = value;
+        }
+
+        public void Add<T>(Entity entity, in T value) where T : unmanaged
+        {
+            if (!IsAlive(entity))
+                return;
+
+            ulong mask = records[entity.Index].archetype.Mask;
+            if ((mask & ComponentType<T>.Bit) == 0)
+                Move(entity.Index, GetArchetype(mask | ComponentType<T>.Bit));
+            Write(entity, value);
+        }
+
+        public void Remove<T>(Entity entity) where T : unmanaged
+        {
+            if (!IsAlive(entity))
+                return;
+
+            ulong mask = records[entity.Index].archetype.Mask;
+            if ((mask & ComponentType<T>.Bit) != 0)
+                Move(entity.Index, GetArchetype(mask & ~ComponentType<T>.Bit));
+        }
+
+        private unsafe void Move(int index, Archetype target)
+        {
+            ref EntityRecord rec = ref records[index];
+            Archetype source = rec.archetype;
+
+            Chunk chunk = target.AllocateRow(this, out int row);
+            chunk.entities[row] = index;
+
+            // Copy the columns both archetypes share
+            for (int c = 0; c < target.components.Length; c++)
+            {
+                int sourceColumn = source.ColumnOf(target.components[c]);
+                if (sourceColumn >= 0)
+                {
+                    int size = target.sizes[c];
+                    Buffer.MemoryCopy(rec.chunk.RowPointer(sourceColumn, rec.row), chunk.RowPointer(c, row), size, size);
+                }
+                else
+                {
+                    new Span<byte>(chunk.RowPointer(c, row), target.sizes[c]).Clear();
+                }
+            }
+
+            int moved = source.RemoveRow(this, rec.chunk, rec.row);
+            if (moved >= 0)
+            {
+                records[moved].chunk = rec.chunk;
+                records[moved].row = rec.row;
+            }
+
+            rec.archetype = target;
+            rec.chunk = chunk;
+            rec.row = row;
+        }
+
+        // Queries
+
+        /// <summary>Archetypes containing every component in the mask, appended to result.</summary>
+        public void MatchArchetypes(ulong mask, List<Archetype> result)
+        {
+            foreach (Archetype archetype in archetypeList)
+            {
+                if ((archetype.Mask & mask) == mask)
+                    result.Add(archetype);
+            }
+        }
+
+        public Query CreateQuery(ulong mask) => new Query(this, mask);
+        public Query CreateQuery<T1>() where T1 : unmanaged => new Query(this, ComponentType<T1>.Bit);
+        public Query CreateQuery<T1, T2>() where T1 : unmanaged where T2 : unmanaged
+            => new Query(this, ComponentType<T1>.Bit | ComponentType<T2>.Bit);
+        public Query CreateQuery<T1, T2, T3>() where T1 : unmanaged where T2 : unmanaged where T3 : unmanaged
+            => new Query(this, ComponentType<T1>.Bit | ComponentType<T2>.Bit | ComponentType<T3>.Bit);
+
+        public void Dispose()
+        {
+            foreach (Archetype archetype in archetypeList)
+                archetype.Release(this);
+            archetypes.Clear();
+            archetypeList.Clear();
+            highWater = 0;
+            freeHead = -1;
+            aliveCount = 0;
+            chunkPool.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Cached archetype match for a component mask. The match list is refreshed only when the
+    /// world has created new archetypes since the last run.
+    /// </summary>
+    public sealed class Query
+    {
+        private readonly World world;
+        private readonly List<Archetype> matches = new List<Archetype>();
+        private int seenArchetypes = -1;
+        public readonly ulong Mask;
+
+        internal Query(World world, ulong mask)
+        {
+            this.world = world;
+            Mask = mask;
+        }
+
+        private List<Archetype> Refresh()
+        {
+            if (seenArchetypes != world.ArchetypeCount)
+            {
+                matches.Clear();
+                world.MatchArchetypes(Mask, matches);
+                seenArchetypes = world.ArchetypeCount;
+            }
+            return matches;
+        }
+
+        public int Count()
+        {
+            int total = 0;
+            foreach (Archetype archetype in Refresh())
+                total += archetype.EntityCount;
+            return total;
+        }
+
+        public void ForEachChunk(Action<Chunk> action)
+        {
+            foreach (Archetype archetype in Refresh())
+            {
+                foreach (Chunk chunk in archetype.chunks)
+                    action(chunk);
+            }
+        }
+
+        public void ForEach<T1>(ChunkAction<T1> action) where T1 : unmanaged
+        {
+            foreach (Archetype archetype in Refresh())
+            {
+                foreach (Chunk chunk in archetype.chunks)
+                    action(chunk.GetSpan<T1>());
+            }
+        }
+
+        public void ForEach<T1, T2>(ChunkAction<T1, T2> action) where T1 : unmanaged where T2 : unmanaged
+        {
+            foreach (Archetype archetype in Refresh())
+            {
+                foreach (Chunk chunk in archetype.chunks)
+                    action(chunk.GetSpan<T1>(), chunk.GetSpan<T2>());
+            }
+        }
+
+        public void ForEach<T1, T2, T3>(ChunkAction<T1, T2, T3> action)
+            where T1 : unmanaged where T2 : unmanaged where T3 : unmanaged
+        {
+            foreach (Archetype archetype in Refresh())
+            {
+                foreach (Chunk chunk in archetype.chunks)
+                    action(chunk.GetSpan<T1>(), chunk.GetSpan<T2>(), chunk.GetSpan<T3>());
+            }
+        }
+
+        // Matching chunks flattened for ParallelForEach; reused between calls
+        private readonly List<Chunk> parallelChunks = new List<Chunk>();
+
+        private List<Chunk> CollectChunks()
+        {
+            parallelChunks.Clear();
+            foreach (Archetype archetype in Refresh())
+                parallelChunks.AddRange(archetype.chunks);
+            return parallelChunks;
+        }
+
+        /// <summary>
+        /// ForEach with one job per chunk. The action must only touch the spans it is given;
+        /// structural changes (create, destroy, add, remove) are not allowed until it returns.
+        /// </summary>
+        public void ParallelForEach<T1>(ChunkAction<T1> action) where T1 : unmanaged
+        {
+            List<Chunk> chunks = CollectChunks();
+            Jobs.ParallelFor(chunks.Count, i => action(chunks[i].GetSpan<T1>()));
+        }
+
+        public void ParallelForEach<T1, T2>(ChunkAction<T1, T2> action) where T1 : unmanaged where T2 : unmanaged
+        {
+            List<Chunk> chunks = CollectChunks();
+            Jobs.ParallelFor(chunks.Count, i => action(chunks[i].GetSpan<T1>(), chunks[i].GetSpan<T2>()));
+        }
+
+        public void ParallelForEach<T1, T2, T3>(ChunkAction<T1, T2, T3> action)
+            where T1 : unmanaged where T2 : unmanaged where T3 : unmanaged
+        {
+            List<Chunk> chunks = CollectChunks();
+            Jobs.ParallelFor(chunks.Count,
+                i => action(chunks[i].GetSpan<T1>(), chunks[i].GetSpan<T2>(), chunks[i].GetSpan<T3>()));
+        }
+    }
+
+    /// <summary>
+    /// Stock systems over the built-in components
+    /// </summary>
+    public static class SceneSystems
+    {
+        public static void IntegrateVelocities(Query query, float dt)
+        {
+            query.ParallelForEach((Span<Transform2D> transforms, Span<Velocity2D> velocities) =>
+            {
+                for (int i = 0; i < transforms.Length; i++)
+                {
+                    transforms[i].Position += velocities[i].Linear * dt;
+                    transforms[i].Rotation += velocities[i].Angular * dt;
+                }
+            });
+        }
+    }
+
+    // ============================================================================
+    // SCENE TREE
+    // ============================================================================
+
+    /// <summary>
+    /// Scriptable scene object backed by an entity. Hierarchy, names and scripts live here;
+    /// per-frame data lives in the entity's components.
+    /// </summary>
+    public class Node : PyFlareObject
+    {
+        protected readonly World world;
+        protected Entity entity;
+        protected string name;
+        protected Node parent;
+        protected List<Node> children;   // created on first AddChild
+
+        public Node(World world, string name = "Node")
+        {
+            this.world = world;
+            this.name = name;
+            entity = world.CreateEntity(Transform2D.Identity);
+        }
+
+        public World GetWorld() => world;
+        public Entity GetEntity() => entity;
+        public string GetName() => name;
+        public void SetName(string value) => name = value;
+
+        // Components
+        public ref T Get<T>() where T : unmanaged => ref world.Get<T>(entity);
+        public bool Has<T>() where T : unmanaged => world.Has<T>(entity);
+        public void Add<T>(in T value) where T : unmanaged => world.Add(entity, value);
+        public void Remove<T>() where T : unmanaged => world.Remove<T>(entity);
+
+        public Vector2 Position
+        {
+            get => world.Get<Transform2D>(entity).Position;
+            set => world.Get<Transform2D>(entity).Position = value;
+        }
+
+        public float Rotation
+        {
+            get => world.Get<Transform2D>(entity).Rotation;
+            set => world.Get<Transform2D>(entity).Rotation = value;
+        }
+
+        // Hierarchy
+        public Node GetParent() => parent;
+        public int GetChildCount() => children?.Count ?? 0;
+        public Node GetChild(int index) => children[index];
+
+        public void AddChild(Node child)
+        {
+            if (child == null || child == this)
+                return;
+            child.parent?.RemoveChild(child);
+            children ??= new List<Node>();
+            children.Add(child);
+            child.parent = this;
+        }
+
+        public void RemoveChild(Node child)
+        {
+            if (children != null && children.Remove(child))
+                child.parent = null;
+        }
+
+        protected override void Cleanup()
+        {
+            if (children != null)
+            {
+                foreach (Node child in children)
+                {
+                    child.parent = null;
+                    child.Unreference();
+                }
+                children = null;
+            }
+            parent?.children?.Remove(this);
+            parent = null;
+            world.DestroyEntity(entity);
+            entity = Entity.Null;
+            base.Cleanup();
+        }
+    }
+}
@@ -0,0 +1,995 @@
+/*
+ * PyFlare Engine - Spatial Partitioning
+ * Loose grid for 2D and dynamic AABB tree for 3D, both updated in place as things move,
+ * with view culling that tests bounds four at a time (SSE2 / NEON)
+ */
+
+using System;
+using System.Collections.Generic;
+using System.Numerics;
+using System.Runtime.InteropServices;
+using System.Runtime.Intrinsics;
+
+namespace PyFlare.Engine.Core
+{
+    // ============================================================================
+    // BOUNDS
+    // ============================================================================
+
+    public struct Aabb2
+    {
+        public Vector2 Min;
+        public Vector2 Max;
+
+        public Aabb2(Vector2 min, Vector2 max)
+        {
+            Min = min;
+            Max = max;
+        }
+
+        public static Aabb2 FromCenter(Vector2 center, Vector2 halfExtents) =>
+            new Aabb2(center - halfExtents, center + halfExtents);
+
+        public Vector2 Center => (Min + Max) * 0.5f;
+        public Vector2 HalfExtents => (Max - Min) * 0.5f;
+
+        public bool Overlaps(in Aabb2 other) =>
+            Min.X <= other.Max.X && Max.X >= other.Min.X && Min.Y <= other.Max.Y && Max.Y >= other.Min.Y;
+
+        public bool Contains(in Aabb2 other) =>
+            Min.X <= other.Min.X && Min.Y <= other.Min.Y && Max.X >= other.Max.X && Max.Y >= other.Max.Y;
+    }
+
+    public struct Aabb3
+    {
+        public Vector3 Min;
+        public Vector3 Max;
+
+        public Aabb3(Vector3 min, Vector3 max)
+        {
+            Min = min;
+            Max = max;
+        }
+
+        public static Aabb3 FromCenter(Vector3 center, Vector3 halfExtents) =>
+            new Aabb3(center - halfExtents, center + halfExtents);
+
+        public static Aabb3 Union(in Aabb3 a, in Aabb3 b) =>
+            new Aabb3(Vector3.Min(a.Min, b.Min), Vector3.Max(a.Max, b.Max));
+
+        public bool Contains(in Aabb3 other) =>
+            Min.X <= other.Min.X && Min.Y <= other.Min.Y && Min.Z <= other.Min.Z &&
+            Max.X >= other.Max.X && Max.Y >= other.Max.Y && Max.Z >= other.Max.Z;
+
+        /// <summary>Half the surface area; the tree's insertion cost</summary>
+        public float Perimeter
+        {
+            get
+            {
+                Vector3 d = Max - Min;
+                return d.X * d.Y + d.Y * d.Z + d.Z * d.X;
+            }
+        }
+    }
+
+    public enum Containment
+    {
+        Outside,
+        Intersects,
+        Inside
+    }
+
+    /// <summary>
+    /// Six inward-facing planes (xyz = normal, w = distance); a point p is inside when
+    /// dot(normal, p) + w >= 0 for every plane.
+    /// </summary>
+    public struct Frustum
+    {
+        public const int PlaneCount = 6;
+
+        public Vector4 Left, Right, Bottom, Top, Near, Far;
+
+        /// <summary>
+        /// Planes of a System.Numerics view-projection matrix (row vectors, depth 0..1 as
+        /// produced by Matrix4x4.CreatePerspectiveFieldOfView)
+        /// </summary>
+        public static Frustum FromViewProjection(in Matrix4x4 m)
+        {
+            var c1 = new Vector4(m.M11, m.M21, m.M31, m.M41);
+            var c2 = new Vector4(m.M12, m.M22, m.M32, m.M42);
+            var c3 = new Vector4(m.M13, m.M23, m.M33, m.M43);
+            var c4 = new Vector4(m.M14, m.M24, m.M34, m.M44);
+
+            return new Frustum
+            {
+                Left = Normalize(c4 + c1),
+                Right = Normalize(c4 - c1),
+                Bottom = Normalize(c4 + c2),
+                Top = Normalize(c4 - c2),
+                Near = Normalize(c3),
+                Far = Normalize(c4 - c3)
+            };
+        }
+
+        private static Vector4 Normalize(Vector4 plane)
+        {
+            float length = new Vector3(plane.X, plane.Y, plane.Z).Length();
+            return length > 0 ? plane / length : plane;
+        }
+
+        public Vector4 GetPlane(int index) => index switch
+        {
+            0 => Left,
+            1 => Right,
+            2 => Bottom,
+            3 => Top,
+            4 => Near,
+            _ => Far
+        };
+
+        public Containment Classify(in Aabb3 box)
+        {
+            Containment result = Containment.Inside;
+            for (int i = 0; i < PlaneCount; i++)
+            {
+                Vector4 p = GetPlane(i);
+                // Corner furthest along the normal, and the one opposite it
+                float far = p.W + p.X * (p.X >= 0 ? box.Max.X : box.Min.X)
+                                + p.Y * (p.Y >= 0 ? box.Max.Y : box.Min.Y)
+                                + p.Z * (p.Z >= 0 ? box.Max.Z : box.Min.Z);
+                if (far < 0)
+                    return Containment.Outside;
+                float near = p.W + p.X * (p.X >= 0 ? box.Min.X : box.Max.X)
+                                 + p.Y * (p.Y >= 0 ? box.Min.Y : box.Max.Y)
+                                 + p.Z * (p.Z >= 0 ? box.Min.Z : box.Max.Z);
+                if (near < 0)
+                    result = Containment.Intersects;
+            }
+            return result;
+        }
+    }
+
+    // ============================================================================
+    // CULL OUTPUT
+    // ============================================================================
+
+    /// <summary>
+    /// Values of the items a cull found visible, in no particular order. Reuse one per view.
+    /// </summary>
+    public sealed class VisibleSet
+    {
+        internal int[] values = new int[256];
+        internal int count;
+
+        public int Count => count;
+        public ReadOnlySpan<int> Values => new ReadOnlySpan<int>(values, 0, count);
+        public void Clear() => count = 0;
+
+        internal void Reserve(int extra)
+        {
+            if (count + extra > values.Length)
+                Array.Resize(ref values, Math.Max(values.Length * 2, count + extra));
+        }
+
+        internal void Add(int value)
+        {
+            if (count == values.Length)
+                Array.Resize(ref values, values.Length * 2);
+            values[count++] = value;
+        }
+    }
+
+    public struct CullStats
+    {
+        public int Visited;      // cells or nodes looked at
+        public int Accepted;     // cells or subtrees that were entirely visible
+        public int Tested;       // items whose own bounds were tested
+        public int Visible;
+    }
+
+    // ============================================================================
+    // LOOSE GRID (2D)
+    // ============================================================================
+
+    /// <summary>
+    /// Uniform hash grid in which an item lives in the cell holding its center. Cells are
+    /// loose (their bounds reach half a cell past their edges), so an item up to one cell wide
+    /// never straddles; larger items go to a list that every cull tests. Each cell keeps its
+    /// bounds in blocks of four (four minX, four minY, four maxX, four maxY), so culling loads
+    /// one block per SIMD test and an update touches a single cache line.
+    /// Not thread-safe; Insert, Update and Remove must not overlap a Cull.
+    /// </summary>
+    public sealed class SpatialGrid2D
+    {
+        private sealed class Cell
+        {
+            public float[] bounds;      // 16 floats per block of four items
+            public int[] values;
+            public int[] proxies;
+            public int count;
+            public Aabb2 loose;
+
+            public Cell(int capacity, Aabb2 loose)
+            {
+                bounds = new float[capacity * 4];
+                values = new int[capacity];
+                proxies = new int[capacity];
+                this.loose = loose;
+            }
+
+            public void Grow()
+            {
+                int capacity = values.Length * 2;
+                Array.Resize(ref bounds, capacity * 4);
+                Array.Resize(ref values, capacity);
+                Array.Resize(ref proxies, capacity);
+            }
+
+            public void SetBounds(int slot, in Aabb2 b)
+            {
+                int i = (slot & ~3) * 4 + (slot & 3);
+                bounds[i] = b.Min.X;
+                bounds[i + 4] = b.Min.Y;
+                bounds[i + 8] = b.Max.X;
+                bounds[i + 12] = b.Max.Y;
+            }
+
+            public void MoveSlot(int from, int to)
+            {
+                int src = (from & ~3) * 4 + (from & 3);
+                int dst = (to & ~3) * 4 + (to & 3);
+                bounds[dst] = bounds[src];
+                bounds[dst + 4] = bounds[src + 4];
+                bounds[dst + 8] = bounds[src + 8];
+                bounds[dst + 12] = bounds[src + 12];
+                values[to] = values[from];
+                proxies[to] = proxies[from];
+            }
+        }
+
+        // long.GetHashCode folds the halves together, so (cx, cy) keys near the diagonal
+        // would all collide; mix the bits instead
+        private sealed class KeyComparer : IEqualityComparer<long>
+        {
+            public bool Equals(long a, long b) => a == b;
+            public int GetHashCode(long key)
+            {
+                ulong h = (ulong)key * 0x9E3779B97F4A7C15UL;
+                return (int)(h >> 32);
+            }
+        }
+
+        private struct Proxy
+        {
+            public int cell;       // -1 while free
+            public int slot;
+            public int nextFree;
+            public long key;       // cell coordinates, or OversizedKey
+        }
+
+        // Below this many candidate items a cull stays on the calling thread
+        private const int ParallelThreshold = 8192;
+        private const int CellsPerJob = 16;
+        private const int OversizedCell = 0;
+        private const long OversizedKey = long.MinValue;
+
+        private readonly float cellSize;
+        private readonly float invCellSize;
+        private readonly List<Cell> cells = new List<Cell>();
+        private readonly Dictionary<long, int> cellLookup = new Dictionary<long, int>(new KeyComparer());
+        private Proxy[] proxies = new Proxy[1024];
+        private int proxyHighWater = 0;
+        private int freeProxy = -1;
+        private int count = 0;
+
+        // Cull scratch, reused between calls
+        private readonly List<Cell> candidates = new List<Cell>();
+        private readonly List<bool> candidateInside = new List<bool>();
+        private int[][] jobOutput = Array.Empty<int[]>();
+        private int[] jobCounts = Array.Empty<int>();
+
+        public CullStats LastCull;
+
+        /// <summary>cellSize should be about the size of a typical item, and at least the largest common one</summary>
+        public SpatialGrid2D(float cellSize = 128.0f)
+        {
+            if (cellSize <= 0)
+                throw new ArgumentOutOfRangeException(nameof(cellSize));
+            this.cellSize = cellSize;
+            invCellSize = 1.0f / cellSize;
+
+            var everywhere = new Aabb2(new Vector2(float.MinValue), new Vector2(float.MaxValue));
+            cells.Add(new Cell(64, everywhere));
+        }
+
+        public int Count => count;
+        public int CellCount => cells.Count - 1;
+        public float CellSize => cellSize;
+
+        private static long Key(int cx, int cy) => ((long)cx << 32) | (uint)cy;
+
+        private long KeyFor(in Aabb2 bounds)
+        {
+            Vector2 half = bounds.HalfExtents;
+            if (!(half.X <= cellSize * 0.5f && half.Y <= cellSize * 0.5f))   // NaN goes here too
+                return OversizedKey;
+
+            Vector2 center = bounds.Center;
+            return Key((int)MathF.Floor(center.X * invCellSize), (int)MathF.Floor(center.Y * invCellSize));
+        }
+
+        private int CellFor(long key)
+        {
+            if (key == OversizedKey)
+                return OversizedCell;
+            if (cellLookup.TryGetValue(key, out int index))
+                return index;
+
+            int cx = (int)(key >> 32);
+            int cy = (int)key;
+            float pad = cellSize * 0.5f;
+            var loose = new Aabb2(
+                new Vector2(cx * cellSize - pad, cy * cellSize - pad),
+                new Vector2((cx + 1) * cellSize + pad, (cy + 1) * cellSize + pad));
+            index = cells.Count;
+            cells.Add(new Cell(16, loose));
+            cellLookup[key] = index;
+            return index;
+        }
+
+        private void Place(int proxy, long key, in Aabb2 bounds, int value)
+        {
+            int cellIndex = CellFor(key);
+            Cell cell = cells[cellIndex];
+            if (cell.count == cell.values.Length)
+                cell.Grow();
+
+            int slot = cell.count++;
+            cell.SetBounds(slot, bounds);
+            cell.values[slot] = value;
+            cell.proxies[slot] = proxy;
+            proxies[proxy].cell = cellIndex;
+            proxies[proxy].slot = slot;
+            proxies[proxy].key = key;
+        }
+
+        // Swap-remove keeps every cell dense
+        private void Unplace(int proxy)
+        {
+            Cell cell = cells[proxies[proxy].cell];
+            int slot = proxies[proxy].slot;
+            int last = --cell.count;
+            if (slot != last)
+            {
+                cell.MoveSlot(last, slot);
+                proxies[cell.proxies[slot]].slot = slot;
+            }
+        }
+
+        /// <summary>Adds an item; value comes back from Cull. Returns the proxy for Update/Remove.</summary>
+        public int Insert(in Aabb2 bounds, int value)
+        {
+            int proxy;
+            if (freeProxy >= 0)
+            {
+                proxy = freeProxy;
+                freeProxy = proxies[proxy].nextFree;
+            }
+            else
+            {
+                if (proxyHighWater == proxies.Length)
+                    Array.Resize(ref proxies, proxies.Length * 2);
+                proxy = proxyHighWater++;
+            }
+
+            Place(proxy, KeyFor(bounds), bounds, value);
+            count++;
+            return proxy;
+        }
+
+        /// <summary>Moves an item. Staying in the same cell is four stores and no lookup.</summary>
+        public void Update(int proxy, in Aabb2 bounds)
+        {
+            if (!IsValid(proxy))
+                return;
+
+            long key = KeyFor(bounds);
+            Cell cell = cells[proxies[proxy].cell];
+            if (key == proxies[proxy].key)
+            {
+                cell.SetBounds(proxies[proxy].slot, bounds);
+                return;
+            }
+
+            int value = cell.values[proxies[proxy].slot];
+            Unplace(proxy);
+            Place(proxy, key, bounds, value);
+        }
+
+        public void Remove(int proxy)
+        {
+            if (!IsValid(proxy))
+                return;
+            Unplace(proxy);
+            proxies[proxy].cell = -1;
+            proxies[proxy].nextFree = freeProxy;
+            freeProxy = proxy;
+            count--;
+        }
+
+        public bool IsValid(int proxy) => (uint)proxy < (uint)proxyHighWater && proxies[proxy].cell >= 0;
+
+        public int GetValue(int proxy) => cells[proxies[proxy].cell].values[proxies[proxy].slot];
+
+        public void Clear()
+        {
+            foreach (Cell cell in cells)
+                cell.count = 0;
+            proxyHighWater = 0;
+            freeProxy = -1;
+            count = 0;
+        }
+
+        /// <summary>
+        /// Replaces result's contents with the values of every item overlapping view. Big views
+        /// are split across the job system by cell.
+        /// </summary>
+        public void Cull(in Aabb2 view, VisibleSet result)
+        {
+            result.Clear();
+            candidates.Clear();
+            candidateInside.Clear();
+            int candidateItems = 0;
+            int accepted = 0;
+
+            void Consider(Cell cell, in Aabb2 v)
+            {
+                if (cell.count == 0 || !cell.loose.Overlaps(v))
+                    return;
+                bool inside = v.Contains(cell.loose);
+                candidates.Add(cell);
+                candidateInside.Add(inside);
+                candidateItems += cell.count;
+                if (inside) accepted++;
+            }
+
+            Consider(cells[OversizedCell], view);
+
+            // Cells whose loose bounds can reach the view; walk every cell instead if that is fewer
+            float pad = cellSize * 0.5f;
+            double x0 = Math.Floor((view.Min.X - pad) * invCellSize), x1 = Math.Floor((view.Max.X + pad) * invCellSize);
+            double y0 = Math.Floor((view.Min.Y - pad) * invCellSize), y1 = Math.Floor((view.Max.Y + pad) * invCellSize);
+            double span = (x1 - x0 + 1) * (y1 - y0 + 1);
+            if (span <= cellLookup.Count)
+            {
+                for (int cy = (int)y0; cy <= (int)y1; cy++)
+                {
+                    for (int cx = (int)x0; cx <= (int)x1; cx++)
+                    {
+                        if (cellLookup.TryGetValue(Key(cx, cy), out int index))
+                            Consider(cells[index], view);
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 1; i < cells.Count; i++)
+                    Consider(cells[i], view);
+            }
+
+            LastCull = new CullStats { Visited = candidates.Count, Accepted = accepted };
+            if (candidates.Count == 0)
+                return;
+
+            if (candidateItems < ParallelThreshold || Jobs.WorkerCount <= 1)
+            {
+                result.Reserve(candidateItems);
+                for (int i = 0; i < candidates.Count; i++)
+                {
+                    if (!candidateInside[i])
+                        LastCull.Tested += candidates[i].count;
+                    result.count = CullCell(candidates[i], candidateInside[i], view, result.values, result.count);
+                }
+            }
+            else
+            {
+                CullParallel(view, result);
+            }
+            LastCull.Visible = result.count;
+        }
+
+        private void CullParallel(Aabb2 view, VisibleSet result)
+        {
+            int jobs = (candidates.Count + CellsPerJob - 1) / CellsPerJob;
+            if (jobOutput.Length < jobs)
+            {
+                Array.Resize(ref jobOutput, jobs);
+                Array.Resize(ref jobCounts, jobs);
+            }
+
+            int tested = 0;
+            for (int j = 0; j < jobs; j++)
+            {
+                int items = 0;
+                int end = Math.Min(candidates.Count, (j + 1) * CellsPerJob);
+                for (int i = j * CellsPerJob; i < end; i++)
+                {
+                    items += candidates[i].count;
+                    if (!candidateInside[i]) tested += candidates[i].count;
+                }
+                if (jobOutput[j] == null || jobOutput[j].Length < items)
+                    jobOutput[j] = new int[Math.Max(items, 64)];
+            }
+            LastCull.Tested = tested;
+
+            Jobs.ParallelFor(jobs, j =>
+            {
+                int written = 0;
+                int end = Math.Min(candidates.Count, (j + 1) * CellsPerJob);
+                for (int i = j * CellsPerJob; i < end; i++)
+                    written = CullCell(candidates[i], candidateInside[i], view, jobOutput[j], written);
+                jobCounts[j] = written;
+            });
+
+            int total = 0;
+            for (int j = 0; j < jobs; j++)
+                total += jobCounts[j];
+            result.Reserve(total);
+            for (int j = 0; j < jobs; j++)
+            {
+                Array.Copy(jobOutput[j], 0, result.values, result.count, jobCounts[j]);
+                result.count += jobCounts[j];
+            }
+        }
+
+        /// <summary>Appends the cell's visible values at output[written]; output has room for the whole cell</summary>
+        private static int CullCell(Cell cell, bool inside, in Aabb2 view, int[] output, int written)
+        {
+            int n = cell.count;
+            if (inside)
+            {
+                Array.Copy(cell.values, 0, output, written, n);
+                return written + n;
+            }
+
+            if (Vector128.IsHardwareAccelerated)
+            {
+                Vector128<float> viewMinX = Vector128.Create(view.Min.X);
+                Vector128<float> viewMinY = Vector128.Create(view.Min.Y);
+                Vector128<float> viewMaxX = Vector128.Create(view.Max.X);
+                Vector128<float> viewMaxY = Vector128.Create(view.Max.Y);
+                ref float block = ref MemoryMarshal.GetArrayDataReference(cell.bounds);
+
+                for (int i = 0; i < n; i += 4)
+                {
+                    nuint at = (nuint)(i * 4);
+                    Vector128<float> hit =
+                        Vector128.LessThanOrEqual(Vector128.LoadUnsafe(ref block, at), viewMaxX) &
+                        Vector128.LessThanOrEqual(Vector128.LoadUnsafe(ref block, at + 4), viewMaxY) &
+                        Vector128.GreaterThanOrEqual(Vector128.LoadUnsafe(ref block, at + 8), viewMinX) &
+                        Vector128.GreaterThanOrEqual(Vector128.LoadUnsafe(ref block, at + 12), viewMinY);
+
+                    // Lanes past the end of a partial last block hold stale bounds
+                    uint lanes = hit.ExtractMostSignificantBits();
+                    if (n - i < 4)
+                        lanes &= (1u << (n - i)) - 1;
+                    while (lanes != 0)
+                    {
+                        output[written++] = cell.values[i + BitOperations.TrailingZeroCount(lanes)];
+                        lanes &= lanes - 1;
+                    }
+                }
+                return written;
+            }
+
+            float[] b = cell.bounds;
+            for (int i = 0; i < n; i++)
+            {
+                int j = (i & ~3) * 4 + (i & 3);
+                if (b[j] <= view.Max.X && b[j + 4] <= view.Max.Y && b[j + 8] >= view.Min.X && b[j + 12] >= view.Min.Y)
+                    output[written++] = cell.values[i];
+            }
+            return written;
+        }
+    }
+
+    // ============================================================================
+    // DYNAMIC AABB TREE (3D)
+    // ============================================================================
+
+    /// <summary>
+    /// Bounding volume hierarchy over fattened leaf bounds, kept balanced by rotations as
+    /// items come and go. A move that stays inside the fat bounds only rewrites the leaf.
+    /// Nodes live in one array and link by index. Not thread-safe.
+    /// </summary>
+    public sealed class Bvh3D
+    {
+        private const int Null = -1;
+
+        private struct Node
+        {
+            public Aabb3 fat;
+            public Aabb3 tight;     // leaves only
+            public int parent;      // next free node while on the free list
+            public int left;
+            public int right;
+            public int height;      // 0 for leaves, -1 while free
+            public int value;
+
+            public bool IsLeaf => left == Null;
+        }
+
+        private Node[] nodes = new Node[256];
+        private int nodeHighWater = 0;
+        private int freeNode = Null;
+        private int root = Null;
+        private int count = 0;
+        private readonly float margin;
+
+        // Cull scratch: leaves whose bounds still need a test, laid out for SIMD
+        private float[] candMinX = new float[256], candMinY = new float[256], candMinZ = new float[256];
+        private float[] candMaxX = new float[256], candMaxY = new float[256], candMaxZ = new float[256];
+        private int[] candValues = new int[256];
+        private int candCount;
+        private int[] stack = new int[64];
+        private int[] collectStack = new int[64];
+
+        public CullStats LastCull;
+
+        /// <summary>margin fattens leaves so small moves don't touch the tree</summary>
+        public Bvh3D(float margin = 0.1f)
+        {
+            this.margin = margin;
+        }
+
+        public int Count => count;
+        public int Height => root == Null ? 0 : nodes[root].height;
+
+        private int AllocateNode()
+        {
+            int index;
+            if (freeNode != Null)
+            {
+                index = freeNode;
+                freeNode = nodes[index].parent;
+            }
+            else
+            {
+                if (nodeHighWater == nodes.Length)
+                    Array.Resize(ref nodes, nodes.Length * 2);
+                index = nodeHighWater++;
+            }
+            nodes[index] = new Node { parent = Null, left = Null, right = Null, height = 0 };
+            return index;
+        }
+
+        private void FreeNode(int index)
+        {
+            nodes[index].parent = freeNode;
+            nodes[index].height = -1;
+            freeNode = index;
+        }
+
+        /// <summary>Adds an item; value comes back from Cull. Returns the proxy for Update/Remove.</summary>
+        public int Insert(in Aabb3 bounds, int value)
+        {
+            int leaf = AllocateNode();
+            var pad = new Vector3(margin);
+            nodes[leaf].fat = new Aabb3(bounds.Min - pad, bounds.Max + pad);
+            nodes[leaf].tight = bounds;
+            nodes[leaf].value = value;
+            InsertLeaf(leaf);
+            count++;
+            return leaf;
+        }
+
+        public void Update(int proxy, in Aabb3 bounds)
+        {
+            if (!IsValid(proxy))
+                return;
+
+            ref Node node = ref nodes[proxy];
+            node.tight = bounds;
+            if (node.fat.Contains(bounds))
+                return;
+
+            RemoveLeaf(proxy);
+            var pad = new Vector3(margin);
+            nodes[proxy].fat = new Aabb3(bounds.Min - pad, bounds.Max + pad);
+            InsertLeaf(proxy);
+        }
+
+        public void Remove(int proxy)
+        {
+            if (!IsValid(proxy))
+                return;
+            RemoveLeaf(proxy);
+            FreeNode(proxy);
+            count--;
+        }
+
+        public bool IsValid(int proxy) =>
+            (uint)proxy < (uint)nodeHighWater && nodes[proxy].height == 0;
+
+        public int GetValue(int proxy) => nodes[proxy].value;
+
+        private void InsertLeaf(int leaf)
+        {
+            if (root == Null)
+            {
+                root = leaf;
+                nodes[leaf].parent = Null;
+                return;
+            }
+
+            // Walk down toward the sibling that grows the tree's total area least
+            Aabb3 box = nodes[leaf].fat;
+            int index = root;
+            while (!nodes[index].IsLeaf)
+            {
+                int left = nodes[index].left;
+                int right = nodes[index].right;
+                float area = nodes[index].fat.Perimeter;
+                float combined = Aabb3.Union(nodes[index].fat, box).Perimeter;
+
+                float cost = 2.0f * combined;
+                float inheritance = 2.0f * (combined - area);
+                float costLeft = DescendCost(left, box) + inheritance;
+                float costRight = DescendCost(right, box) + inheritance;
+
+                if (cost < costLeft && cost < costRight)
+                    break;
+                index = costLeft < costRight ? left : right;
+            }
+
+            int sibling = index;
+            int oldParent = nodes[sibling].parent;
+            int newParent = AllocateNode();
+            nodes[newParent].parent = oldParent;
+            nodes[newParent].fat = Aabb3.Union(box, nodes[sibling].fat);
+            nodes[newParent].height = nodes[sibling].height + 1;
+            nodes[newParent].left = sibling;
+            nodes[newParent].right = leaf;
+            nodes[sibling].parent = newParent;
+            nodes[leaf].parent = newParent;
+
+            if (oldParent == Null)
+                root = newParent;
+            else if (nodes[oldParent].left == sibling)
+                nodes[oldParent].left = newParent;
+            else
+                nodes[oldParent].right = newParent;
+
+            Refit(nodes[leaf].parent);
+        }
+
+        private float DescendCost(int child, in Aabb3 box)
+        {
+            float union = Aabb3.Union(box, nodes[child].fat).Perimeter;
+            return nodes[child].IsLeaf ? union : union - nodes[child].fat.Perimeter;
+        }
+
+        private void RemoveLeaf(int leaf)
+        {
+            if (leaf == root)
+            {
+                root = Null;
+                return;
+            }
+
+            int parent = nodes[leaf].parent;
+            int grandParent = nodes[parent].parent;
+            int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+            if (grandParent == Null)
+            {
+                root = sibling;
+                nodes[sibling].parent = Null;
+            }
+            else
+            {
+                if (nodes[grandParent].left == parent)
+                    nodes[grandParent].left = sibling;
+                else
+                    nodes[grandParent].right = sibling;
+                nodes[sibling].parent = grandParent;
+                Refit(grandParent);
+            }
+            FreeNode(parent);
+        }
+
+        // Rebalances and refits bounds from index up to the root
+        private void Refit(int index)
+        {
+            while (index != Null)
+            {
+                index = Balance(index);
+                int left = nodes[index].left;
+                int right = nodes[index].right;
+                nodes[index].height = 1 + Math.Max(nodes[left].height, nodes[right].height);
+                nodes[index].fat = Aabb3.Union(nodes[left].fat, nodes[right].fat);
+                index = nodes[index].parent;
+            }
+        }
+
+        /// <summary>Rotates the taller grandchild up when a's children differ in height by more than one</summary>
+        private int Balance(int a)
+        {
+            if (nodes[a].IsLeaf || nodes[a].height < 2)
+                return a;
+
+            int b = nodes[a].left;
+            int c = nodes[a].right;
+            int balance = nodes[c].height - nodes[b].height;
+            if (balance > 1)
+                return Rotate(a, c, b, true);
+            if (balance < -1)
+                return Rotate(a, b, c, false);
+            return a;
+        }
+
+        // Lifts `up` (a child of a) above a; `other` is a's remaining child
+        private int Rotate(int a, int up, int other, bool upIsRight)
+        {
+            int f = nodes[up].left;
+            int g = nodes[up].right;
+
+            nodes[up].left = a;
+            nodes[up].parent = nodes[a].parent;
+            nodes[a].parent = up;
+
+            int upParent = nodes[up].parent;
+            if (upParent == Null)
+                root = up;
+            else if (nodes[upParent].left == a)
+                nodes[upParent].left = up;
+            else
+                nodes[upParent].right = up;
+
+            // The taller grandchild stays with `up`, the shorter one moves down to a
+            int keep = nodes[f].height > nodes[g].height ? f : g;
+            int move = keep == f ? g : f;
+            nodes[up].right = keep;
+            if (upIsRight)
+                nodes[a].right = move;
+            else
+                nodes[a].left = move;
+            nodes[move].parent = a;
+
+            nodes[a].fat = Aabb3.Union(nodes[other].fat, nodes[move].fat);
+            nodes[a].height = 1 + Math.Max(nodes[other].height, nodes[move].height);
+            nodes[up].fat = Aabb3.Union(nodes[a].fat, nodes[keep].fat);
+            nodes[up].height = 1 + Math.Max(nodes[a].height, nodes[keep].height);
+            return up;
+        }
+
+        /// <summary>
+        /// Replaces result's contents with the values of every item intersecting the frustum.
+        /// Subtrees entirely inside are taken whole; leaves under partly visible nodes are
+        /// gathered and tested in one SIMD pass at the end.
+        /// </summary>
+        public void Cull(in Frustum frustum, VisibleSet result)
+        {
+            result.Clear();
+            candCount = 0;
+            LastCull = default;
+            if (root == Null)
+                return;
+
+            int top = 0;
+            stack[top++] = root;
+            while (top > 0)
+            {
+                int index = stack[--top];
+                LastCull.Visited++;
+                Containment c = frustum.Classify(nodes[index].fat);
+                if (c == Containment.Outside)
+                    continue;
+
+                if (c == Containment.Inside)
+                {
+                    LastCull.Accepted++;
+                    CollectSubtree(index, result);
+                }
+                else if (nodes[index].IsLeaf)
+                {
+                    AddCandidate(index);
+                }
+                else
+                {
+                    if (top + 2 > stack.Length)
+                        Array.Resize(ref stack, stack.Length * 2);
+                    stack[top++] = nodes[index].left;
+                    stack[top++] = nodes[index].right;
+                }
+            }
+
+            LastCull.Tested = candCount;
+            TestCandidates(frustum, result);
+            LastCull.Visible = result.count;
+        }
+
+        // The fat bounds are inside, so the tight ones are too: take every leaf untested
+        private void CollectSubtree(int index, VisibleSet result)
+        {
+            int top = 0;
+            collectStack[top++] = index;
+            while (top > 0)
+            {
+                int n = collectStack[--top];
+                if (nodes[n].IsLeaf)
+                {
+                    result.Add(nodes[n].value);
+                    continue;
+                }
+                if (top + 2 > collectStack.Length)
+                    Array.Resize(ref collectStack, collectStack.Length * 2);
+                collectStack[top++] = nodes[n].left;
+                collectStack[top++] = nodes[n].right;
+            }
+        }
+
+        private void AddCandidate(int leaf)
+        {
+            if (candCount == candValues.Length)
+            {
+                int capacity = candValues.Length * 2;
+                Array.Resize(ref candMinX, capacity);
+                Array.Resize(ref candMinY, capacity);
+                Array.Resize(ref candMinZ, capacity);
+                Array.Resize(ref candMaxX, capacity);
+                Array.Resize(ref candMaxY, capacity);
+                Array.Resize(ref candMaxZ, capacity);
+                Array.Resize(ref candValues, capacity);
+            }
+            ref Aabb3 b = ref nodes[leaf].tight;
+            candMinX[candCount] = b.Min.X;
+            candMinY[candCount] = b.Min.Y;
+            candMinZ[candCount] = b.Min.Z;
+            candMaxX[candCount] = b.Max.X;
+            candMaxY[candCount] = b.Max.Y;
+            candMaxZ[candCount] = b.Max.Z;
+            candValues[candCount] = nodes[leaf].value;
+            candCount++;
+        }
+
+        // Per plane, the corner furthest along the normal is picked by the normal's signs,
+        // so the whole batch uses the same arrays and only the dot product is per lane
+        private void TestCandidates(in Frustum frustum, VisibleSet result)
+        {
+            result.Reserve(candCount);
+            int i = 0;
+            if (Vector128.IsHardwareAccelerated)
+            {
+                for (; i + 4 <= candCount; i += 4)
+                {
+                    Vector128<float> visible = Vector128<float>.AllBitsSet;
+                    for (int p = 0; p < Frustum.PlaneCount; p++)
+                    {
+                        Vector4 plane = frustum.GetPlane(p);
+                        Vector128<float> x = Vector128.LoadUnsafe(ref MemoryMarshal.GetArrayDataReference(plane.X >= 0 ? candMaxX : candMinX), (nuint)i);
+                        Vector128<float> y = Vector128.LoadUnsafe(ref MemoryMarshal.GetArrayDataReference(plane.Y >= 0 ? candMaxY : candMinY), (nuint)i);
+                        Vector128<float> z = Vector128.LoadUnsafe(ref MemoryMarshal.GetArrayDataReference(plane.Z >= 0 ? candMaxZ : candMinZ), (nuint)i);
+                        Vector128<float> d = x * plane.X + y * plane.Y + z * plane.Z + Vector128.Create(plane.W);
+                        visible &= Vector128.GreaterThanOrEqual(d, Vector128<float>.Zero);
+                    }
+
+                    uint lanes = visible.ExtractMostSignificantBits();
+                    while (lanes != 0)
+                    {
+                        result.values[result.count++] = candValues[i + BitOperations.TrailingZeroCount(lanes)];
+                        lanes &= lanes - 1;
+                    }
+                }
+            }
+
+            for (; i < candCount; i++)
+            {
+                var box = new Aabb3(new Vector3(candMinX[i], candMinY[i], candMinZ[i]),
+                                    new Vector3(candMaxX[i], candMaxY[i], candMaxZ[i]));
+                if (frustum.Classify(box) != Containment.Outside)
+                    result.values[result.count++] = candValues[i];
+            }
+        }
+    }
+}
@@ -0,0 +1,180 @@
+/*
+ * PyFlare Engine - Startup
+ * Parallel engine bring-up: the window and GL context are created on the main thread while
+ * workers prefetch the shader cache, index archives, reserve memory pools and load the class
+ * registry. Measures time to first frame.
+ */
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Text;
+using PyFlare.Engine.Platform;
+
+namespace PyFlare.Engine.Core
+{
+    public sealed class StartupConfig
+    {
+        public int width = 1280;
+        public int height = 720;
+        public string title = "PyFlare";
+        public bool fullscreen = false;
+        public bool vsync = true;
+        public bool headless = false;           // offscreen context, see Platform.InitializeHeadless
+        public List<string> archives = new List<string>();   // mounted in order, last has priority
+        public string shaderCacheDir = null;    // null leaves the shader cache unconfigured
+        public int workers = 0;                 // 0 = one per core
+    }
+
+    /// <summary>One step of Startup.Run; times are milliseconds from the start of Run</summary>
+    public struct StartupPhase
+    {
+        public string name;
+        public int worker;          // Jobs.CurrentWorker that ran it, 0 = main thread
+        public double startMs;
+        public double durationMs;
+    }
+
+    public static class Startup
+    {
+        private static readonly object phaseLock = new object();
+        private static readonly List<StartupPhase> phases = new List<StartupPhase>();
+        private static long runTicks;
+        private static bool ran;
+        private static bool reported;
+        private static double firstFrameMs = -1.0;
+
+        /// <summary>
+        /// Initializes Jobs, Platform and Engine. Work that does not need the GL context runs on
+        /// workers while the main thread creates it; the first frame presented after this returns
+        /// is reported from Engine.Update. Returns false if the platform failed to initialize.
+        /// </summary>
+        public static bool Run(StartupConfig config)
+        {
+            if (ran)
+            {
+                Console.WriteLine("Startup already ran");
+                return true;
+            }
+            config ??= new StartupConfig();
+            runTicks = Platform.Platform.GetTicks();
+
+            Phase("jobs", () => Jobs.Initialize(config.workers));
+
+            bool platformOk = false;
+            using (var counter = new JobCounter())
+            {
+                if (config.shaderCacheDir != null)
+                {
+                    ShaderCache.SetDirectory(config.shaderCacheDir);
+                    Jobs.Run(() => Phase("shader cache prefetch", () => ShaderCache.Prefetch()), counter);
+                }
+                if (config.archives != null && config.archives.Count > 0)
+                    Jobs.Run(() => Phase("archives", () => ResourceLoader.MountArchives(config.archives)), counter);
+                Jobs.Run(() => Phase("memory pools", () => MemoryManager.Instance.ReservePools()), counter);
+                Jobs.Run(() => Phase("class registry", () => _ = ClassRegistry.Count), counter);
+
+                // GL contexts belong to the thread that creates them
+                Phase("platform", () => platformOk = config.headless
+                    ? Platform.Platform.InitializeHeadless(config.width, config.height)
+                    : Platform.Platform.Initialize(config.width, config.height, config.title,
+                        config.fullscreen, config.vsync));
+                Phase("wait for workers", counter.Wait);
+            }
+
+            if (!platformOk)
+            {
+                ShaderCache.DropPrefetched();
+                return false;
+            }
+
+            Phase("engine", Engine.Instance.Initialize);
+            ran = true;
+            return true;
+        }
+
+        private static void Phase(string name, Action body)
+        {
+            long begin = Platform.Platform.GetTicks();
+            body();
+            long end = Platform.Platform.GetTicks();
+
+            var phase = new StartupPhase
+            {
+                name = name,
+                worker = Jobs.CurrentWorker,
+                startMs = TicksToMs(begin - runTicks),
+                durationMs = TicksToMs(end - begin)
+            };
+            lock (phaseLock)
+                phases.Add(phase);
+        }
+
+        private static double TicksToMs(long ticks) => ticks * 1000.0 / Platform.Platform.GetTickFrequency();
+
+        /// <summary>Called by Engine.Update; prints the report once the first frame is on screen</summary>
+        internal static void Update()
+        {
+            if (!ran || reported) return;
+            StartupStats stats = Platform.Platform.GetStartupStats();
+            if (stats.firstPresent == 0) return;
+
+            reported = true;
+            firstFrameMs = TicksToMs(stats.firstPresent - ProcessStartTicks());
+            // Shaders compiled from here on read the disk cache directly
+            ShaderCache.DropPrefetched();
+            Console.Write(GetReport());
+        }
+
+        // Process start on the Platform.GetTicks clock; Run's start if the OS won't say
+        private static long ProcessStartTicks()
+        {
+            try
+            {
+                DateTime started = Process.GetCurrentProcess().StartTime.ToUniversalTime();
+                double sinceStart = (DateTime.UtcNow - started).TotalSeconds;
+                return Platform.Platform.GetTicks() - (long)(sinceStart * Platform.Platform.GetTickFrequency());
+            }
+            catch (Exception)
+            {
+                return runTicks;
+            }
+        }
+
+        /// <summary>Process start to the first presented frame, -1 until it has been presented</summary>
+        public static double GetTimeToFirstFrameMs() => firstFrameMs;
+
+        public static StartupPhase[] GetPhases()
+        {
+            lock (phaseLock)
+                return phases.ToArray();
+        }
+
+        public static string GetReport()
+        {
+            StartupStats stats = Platform.Platform.GetStartupStats();
+            var sb = new StringBuilder();
+            sb.AppendLine("=== Startup ===");
+            foreach (StartupPhase phase in GetPhases())
+            {
+                sb.AppendLine(string.Format(CultureInfo.InvariantCulture, "{0,-22} {1,8:F2} ms  at {2,8:F2} ms  ({3})",
+                    phase.name, phase.durationMs, phase.startMs,
+                    phase.worker == 0 ? "main" : "worker " + phase.worker));
+            }
+            if (stats.initBegin != 0 && stats.contextReady != 0)
+                sb.AppendLine(string.Format(CultureInfo.InvariantCulture, "Context creation: {0:F2} ms",
+                    TicksToMs(stats.contextReady - stats.initBegin)));
+            if (stats.initBegin != 0 && stats.initEnd != 0)
+                sb.AppendLine(string.Format(CultureInfo.InvariantCulture, "Native init: {0:F2} ms",
+                    TicksToMs(stats.initEnd - stats.initBegin)));
+            if (stats.firstPresent != 0 && ran)
+                sb.AppendLine(string.Format(CultureInfo.InvariantCulture, "Startup.Run to first frame: {0:F2} ms",
+                    TicksToMs(stats.firstPresent - runTicks)));
+            if (firstFrameMs >= 0)
+                sb.AppendLine(string.Format(CultureInfo.InvariantCulture, "Time to first frame: {0:F2} ms", firstFrameMs));
+            sb.AppendLine("===============");
+            return sb.ToString();
+        }
+    }
+}
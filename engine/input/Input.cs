@@ -1 +1,219 @@
-// Input system placeholder
+/*
+ * PyFlare Engine - Input System
+ * Keyboard, mouse and text input, read straight from the native input snapshot
+ * The snapshot is filled while native code drains the OS queue; nothing here runs per event
+ */
+
+using System;
+using System.Runtime.InteropServices;
+
+namespace PyFlare.Engine.Input
+{
+    /// <summary>
+    /// Key codes, GLFW numbering: printable keys are their uppercase ASCII value
+    /// </summary>
+    public enum Key
+    {
+        Unknown = 0,
+        Space = 32,
+        Apostrophe = 39,
+        Comma = 44, Minus = 45, Period = 46, Slash = 47,
+        D0 = 48, D1, D2, D3, D4, D5, D6, D7, D8, D9,
+        Semicolon = 59,
+        Equal = 61,
+        A = 65, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P, Q, R, S, T, U, V, W, X, Y, Z,
+        LeftBracket = 91, Backslash = 92, RightBracket = 93,
+        GraveAccent = 96,
+        Escape = 256, Enter, Tab, Backspace, Insert, Delete,
+        Right, Left, Down, Up, PageUp, PageDown, Home, End,
+        F1 = 290, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12,
+        LeftShift = 340, LeftControl, LeftAlt, LeftSuper,
+        RightShift, RightControl, RightAlt, RightSuper
+    }
+
+    public enum MouseButton
+    {
+        Left = 0,
+        Right = 1,
+        Middle = 2,
+        Back = 3,
+        Forward = 4
+    }
+
+    [Flags]
+    public enum KeyModifiers
+    {
+        None = 0,
+        Shift = 1,
+        Control = 2,
+        Alt = 4
+    }
+
+    /// <summary>
+    /// Values must match the PF_INPUT_* event types in native.c
+    /// </summary>
+    public enum InputEventType
+    {
+        KeyDown = 1,
+        KeyUp = 2,
+        KeyRepeat = 3,
+        Text = 4,
+        ButtonDown = 5,
+        ButtonUp = 6,
+        Wheel = 7
+    }
+
+    /// <summary>
+    /// One timestamped event. Layout must match InputEvent in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct InputEvent
+    {
+        public long ticks;          // Platform.GetTicks clock
+        public InputEventType type;
+        public int code;            // Key, MouseButton or Unicode code point
+        public int x;               // mouse position, or wheel steps * 120
+        public int y;
+        public KeyModifiers modifiers;
+        private int reserved;
+
+        public Key Key => (Key)code;
+        public MouseButton Button => (MouseButton)code;
+    }
+
+    /// <summary>
+    /// One frame of input state. Layout must match InputSnapshot in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct InputSnapshot
+    {
+        public const int KeyCount = 512;
+        public const int EventCapacity = 128;
+
+        public long frame;
+        public long pollTicks;
+        public fixed ulong keysDown[KeyCount / 64];
+        public fixed ulong keysPressed[KeyCount / 64];
+        public fixed ulong keysReleased[KeyCount / 64];
+        public int mouseX;
+        public int mouseY;
+        public int mouseDX;
+        public int mouseDY;
+        public int wheelX;
+        public int wheelY;
+        public int buttonsDown;
+        public int buttonsPressed;
+        public int buttonsReleased;
+        public int modifiers;
+        public int focused;
+        public int eventCount;
+        public int eventStart;
+        public int eventsDropped;
+        // InputEvent events[EventCapacity] follows
+    }
+
+    /// <summary>
+    /// Access to the current frame's snapshot. The pointer comes from Platform.Update, the one
+    /// P/Invoke per frame; every query after that is a plain memory read.
+    /// </summary>
+    internal static unsafe class InputState
+    {
+        // Zeroed stand-in for when no window is open, so queries never need a null check
+        private static readonly InputSnapshot* empty = (InputSnapshot*)NativeMemory.AllocZeroed(
+            (nuint)(sizeof(InputSnapshot) + InputSnapshot.EventCapacity * sizeof(InputEvent)));
+
+        public static InputSnapshot* Current
+        {
+            get
+            {
+                IntPtr ptr = Platform.Platform.GetInputSnapshot();
+                return ptr != IntPtr.Zero ? (InputSnapshot*)ptr : empty;
+            }
+        }
+
+        public static InputEvent* Events(InputSnapshot* s) => (InputEvent*)(s + 1);
+
+        public static bool TestBit(ulong* words, Key key)
+        {
+            int k = (int)key;
+            if ((uint)k >= InputSnapshot.KeyCount) return false;
+            return (words[k >> 6] & (1UL << (k & 63))) != 0;
+        }
+    }
+
+    public static unsafe class Keyboard
+    {
+        public static bool IsDown(Key key) => InputState.TestBit(InputState.Current->keysDown, key);
+
+        /// <summary>Went down during the last frame (repeats don't count)</summary>
+        public static bool WasPressed(Key key) => InputState.TestBit(InputState.Current->keysPressed, key);
+        public static bool WasReleased(Key key) => InputState.TestBit(InputState.Current->keysReleased, key);
+
+        public static KeyModifiers Modifiers => (KeyModifiers)InputState.Current->modifiers;
+    }
+
+    public static unsafe class Mouse
+    {
+        public static int X => InputState.Current->mouseX;
+        public static int Y => InputState.Current->mouseY;
+        public static int DeltaX => InputState.Current->mouseDX;
+        public static int DeltaY => InputState.Current->mouseDY;
+
+        /// <summary>Wheel movement this frame in notches (fractional on precision touchpads)</summary>
+        public static float WheelX => InputState.Current->wheelX / 120.0f;
+        public static float WheelY => InputState.Current->wheelY / 120.0f;
+
+        public static bool IsDown(MouseButton button) => (InputState.Current->buttonsDown & (1 << (int)button)) != 0;
+        public static bool WasPressed(MouseButton button) => (InputState.Current->buttonsPressed & (1 << (int)button)) != 0;
+        public static bool WasReleased(MouseButton button) => (InputState.Current->buttonsReleased & (1 << (int)button)) != 0;
+    }
+
+    /// <summary>
+    /// The frame's events in arrival order, for text entry and for anything that must see presses
+    /// shorter than a frame. Timestamps are on the Platform.GetTicks clock.
+    /// </summary>
+    public static unsafe class InputEvents
+    {
+        public static int Count => InputState.Current->eventCount;
+
+        /// <summary>Events lost because more than InputSnapshot.EventCapacity arrived in one frame</summary>
+        public static int Dropped => InputState.Current->eventsDropped;
+
+        public static long FrameTicks => InputState.Current->pollTicks;
+        public static long Frame => InputState.Current->frame;
+        public static bool HasFocus => InputState.Current->focused != 0;
+
+        public static ref readonly InputEvent Get(int index)
+        {
+            InputSnapshot* s = InputState.Current;
+            if ((uint)index >= (uint)s->eventCount)
+                throw new ArgumentOutOfRangeException(nameof(index));
+            return ref InputState.Events(s)[(s->eventStart + index) & (InputSnapshot.EventCapacity - 1)];
+        }
+
+        /// <summary>Appends this frame's text input to the builder</summary>
+        public static void AppendText(System.Text.StringBuilder builder)
+        {
+            InputSnapshot* s = InputState.Current;
+            InputEvent* events = InputState.Events(s);
+            for (int i = 0; i < s->eventCount; i++)
+            {
+                ref InputEvent e = ref events[(s->eventStart + i) & (InputSnapshot.EventCapacity - 1)];
+                if (e.type != InputEventType.Text)
+                    continue;
+                // Surrogate code points and out-of-range values are not scalars
+                bool valid = e.code >= 0 && e.code <= 0x10FFFF && (e.code < 0xD800 || e.code > 0xDFFF);
+                builder.Append(char.ConvertFromUtf32(valid ? e.code : 0xFFFD));
+            }
+        }
+
+        /// <summary>
+        /// Milliseconds from the event to now. Called right after Present, this is the
+        /// input-to-present part of input-to-photon latency.
+        /// </summary>
+        public static double GetAgeMs(in InputEvent e)
+        {
+            return (Platform.Platform.GetTicks() - e.ticks) * 1000.0 / Platform.Platform.GetTickFrequency();
+        }
+    }
+}
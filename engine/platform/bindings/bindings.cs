@@ -4,14 +4,24 @@
  */
 
 using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
 
 namespace PyFlare.Engine.Platform
 {
     /// <summary>
-    /// P/Invoke bindings to native platform layer
+    /// P/Invoke bindings to native platform layer. Strings are NUL-terminated UTF-8 (see Utf8Buffer).
+    /// Imports marked SuppressGCTransition must stay short, never block and never call back
+    /// into managed code.
     /// </summary>
-    public static class NativePlatform
+    public static unsafe class NativePlatform
     {
         private const string NATIVE_LIB = "native";
 
@@ -20,265 +30,1901 @@ namespace PyFlare.Engine.Platform
         // ====================================================================
 
         [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern int native_init_window(int width, int height, 
-            [MarshalAs(UnmanagedType.LPStr)] string title, 
+        public static extern int native_init_window(int width, int height, byte* title,
             int fullscreen, int vsync);
 
+        /// <summary>Offscreen context (GLX/EGL pbuffer, hidden window on Windows); no input, vsync off</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_init_headless(int width, int height);
+
         [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
         public static extern void native_destroy_window();
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern void native_update();
+        /// <summary>0 vendor, 1 renderer, 2 version: a UTF-8 string owned by native code</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr native_get_gl_info(int which);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_get_startup_stats(out StartupStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_update();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_present();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_present_async();
+
+        /// <summary>Moves GL onto a native render thread (1) or back to the caller (0). Returns 1 if it runs</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_set_render_thread(int enabled);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_get_render_thread_stats(out RenderThreadStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern int native_is_window_open();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern void native_get_window_size(out int width, out int height);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern double native_get_delta_time();
+
+        /// <summary>Front InputSnapshot (see Input.cs); valid until the next native_update</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern IntPtr native_get_input_snapshot();
+
+        /// <summary>SharedState block, valid for the life of the process</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern SharedState* native_get_shared_state();
+
+        // ====================================================================
+        // FRAME PACING
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_target_fps(double fps);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_set_vsync(int enabled);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_get_frame_pacing_stats(out FramePacingStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_reset_frame_pacing_stats();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_get_frame_stats(int scope, out FrameStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_frame_stats_window(int frames);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_frame_budget_ms(double budgetMs);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_reset_frame_stats();
+
+        // ====================================================================
+        // OPENGL FUNCTIONS
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_clear(float r, float g, float b, float a);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern uint native_create_shader(byte* vertexSrc, byte* fragmentSrc);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_use_shader(uint shaderId);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_delete_shader(uint shaderId);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_shader_cache_dir(byte* directory);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_shader_cache_supported();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_get_shader_cache_stats(out int memoryHits, out int diskHits, out int compiles);
+
+        /// <summary>Reads the cache directory's binaries into memory; any thread, no GL context needed</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_shader_cache_prefetch();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_shader_cache_drop_prefetch();
+
+        /// <summary>Returns 1 if queued; the rebuilt program replaces the old one after a later present</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_shader_reload(uint shaderId, byte* vertexSrc, byte* fragmentSrc);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_shader_reload_status(uint shaderId);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_shader_reload_error(uint shaderId, byte* buffer, int size);
+
+        // ====================================================================
+        // TEXTURES
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_texture_format_supported(int format);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern long native_texture_level_size(int format, int width, int height);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern uint native_create_texture(int width, int height, int format, int levels);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_texture_upload(uint texture, int level, IntPtr data, long bytes, int copy);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_texture_pending(uint texture);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_delete_texture(uint texture);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_texture_upload_budget(long bytesPerFrame);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_texture_upload_thread(int enabled);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_get_texture_stats(out TextureStats stats);
+
+        // ====================================================================
+        // STREAMING BUFFERS
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_create_stream_buffer(int size, int ringCount);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr native_map_ring(int handle, int bytes);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_commit_ring(int handle, int bytesWritten);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern uint native_get_ring_buffer_id(int handle);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_get_stream_buffer_mode(int handle);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_destroy_stream_buffer(int handle);
+
+        // ====================================================================
+        // SPRITE BATCHING
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_submit_batch(SpriteInstance* sprites, int count);
+
+        // ====================================================================
+        // MEMORY POOLS
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_pool_create(int blockSize, int initialBlocks);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr native_pool_alloc(int handle);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_pool_free(int handle, IntPtr ptr);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_pool_get_stats(int handle, out PoolStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_pool_destroy(int handle);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern long native_large_block_size(long size);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr native_large_alloc(long size);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_large_free(IntPtr ptr, long size);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_large_get_stats(out long liveBytes, out long cachedBytes);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_large_trim();
+
+        // ====================================================================
+        // ASSET ARCHIVES
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_open(byte* path);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_archive_close(int handle);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_entry_count(int handle);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_find(int handle, byte* path, out ArchiveEntryInfo info);
+
+        /// <summary>path is UTF-8 without a terminator; length in bytes</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_find_span(int handle, byte* path, int length, out ArchiveEntryInfo info);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_get_entry(int handle, int index, out ArchiveEntryInfo info);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_archive_prefetch(int handle, int index);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_chunk_count(int handle, int index);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_archive_decode_chunks(int handle, int index, int first, int count,
+            IntPtr dst, long dstSize);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_lz4_decompress(IntPtr src, int srcSize, IntPtr dst, int dstCapacity);
+
+        // ====================================================================
+        // FILE WATCHING
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_watch_supported();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_watch_add(byte* directory, int recursive);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_watch_remove(int watch);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_watch_poll(WatchEvent* events, int max);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_watch_shutdown();
+
+        // ====================================================================
+        // AUDIO MIXER
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_init(int latencyMs, int nullDevice);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_audio_shutdown();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_push(AudioCommand* command);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_update();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_voice_active(uint voice);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_sound_create(float* samples, int frames, int channels, int rate);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_sound_release(int sound);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_stream_create(int channels, int rate, int capacityFrames);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_stream_space(int stream);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_stream_write(int stream, float* samples, int frames);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_audio_stream_end(int stream);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_audio_stream_release(int stream);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_audio_get_stats(out AudioStats stats);
+
+        // ====================================================================
+        // JOB SYSTEM
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_jobs_init(int workerCount);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_jobs_shutdown();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr native_job_counter_create();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_job_counter_destroy(IntPtr counter);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern int native_job_counter_value(IntPtr counter);
+
+        /// <summary>fn is a cdecl void(void* data, int index). Returns 1 if queued, 0 if it already ran</summary>
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_job_submit(IntPtr fn, IntPtr data, int index, IntPtr counter, int flags);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_job_submit_range(IntPtr fn, IntPtr data, int count, IntPtr counter);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_job_wait(IntPtr counter);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_jobs_try_run();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_jobs_run_main(double maxMs);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_jobs_worker_count();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern int native_jobs_current_worker();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_jobs_get_stats(out JobStats stats);
+
+        // ====================================================================
+        // PROFILER
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_profiler_register_marker(byte* name);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr native_profiler_get_marker_name(int marker);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_profiler_set_enabled(int enabled);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_profiler_collect([Out] ProfileEvent[] events, int max);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern long native_profiler_get_dropped();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_profiler_gpu_supported();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_gpu_marker_begin(int marker);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_gpu_marker_end(int marker);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_get_gl_state_stats(out GLStateStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_reset_gl_state_stats();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void native_set_gl_state_cache(int enabled);
+
+        // ====================================================================
+        // UTILITY FUNCTIONS
+        // ====================================================================
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern long native_get_memory_usage();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int native_get_memory_stats(out MemoryStats stats);
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        public static extern double native_get_time();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern long native_get_ticks();
+
+        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
+        [SuppressGCTransition]
+        public static extern long native_get_tick_frequency();
+    }
+
+    /// <summary>
+    /// Per-frame entry points as unmanaged function pointers, resolved once from the library
+    /// the DllImports load. Calls go straight to the export with no marshalling stub.
+    /// </summary>
+    public static unsafe class NativeCalls
+    {
+        public static readonly delegate* unmanaged[Cdecl]<void> Update;
+        public static readonly delegate* unmanaged[Cdecl]<void> Present;
+        public static readonly delegate* unmanaged[Cdecl]<float, float, float, float, void> Clear;
+        public static readonly delegate* unmanaged[Cdecl]<SpriteInstance*, int, int> SubmitBatch;
+        public static readonly delegate* unmanaged[Cdecl]<int, void> GpuMarkerBegin;
+        public static readonly delegate* unmanaged[Cdecl]<int, void> GpuMarkerEnd;
+        public static readonly delegate* unmanaged[Cdecl, SuppressGCTransition]<long> GetTicks;
+        public static readonly delegate* unmanaged[Cdecl, SuppressGCTransition]<AudioCommand*, int> AudioPush;
+        public static readonly delegate* unmanaged[Cdecl, SuppressGCTransition]<uint, int> AudioVoiceActive;
+
+        static NativeCalls()
+        {
+            IntPtr library = NativeLibrary.Load("native", typeof(NativeCalls).Assembly, null);
+            Update = (delegate* unmanaged[Cdecl]<void>)NativeLibrary.GetExport(library, "native_update");
+            Present = (delegate* unmanaged[Cdecl]<void>)NativeLibrary.GetExport(library, "native_present");
+            Clear = (delegate* unmanaged[Cdecl]<float, float, float, float, void>)NativeLibrary.GetExport(library, "native_clear");
+            SubmitBatch = (delegate* unmanaged[Cdecl]<SpriteInstance*, int, int>)NativeLibrary.GetExport(library, "native_submit_batch");
+            GpuMarkerBegin = (delegate* unmanaged[Cdecl]<int, void>)NativeLibrary.GetExport(library, "native_gpu_marker_begin");
+            GpuMarkerEnd = (delegate* unmanaged[Cdecl]<int, void>)NativeLibrary.GetExport(library, "native_gpu_marker_end");
+            GetTicks = (delegate* unmanaged[Cdecl, SuppressGCTransition]<long>)NativeLibrary.GetExport(library, "native_get_ticks");
+            // Queue pushes and voice queries are a few atomics, cheap enough to skip the GC transition
+            AudioPush = (delegate* unmanaged[Cdecl, SuppressGCTransition]<AudioCommand*, int>)NativeLibrary.GetExport(library, "native_audio_push");
+            AudioVoiceActive = (delegate* unmanaged[Cdecl, SuppressGCTransition]<uint, int>)NativeLibrary.GetExport(library, "native_audio_voice_active");
+        }
+    }
+
+    /// <summary>
+    /// NUL-terminated UTF-8 copy of a string for native calls: encoded into the caller's stack
+    /// buffer when it fits, into a pooled array otherwise. Pin with `fixed (byte* p = utf8)`.
+    /// </summary>
+    public ref struct Utf8Buffer
+    {
+        private byte[] rented;
+        private readonly Span<byte> bytes;
+        private readonly bool isNull;
+
+        public Utf8Buffer(string text, Span<byte> scratch)
+        {
+            rented = null;
+            isNull = text == null;
+            if (isNull)
+            {
+                bytes = default;
+                return;
+            }
+
+            int size = Encoding.UTF8.GetByteCount(text) + 1;
+            Span<byte> target = size <= scratch.Length
+                ? scratch
+                : (rented = ArrayPool<byte>.Shared.Rent(size));
+            int written = Encoding.UTF8.GetBytes(text, target);
+            target[written] = 0;
+            bytes = target.Slice(0, written + 1);
+        }
+
+        /// <summary>Encoded bytes without the terminator</summary>
+        public readonly ReadOnlySpan<byte> Bytes => isNull ? default : bytes.Slice(0, bytes.Length - 1);
+
+        /// <summary>Null strings pin to a null pointer</summary>
+        public readonly ref byte GetPinnableReference() => ref (isNull ? ref Unsafe.NullRef<byte>() : ref bytes[0]);
+
+        public void Dispose()
+        {
+            if (rented != null)
+                ArrayPool<byte>.Shared.Return(rented);
+            rented = null;
+        }
+    }
+
+    /// <summary>
+    /// Window and frame state published by native_update, read without a call.
+    /// Layout must match SharedState in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SharedState
+    {
+        public const int Version = 1;
+
+        public int size;
+        public int version;
+        public long frame;
+        public long updateTicks;
+        public long tickFrequency;
+        public double deltaTime;
+        public IntPtr input;
+        public int width;
+        public int height;
+        public int isOpen;
+        public int headless;
+    }
+
+    /// <summary>
+    /// Platform.GetTicks values at points of window startup, 0 until reached.
+    /// Layout must match StartupStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct StartupStats
+    {
+        public long initBegin;
+        public long contextReady;   // window and GL context exist
+        public long initEnd;        // shared contexts and default state set up
+        public long firstPresent;   // first swap returned
+    }
+
+    /// <summary>
+    /// Frame pacer counters. Layout must match FramePacingStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct FramePacingStats
+    {
+        public long frames;
+        public long missedDeadlines;
+        public double lastFrameMs;
+        public double worstFrameMs;
+        public double targetFrameMs;
+        public double sleepMs;
+        public int vsync;
+    }
+
+    /// <summary>
+    /// Render thread counters. Layout must match RenderThreadStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct RenderThreadStats
+    {
+        public long frames;
+        public long syncCalls;      // calls that waited on the render thread for a GL result
+        public long commandBytes;   // last frame
+        public int commands;        // last frame
+        public int active;
+        public double mainWaitMs;   // last frame: Present blocked on the previous frame
+        public double executeMs;    // last frame: command execution, excluding pacing and swap
+    }
+
+    /// <summary>
+    /// Which frame-time histogram to query
+    /// </summary>
+    public enum FrameStatsScope
+    {
+        Window = 0,   // rolling window of recent frames
+        Total = 1     // everything since the last reset (soak runs)
+    }
+
+    /// <summary>
+    /// Frame-time percentiles from the native histogram. Layout must match FrameStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct FrameStats
+    {
+        public long frames;
+        public long overBudget;
+        public double budgetMs;
+        public double meanMs;
+        public double p50Ms;
+        public double p95Ms;
+        public double p99Ms;
+        public double maxMs;
+    }
+
+    /// <summary>
+    /// Native slab pool counters. Layout must match PoolStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct PoolStats
+    {
+        public int blockSize;
+        public int allocatedBlocks;
+        public int freeBlocks;
+        public int pages;
+        public long reservedBytes;
+    }
+
+    /// <summary>
+    /// Process and GPU memory in bytes, -1 where the platform can't tell.
+    /// Layout must match MemoryStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct MemoryStats
+    {
+        public long residentBytes;
+        public long peakResidentBytes;
+        public long virtualBytes;
+        public long committedBytes;
+        public long gpuTotalBytes;
+        public long gpuAvailableBytes;
+    }
+
+    /// <summary>
+    /// Pixel formats understood by native_create_texture. Values must match native.c and build.py
+    /// </summary>
+    public enum TextureFormat
+    {
+        RGBA8 = 0,
+        RGB8 = 1,
+        DXT1 = 2,
+        DXT3 = 3,
+        DXT5 = 4,
+        ETC2_RGB = 5,
+        ETC2_RGBA = 6
+    }
+
+    /// <summary>
+    /// Texture upload counters. Layout must match TextureStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct TextureStats
+    {
+        public long uploadedBytes;
+        public long uploads;
+        public long queuedBytes;
+        public int queued;
+        public int background;
+    }
+
+    /// <summary>
+    /// Job system counters. Layout must match JobStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct JobStats
+    {
+        public int workers;         // including the main thread
+        private int reserved;
+        public long executed;
+        public long stolen;
+        public long inlineRuns;     // deque or pool full, ran in the submitter
+        public long mainRuns;       // jobs pinned to the main thread
+    }
+
+    /// <summary>
+    /// Archive entry as seen through the mapping. Layout must match ArchiveEntryInfo in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ArchiveEntryInfo
+    {
+        public IntPtr data;
+        public long size;
+        public long rawSize;
+        public int compression;
+        public int index;
+    }
+
+    /// <summary>
+    /// Values must match the PF_WATCH_* actions in native.c
+    /// </summary>
+    public enum WatchAction
+    {
+        Modified = 1,       // written, created or moved in
+        Removed = 2,        // deleted or moved out
+        Overflow = 3        // events were lost; rescan what is watched
+    }
+
+    /// <summary>
+    /// One file change. Layout must match WatchEvent in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct WatchEvent
+    {
+        public const int PathCapacity = 512;
+
+        public long ticks;          // Platform.GetTicks clock
+        public int watch;
+        public WatchAction action;
+        public fixed byte path[PathCapacity];   // UTF-8, '/' separated, under the watched directory
+
+        public string GetPath()
+        {
+            fixed (byte* p = path)
+                return Marshal.PtrToStringUTF8((IntPtr)p);
+        }
+    }
+
+    /// <summary>
+    /// Values must match the PF_AUDIO_BACKEND_* values in native.c
+    /// </summary>
+    public enum AudioBackend
+    {
+        None = 0,
+        Null = 1,           // no device; the mixer runs in real time and its output is dropped
+        Wasapi = 2,
+        Alsa = 3,
+        CoreAudio = 4
+    }
+
+    /// <summary>
+    /// Values must match the PF_AUDIO_CMD_* commands in native.c
+    /// </summary>
+    public enum AudioCommandType
+    {
+        Play = 1,
+        Stop = 2,
+        Volume = 3,
+        Pan = 4,
+        Pitch = 5,
+        Pause = 6,
+        MasterVolume = 7,
+        StopAll = 8
+    }
+
+    /// <summary>
+    /// Values must match the PF_AUDIO_PLAY_* flags in native.c
+    /// </summary>
+    [Flags]
+    public enum AudioPlayFlags
+    {
+        None = 0,
+        Loop = 1,
+        Stream = 2,         // source is a stream handle
+        Paused = 4
+    }
+
+    /// <summary>
+    /// One entry of the mixer's command queue. Layout must match AudioCommand in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioCommand
+    {
+        public AudioCommandType type;
+        public uint voice;
+        public int source;          // sound or stream handle
+        public AudioPlayFlags flags;
+        public float volume;
+        public float pan;           // -1 left .. 1 right
+        public float pitch;
+        public float fade;          // seconds
+    }
+
+    /// <summary>
+    /// Mixer counters. Layout must match AudioStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioStats
+    {
+        public AudioBackend backend;
+        public int sampleRate;
+        public int latencyFrames;   // how far the mixer stays ahead of the device
+        public int activeVoices;
+        public long framesMixed;
+        public long underruns;      // device reads that found the mixer behind
+        public long commands;
+        public long commandsDropped;
+        public long voicesRejected; // plays with every voice busy
+        public long streamStarved;  // silent frames inserted because a stream's decoder fell behind
+        public double mixAvgUs;     // per 256-frame block
+        public double mixPeakUs;
+    }
+
+    /// <summary>
+    /// Values must match the PF_SHADER_RELOAD_* states in native.c
+    /// </summary>
+    public enum ShaderReloadStatus
+    {
+        None = 0,
+        Pending = 1,
+        Applied = 2,
+        Failed = 3          // the previous program is still in use
+    }
+
+    /// <summary>
+    /// One completed profiler scope, or a counter sample on the counter track (threadId -1).
+    /// Layout must match ProfileEvent in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ProfileEvent
+    {
+        public long startTicks;
+        public long endTicks;
+        public int marker;
+        public int threadId;
+        public int depth;
+        public int value;           // counter samples only
+    }
+
+    /// <summary>
+    /// GL calls that reached the driver versus ones the native state cache dropped.
+    /// Layout must match GLStateCounts in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct GLStateCounts
+    {
+        public long emitted;
+        public long filtered;
+
+        public long Total => emitted + filtered;
+        public double FilteredRatio => Total > 0 ? (double)filtered / Total : 0;
+    }
+
+    /// <summary>
+    /// Native GL state cache counters, as of the last presented frame. Layout must match GLStateStats in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct GLStateStats
+    {
+        public GLStateCounts programs;
+        public GLStateCounts textures;      // binds and active unit changes
+        public GLStateCounts buffers;
+        public GLStateCounts blend;
+        public GLStateCounts depth;
+        public GLStateCounts viewport;
+        public GLStateCounts clearColor;
+        public GLStateCounts vertexArrays;
+        public GLStateCounts total;
+        public GLStateCounts lastFrame;
+        public long frames;
+        public int enabled;
+        private int reserved;
+    }
+
+    /// <summary>
+    /// One sprite as consumed by native_submit_batch. Layout must match SpriteInstance in native.c
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SpriteInstance
+    {
+        public float x, y;
+        public float width, height;
+        public float u0, v0, u1, v1;
+        public float rotation;
+        public uint color;
+        public uint texture;
+        public uint shader;
+        public int layer;
+
+        public static uint PackColor(float r, float g, float b, float a = 1.0f)
+        {
+            uint R = (uint)(Math.Clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint G = (uint)(Math.Clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint B = (uint)(Math.Clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint A = (uint)(Math.Clamp(a, 0.0f, 1.0f) * 255.0f + 0.5f);
+            return R | (G << 8) | (B << 16) | (A << 24);
+        }
+    }
+
+    /// <summary>
+    /// High-level C# wrapper for platform functionality
+    /// </summary>
+    public unsafe class Platform
+    {
+        private static bool initialized = false;
+        private static int windowWidth;
+        private static int windowHeight;
+        private static long tickFrequency = 0;
+        private static double targetFPS = 0.0;
+        private static IntPtr inputSnapshot = IntPtr.Zero;
+        private static bool renderThread = true;
+        private static SharedState* shared;     // null if the library's layout doesn't match
+
+        public static bool Initialize(int width, int height, string title, 
+            bool fullscreen = false, bool vsync = true)
+        {
+            if (initialized)
+            {
+                Console.WriteLine("Platform already initialized");
+                return true;
+            }
+
+            int result;
+            using (var utf8 = new Utf8Buffer(title ?? "", stackalloc byte[256]))
+            {
+                fixed (byte* titlePtr = utf8)
+                    result = NativePlatform.native_init_window(
+                        width, height, titlePtr,
+                        fullscreen ? 1 : 0, vsync ? 1 : 0
+                    );
+            }
+
+            return FinishInitialize(result, width, height);
+        }
+
+        /// <summary>
+        /// Offscreen GL context of the given framebuffer size, for benchmarks and tools. Rendering,
+        /// Present and frame statistics work as with a window; there is no input and no vsync.
+        /// </summary>
+        public static bool InitializeHeadless(int width, int height)
+        {
+            if (initialized)
+            {
+                Console.WriteLine("Platform already initialized");
+                return true;
+            }
+            return FinishInitialize(NativePlatform.native_init_headless(width, height), width, height);
+        }
+
+        private static bool FinishInitialize(int result, int width, int height)
+        {
+            if (result == 1)
+            {
+                initialized = true;
+                windowWidth = width;
+                windowHeight = height;
+                shared = NativePlatform.native_get_shared_state();
+                if (shared->size != sizeof(SharedState) || shared->version != SharedState.Version)
+                {
+                    Console.WriteLine("Native SharedState layout mismatch; falling back to calls");
+                    shared = null;
+                }
+                NativePlatform.native_set_target_fps(targetFPS);
+                if (renderThread)
+                    renderThread = NativePlatform.native_set_render_thread(1) == 1;
+                Console.WriteLine($"Platform initialized: {width}x{height}" + (IsHeadless() ? " headless" : "") +
+                    (renderThread ? " (render thread)" : ""));
+                return true;
+            }
+
+            Console.WriteLine("Failed to initialize platform");
+            return false;
+        }
+
+        public static bool IsHeadless() => initialized && shared != null && shared->headless != 0;
+
+        /// <summary>GL_VENDOR, GL_RENDERER and GL_VERSION of the context, empty before Initialize</summary>
+        public static string GetGLVendor() => Marshal.PtrToStringUTF8(NativePlatform.native_get_gl_info(0));
+        public static string GetGLRenderer() => Marshal.PtrToStringUTF8(NativePlatform.native_get_gl_info(1));
+        public static string GetGLVersion() => Marshal.PtrToStringUTF8(NativePlatform.native_get_gl_info(2));
+
+        public static StartupStats GetStartupStats()
+        {
+            NativePlatform.native_get_startup_stats(out StartupStats stats);
+            return stats;
+        }
+
+        public static void Shutdown()
+        {
+            if (initialized)
+            {
+                NativePlatform.native_destroy_window();
+                initialized = false;
+                inputSnapshot = IntPtr.Zero;
+                Console.WriteLine("Platform shutdown complete");
+            }
+        }
+
+        public static void Update()
+        {
+            if (!initialized) return;
+            NativeCalls.Update();
+            inputSnapshot = shared != null ? shared->input : NativePlatform.native_get_input_snapshot();
+        }
+
+        /// <summary>Update calls since the window opened</summary>
+        public static long GetFrameIndex() => initialized && shared != null ? shared->frame : 0;
+
+        /// <summary>This frame's native InputSnapshot, or zero before the first Update</summary>
+        public static IntPtr GetInputSnapshot() => inputSnapshot;
+
+        public static void Present()
+        {
+            if (!initialized) return;
+            NativeCalls.Present();
+        }
+
+        /// <summary>
+        /// Queues the buffer swap on a presentation thread (Windows); synchronous elsewhere.
+        /// The next native draw call waits for the swap to finish. Same as Present with the render thread.
+        /// </summary>
+        public static void PresentAsync()
+        {
+            if (!initialized) return;
+            NativePlatform.native_present_async();
+        }
+
+        /// <summary>
+        /// Runs GL on a native render thread: draw calls are recorded and Present hands the frame
+        /// over, so the next frame's simulation overlaps this frame's GL work and swap. On by default;
+        /// set before Initialize or at any time after. Returns whether the thread is running.
+        /// </summary>
+        public static bool SetRenderThread(bool enabled)
+        {
+            renderThread = enabled;
+            if (!initialized) return enabled;
+            renderThread = NativePlatform.native_set_render_thread(enabled ? 1 : 0) == 1;
+            return renderThread;
+        }
+
+        public static bool IsRenderThreadEnabled() => renderThread;
+
+        public static RenderThreadStats GetRenderThreadStats()
+        {
+            NativePlatform.native_get_render_thread_stats(out RenderThreadStats stats);
+            return stats;
+        }
+
+        public static bool IsWindowOpen()
+        {
+            if (!initialized) return false;
+            if (shared != null) return shared->isOpen != 0;
+            return NativePlatform.native_is_window_open() == 1;
+        }
+
+        /// <summary>Size as of the last Update; a plain memory read</summary>
+        public static void GetWindowSize(out int width, out int height)
+        {
+            if (initialized)
+            {
+                if (shared != null)
+                {
+                    width = shared->width;
+                    height = shared->height;
+                }
+                else
+                {
+                    NativePlatform.native_get_window_size(out width, out height);
+                }
+                windowWidth = width;
+                windowHeight = height;
+            }
+            else
+            {
+                width = 0;
+                height = 0;
+            }
+        }
+
+        public static int GetWindowWidth()
+        {
+            GetWindowSize(out int w, out _);
+            return w;
+        }
+
+        public static int GetWindowHeight()
+        {
+            GetWindowSize(out _, out int h);
+            return h;
+        }
+
+        public static double GetDeltaTime()
+        {
+            if (!initialized) return 0.0;
+            if (shared != null) return shared->deltaTime;
+            return NativePlatform.native_get_delta_time();
+        }
+
+        /// <summary>
+        /// Frame limit applied in Present when vsync is off. 0 disables the limiter
+        /// </summary>
+        public static void SetTargetFPS(double fps)
+        {
+            targetFPS = Math.Max(0.0, fps);
+            if (initialized)
+                NativePlatform.native_set_target_fps(targetFPS);
+        }
+
+        /// <summary>
+        /// Returns false if the driver refused to change the swap interval
+        /// </summary>
+        public static bool SetVSync(bool enabled)
+        {
+            if (!initialized) return false;
+            return NativePlatform.native_set_vsync(enabled ? 1 : 0) == 1 || !enabled;
+        }
+
+        public static FramePacingStats GetFramePacingStats()
+        {
+            NativePlatform.native_get_frame_pacing_stats(out FramePacingStats stats);
+            return stats;
+        }
+
+        public static void ResetFramePacingStats()
+        {
+            NativePlatform.native_reset_frame_pacing_stats();
+        }
+
+        public static void Clear(float r, float g, float b, float a = 1.0f)
+        {
+            if (!initialized) return;
+            NativeCalls.Clear(r, g, b, a);
+        }
+
+        public static long GetMemoryUsage()
+        {
+            MemoryStats stats = GetMemoryStats();
+            return Math.Max(0, stats.residentBytes);
+        }
+
+        public static MemoryStats GetMemoryStats()
+        {
+            NativePlatform.native_get_memory_stats(out MemoryStats stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Seconds on the native monotonic clock
+        /// </summary>
+        public static double GetTime()
+        {
+            return (double)GetTicks() / GetTickFrequency();
+        }
+
+        /// <summary>
+        /// Raw monotonic ticks; use these rather than GetTime for interval math to avoid precision loss
+        /// </summary>
+        public static long GetTicks()
+        {
+            return NativeCalls.GetTicks();
+        }
+
+        public static long GetTickFrequency()
+        {
+            if (tickFrequency == 0)
+                tickFrequency = NativePlatform.native_get_tick_frequency();
+            return tickFrequency;
+        }
+
+        public static bool IsInitialized() => initialized;
+    }
+
+    /// <summary>
+    /// Shader management wrapper
+    /// </summary>
+    public unsafe class Shader
+    {
+        private uint shaderId;
+        private bool isValid;
+
+        public Shader(string vertexSource, string fragmentSource)
+        {
+            using (var vertex = new Utf8Buffer(vertexSource, stackalloc byte[1024]))
+            using (var fragment = new Utf8Buffer(fragmentSource, stackalloc byte[1024]))
+            {
+                fixed (byte* vertexPtr = vertex)
+                fixed (byte* fragmentPtr = fragment)
+                    shaderId = NativePlatform.native_create_shader(vertexPtr, fragmentPtr);
+            }
+            isValid = shaderId != 0;
+
+            if (!isValid)
+            {
+                Console.WriteLine("Failed to create shader");
+            }
+        }
+
+        public void Use()
+        {
+            if (isValid)
+            {
+                NativePlatform.native_use_shader(shaderId);
+            }
+        }
+
+        public void Dispose()
+        {
+            if (isValid)
+            {
+                NativePlatform.native_delete_shader(shaderId);
+                isValid = false;
+            }
+        }
+
+        /// <summary>
+        /// Replaces the program's sources, keeping its id. The new sources compile in the
+        /// background and are swapped in after a later Present; until then, and for good if they
+        /// fail to build, the old program keeps drawing. Shader objects created from identical
+        /// sources share one program, so all of them change.
+        /// </summary>
+        public bool Reload(string vertexSource, string fragmentSource)
+        {
+            if (!isValid) return false;
+            using (var vertex = new Utf8Buffer(vertexSource, stackalloc byte[1024]))
+            using (var fragment = new Utf8Buffer(fragmentSource, stackalloc byte[1024]))
+            {
+                fixed (byte* vertexPtr = vertex)
+                fixed (byte* fragmentPtr = fragment)
+                    return NativePlatform.native_shader_reload(shaderId, vertexPtr, fragmentPtr) == 1;
+            }
+        }
+
+        public ShaderReloadStatus GetReloadStatus()
+        {
+            if (!isValid) return ShaderReloadStatus.None;
+            return (ShaderReloadStatus)NativePlatform.native_shader_reload_status(shaderId);
+        }
+
+        /// <summary>Compile or link log of the last failed reload, or ""</summary>
+        public string GetReloadError()
+        {
+            // PF_SHADER_LOG_SIZE in native.c
+            byte* buffer = stackalloc byte[2048];
+            int length = NativePlatform.native_shader_reload_error(shaderId, buffer, 2048);
+            return length > 0 ? System.Text.Encoding.UTF8.GetString(buffer, length) : "";
+        }
+
+        public bool IsValid() => isValid;
+        public uint GetId() => shaderId;
+    }
+
+    /// <summary>
+    /// Shader program cache control. Identical source pairs always share one program;
+    /// with a directory set, linked binaries are also reused across runs where the driver allows it.
+    /// </summary>
+    public static unsafe class ShaderCache
+    {
+        public static void SetDirectory(string directory)
+        {
+            if (!string.IsNullOrEmpty(directory))
+                System.IO.Directory.CreateDirectory(directory);
+
+            using var utf8 = new Utf8Buffer(directory ?? "", stackalloc byte[512]);
+            fixed (byte* path = utf8)
+                NativePlatform.native_set_shader_cache_dir(path);
+        }
+
+        /// <summary>
+        /// Reads every cached binary into memory so later shader creation skips the disk. Safe on
+        /// a worker while the window is being created; call after SetDirectory. Returns the count.
+        /// </summary>
+        public static int Prefetch() => NativePlatform.native_shader_cache_prefetch();
+
+        /// <summary>Frees prefetched binaries that no shader used</summary>
+        public static void DropPrefetched() => NativePlatform.native_shader_cache_drop_prefetch();
+
+        public static bool IsBinaryCacheSupported()
+        {
+            if (!Platform.IsInitialized()) return false;
+            return NativePlatform.native_shader_cache_supported() == 1;
+        }
+
+        public static void GetStats(out int memoryHits, out int diskHits, out int compiles)
+        {
+            NativePlatform.native_get_shader_cache_stats(out memoryHits, out diskHits, out compiles);
+        }
+
+        public static void PrintStats()
+        {
+            GetStats(out int memoryHits, out int diskHits, out int compiles);
+            Console.WriteLine($"Shader cache: {memoryHits} reused, {diskHits} from disk, {compiles} compiled");
+        }
+    }
+
+    /// <summary>
+    /// Directory change notifications (inotify, ReadDirectoryChangesW). Events queue natively
+    /// on a watcher thread until polled; unsupported platforms return 0 from Add.
+    /// </summary>
+    public static unsafe class FileWatcher
+    {
+        public static bool IsSupported => NativePlatform.native_watch_supported() == 1;
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern void native_present();
+        /// <summary>Returns a watch handle, or 0 if the directory cannot be watched</summary>
+        public static int Add(string directory, bool recursive = true)
+        {
+            using var utf8 = new Utf8Buffer(directory, stackalloc byte[512]);
+            fixed (byte* path = utf8)
+                return NativePlatform.native_watch_add(path, recursive ? 1 : 0);
+        }
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern int native_is_window_open();
+        public static void Remove(int watch) => NativePlatform.native_watch_remove(watch);
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern void native_get_window_size(out int width, out int height);
+        /// <summary>Fills events with the oldest queued changes; returns how many</summary>
+        public static int Poll(Span<WatchEvent> events)
+        {
+            fixed (WatchEvent* ptr = events)
+                return NativePlatform.native_watch_poll(ptr, events.Length);
+        }
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern double native_get_delta_time();
+        public static void Shutdown() => NativePlatform.native_watch_shutdown();
+    }
 
-        // ====================================================================
-        // OPENGL FUNCTIONS
-        // ====================================================================
+    /// <summary>
+    /// How a stream buffer avoids GPU stalls, chosen natively from the available GL extensions
+    /// </summary>
+    public enum StreamBufferMode
+    {
+        Orphan = 0,
+        MapRange = 1,
+        Persistent = 2
+    }
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern void native_clear(float r, float g, float b, float a);
+    /// <summary>
+    /// Ring of GL buffers for dynamic geometry written from C#.
+    /// Map, write, Commit; the returned offset locates the data in the current GL buffer.
+    /// </summary>
+    public class StreamBuffer
+    {
+        private int handle;
+        private int size;
+        private IntPtr mapped;
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern uint native_create_shader(
-            [MarshalAs(UnmanagedType.LPStr)] string vertexSrc,
-            [MarshalAs(UnmanagedType.LPStr)] string fragmentSrc);
+        public StreamBuffer(int size, int ringCount = 3)
+        {
+            this.size = size;
+            handle = NativePlatform.native_create_stream_buffer(size, ringCount);
+            mapped = IntPtr.Zero;
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern void native_use_shader(uint shaderId);
+            if (handle == 0)
+            {
+                Console.WriteLine("Failed to create stream buffer");
+            }
+        }
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern void native_delete_shader(uint shaderId);
+        public IntPtr Map(int bytes)
+        {
+            if (handle == 0) return IntPtr.Zero;
+            mapped = NativePlatform.native_map_ring(handle, bytes);
+            return mapped;
+        }
 
-        // ====================================================================
-        // UTILITY FUNCTIONS
-        // ====================================================================
+        public int Commit(int bytesWritten)
+        {
+            if (handle == 0) return -1;
+            mapped = IntPtr.Zero;
+            return NativePlatform.native_commit_ring(handle, bytesWritten);
+        }
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern long native_get_memory_usage();
+        /// <summary>
+        /// Maps, copies and commits in one go. Returns the byte offset or -1
+        /// </summary>
+        public unsafe int Write<T>(ReadOnlySpan<T> data) where T : unmanaged
+        {
+            ReadOnlySpan<byte> bytes = MemoryMarshal.AsBytes(data);
+            IntPtr ptr = Map(bytes.Length);
+            if (ptr == IntPtr.Zero) return -1;
 
-        [DllImport(NATIVE_LIB, CallingConvention = CallingConvention.Cdecl)]
-        public static extern double native_get_time();
+            bytes.CopyTo(new Span<byte>((void*)ptr, bytes.Length));
+            return Commit(bytes.Length);
+        }
+
+        public void Dispose()
+        {
+            if (handle != 0)
+            {
+                NativePlatform.native_destroy_stream_buffer(handle);
+                handle = 0;
+            }
+        }
+
+        public bool IsValid() => handle != 0;
+        public int GetSize() => size;
+        public uint GetBufferId() => handle != 0 ? NativePlatform.native_get_ring_buffer_id(handle) : 0;
+        public StreamBufferMode GetMode() => (StreamBufferMode)NativePlatform.native_get_stream_buffer_mode(handle);
     }
 
     /// <summary>
-    /// High-level C# wrapper for platform functionality
+    /// Memory-mapped asset pack built by tools/build/build.py. Spans returned by TryGetSpan
+    /// point into the mapping and stay valid until the archive is disposed.
     /// </summary>
-    public class Platform
+    public unsafe class AssetArchive : IDisposable
     {
-        private static bool initialized = false;
-        private static int windowWidth;
-        private static int windowHeight;
+        private int handle;
+        private readonly string path;
 
-        public static bool Initialize(int width, int height, string title, 
-            bool fullscreen = false, bool vsync = true)
+        private AssetArchive(int handle, string path)
         {
-            if (initialized)
+            this.handle = handle;
+            this.path = path;
+        }
+
+        /// <summary>Returns null if the file is missing or isn't a valid archive</summary>
+        public static AssetArchive Open(string path)
+        {
+            int handle;
+            using (var utf8 = new Utf8Buffer(path, stackalloc byte[512]))
             {
-                Console.WriteLine("Platform already initialized");
-                return true;
+                fixed (byte* pathPtr = utf8)
+                    handle = NativePlatform.native_archive_open(pathPtr);
             }
+            return handle != 0 ? new AssetArchive(handle, path) : null;
+        }
 
-            int result = NativePlatform.native_init_window(
-                width, height, title,
-                fullscreen ? 1 : 0, vsync ? 1 : 0
-            );
+        public bool TryGetEntry(string assetPath, out ArchiveEntryInfo info)
+        {
+            using var utf8 = new Utf8Buffer(assetPath, stackalloc byte[256]);
+            return TryGetEntry(utf8.Bytes, out info);
+        }
 
-            if (result == 1)
+        /// <summary>Lookup by a pre-encoded UTF-8 path (e.g. a "sprites/hero.png"u8 literal), no terminator needed</summary>
+        public bool TryGetEntry(ReadOnlySpan<byte> utf8Path, out ArchiveEntryInfo info)
+        {
+            if (handle == 0)
             {
-                initialized = true;
-                windowWidth = width;
-                windowHeight = height;
-                Console.WriteLine($"Platform initialized: {width}x{height}");
-                return true;
+                info = default;
+                return false;
             }
-
-            Console.WriteLine("Failed to initialize platform");
-            return false;
+            fixed (byte* path = utf8Path)
+                return NativePlatform.native_archive_find_span(handle, path, utf8Path.Length, out info) >= 0;
         }
 
-        public static void Shutdown()
+        /// <summary>Stored bytes of an entry, without copying. Compressed entries come back still compressed.</summary>
+        public unsafe bool TryGetSpan(string assetPath, out ReadOnlySpan<byte> data, out ArchiveEntryInfo info)
         {
-            if (initialized)
+            if (!TryGetEntry(assetPath, out info))
             {
-                NativePlatform.native_destroy_window();
-                initialized = false;
-                Console.WriteLine("Platform shutdown complete");
+                data = ReadOnlySpan<byte>.Empty;
+                return false;
             }
+            data = new ReadOnlySpan<byte>((void*)info.data, checked((int)info.size));
+            return true;
         }
 
-        public static void Update()
+        public const int CompressionNone = 0;
+        public const int CompressionLz4Chunked = 1;
+
+        /// <summary>Independently decodable chunks in a compressed entry; 0 for stored entries</summary>
+        public int GetChunkCount(in ArchiveEntryInfo info)
         {
-            if (!initialized) return;
-            NativePlatform.native_update();
+            return handle != 0 ? NativePlatform.native_archive_chunk_count(handle, info.index) : 0;
         }
 
-        public static void Present()
+        /// <summary>
+        /// Decodes chunks [first, first + count) into their place in output, which must cover the
+        /// whole entry (rawSize bytes). Disjoint chunk ranges may be decoded from different threads.
+        /// </summary>
+        public unsafe bool DecodeChunks(in ArchiveEntryInfo info, int first, int count, Span<byte> output)
         {
-            if (!initialized) return;
-            NativePlatform.native_present();
+            if (handle == 0) return false;
+            fixed (byte* dst = output)
+            {
+                return NativePlatform.native_archive_decode_chunks(handle, info.index, first, count,
+                    (IntPtr)dst, output.Length) != 0;
+            }
         }
 
-        public static bool IsWindowOpen()
+        public void Prefetch(in ArchiveEntryInfo info)
         {
-            if (!initialized) return false;
-            return NativePlatform.native_is_window_open() == 1;
+            if (handle != 0) NativePlatform.native_archive_prefetch(handle, info.index);
         }
 
-        public static void GetWindowSize(out int width, out int height)
+        public int GetEntryCount() => handle != 0 ? NativePlatform.native_archive_entry_count(handle) : 0;
+        public string GetPath() => path;
+        public bool IsValid() => handle != 0;
+
+        public void Dispose()
         {
-            if (initialized)
+            if (handle != 0)
             {
-                NativePlatform.native_get_window_size(out width, out height);
-                windowWidth = width;
-                windowHeight = height;
-            }
-            else
-            {
-                width = 0;
-                height = 0;
+                NativePlatform.native_archive_close(handle);
+                handle = 0;
             }
         }
+    }
 
-        public static int GetWindowWidth()
+    /// <summary>
+    /// Performance monitoring utilities
+    /// </summary>
+    public class Performance
+    {
+        // Frame times are sampled natively in native_update; this is the last snapshot
+        private static FrameStats window;
+
+        /// <summary>
+        /// Refreshes the cached rolling-window stats. Call once per frame
+        /// </summary>
+        public static void Update()
         {
-            GetWindowSize(out int w, out int h);
-            return w;
+            NativePlatform.native_get_frame_stats((int)FrameStatsScope.Window, out window);
         }
 
-        public static int GetWindowHeight()
+        /// <summary>
+        /// Allocation-free query of either histogram
+        /// </summary>
+        public static void GetFrameStats(FrameStatsScope scope, out FrameStats stats)
         {
-            GetWindowSize(out int w, out int h);
-            return h;
+            NativePlatform.native_get_frame_stats((int)scope, out stats);
         }
 
-        public static double GetDeltaTime()
+        public static void SetStatsWindow(int frames)
         {
-            if (!initialized) return 0.0;
-            return NativePlatform.native_get_delta_time();
+            NativePlatform.native_set_frame_stats_window(frames);
         }
 
-        public static void Clear(float r, float g, float b, float a = 1.0f)
+        /// <summary>
+        /// Threshold for the over-budget count; 0 follows the target FPS
+        /// </summary>
+        public static void SetFrameBudget(double budgetMs)
         {
-            if (!initialized) return;
-            NativePlatform.native_clear(r, g, b, a);
+            NativePlatform.native_set_frame_budget_ms(budgetMs);
         }
 
-        public static long GetMemoryUsage()
+        public static void ResetFrameStats()
         {
-            return NativePlatform.native_get_memory_usage();
+            NativePlatform.native_reset_frame_stats();
+            window = default;
         }
 
-        public static double GetTime()
+        public static double GetAverageFPS()
         {
-            return NativePlatform.native_get_time();
+            return window.meanMs > 0 ? 1000.0 / window.meanMs : 0;
         }
 
-        public static bool IsInitialized() => initialized;
+        public static double GetP99FrameTimeMs() => window.p99Ms;
+
+        public static double GetCurrentFPS()
+        {
+            double deltaTime = Platform.GetDeltaTime();
+            return deltaTime > 0 ? 1.0 / deltaTime : 0;
+        }
+
+        public static long GetMemoryUsageMB()
+        {
+            return Platform.GetMemoryUsage() / (1024 * 1024);
+        }
+
+        private static string ToMB(long bytes) => bytes < 0 ? "?" : (bytes / (1024 * 1024)).ToString();
+
+        public static void PrintStats()
+        {
+            Console.WriteLine($"FPS: {GetCurrentFPS():F1} (Avg: {GetAverageFPS():F1})");
+            MemoryStats memory = Platform.GetMemoryStats();
+            Console.WriteLine($"Memory: {ToMB(memory.residentBytes)} MB (Peak: {ToMB(memory.peakResidentBytes)} MB, Committed: {ToMB(memory.committedBytes)} MB)");
+            if (memory.gpuAvailableBytes >= 0)
+                Console.WriteLine($"GPU Memory: {ToMB(memory.gpuAvailableBytes)} MB free of {ToMB(memory.gpuTotalBytes)} MB");
+            Console.WriteLine($"Delta Time: {Platform.GetDeltaTime() * 1000:F2} ms");
+            Console.WriteLine($"Frame Time: p50 {window.p50Ms:F2} / p95 {window.p95Ms:F2} / p99 {window.p99Ms:F2} / max {window.maxMs:F2} ms, {window.overBudget}/{window.frames} over {window.budgetMs:F2} ms");
+
+            FramePacingStats pacing = Platform.GetFramePacingStats();
+            Console.WriteLine($"Missed Deadlines: {pacing.missedDeadlines}/{pacing.frames} (vsync {(pacing.vsync != 0 ? "on" : "off")})");
+        }
     }
 
     /// <summary>
-    /// Shader management wrapper
+    /// Static profiler scope id. Register once (e.g. in a static readonly field), reuse every frame
     /// </summary>
-    public class Shader
+    public readonly struct ProfilerMarker
     {
-        private uint shaderId;
-        private bool isValid;
+        public readonly int Id;
 
-        public Shader(string vertexSource, string fragmentSource)
+        public ProfilerMarker(int id)
         {
-            shaderId = NativePlatform.native_create_shader(vertexSource, fragmentSource);
-            isValid = shaderId != 0;
+            Id = id;
+        }
 
-            if (!isValid)
+        public bool IsValid => Id > 0;
+    }
+
+    /// <summary>
+    /// Hierarchical CPU/GPU profiler. Managed scopes are recorded into per-thread rings without
+    /// locks or P/Invoke; native scopes and GPU timer queries are merged at capture time.
+    /// </summary>
+    public static unsafe class Profiler
+    {
+        // Managed thread ids are offset so they never collide with native (1-64), GPU (0) or counter (-1) tracks
+        private const int MANAGED_THREAD_BASE = 1000;
+        private const int COUNTER_THREAD = -1;
+        private const int RING_SIZE = 16384;
+        private const int MAX_DEPTH = 32;
+
+        private class ThreadBuffer
+        {
+            public readonly ProfileEvent[] events = new ProfileEvent[RING_SIZE];
+            public long write;
+            public long read;
+            public int threadId;
+            public string name;
+            public int depth;
+            public readonly long[] stackStart = new long[MAX_DEPTH];
+            public readonly int[] stackMarker = new int[MAX_DEPTH];
+        }
+
+        /// <summary>
+        /// Begin/End pair for `using` blocks; a struct, so no allocation
+        /// </summary>
+        public readonly struct Scope : IDisposable
+        {
+            private readonly int marker;
+
+            public Scope(ProfilerMarker marker)
             {
-                Console.WriteLine("Failed to create shader");
+                this.marker = marker.Id;
+                Begin(marker);
+            }
+
+            public void Dispose()
+            {
+                End(new ProfilerMarker(marker));
             }
         }
 
-        public void Use()
+        private static volatile bool enabled = false;
+        private static readonly object registryLock = new object();
+        private static readonly List<ThreadBuffer> buffers = new List<ThreadBuffer>();
+        private static readonly Dictionary<string, ProfilerMarker> markers = new Dictionary<string, ProfilerMarker>();
+        private static long droppedManaged = 0;
+        private static readonly ProfileEvent[] collectChunk = new ProfileEvent[4096];   // under registryLock
+
+        [ThreadStatic] private static ThreadBuffer threadBuffer;
+
+        public static ProfilerMarker RegisterMarker(string name)
         {
-            if (isValid)
+            lock (registryLock)
             {
-                NativePlatform.native_use_shader(shaderId);
+                if (markers.TryGetValue(name, out ProfilerMarker existing))
+                    return existing;
+
+                int id;
+                using (var utf8 = new Utf8Buffer(name, stackalloc byte[128]))
+                {
+                    fixed (byte* namePtr = utf8)
+                        id = NativePlatform.native_profiler_register_marker(namePtr);
+                }
+                var marker = new ProfilerMarker(id);
+                markers[name] = marker;
+                return marker;
             }
         }
 
-        public void Dispose()
+        public static bool IsEnabled() => enabled;
+
+        public static void SetEnabled(bool value)
         {
-            if (isValid)
+            enabled = value;
+            NativePlatform.native_profiler_set_enabled(value ? 1 : 0);
+        }
+
+        public static bool IsGpuTimingSupported()
+        {
+            return Platform.IsInitialized() && NativePlatform.native_profiler_gpu_supported() == 1;
+        }
+
+        /// <summary>
+        /// Current time in native tick units (ns), derived from Stopwatch so no P/Invoke is needed.
+        /// Stopwatch reads the same QPC / CLOCK_MONOTONIC source as native_get_ticks.
+        /// </summary>
+        public static long GetTimestamp()
+        {
+            long ts = Stopwatch.GetTimestamp();
+            long freq = Stopwatch.Frequency;
+            if (freq == 1000000000L) return ts;
+            return (ts / freq) * 1000000000L + (ts % freq) * 1000000000L / freq;
+        }
+
+        public static Scope Sample(ProfilerMarker marker) => new Scope(marker);
+
+        public static void Begin(ProfilerMarker marker)
+        {
+            if (!enabled) return;
+            ThreadBuffer buffer = threadBuffer ?? CreateThreadBuffer();
+
+            if (buffer.depth < MAX_DEPTH)
             {
-                NativePlatform.native_delete_shader(shaderId);
-                isValid = false;
+                buffer.stackMarker[buffer.depth] = marker.Id;
+                buffer.stackStart[buffer.depth] = GetTimestamp();
             }
+            buffer.depth++;
         }
 
-        public bool IsValid() => isValid;
-        public uint GetId() => shaderId;
-    }
+        public static void End(ProfilerMarker marker)
+        {
+            ThreadBuffer buffer = threadBuffer;
+            if (buffer == null || buffer.depth == 0) return;
 
-    /// <summary>
-    /// Performance monitoring utilities
-    /// </summary>
-    public class Performance
-    {
-        private static double lastFrameTime = 0;
-        private static double[] frameTimes = new double[60];
-        private static int frameIndex = 0;
-        private static int frameCount = 0;
+            buffer.depth--;
+            if (buffer.depth >= MAX_DEPTH || buffer.stackMarker[buffer.depth] != marker.Id) return;
+            if (!enabled) return;
 
-        public static void Update()
+            long write = buffer.write;
+            ref ProfileEvent e = ref buffer.events[write & (RING_SIZE - 1)];
+            e.startTicks = buffer.stackStart[buffer.depth];
+            e.endTicks = GetTimestamp();
+            e.marker = marker.Id;
+            e.threadId = buffer.threadId;
+            e.depth = buffer.depth;
+            e.value = 0;
+            Volatile.Write(ref buffer.write, write + 1);
+        }
+
+        /// <summary>
+        /// GPU scope around native draw calls issued between the two calls (GL thread only)
+        /// </summary>
+        public static void BeginGpu(ProfilerMarker marker)
         {
-            double currentTime = Platform.GetTime();
-            double deltaTime = currentTime - lastFrameTime;
-            lastFrameTime = currentTime;
+            if (enabled) NativeCalls.GpuMarkerBegin(marker.Id);
+        }
 
-            frameTimes[frameIndex] = deltaTime;
-            frameIndex = (frameIndex + 1) % frameTimes.Length;
-            frameCount++;
+        public static void EndGpu(ProfilerMarker marker)
+        {
+            if (enabled) NativeCalls.GpuMarkerEnd(marker.Id);
         }
 
-        public static double GetAverageFPS()
+        private static ThreadBuffer CreateThreadBuffer()
         {
-            if (frameCount == 0) return 0;
+            var buffer = new ThreadBuffer();
+            Thread thread = Thread.CurrentThread;
+            buffer.threadId = MANAGED_THREAD_BASE + thread.ManagedThreadId;
+            buffer.name = thread.Name ?? $"Managed {thread.ManagedThreadId}";
 
-            double sum = 0;
-            int count = Math.Min(frameCount, frameTimes.Length);
-            for (int i = 0; i < count; i++)
+            lock (registryLock)
             {
-                sum += frameTimes[i];
+                buffers.Add(buffer);
             }
+            threadBuffer = buffer;
+            return buffer;
+        }
 
-            double avgDelta = sum / count;
-            return avgDelta > 0 ? 1.0 / avgDelta : 0;
+        /// <summary>
+        /// Enables recording and discards anything recorded so far
+        /// </summary>
+        public static void BeginCapture()
+        {
+            SetEnabled(true);
+            Collect(null);
         }
 
-        public static double GetCurrentFPS()
+        /// <summary>
+        /// Stops recording and writes everything captured to a Chrome trace (chrome://tracing, Perfetto)
+        /// </summary>
+        public static int EndCapture(string path)
         {
-            double deltaTime = Platform.GetDeltaTime();
-            return deltaTime > 0 ? 1.0 / deltaTime : 0;
+            SetEnabled(false);
+            var events = new List<ProfileEvent>();
+            Collect(events);
+            ExportChromeTrace(path, events);
+            return events.Count;
         }
 
-        public static long GetMemoryUsageMB()
+        /// <summary>
+        /// Drains managed and native rings into `events` (null discards)
+        /// </summary>
+        public static void Collect(List<ProfileEvent> events)
         {
-            return Platform.GetMemoryUsage() / (1024 * 1024);
+            lock (registryLock)
+            {
+                foreach (ThreadBuffer buffer in buffers)
+                {
+                    long write = Volatile.Read(ref buffer.write);
+                    long read = buffer.read;
+                    if (write - read > RING_SIZE)
+                    {
+                        droppedManaged += write - read - RING_SIZE;
+                        read = write - RING_SIZE;
+                    }
+                    if (events != null)
+                    {
+                        for (long i = read; i < write; i++)
+                            events.Add(buffer.events[i & (RING_SIZE - 1)]);
+                    }
+                    buffer.read = write;
+                }
+
+                // collectChunk is shared, so the native drain stays under the lock too
+                int count;
+                while ((count = NativePlatform.native_profiler_collect(collectChunk, collectChunk.Length)) > 0)
+                {
+                    if (events != null)
+                    {
+                        for (int i = 0; i < count; i++)
+                            events.Add(collectChunk[i]);
+                    }
+                    if (count < collectChunk.Length) break;
+                }
+            }
         }
 
-        public static void PrintStats()
+        public static long GetDroppedEvents()
         {
-            Console.WriteLine($"FPS: {GetCurrentFPS():F1} (Avg: {GetAverageFPS():F1})");
-            Console.WriteLine($"Memory: {GetMemoryUsageMB()} MB");
-            Console.WriteLine($"Delta Time: {Platform.GetDeltaTime() * 1000:F2} ms");
+            return droppedManaged + NativePlatform.native_profiler_get_dropped();
+        }
+
+        /// <summary>
+        /// Redundant GL calls skipped by the native state cache. The per-frame emitted/filtered
+        /// counts also appear as gl_calls_emitted / gl_calls_filtered counters in captures.
+        /// </summary>
+        public static GLStateStats GetGLStateStats()
+        {
+            NativePlatform.native_get_gl_state_stats(out GLStateStats stats);
+            return stats;
+        }
+
+        public static void ResetGLStateStats() => NativePlatform.native_reset_gl_state_stats();
+
+        /// <summary>Off sends every state call to the driver, to measure what the cache saves</summary>
+        public static void SetGLStateCacheEnabled(bool value) => NativePlatform.native_set_gl_state_cache(value ? 1 : 0);
+
+        public static void PrintGLStateStats()
+        {
+            GLStateStats stats = GetGLStateStats();
+            Console.WriteLine($"GL State Cache: {(stats.enabled != 0 ? "on" : "off")}, {stats.total.emitted} emitted / {stats.total.filtered} filtered over {stats.frames} frames ({stats.total.FilteredRatio * 100:F1}% filtered)");
+            Console.WriteLine($"  Last frame: {stats.lastFrame.emitted} emitted / {stats.lastFrame.filtered} filtered");
+            PrintCounts("Programs", stats.programs);
+            PrintCounts("Textures", stats.textures);
+            PrintCounts("Buffers", stats.buffers);
+            PrintCounts("Blend", stats.blend);
+            PrintCounts("Depth", stats.depth);
+            PrintCounts("Viewport", stats.viewport);
+            PrintCounts("Clear Color", stats.clearColor);
+            PrintCounts("Vertex Arrays", stats.vertexArrays);
+        }
+
+        private static void PrintCounts(string name, GLStateCounts counts)
+        {
+            if (counts.Total > 0)
+                Console.WriteLine($"  {name}: {counts.emitted} / {counts.filtered}");
+        }
+
+        public static string GetMarkerName(int marker)
+        {
+            IntPtr name = NativePlatform.native_profiler_get_marker_name(marker);
+            return name != IntPtr.Zero ? Marshal.PtrToStringAnsi(name) : $"marker_{marker}";
+        }
+
+        public static void ExportChromeTrace(string path, List<ProfileEvent> events)
+        {
+            long origin = long.MaxValue;
+            foreach (var e in events)
+                origin = Math.Min(origin, e.startTicks);
+            if (origin == long.MaxValue) origin = 0;
+
+            var names = new Dictionary<int, string>();
+            var threads = new Dictionary<int, string>();
+            threads[0] = "GPU";
+            lock (registryLock)
+            {
+                foreach (ThreadBuffer buffer in buffers)
+                    threads[buffer.threadId] = buffer.name;
+            }
+
+            using (var writer = new StreamWriter(path, false, new UTF8Encoding(false)))
+            {
+                writer.Write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+                bool first = true;
+
+                foreach (var e in events)
+                {
+                    if (!names.TryGetValue(e.marker, out string name))
+                    {
+                        name = EscapeJson(GetMarkerName(e.marker));
+                        names[e.marker] = name;
+                    }
+
+                    if (e.threadId == COUNTER_THREAD)
+                    {
+                        writer.Write(first ? "\n" : ",\n");
+                        writer.Write(string.Format(CultureInfo.InvariantCulture,
+                            "{{\"name\":\"{0}\",\"ph\":\"C\",\"pid\":1,\"ts\":{1:F3},\"args\":{{\"value\":{2}}}}}",
+                            name, (e.startTicks - origin) / 1000.0, e.value));
+                        first = false;
+                        continue;
+                    }
+                    if (!threads.ContainsKey(e.threadId))
+                        threads[e.threadId] = $"Native {e.threadId}";
+
+                    double ts = (e.startTicks - origin) / 1000.0;
+                    double dur = (e.endTicks - e.startTicks) / 1000.0;
+                    writer.Write(first ? "\n" : ",\n");
+                    writer.Write(string.Format(CultureInfo.InvariantCulture,
+                        "{{\"name\":\"{0}\",\"ph\":\"X\",\"pid\":1,\"tid\":{1},\"ts\":{2:F3},\"dur\":{3:F3},\"args\":{{\"depth\":{4}}}}}",
+                        name, e.threadId, ts, dur, e.depth));
+                    first = false;
+                }
+
+                foreach (var kvp in threads)
+                {
+                    writer.Write(first ? "\n" : ",\n");
+                    writer.Write(string.Format(CultureInfo.InvariantCulture,
+                        "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{0},\"args\":{{\"name\":\"{1}\"}}}}",
+                        kvp.Key, EscapeJson(kvp.Value)));
+                    first = false;
+                }
+
+                writer.Write("\n]}\n");
+            }
+        }
+
+        private static string EscapeJson(string value)
+        {
+            var sb = new StringBuilder(value.Length + 8);
+            foreach (char c in value)
+            {
+                switch (c)
+                {
+                    case '"': sb.Append("\\\""); break;
+                    case '\\': sb.Append("\\\\"); break;
+                    case '\n': sb.Append("\\n"); break;
+                    case '\r': sb.Append("\\r"); break;
+                    case '\t': sb.Append("\\t"); break;
+                    default:
+                        if (c < 0x20) sb.Append($"\\u{(int)c:X4}");
+                        else sb.Append(c);
+                        break;
+                }
+            }
+            return sb.ToString();
         }
     }
 }
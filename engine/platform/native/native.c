@@ -4,25 +4,82 @@
  * Optimized for old hardware (OpenGL 2.1+ support)
  */
 
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+    #define _DEFAULT_SOURCE /* clock_gettime, nanosleep */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#ifdef _MSC_VER
+    #define PF_THREAD_LOCAL __declspec(thread)
+#else
+    #define PF_THREAD_LOCAL _Thread_local
+#endif
+
+/* Vector paths for the audio mixer; everything has a scalar fallback */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PF_SIMD_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define PF_SIMD_NEON
+    #include <arm_neon.h>
+#endif
 
 #ifdef _WIN32
     #define WIN32_LEAN_AND_MEAN
+    #define COBJMACROS
     #include <windows.h>
+    #include <psapi.h>
+    #include <objbase.h>
+    #include <mmreg.h>
+    #include <mmdeviceapi.h>
+    #include <audioclient.h>
     #include <GL/gl.h>
+    #include <GL/glext.h>
     #pragma comment(lib, "opengl32.lib")
+    #pragma comment(lib, "winmm.lib")
+    #pragma comment(lib, "psapi.lib")
+    #pragma comment(lib, "ole32.lib")
 #elif __APPLE__
     #include <OpenGL/gl.h>
     #include <OpenGL/glu.h>
     #include <GLUT/glut.h>
+    #include <AudioToolbox/AudioToolbox.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <mach/mach.h>
+    #include <dirent.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <sys/resource.h>
+    #include <sys/mman.h>
 #else
     #include <GL/gl.h>
     #include <GL/glx.h>
     #include <X11/Xlib.h>
     #include <X11/Xutil.h>
+    #include <X11/keysym.h>
+    #include <dlfcn.h>
+    #include <dirent.h>
+    #include <errno.h>
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <sys/resource.h>
+    #include <sys/mman.h>
 #endif
 
 /* ============================================================================
@@ -35,6 +92,7 @@ typedef struct {
     const char* title;
     bool fullscreen;
     bool vsync;
+    bool headless;          /* offscreen: GLX pbuffer, or a never-shown window on Windows */
     int gl_major;
     int gl_minor;
 } WindowConfig;
@@ -44,14 +102,553 @@ typedef struct {
     void* gl_context;
     int width;
     int height;
+    void* device_context;   /* HDC on Windows; owned by the CS_OWNDC window class */
     bool is_open;
-    double last_time;
+    bool headless;
+    int64_t last_ticks;
     double delta_time;
 } WindowState;
 
 /* Global window state */
 static WindowState g_window = {0};
 
+/* Ticks at points of window startup, 0 until reached. Layout must match StartupStats in bindings.cs */
+typedef struct {
+    int64_t init_begin;
+    int64_t context_ready;      /* window and GL context exist, extensions loaded */
+    int64_t init_end;           /* shared contexts and default state set up */
+    int64_t first_present;      /* first swap returned; written by the GL thread */
+} StartupStats;
+
+static StartupStats g_startup = {0};
+static atomic_llong g_first_present = 0;
+
+#define PF_SHARED_STATE_VERSION 1
+
+/*
+ * Window and frame state the managed side reads straight from memory instead of calling
+ * for it. Published on the main thread by native_update and window create/destroy, so it
+ * is stable between updates. Layout must match SharedState in bindings.cs
+ */
+typedef struct {
+    int32_t size;               /* sizeof(SharedState), checked before use */
+    int32_t version;
+    int64_t frame;              /* native_update calls since the window opened */
+    int64_t update_ticks;       /* native_get_ticks at the last native_update */
+    int64_t tick_frequency;
+    double delta_time;
+    const void* input;          /* front InputSnapshot */
+    int32_t width;
+    int32_t height;
+    int32_t is_open;
+    int32_t headless;
+} SharedState;
+
+static SharedState g_shared = {0};
+
+/* ============================================================================
+ * HIGH-RESOLUTION CLOCK
+ * Monotonic nanosecond ticks: QueryPerformanceCounter on Windows,
+ * CLOCK_MONOTONIC elsewhere.
+ * ============================================================================ */
+
+#define PF_TICKS_PER_SECOND 1000000000LL
+
+int64_t native_get_ticks() {
+    #ifdef _WIN32
+        static LARGE_INTEGER frequency = {0};
+        if (frequency.QuadPart == 0) {
+            QueryPerformanceFrequency(&frequency);
+        }
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+
+        /* Split the conversion so counter * 1e9 cannot overflow */
+        int64_t seconds = counter.QuadPart / frequency.QuadPart;
+        int64_t remainder = counter.QuadPart % frequency.QuadPart;
+        return seconds * PF_TICKS_PER_SECOND + remainder * PF_TICKS_PER_SECOND / frequency.QuadPart;
+    #else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * PF_TICKS_PER_SECOND + ts.tv_nsec;
+    #endif
+}
+
+int64_t native_get_tick_frequency() {
+    return PF_TICKS_PER_SECOND;
+}
+
+/* ============================================================================
+ * UTF-8 STRINGS
+ * Every string crossing the API is NUL-terminated UTF-8. Windows file and window
+ * APIs take it as UTF-16; elsewhere the bytes pass through unchanged.
+ * ============================================================================ */
+
+#ifdef _WIN32
+/* Caller frees; NULL on invalid input */
+static wchar_t* utf8_to_wide(const char* text) {
+    int length = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text, -1, NULL, 0);
+    if (length <= 0) return NULL;
+    wchar_t* wide = (wchar_t*)malloc((size_t)length * sizeof(wchar_t));
+    if (wide) MultiByteToWideChar(CP_UTF8, 0, text, -1, wide, length);
+    return wide;
+}
+#endif
+
+static FILE* utf8_fopen(const char* path, const char* mode) {
+    #ifdef _WIN32
+        wchar_t* wide_path = utf8_to_wide(path);
+        wchar_t* wide_mode = utf8_to_wide(mode);
+        FILE* file = wide_path && wide_mode ? _wfopen(wide_path, wide_mode) : NULL;
+        free(wide_path);
+        free(wide_mode);
+        return file;
+    #else
+        return fopen(path, mode);
+    #endif
+}
+
+/* Moves from over to, replacing it in one step, so readers never see a partial file */
+static bool utf8_replace_file(const char* from, const char* to) {
+    #ifdef _WIN32
+        wchar_t* wide_from = utf8_to_wide(from);
+        wchar_t* wide_to = utf8_to_wide(to);
+        bool ok = wide_from && wide_to && MoveFileExW(wide_from, wide_to, MOVEFILE_REPLACE_EXISTING);
+        free(wide_from);
+        free(wide_to);
+        return ok;
+    #else
+        return rename(from, to) == 0;
+    #endif
+}
+
+/* ============================================================================
+ * THREADING PRIMITIVES
+ * Thin wrappers over Win32 and pthreads for the native worker threads.
+ * ============================================================================ */
+
+#ifdef _WIN32
+    typedef HANDLE pf_thread;
+    typedef CRITICAL_SECTION pf_mutex;
+    typedef CONDITION_VARIABLE pf_cond;
+#else
+    typedef pthread_t pf_thread;
+    typedef pthread_mutex_t pf_mutex;
+    typedef pthread_cond_t pf_cond;
+#endif
+
+typedef void (*pf_thread_fn)(void* arg);
+
+typedef struct {
+    pf_thread_fn fn;
+    void* arg;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID param) {
+#else
+static void* thread_entry(void* param) {
+#endif
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.fn(start.arg);
+    return 0;
+}
+
+static bool pf_thread_start(pf_thread* thread, pf_thread_fn fn, void* arg) {
+    ThreadStart* start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if (!start) return false;
+    start->fn = fn;
+    start->arg = arg;
+
+    #ifdef _WIN32
+        *thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+        if (*thread == NULL) {
+            free(start);
+            return false;
+        }
+    #else
+        if (pthread_create(thread, NULL, thread_entry, start) != 0) {
+            free(start);
+            return false;
+        }
+    #endif
+    return true;
+}
+
+static void pf_thread_join(pf_thread thread) {
+    #ifdef _WIN32
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    #else
+        pthread_join(thread, NULL);
+    #endif
+}
+
+static void pf_mutex_init(pf_mutex* m) {
+    #ifdef _WIN32
+        InitializeCriticalSection(m);
+    #else
+        pthread_mutex_init(m, NULL);
+    #endif
+}
+
+static void pf_mutex_destroy(pf_mutex* m) {
+    #ifdef _WIN32
+        DeleteCriticalSection(m);
+    #else
+        pthread_mutex_destroy(m);
+    #endif
+}
+
+static void pf_mutex_lock(pf_mutex* m) {
+    #ifdef _WIN32
+        EnterCriticalSection(m);
+    #else
+        pthread_mutex_lock(m);
+    #endif
+}
+
+static void pf_mutex_unlock(pf_mutex* m) {
+    #ifdef _WIN32
+        LeaveCriticalSection(m);
+    #else
+        pthread_mutex_unlock(m);
+    #endif
+}
+
+static void pf_cond_init(pf_cond* c) {
+    #ifdef _WIN32
+        InitializeConditionVariable(c);
+    #else
+        pthread_cond_init(c, NULL);
+    #endif
+}
+
+static void pf_cond_destroy(pf_cond* c) {
+    #ifdef _WIN32
+        (void)c;
+    #else
+        pthread_cond_destroy(c);
+    #endif
+}
+
+static void pf_cond_wait(pf_cond* c, pf_mutex* m) {
+    #ifdef _WIN32
+        SleepConditionVariableCS(c, m, INFINITE);
+    #else
+        pthread_cond_wait(c, m);
+    #endif
+}
+
+static void pf_cond_broadcast(pf_cond* c) {
+    #ifdef _WIN32
+        WakeAllConditionVariable(c);
+    #else
+        pthread_cond_broadcast(c);
+    #endif
+}
+
+/* One-time init for zero-initialized statics reachable from any thread.
+ * State: 0 = untouched, 1 = initializing, 2 = done. */
+static bool pf_once_done(atomic_int* state) {
+    return atomic_load_explicit(state, memory_order_acquire) == 2;
+}
+
+/* True for the one caller that must run the init and then pf_once_end();
+ * everyone else returns false once that init has finished */
+static bool pf_once_begin(atomic_int* state) {
+    if (pf_once_done(state)) return false;
+    int expected = 0;
+    if (atomic_compare_exchange_strong_explicit(state, &expected, 1,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        return true;
+    }
+    while (!pf_once_done(state)) {
+        #ifdef _WIN32
+            SwitchToThread();
+        #else
+            sched_yield();
+        #endif
+    }
+    return false;
+}
+
+static void pf_once_end(atomic_int* state) {
+    atomic_store_explicit(state, 2, memory_order_release);
+}
+
+/* Mutex for statics used before any init call; the first locker creates it */
+typedef struct {
+    pf_mutex mutex;
+    atomic_int state;
+} pf_lazy_mutex;
+
+static bool pf_lazy_mutex_ready(pf_lazy_mutex* m) {
+    return pf_once_done(&m->state);
+}
+
+static void pf_lazy_mutex_lock(pf_lazy_mutex* m) {
+    if (pf_once_begin(&m->state)) {
+        pf_mutex_init(&m->mutex);
+        pf_once_end(&m->state);
+    }
+    pf_mutex_lock(&m->mutex);
+}
+
+static void pf_lazy_mutex_unlock(pf_lazy_mutex* m) {
+    pf_mutex_unlock(&m->mutex);
+}
+
+/* Vertex attribute slots bound at link time by native_create_shader */
+#define PF_ATTRIB_POSITION 0
+#define PF_ATTRIB_TEXCOORD 1
+#define PF_ATTRIB_COLOR    2
+
+static void batcher_shutdown();
+static void batcher_execute(const void* payload);
+static void present_now();
+typedef void (*render_call_fn)(void* args);
+static bool render_deferred();
+static void render_call(render_call_fn fn, void* args);
+static void render_record_gpu_marker(int marker, bool begin);
+static void render_viewport(int width, int height);
+static void texture_init();
+static void texture_frame();
+static void texture_shutdown();
+static void shader_reload_init();
+static void shader_reload_frame();
+static void shader_reload_shutdown();
+static void shader_reload_forget(GLuint program);
+
+/* Executed by the render thread, from its command buffer or a synchronous call */
+void native_set_target_fps(double fps);
+int native_set_vsync(int enabled);
+unsigned int native_create_shader(const char* vertex_src, const char* fragment_src);
+unsigned int native_create_texture(int width, int height, int format, int levels);
+void native_clear(float r, float g, float b, float a);
+void native_use_shader(unsigned int shader_id);
+void native_delete_shader(unsigned int shader_id);
+void native_destroy_stream_buffer(int handle);
+
+/* ============================================================================
+ * INPUT SNAPSHOT
+ * native_poll_events records keys, buttons and text into a back snapshot and
+ * publishes it when the OS queue is drained; C# reads the front snapshot
+ * through one pointer, valid until the next poll. Key and button state are
+ * bitsets; each frame also carries a ring of timestamped events so presses
+ * shorter than a frame are not lost. Key codes follow the GLFW numbering:
+ * printable keys are their uppercase ASCII value.
+ * ============================================================================ */
+
+#define PF_KEY_COUNT 512
+#define PF_KEY_WORDS (PF_KEY_COUNT / 64)
+#define PF_INPUT_EVENT_CAPACITY 128   /* per frame, power of two */
+
+enum {
+    PF_KEY_UNKNOWN = 0,
+    PF_KEY_SPACE = 32,
+    PF_KEY_ESCAPE = 256, PF_KEY_ENTER, PF_KEY_TAB, PF_KEY_BACKSPACE, PF_KEY_INSERT, PF_KEY_DELETE,
+    PF_KEY_RIGHT, PF_KEY_LEFT, PF_KEY_DOWN, PF_KEY_UP, PF_KEY_PAGE_UP, PF_KEY_PAGE_DOWN,
+    PF_KEY_HOME, PF_KEY_END,
+    PF_KEY_F1 = 290,   /* through F12 = 301 */
+    PF_KEY_LEFT_SHIFT = 340, PF_KEY_LEFT_CONTROL, PF_KEY_LEFT_ALT, PF_KEY_LEFT_SUPER,
+    PF_KEY_RIGHT_SHIFT, PF_KEY_RIGHT_CONTROL, PF_KEY_RIGHT_ALT, PF_KEY_RIGHT_SUPER
+};
+
+/* Keep in sync with InputEventType in Input.cs */
+enum {
+    PF_INPUT_KEY_DOWN = 1,
+    PF_INPUT_KEY_UP = 2,
+    PF_INPUT_KEY_REPEAT = 3,
+    PF_INPUT_TEXT = 4,          /* code = Unicode code point */
+    PF_INPUT_BUTTON_DOWN = 5,
+    PF_INPUT_BUTTON_UP = 6,
+    PF_INPUT_WHEEL = 7          /* x/y = wheel steps * 120 */
+};
+
+#define PF_MOD_SHIFT   1
+#define PF_MOD_CONTROL 2
+#define PF_MOD_ALT     4
+
+/* Layout shared with InputEvent in Input.cs - keep in sync */
+typedef struct {
+    int64_t ticks;              /* native_get_ticks time the OS delivered the event */
+    int type;
+    int code;                   /* key, button or code point */
+    int x;
+    int y;
+    int modifiers;
+    int reserved;
+} InputEvent;
+
+/* Layout shared with InputSnapshot in Input.cs - keep in sync */
+typedef struct {
+    int64_t frame;
+    int64_t poll_ticks;         /* when this snapshot was published */
+    uint64_t keys_down[PF_KEY_WORDS];
+    uint64_t keys_pressed[PF_KEY_WORDS];    /* went down at least once this frame */
+    uint64_t keys_released[PF_KEY_WORDS];
+    int mouse_x;
+    int mouse_y;
+    int mouse_dx;
+    int mouse_dy;
+    int wheel_x;
+    int wheel_y;
+    int buttons_down;           /* bit n = button n (0 left, 1 right, 2 middle, 3-4 extra) */
+    int buttons_pressed;
+    int buttons_released;
+    int modifiers;
+    int focused;
+    int event_count;            /* events in the ring, oldest at event_start */
+    int event_start;
+    int events_dropped;
+    InputEvent events[PF_INPUT_EVENT_CAPACITY];
+} InputSnapshot;
+
+typedef struct {
+    InputSnapshot snapshots[2];
+    int front;
+    bool mouse_known;
+} InputState;
+
+static InputState g_input = {0};
+
+static InputSnapshot* input_back() {
+    return &g_input.snapshots[g_input.front ^ 1];
+}
+
+static void input_push_event(int type, int code, int x, int y, int64_t ticks) {
+    InputSnapshot* s = input_back();
+    if (s->event_count == PF_INPUT_EVENT_CAPACITY) {
+        /* Keep the newest events */
+        s->event_start = (s->event_start + 1) & (PF_INPUT_EVENT_CAPACITY - 1);
+        s->event_count--;
+        s->events_dropped++;
+    }
+    InputEvent* e = &s->events[(s->event_start + s->event_count) & (PF_INPUT_EVENT_CAPACITY - 1)];
+    e->ticks = ticks;
+    e->type = type;
+    e->code = code;
+    e->x = x;
+    e->y = y;
+    e->modifiers = s->modifiers;
+    e->reserved = 0;
+    s->event_count++;
+}
+
+static void input_update_modifiers(InputSnapshot* s) {
+    #define PF_KEY_BIT(k) ((s->keys_down[(k) >> 6] >> ((k) & 63)) & 1)
+    int mods = 0;
+    if (PF_KEY_BIT(PF_KEY_LEFT_SHIFT) || PF_KEY_BIT(PF_KEY_RIGHT_SHIFT)) mods |= PF_MOD_SHIFT;
+    if (PF_KEY_BIT(PF_KEY_LEFT_CONTROL) || PF_KEY_BIT(PF_KEY_RIGHT_CONTROL)) mods |= PF_MOD_CONTROL;
+    if (PF_KEY_BIT(PF_KEY_LEFT_ALT) || PF_KEY_BIT(PF_KEY_RIGHT_ALT)) mods |= PF_MOD_ALT;
+    s->modifiers = mods;
+    #undef PF_KEY_BIT
+}
+
+static void input_key(int key, bool down, bool repeat, int64_t ticks) {
+    if (key <= 0 || key >= PF_KEY_COUNT) return;
+    InputSnapshot* s = input_back();
+    uint64_t bit = 1ull << (key & 63);
+    int word = key >> 6;
+
+    if (down) {
+        if (!repeat) s->keys_pressed[word] |= bit;
+        s->keys_down[word] |= bit;
+    } else {
+        s->keys_released[word] |= bit;
+        s->keys_down[word] &= ~bit;
+    }
+    input_update_modifiers(s);
+    input_push_event(down ? (repeat ? PF_INPUT_KEY_REPEAT : PF_INPUT_KEY_DOWN) : PF_INPUT_KEY_UP,
+                     key, s->mouse_x, s->mouse_y, ticks);
+}
+
+static void input_text(unsigned int codepoint, int64_t ticks) {
+    /* Control characters arrive as key events already */
+    if (codepoint < 32 || codepoint == 127) return;
+    InputSnapshot* s = input_back();
+    input_push_event(PF_INPUT_TEXT, (int)codepoint, s->mouse_x, s->mouse_y, ticks);
+}
+
+static void input_mouse_move(int x, int y) {
+    InputSnapshot* s = input_back();
+    if (g_input.mouse_known) {
+        s->mouse_dx += x - s->mouse_x;
+        s->mouse_dy += y - s->mouse_y;
+    }
+    s->mouse_x = x;
+    s->mouse_y = y;
+    g_input.mouse_known = true;
+}
+
+static void input_button(int button, bool down, int64_t ticks) {
+    if (button < 0 || button > 30) return;
+    InputSnapshot* s = input_back();
+    int bit = 1 << button;
+    if (down) {
+        s->buttons_down |= bit;
+        s->buttons_pressed |= bit;
+    } else {
+        s->buttons_down &= ~bit;
+        s->buttons_released |= bit;
+    }
+    input_push_event(down ? PF_INPUT_BUTTON_DOWN : PF_INPUT_BUTTON_UP, button, s->mouse_x, s->mouse_y, ticks);
+}
+
+static void input_wheel(int dx, int dy, int64_t ticks) {
+    InputSnapshot* s = input_back();
+    s->wheel_x += dx;
+    s->wheel_y += dy;
+    input_push_event(PF_INPUT_WHEEL, 0, dx, dy, ticks);
+}
+
+/* Releases everything on focus loss so no key stays stuck down */
+static void input_focus(bool focused, int64_t ticks) {
+    InputSnapshot* s = input_back();
+    s->focused = focused ? 1 : 0;
+    if (focused) return;
+
+    for (int word = 0; word < PF_KEY_WORDS; word++) {
+        if (!s->keys_down[word]) continue;
+        for (int bit = 0; bit < 64; bit++) {
+            if (s->keys_down[word] & (1ull << bit)) input_key(word * 64 + bit, false, false, ticks);
+        }
+    }
+    for (int b = 0; b < 31; b++) {
+        if (s->buttons_down & (1 << b)) input_button(b, false, ticks);
+    }
+}
+
+/* End of native_poll_events: the back snapshot becomes the front one, and the
+ * new back starts from its persistent state with per-frame fields cleared */
+static void input_publish() {
+    InputSnapshot* done = input_back();
+    done->frame = g_input.snapshots[g_input.front].frame + 1;
+    done->poll_ticks = native_get_ticks();
+    g_input.front ^= 1;
+
+    InputSnapshot* next = input_back();
+    memcpy(next->keys_down, done->keys_down, sizeof(next->keys_down));
+    memset(next->keys_pressed, 0, sizeof(next->keys_pressed));
+    memset(next->keys_released, 0, sizeof(next->keys_released));
+    next->mouse_x = done->mouse_x;
+    next->mouse_y = done->mouse_y;
+    next->mouse_dx = next->mouse_dy = 0;
+    next->wheel_x = next->wheel_y = 0;
+    next->buttons_down = done->buttons_down;
+    next->buttons_pressed = next->buttons_released = 0;
+    next->modifiers = done->modifiers;
+    next->focused = done->focused;
+    next->event_count = next->event_start = next->events_dropped = 0;
+}
+
+/* Front snapshot; stays unchanged until the next native_poll_events */
+const InputSnapshot* native_get_input_snapshot() {
+    return &g_input.snapshots[g_input.front];
+}
+
 /* ============================================================================
  * PLATFORM-SPECIFIC IMPLEMENTATIONS
  * ============================================================================ */
@@ -59,33 +656,149 @@ static WindowState g_window = {0};
 #ifdef _WIN32
 /* Windows implementation */
 
+static int win32_map_key(WPARAM vk, LPARAM lParam) {
+    if ((vk >= 'A' && vk <= 'Z') || (vk >= '0' && vk <= '9')) return (int)vk;
+    if (vk >= VK_F1 && vk <= VK_F12) return PF_KEY_F1 + (int)(vk - VK_F1);
+
+    bool extended = (lParam >> 24) & 1;
+    switch (vk) {
+        case VK_SPACE: return PF_KEY_SPACE;
+        case VK_ESCAPE: return PF_KEY_ESCAPE;
+        case VK_RETURN: return PF_KEY_ENTER;
+        case VK_TAB: return PF_KEY_TAB;
+        case VK_BACK: return PF_KEY_BACKSPACE;
+        case VK_INSERT: return PF_KEY_INSERT;
+        case VK_DELETE: return PF_KEY_DELETE;
+        case VK_RIGHT: return PF_KEY_RIGHT;
+        case VK_LEFT: return PF_KEY_LEFT;
+        case VK_DOWN: return PF_KEY_DOWN;
+        case VK_UP: return PF_KEY_UP;
+        case VK_PRIOR: return PF_KEY_PAGE_UP;
+        case VK_NEXT: return PF_KEY_PAGE_DOWN;
+        case VK_HOME: return PF_KEY_HOME;
+        case VK_END: return PF_KEY_END;
+        case VK_SHIFT: {
+            UINT scancode = (UINT)((lParam >> 16) & 0xFF);
+            return MapVirtualKey(scancode, MAPVK_VSC_TO_VK_EX) == VK_RSHIFT ? PF_KEY_RIGHT_SHIFT : PF_KEY_LEFT_SHIFT;
+        }
+        case VK_CONTROL: return extended ? PF_KEY_RIGHT_CONTROL : PF_KEY_LEFT_CONTROL;
+        case VK_MENU: return extended ? PF_KEY_RIGHT_ALT : PF_KEY_LEFT_ALT;
+        case VK_LWIN: return PF_KEY_LEFT_SUPER;
+        case VK_RWIN: return PF_KEY_RIGHT_SUPER;
+        case VK_OEM_1: return ';';
+        case VK_OEM_PLUS: return '=';
+        case VK_OEM_COMMA: return ',';
+        case VK_OEM_MINUS: return '-';
+        case VK_OEM_PERIOD: return '.';
+        case VK_OEM_2: return '/';
+        case VK_OEM_3: return '`';
+        case VK_OEM_4: return '[';
+        case VK_OEM_5: return '\\';
+        case VK_OEM_6: return ']';
+        case VK_OEM_7: return '\'';
+    }
+    return PF_KEY_UNKNOWN;
+}
+
+/* GetMessageTime is in GetTickCount milliseconds; express the message's age on our clock */
+static int64_t win32_message_ticks() {
+    DWORD age = GetTickCount() - (DWORD)GetMessageTime();
+    return native_get_ticks() - (int64_t)age * 1000000;
+}
+
+static void win32_button(HWND hwnd, int button, bool down) {
+    input_button(button, down, win32_message_ticks());
+    /* Keep receiving the release if it happens outside the window */
+    if (down) SetCapture(hwnd);
+    else if (input_back()->buttons_down == 0) ReleaseCapture();
+}
+
 static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    static WCHAR high_surrogate = 0;
+
     switch (msg) {
         case WM_CLOSE:
             g_window.is_open = false;
             return 0;
+        case WM_KEYDOWN:
+        case WM_SYSKEYDOWN:
+        case WM_KEYUP:
+        case WM_SYSKEYUP: {
+            bool down = msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN;
+            bool repeat = down && ((lParam >> 30) & 1);
+            input_key(win32_map_key(wParam, lParam), down, repeat, win32_message_ticks());
+            /* Let Alt+F4 and friends through */
+            if (msg == WM_SYSKEYDOWN || msg == WM_SYSKEYUP) break;
+            return 0;
+        }
+        case WM_CHAR: {
+            /* Unpaired surrogates become U+FFFD so text events are always valid scalars */
+            WCHAR c = (WCHAR)wParam;
+            int64_t ticks = win32_message_ticks();
+            bool low = c >= 0xDC00 && c <= 0xDFFF;
+            if (high_surrogate && !low) input_text(0xFFFD, ticks);
+            if (c >= 0xD800 && c <= 0xDBFF) {
+                high_surrogate = c;
+                return 0;
+            }
+            unsigned int codepoint = c;
+            if (low) {
+                codepoint = high_surrogate
+                    ? 0x10000 + (((unsigned int)high_surrogate - 0xD800) << 10) + (c - 0xDC00)
+                    : 0xFFFD;
+            }
+            high_surrogate = 0;
+            input_text(codepoint, ticks);
+            return 0;
+        }
+        case WM_MOUSEMOVE:
+            input_mouse_move((short)LOWORD(lParam), (short)HIWORD(lParam));
+            return 0;
+        case WM_LBUTTONDOWN: win32_button(hwnd, 0, true); return 0;
+        case WM_LBUTTONUP: win32_button(hwnd, 0, false); return 0;
+        case WM_RBUTTONDOWN: win32_button(hwnd, 1, true); return 0;
+        case WM_RBUTTONUP: win32_button(hwnd, 1, false); return 0;
+        case WM_MBUTTONDOWN: win32_button(hwnd, 2, true); return 0;
+        case WM_MBUTTONUP: win32_button(hwnd, 2, false); return 0;
+        case WM_XBUTTONDOWN:
+        case WM_XBUTTONUP:
+            win32_button(hwnd, HIWORD(wParam) == XBUTTON1 ? 3 : 4, msg == WM_XBUTTONDOWN);
+            return TRUE;
+        case WM_MOUSEWHEEL:
+            input_wheel(0, (short)HIWORD(wParam), win32_message_ticks());
+            return 0;
+        case WM_MOUSEHWHEEL:
+            input_wheel((short)HIWORD(wParam), 0, win32_message_ticks());
+            return 0;
+        case WM_SETFOCUS:
+            input_focus(true, win32_message_ticks());
+            return 0;
+        case WM_KILLFOCUS:
+            input_focus(false, win32_message_ticks());
+            return 0;
         case WM_SIZE:
             g_window.width = LOWORD(lParam);
             g_window.height = HIWORD(lParam);
-            glViewport(0, 0, g_window.width, g_window.height);
+            render_viewport(g_window.width, g_window.height);
             return 0;
         case WM_DESTROY:
             PostQuitMessage(0);
             return 0;
     }
-    return DefWindowProc(hwnd, msg, wParam, lParam);
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
 }
 
 int native_create_window(WindowConfig* config) {
-    WNDCLASSEX wc = {0};
-    wc.cbSize = sizeof(WNDCLASSEX);
+    /* Wide class and window procedure, so titles keep every UTF-8 character */
+    WNDCLASSEXW wc = {0};
+    wc.cbSize = sizeof(WNDCLASSEXW);
     wc.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
     wc.lpfnWndProc = WindowProc;
-    wc.hInstance = GetModuleHandle(NULL);
-    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-    wc.lpszClassName = "PyFlareWindow";
+    wc.hInstance = GetModuleHandleW(NULL);
+    wc.hCursor = LoadCursorW(NULL, (LPCWSTR)IDC_ARROW);
+    wc.lpszClassName = L"PyFlareWindow";
 
-    if (!RegisterClassEx(&wc)) {
+    if (!RegisterClassExW(&wc)) {
         printf("Failed to register window class\n");
         return 0;
     }
@@ -98,12 +811,14 @@ int native_create_window(WindowConfig* config) {
     RECT rect = {0, 0, config->width, config->height};
     AdjustWindowRect(&rect, style, FALSE);
 
-    HWND hwnd = CreateWindowEx(
-        0, "PyFlareWindow", config->title, style,
+    wchar_t* wide_title = config->title ? utf8_to_wide(config->title) : NULL;
+    HWND hwnd = CreateWindowExW(
+        0, L"PyFlareWindow", wide_title ? wide_title : L"PyFlare", style,
         CW_USEDEFAULT, CW_USEDEFAULT,
         rect.right - rect.left, rect.bottom - rect.top,
-        NULL, NULL, GetModuleHandle(NULL), NULL
+        NULL, NULL, GetModuleHandleW(NULL), NULL
     );
+    free(wide_title);
 
     if (!hwnd) {
         printf("Failed to create window\n");
@@ -129,32 +844,71 @@ int native_create_window(WindowConfig* config) {
     HGLRC hglrc = wglCreateContext(hdc);
     wglMakeCurrent(hdc, hglrc);
 
-    /* Store window state */
+    /* Store window state; CS_OWNDC keeps hdc valid for the window's lifetime */
     g_window.native_handle = hwnd;
+    g_window.device_context = hdc;
     g_window.gl_context = hglrc;
     g_window.width = config->width;
     g_window.height = config->height;
     g_window.is_open = true;
-    g_window.last_time = (double)GetTickCount() / 1000.0;
+    g_window.last_ticks = native_get_ticks();
 
-    ShowWindow(hwnd, SW_SHOW);
-    UpdateWindow(hwnd);
+    g_window.headless = config->headless;
+    if (!config->headless) {
+        ShowWindow(hwnd, SW_SHOW);
+        UpdateWindow(hwnd);
+    }
 
     return 1;
 }
 
+typedef BOOL (WINAPI *PFN_wglSwapIntervalEXT)(int interval);
+
+int native_set_swap_interval(int interval) {
+    PFN_wglSwapIntervalEXT swap_interval = (PFN_wglSwapIntervalEXT)wglGetProcAddress("wglSwapIntervalEXT");
+    if (!swap_interval) return 0;
+    return swap_interval(interval) ? 1 : 0;
+}
+
 void native_swap_buffers() {
-    HDC hdc = GetDC((HWND)g_window.native_handle);
-    SwapBuffers(hdc);
-    ReleaseDC((HWND)g_window.native_handle, hdc);
+    /* Nothing is displayed headless; finishing the frame keeps frame times comparable */
+    if (g_window.headless) {
+        glFinish();
+        return;
+    }
+    SwapBuffers((HDC)g_window.device_context);
+}
+
+/* Context sharing objects with the main one; must be created on the main thread
+ * before it is made current elsewhere */
+static void* platform_create_shared_context() {
+    HDC hdc = (HDC)g_window.device_context;
+    HGLRC shared = wglCreateContext(hdc);
+    if (!shared) return NULL;
+    if (!wglShareLists((HGLRC)g_window.gl_context, shared)) {
+        wglDeleteContext(shared);
+        return NULL;
+    }
+    return shared;
+}
+
+/* Binds ctx (or nothing, for NULL) to the calling thread */
+static bool platform_make_current(void* context) {
+    if (!context) return wglMakeCurrent(NULL, NULL) != 0;
+    return wglMakeCurrent((HDC)g_window.device_context, (HGLRC)context) != 0;
+}
+
+static void platform_destroy_shared_context(void* context) {
+    if (context) wglDeleteContext((HGLRC)context);
 }
 
 void native_poll_events() {
     MSG msg;
-    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+    while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
         TranslateMessage(&msg);
-        DispatchMessage(&msg);
+        DispatchMessageW(&msg);
     }
+    input_publish();
 }
 
 #else
@@ -163,36 +917,237 @@ void native_poll_events() {
 static Display* g_display = NULL;
 static Window g_x_window = 0;
 static GLXContext g_glx_context = NULL;
+static XVisualInfo* g_visual_info = NULL;   /* kept for shared contexts */
+static GLXFBConfig g_glx_fbconfig = NULL;   /* headless only, likewise */
+static GLXPbuffer g_glx_pbuffer = 0;
+static GLXDrawable g_glx_drawable = 0;      /* the window, or the pbuffer */
 
-int native_create_window(WindowConfig* config) {
-    g_display = XOpenDisplay(NULL);
-    if (!g_display) {
-        printf("Failed to open X display\n");
+/*
+ * EGL for headless runs on machines without an X server (CI, lab boxes over ssh).
+ * Loaded with dlopen so the library never links against libEGL; the few types and
+ * enums used are declared here rather than pulling in the headers.
+ */
+typedef void* EGLDisplay;
+typedef void* EGLConfig;
+typedef void* EGLSurface;
+typedef void* EGLContext;
+typedef int32_t EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+#define PF_EGL_NONE                     0x3038
+#define PF_EGL_ALPHA_SIZE               0x3021
+#define PF_EGL_BLUE_SIZE                0x3022
+#define PF_EGL_GREEN_SIZE               0x3023
+#define PF_EGL_RED_SIZE                 0x3024
+#define PF_EGL_DEPTH_SIZE               0x3025
+#define PF_EGL_SURFACE_TYPE             0x3033
+#define PF_EGL_RENDERABLE_TYPE          0x3040
+#define PF_EGL_HEIGHT                   0x3056
+#define PF_EGL_WIDTH                    0x3057
+#define PF_EGL_OPENGL_API               0x30A2
+#define PF_EGL_PBUFFER_BIT              0x0001
+#define PF_EGL_OPENGL_BIT               0x0008
+#define PF_EGL_PLATFORM_SURFACELESS     0x31DD  /* EGL_PLATFORM_SURFACELESS_MESA */
+
+typedef struct {
+    void* library;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLSurface surface;
+    EGLContext context;
+    void* (*GetProcAddress)(const char* name);
+    EGLDisplay (*GetDisplay)(void* native_display);
+    EGLDisplay (*GetPlatformDisplayEXT)(EGLenum platform, void* native_display, const EGLint* attribs);
+    EGLBoolean (*Initialize)(EGLDisplay display, EGLint* major, EGLint* minor);
+    EGLBoolean (*Terminate)(EGLDisplay display);
+    EGLBoolean (*BindAPI)(EGLenum api);
+    EGLBoolean (*ChooseConfig)(EGLDisplay display, const EGLint* attribs, EGLConfig* configs, EGLint size, EGLint* count);
+    EGLSurface (*CreatePbufferSurface)(EGLDisplay display, EGLConfig config, const EGLint* attribs);
+    EGLBoolean (*DestroySurface)(EGLDisplay display, EGLSurface surface);
+    EGLContext (*CreateContext)(EGLDisplay display, EGLConfig config, EGLContext share, const EGLint* attribs);
+    EGLBoolean (*DestroyContext)(EGLDisplay display, EGLContext context);
+    EGLBoolean (*MakeCurrent)(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context);
+} EGLState;
+
+static EGLState g_egl = {0};
+
+static bool egl_load() {
+    g_egl.library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!g_egl.library) return false;
+
+    g_egl.GetProcAddress = (void* (*)(const char*))dlsym(g_egl.library, "eglGetProcAddress");
+    if (!g_egl.GetProcAddress) return false;
+
+    /* EGL 1.4 only resolves extensions through eglGetProcAddress; core entry points come from dlsym */
+    *(void**)&g_egl.GetPlatformDisplayEXT = g_egl.GetProcAddress("eglGetPlatformDisplayEXT");
+
+    #define PF_EGL_LOAD(field, name) *(void**)&g_egl.field = dlsym(g_egl.library, name)
+    PF_EGL_LOAD(GetDisplay, "eglGetDisplay");
+    PF_EGL_LOAD(Initialize, "eglInitialize");
+    PF_EGL_LOAD(Terminate, "eglTerminate");
+    PF_EGL_LOAD(BindAPI, "eglBindAPI");
+    PF_EGL_LOAD(ChooseConfig, "eglChooseConfig");
+    PF_EGL_LOAD(CreatePbufferSurface, "eglCreatePbufferSurface");
+    PF_EGL_LOAD(DestroySurface, "eglDestroySurface");
+    PF_EGL_LOAD(CreateContext, "eglCreateContext");
+    PF_EGL_LOAD(DestroyContext, "eglDestroyContext");
+    PF_EGL_LOAD(MakeCurrent, "eglMakeCurrent");
+    #undef PF_EGL_LOAD
+
+    return g_egl.GetDisplay && g_egl.Initialize && g_egl.Terminate && g_egl.BindAPI &&
+           g_egl.ChooseConfig && g_egl.CreatePbufferSurface && g_egl.DestroySurface &&
+           g_egl.CreateContext && g_egl.DestroyContext && g_egl.MakeCurrent;
+}
+
+static void egl_destroy() {
+    if (g_egl.display) {
+        g_egl.BindAPI(PF_EGL_OPENGL_API);
+        g_egl.MakeCurrent(g_egl.display, NULL, NULL, NULL);
+        if (g_egl.context) g_egl.DestroyContext(g_egl.display, g_egl.context);
+        if (g_egl.surface) g_egl.DestroySurface(g_egl.display, g_egl.surface);
+        g_egl.Terminate(g_egl.display);
+    }
+    if (g_egl.library) dlclose(g_egl.library);
+    memset(&g_egl, 0, sizeof(g_egl));
+}
+
+/* Desktop GL on a pbuffer of the surfaceless (or default) EGL platform */
+static int egl_create_headless(WindowConfig* config) {
+    if (!egl_load()) {
+        printf("Headless: no X display and libEGL is unavailable\n");
+        egl_destroy();
         return 0;
     }
 
-    int screen = DefaultScreen(g_display);
-    
-    /* Get visual info for OpenGL */
-    int visual_attribs[] = {
-        GLX_RGBA,
+    if (g_egl.GetPlatformDisplayEXT)
+        g_egl.display = g_egl.GetPlatformDisplayEXT(PF_EGL_PLATFORM_SURFACELESS, NULL, NULL);
+    if (!g_egl.display)
+        g_egl.display = g_egl.GetDisplay(NULL);
+    if (!g_egl.display || !g_egl.Initialize(g_egl.display, NULL, NULL)) {
+        printf("Headless: eglInitialize failed\n");
+        g_egl.display = NULL;
+        egl_destroy();
+        return 0;
+    }
+
+    const EGLint config_attribs[] = {
+        PF_EGL_SURFACE_TYPE, PF_EGL_PBUFFER_BIT,
+        PF_EGL_RENDERABLE_TYPE, PF_EGL_OPENGL_BIT,
+        PF_EGL_RED_SIZE, 8, PF_EGL_GREEN_SIZE, 8, PF_EGL_BLUE_SIZE, 8, PF_EGL_ALPHA_SIZE, 8,
+        PF_EGL_DEPTH_SIZE, 24,
+        PF_EGL_NONE
+    };
+    const EGLint surface_attribs[] = { PF_EGL_WIDTH, config->width, PF_EGL_HEIGHT, config->height, PF_EGL_NONE };
+    EGLint count = 0;
+
+    if (!g_egl.BindAPI(PF_EGL_OPENGL_API) ||
+        !g_egl.ChooseConfig(g_egl.display, config_attribs, &g_egl.config, 1, &count) || count == 0 ||
+        !(g_egl.surface = g_egl.CreatePbufferSurface(g_egl.display, g_egl.config, surface_attribs)) ||
+        !(g_egl.context = g_egl.CreateContext(g_egl.display, g_egl.config, NULL, NULL)) ||
+        !g_egl.MakeCurrent(g_egl.display, g_egl.surface, g_egl.surface, g_egl.context)) {
+        printf("Headless: no desktop GL pbuffer config through EGL\n");
+        egl_destroy();
+        return 0;
+    }
+    return 1;
+}
+
+/* Offscreen pbuffer instead of a window: no events, nothing mapped */
+static int x11_create_pbuffer(WindowConfig* config) {
+    int fb_attribs[] = {
+        GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+        GLX_RENDER_TYPE, GLX_RGBA_BIT,
+        GLX_RED_SIZE, 8, GLX_GREEN_SIZE, 8, GLX_BLUE_SIZE, 8, GLX_ALPHA_SIZE, 8,
         GLX_DEPTH_SIZE, 24,
-        GLX_DOUBLEBUFFER,
         None
     };
-    
-    XVisualInfo* vi = glXChooseVisual(g_display, screen, visual_attribs);
-    if (!vi) {
-        printf("Failed to choose visual\n");
+    int count = 0;
+    GLXFBConfig* configs = glXChooseFBConfig(g_display, DefaultScreen(g_display), fb_attribs, &count);
+    if (!configs || count == 0) {
+        printf("No pbuffer-capable GLX config\n");
+        if (configs) XFree(configs);
         return 0;
     }
+    g_glx_fbconfig = configs[0];
+    XFree(configs);
 
-    /* Create window */
+    int pbuffer_attribs[] = {
+        GLX_PBUFFER_WIDTH, config->width,
+        GLX_PBUFFER_HEIGHT, config->height,
+        None
+    };
+    g_glx_pbuffer = glXCreatePbuffer(g_display, g_glx_fbconfig, pbuffer_attribs);
+    g_glx_context = g_glx_pbuffer ? glXCreateNewContext(g_display, g_glx_fbconfig, GLX_RGBA_TYPE, NULL, True) : NULL;
+    if (!g_glx_context ||
+        !glXMakeContextCurrent(g_display, g_glx_pbuffer, g_glx_pbuffer, g_glx_context)) {
+        printf("Failed to create GLX pbuffer\n");
+        /* Leave nothing behind for the EGL fallback or shutdown to trip over */
+        if (g_glx_context) glXDestroyContext(g_display, g_glx_context);
+        if (g_glx_pbuffer) glXDestroyPbuffer(g_display, g_glx_pbuffer);
+        g_glx_context = NULL;
+        g_glx_pbuffer = 0;
+        g_glx_fbconfig = NULL;
+        return 0;
+    }
+    g_glx_drawable = g_glx_pbuffer;
+    return 1;
+}
+
+int native_create_window(WindowConfig* config) {
+    /* The texture upload thread makes GLX calls on the same display */
+    XInitThreads();
+
+    g_display = XOpenDisplay(NULL);
+    if (!g_display && !config->headless) {
+        printf("Failed to open X display\n");
+        return 0;
+    }
+
+    if (config->headless) {
+        bool glx = g_display && x11_create_pbuffer(config);
+        if (!glx) {
+            /* No display, or no pbuffer config on it: EGL needs neither. Headless EGL
+             * runs without a display, so events are never polled from one */
+            if (g_display) {
+                printf("Headless: falling back to EGL\n");
+                XCloseDisplay(g_display);
+                g_display = NULL;
+            }
+            if (!egl_create_headless(config)) return 0;
+        }
+        g_window.gl_context = glx ? (void*)g_glx_context : g_egl.context;
+        g_window.width = config->width;
+        g_window.height = config->height;
+        g_window.headless = true;
+        g_window.is_open = true;
+        g_window.last_ticks = native_get_ticks();
+        return 1;
+    }
+
+    int screen = DefaultScreen(g_display);
+    
+    /* Get visual info for OpenGL */
+    int visual_attribs[] = {
+        GLX_RGBA,
+        GLX_DEPTH_SIZE, 24,
+        GLX_DOUBLEBUFFER,
+        None
+    };
+    
+    XVisualInfo* vi = glXChooseVisual(g_display, screen, visual_attribs);
+    if (!vi) {
+        printf("Failed to choose visual\n");
+        return 0;
+    }
+
+    /* Create window */
     Window root = RootWindow(g_display, screen);
     
     XSetWindowAttributes swa = {0};
     swa.colormap = XCreateColormap(g_display, root, vi->visual, AllocNone);
-    swa.event_mask = ExposureMask | KeyPressMask | StructureNotifyMask;
+    swa.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask
+                   | PointerMotionMask | FocusChangeMask | StructureNotifyMask;
 
     g_x_window = XCreateWindow(
         g_display, root,
@@ -208,7 +1163,8 @@ int native_create_window(WindowConfig* config) {
     g_glx_context = glXCreateContext(g_display, vi, NULL, GL_TRUE);
     glXMakeCurrent(g_display, g_x_window, g_glx_context);
 
-    XFree(vi);
+    g_visual_info = vi;
+    g_glx_drawable = g_x_window;
 
     /* Store window state */
     g_window.native_handle = (void*)(long)g_x_window;
@@ -216,211 +1172,7214 @@ int native_create_window(WindowConfig* config) {
     g_window.width = config->width;
     g_window.height = config->height;
     g_window.is_open = true;
+    g_window.last_ticks = native_get_ticks();
 
     return 1;
 }
 
+typedef void (*PFN_glXSwapIntervalEXT)(Display* display, GLXDrawable drawable, int interval);
+typedef int (*PFN_glXSwapIntervalMESA)(unsigned int interval);
+typedef int (*PFN_glXSwapIntervalSGI)(int interval);
+
+int native_set_swap_interval(int interval) {
+    /* A pbuffer has no swap chain; the EXT call would raise BadWindow */
+    if (g_window.headless) return interval == 0 ? 1 : 0;
+
+    PFN_glXSwapIntervalEXT swap_ext = (PFN_glXSwapIntervalEXT)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalEXT");
+    if (swap_ext) {
+        swap_ext(g_display, g_x_window, interval);
+        return 1;
+    }
+
+    PFN_glXSwapIntervalMESA swap_mesa = (PFN_glXSwapIntervalMESA)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalMESA");
+    if (swap_mesa) {
+        return swap_mesa((unsigned int)interval) == 0 ? 1 : 0;
+    }
+
+    /* SGI variant cannot disable vsync (interval 0 is an error) */
+    PFN_glXSwapIntervalSGI swap_sgi = (PFN_glXSwapIntervalSGI)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalSGI");
+    if (swap_sgi && interval > 0) {
+        return swap_sgi(interval) == 0 ? 1 : 0;
+    }
+    return 0;
+}
+
 void native_swap_buffers() {
+    /* Nothing is displayed headless; finishing the frame keeps frame times comparable */
+    if (g_window.headless) {
+        glFinish();
+        return;
+    }
     glXSwapBuffers(g_display, g_x_window);
 }
 
+/* Context sharing objects with the main one. Another thread may bind it to
+ * the same window; it never draws there */
+static void* platform_create_shared_context() {
+    if (g_egl.context) return g_egl.CreateContext(g_egl.display, g_egl.config, g_egl.context, NULL);
+    if (g_glx_fbconfig) return glXCreateNewContext(g_display, g_glx_fbconfig, GLX_RGBA_TYPE, g_glx_context, True);
+    if (!g_visual_info) return NULL;
+    return glXCreateContext(g_display, g_visual_info, g_glx_context, GL_TRUE);
+}
+
+/* Binds ctx (or nothing, for NULL) to the calling thread */
+static bool platform_make_current(void* context) {
+    if (g_egl.context) {
+        /* The bound client API is per thread */
+        g_egl.BindAPI(PF_EGL_OPENGL_API);
+        if (!context) return g_egl.MakeCurrent(g_egl.display, NULL, NULL, NULL) != 0;
+        /* A surface can be current on one thread only, so shared contexts go surfaceless
+         * (KHR_surfaceless_context) and fall back to the pbuffer where that is missing */
+        if (context != g_egl.context && g_egl.MakeCurrent(g_egl.display, NULL, NULL, context)) return true;
+        return g_egl.MakeCurrent(g_egl.display, g_egl.surface, g_egl.surface, context) != 0;
+    }
+    if (!context) return glXMakeCurrent(g_display, None, NULL) != 0;
+    if (g_glx_pbuffer)
+        return glXMakeContextCurrent(g_display, g_glx_drawable, g_glx_drawable, (GLXContext)context) != 0;
+    return glXMakeCurrent(g_display, g_x_window, (GLXContext)context) != 0;
+}
+
+static void platform_destroy_shared_context(void* context) {
+    if (!context) return;
+    if (g_egl.context) g_egl.DestroyContext(g_egl.display, context);
+    else glXDestroyContext(g_display, (GLXContext)context);
+}
+
+static int x11_map_key(KeySym sym) {
+    if (sym >= XK_a && sym <= XK_z) return (int)(sym - XK_a) + 'A';
+    if (sym >= XK_A && sym <= XK_Z) return (int)(sym - XK_A) + 'A';
+    if (sym >= XK_0 && sym <= XK_9) return (int)(sym - XK_0) + '0';
+    if (sym >= XK_F1 && sym <= XK_F12) return PF_KEY_F1 + (int)(sym - XK_F1);
+
+    switch (sym) {
+        case XK_space: return PF_KEY_SPACE;
+        case XK_Escape: return PF_KEY_ESCAPE;
+        case XK_Return: case XK_KP_Enter: return PF_KEY_ENTER;
+        case XK_Tab: return PF_KEY_TAB;
+        case XK_BackSpace: return PF_KEY_BACKSPACE;
+        case XK_Insert: return PF_KEY_INSERT;
+        case XK_Delete: return PF_KEY_DELETE;
+        case XK_Right: return PF_KEY_RIGHT;
+        case XK_Left: return PF_KEY_LEFT;
+        case XK_Down: return PF_KEY_DOWN;
+        case XK_Up: return PF_KEY_UP;
+        case XK_Page_Up: return PF_KEY_PAGE_UP;
+        case XK_Page_Down: return PF_KEY_PAGE_DOWN;
+        case XK_Home: return PF_KEY_HOME;
+        case XK_End: return PF_KEY_END;
+        case XK_Shift_L: return PF_KEY_LEFT_SHIFT;
+        case XK_Shift_R: return PF_KEY_RIGHT_SHIFT;
+        case XK_Control_L: return PF_KEY_LEFT_CONTROL;
+        case XK_Control_R: return PF_KEY_RIGHT_CONTROL;
+        case XK_Alt_L: return PF_KEY_LEFT_ALT;
+        case XK_Alt_R: case XK_ISO_Level3_Shift: return PF_KEY_RIGHT_ALT;
+        case XK_Super_L: return PF_KEY_LEFT_SUPER;
+        case XK_Super_R: return PF_KEY_RIGHT_SUPER;
+        case XK_semicolon: return ';';
+        case XK_equal: return '=';
+        case XK_comma: return ',';
+        case XK_minus: return '-';
+        case XK_period: return '.';
+        case XK_slash: return '/';
+        case XK_grave: return '`';
+        case XK_bracketleft: return '[';
+        case XK_backslash: return '\\';
+        case XK_bracketright: return ']';
+        case XK_apostrophe: return '\'';
+    }
+    return PF_KEY_UNKNOWN;
+}
+
+static void x11_key_text(XKeyEvent* key, int64_t ticks) {
+    /* Without an input method XLookupString yields Latin-1, which maps 1:1 to code points */
+    char text[16];
+    KeySym sym;
+    int length = XLookupString(key, text, sizeof(text), &sym, NULL);
+    for (int i = 0; i < length; i++) input_text((unsigned char)text[i], ticks);
+}
+
+/* X reports button numbers; 4-7 are wheel steps, 8/9 the side buttons */
+static void x11_button(unsigned int button, bool down, int64_t ticks) {
+    switch (button) {
+        case Button1: input_button(0, down, ticks); break;
+        case Button2: input_button(2, down, ticks); break;
+        case Button3: input_button(1, down, ticks); break;
+        case Button4: if (down) input_wheel(0, 120, ticks); break;
+        case Button5: if (down) input_wheel(0, -120, ticks); break;
+        case 6: if (down) input_wheel(-120, 0, ticks); break;
+        case 7: if (down) input_wheel(120, 0, ticks); break;
+        case 8: input_button(3, down, ticks); break;
+        case 9: input_button(4, down, ticks); break;
+    }
+}
+
 void native_poll_events() {
     XEvent event;
-    while (XPending(g_display)) {
+    /* EGL headless has no display, and so no events */
+    while (g_display && XPending(g_display)) {
         XNextEvent(g_display, &event);
-        
+        /* Server timestamps are on another clock; time the dequeue instead */
+        int64_t ticks = native_get_ticks();
+
         switch (event.type) {
+            case KeyPress:
+                input_key(x11_map_key(XLookupKeysym(&event.xkey, 0)), true, false, ticks);
+                x11_key_text(&event.xkey, ticks);
+                break;
+            case KeyRelease: {
+                /* Autorepeat arrives as release+press with the same time; fold it into a repeat */
+                if (XEventsQueued(g_display, QueuedAfterReading)) {
+                    XEvent next;
+                    XPeekEvent(g_display, &next);
+                    if (next.type == KeyPress && next.xkey.keycode == event.xkey.keycode
+                        && next.xkey.time == event.xkey.time) {
+                        XNextEvent(g_display, &next);
+                        input_key(x11_map_key(XLookupKeysym(&next.xkey, 0)), true, true, ticks);
+                        x11_key_text(&next.xkey, ticks);
+                        break;
+                    }
+                }
+                input_key(x11_map_key(XLookupKeysym(&event.xkey, 0)), false, false, ticks);
+                break;
+            }
+            case MotionNotify:
+                input_mouse_move(event.xmotion.x, event.xmotion.y);
+                break;
+            case ButtonPress:
+            case ButtonRelease:
+                input_mouse_move(event.xbutton.x, event.xbutton.y);
+                x11_button(event.xbutton.button, event.type == ButtonPress, ticks);
+                break;
+            case FocusIn:
+                input_focus(true, ticks);
+                break;
+            case FocusOut:
+                input_focus(false, ticks);
+                break;
             case ClientMessage:
                 g_window.is_open = false;
                 break;
             case ConfigureNotify:
                 g_window.width = event.xconfigure.width;
                 g_window.height = event.xconfigure.height;
-                glViewport(0, 0, g_window.width, g_window.height);
+                render_viewport(g_window.width, g_window.height);
                 break;
         }
     }
+    input_publish();
 }
 
 #endif
 
 /* ============================================================================
- * PLATFORM-INDEPENDENT API
+ * OPENGL EXTENSIONS
+ * Optional entry points resolved at runtime; every user has a GL 2.1 fallback.
  * ============================================================================ */
 
-int native_init_window(int width, int height, const char* title, int fullscreen, int vsync) {
-    WindowConfig config = {0};
-    config.width = width;
-    config.height = height;
-    config.title = title;
-    config.fullscreen = fullscreen != 0;
-    config.vsync = vsync != 0;
-    config.gl_major = 2;
-    config.gl_minor = 1;
+typedef struct {
+    bool map_buffer_range;
+    bool buffer_storage;
+    bool sync;
+    bool program_binary;
+    bool gpu_memory_nvx;
+    bool gpu_memory_ati;
+    bool timer_query;
+    bool texture_s3tc;
+    bool texture_etc2;
 
-    if (!native_create_window(&config)) {
-        return 0;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+    PFNGLUNMAPBUFFERPROC UnmapBuffer;
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+    PFNGLFENCESYNCPROC FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC DeleteSync;
+    PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+    PFNGLPROGRAMBINARYPROC ProgramBinary;
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+    PFNGLQUERYCOUNTERPROC QueryCounter;
+    PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+    PFNGLGETINTEGER64VPROC GetInteger64v;
+} GLExtensions;
+
+static GLExtensions g_gl = {0};
+
+static void* gl_get_proc(const char* name) {
+    #ifdef _WIN32
+        void* proc = (void*)wglGetProcAddress(name);
+        /* Some drivers return small sentinel values instead of NULL */
+        if (proc == (void*)0x1 || proc == (void*)0x2 || proc == (void*)0x3 || proc == (void*)-1) {
+            return NULL;
+        }
+        return proc;
+    #elif __APPLE__
+        (void)name;
+        return NULL;
+    #else
+        if (g_egl.context) return g_egl.GetProcAddress(name);
+        return (void*)glXGetProcAddressARB((const GLubyte*)name);
+    #endif
+}
+
+static bool gl_has_extension(const char* name) {
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (!extensions) return false;
+
+    size_t len = strlen(name);
+    const char* p = extensions;
+    while ((p = strstr(p, name)) != NULL) {
+        bool starts = p == extensions || p[-1] == ' ';
+        bool ends = p[len] == ' ' || p[len] == '\0';
+        if (starts && ends) return true;
+        p += len;
     }
+    return false;
+}
 
-    /* Initialize OpenGL state */
-    glViewport(0, 0, width, height);
-    glClearColor(0.2f, 0.2f, 0.25f, 1.0f);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    /* Enable depth testing for 3D */
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+static int gl_version() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (version) sscanf(version, "%d.%d", &major, &minor);
+    return major * 10 + minor;
+}
 
-    printf("PyFlare Native Window Created: %dx%d\n", width, height);
-    printf("OpenGL Version: %s\n", glGetString(GL_VERSION));
-    printf("OpenGL Vendor: %s\n", glGetString(GL_VENDOR));
-    printf("OpenGL Renderer: %s\n", glGetString(GL_RENDERER));
+static void gl_load_extensions() {
+    memset(&g_gl, 0, sizeof(g_gl));
+    int version = gl_version();
 
-    return 1;
+    g_gl.UnmapBuffer = (PFNGLUNMAPBUFFERPROC)gl_get_proc("glUnmapBuffer");
+
+    if (version >= 30 || gl_has_extension("GL_ARB_map_buffer_range")) {
+        g_gl.MapBufferRange = (PFNGLMAPBUFFERRANGEPROC)gl_get_proc("glMapBufferRange");
+        g_gl.map_buffer_range = g_gl.MapBufferRange && g_gl.UnmapBuffer;
+    }
+
+    if (version >= 32 || gl_has_extension("GL_ARB_sync")) {
+        g_gl.FenceSync = (PFNGLFENCESYNCPROC)gl_get_proc("glFenceSync");
+        g_gl.ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)gl_get_proc("glClientWaitSync");
+        g_gl.DeleteSync = (PFNGLDELETESYNCPROC)gl_get_proc("glDeleteSync");
+        g_gl.sync = g_gl.FenceSync && g_gl.ClientWaitSync && g_gl.DeleteSync;
+    }
+
+    if (version >= 41 || gl_has_extension("GL_ARB_get_program_binary")) {
+        g_gl.GetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)gl_get_proc("glGetProgramBinary");
+        g_gl.ProgramBinary = (PFNGLPROGRAMBINARYPROC)gl_get_proc("glProgramBinary");
+        g_gl.ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)gl_get_proc("glProgramParameteri");
+
+        /* Some drivers advertise the extension but support zero formats */
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        g_gl.program_binary = g_gl.GetProgramBinary && g_gl.ProgramBinary
+            && g_gl.ProgramParameteri && formats > 0;
+    }
+
+    if (version >= 44 || gl_has_extension("GL_ARB_buffer_storage")) {
+        g_gl.BufferStorage = (PFNGLBUFFERSTORAGEPROC)gl_get_proc("glBufferStorage");
+        g_gl.buffer_storage = g_gl.BufferStorage && g_gl.map_buffer_range && g_gl.sync;
+    }
+
+    if (version >= 33 || gl_has_extension("GL_ARB_timer_query")) {
+        g_gl.QueryCounter = (PFNGLQUERYCOUNTERPROC)gl_get_proc("glQueryCounter");
+        g_gl.GetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)gl_get_proc("glGetQueryObjectui64v");
+        g_gl.GetInteger64v = (PFNGLGETINTEGER64VPROC)gl_get_proc("glGetInteger64v");
+        g_gl.timer_query = g_gl.QueryCounter && g_gl.GetQueryObjectui64v && g_gl.GetInteger64v;
+    }
+
+    g_gl.texture_s3tc = gl_has_extension("GL_EXT_texture_compression_s3tc");
+    g_gl.texture_etc2 = version >= 43 || gl_has_extension("GL_ARB_ES3_compatibility");
+
+    g_gl.gpu_memory_nvx = gl_has_extension("GL_NVX_gpu_memory_info");
+    g_gl.gpu_memory_ati = gl_has_extension("GL_ATI_meminfo");
 }
 
-void native_destroy_window() {
-    #ifdef _WIN32
-        if (g_window.gl_context) {
-            wglMakeCurrent(NULL, NULL);
-            wglDeleteContext((HGLRC)g_window.gl_context);
-        }
-        if (g_window.native_handle) {
-            DestroyWindow((HWND)g_window.native_handle);
-        }
-    #else
-        if (g_glx_context) {
-            glXMakeCurrent(g_display, None, NULL);
-            glXDestroyContext(g_display, g_glx_context);
-        }
-        if (g_x_window) {
-            XDestroyWindow(g_display, g_x_window);
+/* ============================================================================
+ * PROFILER
+ * Scoped CPU markers go into per-thread rings with a single writer each, so
+ * recording never locks; the collector copies out whatever it has not seen.
+ * GPU scopes use ARB_timer_query timestamps, double-buffered by frame so
+ * results are read one frame late without stalling. All timestamps are in
+ * native_get_ticks units; GPU time is mapped onto that clock per frame.
+ * Per-frame counters are zero-length events on a track of their own.
+ * ============================================================================ */
+
+#define PF_PROFILER_MAX_MARKERS 1024
+#define PF_PROFILER_MAX_THREADS 64
+#define PF_PROFILER_RING_SIZE 16384   /* events per thread, power of two */
+#define PF_PROFILER_MAX_DEPTH 32
+#define PF_GPU_MAX_SCOPES 128          /* per frame */
+#define PF_PROFILER_GPU_THREAD 0       /* thread id reserved for the GPU track */
+#define PF_PROFILER_COUNTER_THREAD -1  /* thread id of counter samples */
+
+/* Layout shared with ProfileEvent in bindings.cs - keep in sync */
+typedef struct {
+    int64_t start_ticks;
+    int64_t end_ticks;
+    int marker;
+    int thread_id;
+    int depth;
+    int value;                 /* counter samples only; 0 for scopes */
+} ProfileEvent;
+
+typedef struct {
+    ProfileEvent events[PF_PROFILER_RING_SIZE];
+    _Atomic uint64_t write;    /* only advanced by the owning thread */
+    uint64_t read;             /* only touched by the collector */
+    int thread_id;
+    int depth;
+    int64_t stack_start[PF_PROFILER_MAX_DEPTH];
+    int stack_marker[PF_PROFILER_MAX_DEPTH];
+} ProfilerThreadBuffer;
+
+typedef struct {
+    GLuint queries[PF_GPU_MAX_SCOPES * 2];
+    int marker[PF_GPU_MAX_SCOPES];
+    int depth[PF_GPU_MAX_SCOPES];
+    int count;
+    int64_t cpu_base;          /* native ticks when gpu_base was sampled */
+    int64_t gpu_base;
+} GpuQueryFrame;
+
+typedef struct {
+    _Atomic int enabled;
+    atomic_int initialized;    /* pf_once state; workers may race the first init */
+    pf_mutex lock;
+    char* marker_names[PF_PROFILER_MAX_MARKERS];
+    _Atomic int marker_count;
+    ProfilerThreadBuffer* threads[PF_PROFILER_MAX_THREADS];
+    _Atomic int thread_count;
+    ProfilerThreadBuffer gpu;
+    ProfilerThreadBuffer counters;   /* written by the GL thread only */
+
+    bool gpu_ready;
+    GpuQueryFrame gpu_frames[2];
+    int gpu_frame;
+    int gpu_stack[PF_PROFILER_MAX_DEPTH];
+    int gpu_depth;
+    _Atomic int64_t dropped;     /* added to from the GL thread and collectors */
+} Profiler;
+
+static Profiler g_profiler = {0};
+static PF_THREAD_LOCAL ProfilerThreadBuffer* t_profiler_buffer = NULL;
+
+static void profiler_init() {
+    if (!pf_once_begin(&g_profiler.initialized)) return;
+    pf_mutex_init(&g_profiler.lock);
+    g_profiler.gpu.thread_id = PF_PROFILER_GPU_THREAD;
+    g_profiler.counters.thread_id = PF_PROFILER_COUNTER_THREAD;
+    /* Marker 0 is reserved as "invalid" */
+    g_profiler.marker_names[0] = NULL;
+    atomic_store(&g_profiler.marker_count, 1);
+    pf_once_end(&g_profiler.initialized);
+}
+
+int native_profiler_register_marker(const char* name) {
+    if (!name) return 0;
+    profiler_init();
+
+    pf_mutex_lock(&g_profiler.lock);
+    int count = atomic_load(&g_profiler.marker_count);
+    for (int i = 1; i < count; i++) {
+        if (strcmp(g_profiler.marker_names[i], name) == 0) {
+            pf_mutex_unlock(&g_profiler.lock);
+            return i;
         }
-        if (g_display) {
-            XCloseDisplay(g_display);
+    }
+
+    int id = 0;
+    if (count < PF_PROFILER_MAX_MARKERS) {
+        size_t len = strlen(name) + 1;
+        char* copy = (char*)malloc(len);
+        if (copy) {
+            memcpy(copy, name, len);
+            g_profiler.marker_names[count] = copy;
+            atomic_store(&g_profiler.marker_count, count + 1);
+            id = count;
         }
-    #endif
+    }
+    pf_mutex_unlock(&g_profiler.lock);
+    return id;
+}
 
-    g_window.is_open = false;
-    printf("PyFlare Native Window Destroyed\n");
+const char* native_profiler_get_marker_name(int marker) {
+    if (marker <= 0 || marker >= atomic_load(&g_profiler.marker_count)) return NULL;
+    return g_profiler.marker_names[marker];
 }
 
-void native_update() {
-    native_poll_events();
-    
-    /* Calculate delta time */
-    #ifdef _WIN32
-        double current_time = (double)GetTickCount() / 1000.0;
-    #else
-        struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        double current_time = ts.tv_sec + ts.tv_nsec / 1000000000.0;
-    #endif
-    
-    g_window.delta_time = current_time - g_window.last_time;
-    g_window.last_time = current_time;
+static ProfilerThreadBuffer* profiler_thread_buffer() {
+    if (t_profiler_buffer) return t_profiler_buffer;
+
+    /* Buffers live until process exit so the collector never races a free */
+    profiler_init();
+    ProfilerThreadBuffer* buffer = (ProfilerThreadBuffer*)calloc(1, sizeof(ProfilerThreadBuffer));
+    if (!buffer) return NULL;
+
+    pf_mutex_lock(&g_profiler.lock);
+    int index = atomic_load(&g_profiler.thread_count);
+    if (index < PF_PROFILER_MAX_THREADS) {
+        buffer->thread_id = index + 1;
+        g_profiler.threads[index] = buffer;
+        atomic_store(&g_profiler.thread_count, index + 1);
+    } else {
+        free(buffer);
+        buffer = NULL;
+    }
+    pf_mutex_unlock(&g_profiler.lock);
+
+    t_profiler_buffer = buffer;
+    return buffer;
 }
 
-void native_present() {
-    native_swap_buffers();
+static void profiler_push(ProfilerThreadBuffer* buffer, int marker, int depth, int64_t start, int64_t end, int value) {
+    uint64_t write = atomic_load_explicit(&buffer->write, memory_order_relaxed);
+    ProfileEvent* e = &buffer->events[write & (PF_PROFILER_RING_SIZE - 1)];
+    e->start_ticks = start;
+    e->end_ticks = end;
+    e->marker = marker;
+    e->thread_id = buffer->thread_id;
+    e->depth = depth;
+    e->value = value;
+    atomic_store_explicit(&buffer->write, write + 1, memory_order_release);
 }
 
-int native_is_window_open() {
-    return g_window.is_open ? 1 : 0;
+/* One sample of a per-frame counter, stamped now */
+static void profiler_counter(int marker, int value) {
+    if (!atomic_load_explicit(&g_profiler.enabled, memory_order_relaxed) || marker <= 0) return;
+    int64_t now = native_get_ticks();
+    profiler_push(&g_profiler.counters, marker, 0, now, now, value);
 }
 
-void native_get_window_size(int* width, int* height) {
-    *width = g_window.width;
-    *height = g_window.height;
+void native_profiler_begin(int marker) {
+    if (!atomic_load_explicit(&g_profiler.enabled, memory_order_relaxed)) return;
+    ProfilerThreadBuffer* buffer = profiler_thread_buffer();
+    if (!buffer) return;
+
+    if (buffer->depth < PF_PROFILER_MAX_DEPTH) {
+        buffer->stack_marker[buffer->depth] = marker;
+        buffer->stack_start[buffer->depth] = native_get_ticks();
+    }
+    buffer->depth++;
 }
 
-double native_get_delta_time() {
-    return g_window.delta_time;
+void native_profiler_end(int marker) {
+    ProfilerThreadBuffer* buffer = t_profiler_buffer;
+    if (!buffer || buffer->depth == 0) return;
+
+    buffer->depth--;
+    /* Scopes opened while disabled or beyond the depth limit are dropped */
+    if (buffer->depth >= PF_PROFILER_MAX_DEPTH || buffer->stack_marker[buffer->depth] != marker) return;
+    if (!atomic_load_explicit(&g_profiler.enabled, memory_order_relaxed)) return;
+
+    profiler_push(buffer, marker, buffer->depth, buffer->stack_start[buffer->depth], native_get_ticks(), 0);
 }
 
-/* ============================================================================
- * OPENGL UTILITY FUNCTIONS
- * ============================================================================ */
+/* Static marker ids for native scopes: PF_PROFILE_BEGIN(id_var, "name") ... PF_PROFILE_END(id_var) */
+#define PF_PROFILE_BEGIN(var, name) \
+    static int var = 0; \
+    if (atomic_load_explicit(&g_profiler.enabled, memory_order_relaxed)) { \
+        if (!var) var = native_profiler_register_marker(name); \
+        native_profiler_begin(var); \
+    }
+#define PF_PROFILE_END(var) native_profiler_end(var)
 
-void native_clear(float r, float g, float b, float a) {
-    glClearColor(r, g, b, a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+/* ---- GPU scopes ---- */
+
+static bool gpu_profiler_ready() {
+    if (!g_gl.timer_query || !atomic_load_explicit(&g_profiler.enabled, memory_order_relaxed)) return false;
+    if (!g_profiler.gpu_ready) {
+        for (int i = 0; i < 2; i++) {
+            glGenQueries(PF_GPU_MAX_SCOPES * 2, g_profiler.gpu_frames[i].queries);
+            g_profiler.gpu_frames[i].count = 0;
+        }
+        g_profiler.gpu_frame = 0;
+        g_profiler.gpu_depth = 0;
+        g_profiler.gpu_ready = true;
+    }
+    return true;
 }
 
-unsigned int native_create_shader(const char* vertex_src, const char* fragment_src) {
-    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &vertex_src, NULL);
-    glCompileShader(vertex_shader);
+void native_gpu_marker_begin(int marker) {
+    if (render_deferred()) {
+        render_record_gpu_marker(marker, true);
+        return;
+    }
+    if (!gpu_profiler_ready()) return;
 
-    GLint success;
-    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetShaderInfoLog(vertex_shader, 512, NULL, info_log);
-        printf("Vertex shader compilation failed: %s\n", info_log);
-        return 0;
+    GpuQueryFrame* frame = &g_profiler.gpu_frames[g_profiler.gpu_frame];
+    if (frame->count >= PF_GPU_MAX_SCOPES || g_profiler.gpu_depth >= PF_PROFILER_MAX_DEPTH) {
+        g_profiler.gpu_depth++;
+        return;
     }
 
-    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 1, &fragment_src, NULL);
-    glCompileShader(fragment_shader);
+    if (frame->count == 0) {
+        /* Anchor this frame's GPU clock to the CPU clock */
+        GLint64 gpu_now = 0;
+        g_gl.GetInteger64v(GL_TIMESTAMP, &gpu_now);
+        frame->gpu_base = (int64_t)gpu_now;
+        frame->cpu_base = native_get_ticks();
+    }
 
-    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetShaderInfoLog(fragment_shader, 512, NULL, info_log);
-        printf("Fragment shader compilation failed: %s\n", info_log);
-        return 0;
+    int scope = frame->count++;
+    frame->marker[scope] = marker;
+    frame->depth[scope] = g_profiler.gpu_depth;
+    g_profiler.gpu_stack[g_profiler.gpu_depth++] = scope;
+    g_gl.QueryCounter(frame->queries[scope * 2], GL_TIMESTAMP);
+}
+
+void native_gpu_marker_end(int marker) {
+    if (render_deferred()) {
+        render_record_gpu_marker(marker, false);
+        return;
     }
+    if (!g_profiler.gpu_ready || g_profiler.gpu_depth == 0) return;
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-    glLinkProgram(program);
+    g_profiler.gpu_depth--;
+    if (g_profiler.gpu_depth >= PF_PROFILER_MAX_DEPTH) return;
 
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetProgramInfoLog(program, 512, NULL, info_log);
-        printf("Shader program linking failed: %s\n", info_log);
-        return 0;
+    GpuQueryFrame* frame = &g_profiler.gpu_frames[g_profiler.gpu_frame];
+    int scope = g_profiler.gpu_stack[g_profiler.gpu_depth];
+    if (scope >= frame->count || frame->marker[scope] != marker) return;
+    g_gl.QueryCounter(frame->queries[scope * 2 + 1], GL_TIMESTAMP);
+}
+
+static void gpu_profiler_resolve(GpuQueryFrame* frame) {
+    for (int i = 0; i < frame->count; i++) {
+        GLint available = 0;
+        glGetQueryObjectiv(frame->queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            /* Still in flight a frame later; drop rather than stall */
+            atomic_fetch_add_explicit(&g_profiler.dropped, frame->count - i, memory_order_relaxed);
+            break;
+        }
+
+        GLuint64 start = 0, end = 0;
+        g_gl.GetQueryObjectui64v(frame->queries[i * 2], GL_QUERY_RESULT, &start);
+        g_gl.GetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        profiler_push(&g_profiler.gpu, frame->marker[i], frame->depth[i],
+            frame->cpu_base + ((int64_t)start - frame->gpu_base),
+            frame->cpu_base + ((int64_t)end - frame->gpu_base), 0);
     }
+    frame->count = 0;
+}
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+/* Called once per frame after the swap */
+static void profiler_frame() {
+    if (!g_profiler.gpu_ready) return;
 
-    return program;
+    /* Unbalanced scopes must not leak into the next frame */
+    g_profiler.gpu_depth = 0;
+    g_profiler.gpu_frame ^= 1;
+    gpu_profiler_resolve(&g_profiler.gpu_frames[g_profiler.gpu_frame]);
 }
 
-void native_use_shader(unsigned int shader_id) {
-    glUseProgram(shader_id);
+static void profiler_shutdown_gpu() {
+    if (!g_profiler.gpu_ready) return;
+    for (int i = 0; i < 2; i++) {
+        glDeleteQueries(PF_GPU_MAX_SCOPES * 2, g_profiler.gpu_frames[i].queries);
+    }
+    g_profiler.gpu_ready = false;
 }
 
-void native_delete_shader(unsigned int shader_id) {
-    glDeleteProgram(shader_id);
+/* ---- Collection ---- */
+
+static int profiler_drain(ProfilerThreadBuffer* buffer, ProfileEvent* out, int max) {
+    uint64_t write = atomic_load_explicit(&buffer->write, memory_order_acquire);
+    uint64_t read = buffer->read;
+
+    /* The writer lapped us: skip what has been overwritten */
+    if (write - read > PF_PROFILER_RING_SIZE) {
+        atomic_fetch_add_explicit(&g_profiler.dropped, (int64_t)(write - read - PF_PROFILER_RING_SIZE), memory_order_relaxed);
+        read = write - PF_PROFILER_RING_SIZE;
+    }
+
+    int copied = 0;
+    while (read < write && copied < max) {
+        out[copied++] = buffer->events[read & (PF_PROFILER_RING_SIZE - 1)];
+        read++;
+    }
+
+    /* Anything overwritten while copying is torn; discard it */
+    uint64_t after = atomic_load_explicit(&buffer->write, memory_order_acquire);
+    if (after - buffer->read > PF_PROFILER_RING_SIZE && copied > 0) {
+        uint64_t first_valid = after - PF_PROFILER_RING_SIZE;
+        uint64_t first_copied = read - (uint64_t)copied;
+        if (first_valid > first_copied) {
+            int torn = (int)(first_valid - first_copied);
+            if (torn > copied) torn = copied;
+            memmove(out, out + torn, (size_t)(copied - torn) * sizeof(ProfileEvent));
+            copied -= torn;
+            atomic_fetch_add_explicit(&g_profiler.dropped, torn, memory_order_relaxed);
+        }
+    }
+
+    buffer->read = read;
+    return copied;
+}
+
+/*
+ * Copies unread events from every thread (and the GPU and counter tracks) into `out`.
+ * Call from a single collector thread. Returns the number of events written.
+ */
+int native_profiler_collect(ProfileEvent* out, int max) {
+    if (!out || max <= 0 || !pf_once_done(&g_profiler.initialized)) return 0;
+
+    int total = profiler_drain(&g_profiler.gpu, out, max);
+    total += profiler_drain(&g_profiler.counters, out + total, max - total);
+    int threads = atomic_load(&g_profiler.thread_count);
+    for (int i = 0; i < threads && total < max; i++) {
+        total += profiler_drain(g_profiler.threads[i], out + total, max - total);
+    }
+    return total;
+}
+
+void native_profiler_set_enabled(int enabled) {
+    profiler_init();
+    atomic_store(&g_profiler.enabled, enabled ? 1 : 0);
+}
+
+int64_t native_profiler_get_dropped() {
+    return atomic_load_explicit(&g_profiler.dropped, memory_order_relaxed);
+}
+
+int native_profiler_gpu_supported() {
+    return g_gl.timer_query ? 1 : 0;
 }
 
 /* ============================================================================
- * MEMORY AND PERFORMANCE UTILITIES
+ * GL STATE CACHE
+ * Shadows the main context's bindings and blend/depth/viewport state so
+ * redundant calls never reach the driver; old GL 2.1 drivers validate even a
+ * no-op glBindTexture. Only the thread that owns the main context (main or
+ * render thread) goes through it. The upload thread's shared context has its
+ * own state and calls GL directly. Emitted and filtered calls are counted per
+ * kind, published once per frame and sampled into the profiler.
  * ============================================================================ */
 
-long native_get_memory_usage() {
-    #ifdef _WIN32
-        PROCESS_MEMORY_COUNTERS pmc;
-        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-            return (long)pmc.WorkingSetSize;
-        }
-    #endif
-    return 0;
+#define PF_GL_STATE_TEXTURE_UNITS 8
+#define PF_GL_STATE_UNKNOWN ((GLuint)-1)   /* matches no real name or enum */
+
+enum {
+    PF_GL_STATE_PROGRAM = 0,
+    PF_GL_STATE_TEXTURE,        /* binds and active unit changes */
+    PF_GL_STATE_BUFFER,
+    PF_GL_STATE_BLEND,          /* enable and func */
+    PF_GL_STATE_DEPTH,
+    PF_GL_STATE_VIEWPORT,
+    PF_GL_STATE_CLEAR_COLOR,
+    PF_GL_STATE_VERTEX_ARRAY,
+    PF_GL_STATE_KIND_COUNT
+};
+
+/* Layout shared with GLStateCounts in bindings.cs - keep in sync */
+typedef struct {
+    int64_t emitted;
+    int64_t filtered;
+} GLStateCounts;
+
+/* Layout shared with GLStateStats in bindings.cs - keep in sync */
+typedef struct {
+    GLStateCounts kinds[PF_GL_STATE_KIND_COUNT];
+    GLStateCounts total;
+    GLStateCounts last_frame;
+    int64_t frames;
+    int enabled;
+    int reserved;
+} GLStateStats;
+
+typedef struct {
+    bool ready;
+    _Atomic int bypass;         /* set by native_set_gl_state_cache(0) */
+    _Atomic int reset_requested;
+
+    GLuint program;
+    GLuint active_unit;
+    GLuint textures[PF_GL_STATE_TEXTURE_UNITS];
+    GLuint array_buffer;
+    GLuint element_buffer;
+    GLuint blend;               /* GL_TRUE, GL_FALSE or unknown */
+    GLenum blend_src, blend_dst;
+    GLuint depth_test;
+    GLenum depth_func;
+    GLint viewport[4];
+    GLfloat clear_color[4];
+    uint32_t vertex_arrays_known;
+    uint32_t vertex_arrays_enabled;
+
+    GLStateCounts counts[PF_GL_STATE_KIND_COUNT];
+    GLStateCounts frame_start;  /* totals at the last frame boundary */
+    int64_t frames;
+
+    pf_mutex lock;              /* guards published */
+    GLStateStats published;
+} GLStateCache;
+
+static GLStateCache g_gl_state = {0};
+
+/* Forgets everything: the next call of each kind is emitted. Call once a context is current */
+static void gl_state_invalidate() {
+    if (!g_gl_state.ready) {
+        pf_mutex_init(&g_gl_state.lock);
+        g_gl_state.ready = true;
+    }
+
+    g_gl_state.program = PF_GL_STATE_UNKNOWN;
+    g_gl_state.active_unit = PF_GL_STATE_UNKNOWN;
+    for (int i = 0; i < PF_GL_STATE_TEXTURE_UNITS; i++) g_gl_state.textures[i] = PF_GL_STATE_UNKNOWN;
+    g_gl_state.array_buffer = PF_GL_STATE_UNKNOWN;
+    g_gl_state.element_buffer = PF_GL_STATE_UNKNOWN;
+    g_gl_state.blend = PF_GL_STATE_UNKNOWN;
+    g_gl_state.blend_src = g_gl_state.blend_dst = PF_GL_STATE_UNKNOWN;
+    g_gl_state.depth_test = PF_GL_STATE_UNKNOWN;
+    g_gl_state.depth_func = PF_GL_STATE_UNKNOWN;
+    g_gl_state.viewport[2] = g_gl_state.viewport[3] = -1;
+    /* NaN never compares equal */
+    for (int i = 0; i < 4; i++) g_gl_state.clear_color[i] = NAN;
+    g_gl_state.vertex_arrays_known = 0;
+    g_gl_state.vertex_arrays_enabled = 0;
 }
 
-double native_get_time() {
+/* Counts the call; true when it can be skipped */
+static bool gl_state_filter(int kind, bool redundant) {
+    if (redundant && !atomic_load_explicit(&g_gl_state.bypass, memory_order_relaxed)) {
+        g_gl_state.counts[kind].filtered++;
+        return true;
+    }
+    g_gl_state.counts[kind].emitted++;
+    return false;
+}
+
+static void gl_state_use_program(GLuint program) {
+    if (gl_state_filter(PF_GL_STATE_PROGRAM, g_gl_state.program == program)) return;
+    g_gl_state.program = program;
+    glUseProgram(program);
+}
+
+static void gl_state_active_texture(GLuint unit) {
+    if (gl_state_filter(PF_GL_STATE_TEXTURE, g_gl_state.active_unit == unit)) return;
+    g_gl_state.active_unit = unit;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+/* GL_TEXTURE_2D on `unit`; leaves that unit active */
+static void gl_state_bind_texture(GLuint unit, GLuint texture) {
+    if (unit >= PF_GL_STATE_TEXTURE_UNITS) return;
+    if (gl_state_filter(PF_GL_STATE_TEXTURE, g_gl_state.textures[unit] == texture)) return;
+    gl_state_active_texture(unit);
+    g_gl_state.textures[unit] = texture;
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+/* Raw GL changed the active unit's binding (main-context texture uploads) */
+static void gl_state_set_bound_texture(GLuint texture) {
+    if (g_gl_state.active_unit < PF_GL_STATE_TEXTURE_UNITS) {
+        g_gl_state.textures[g_gl_state.active_unit] = texture;
+    }
+}
+
+static void gl_state_bind_buffer(GLenum target, GLuint buffer) {
+    GLuint* cached = target == GL_ARRAY_BUFFER ? &g_gl_state.array_buffer
+                   : target == GL_ELEMENT_ARRAY_BUFFER ? &g_gl_state.element_buffer : NULL;
+    if (!cached) {
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (gl_state_filter(PF_GL_STATE_BUFFER, *cached == buffer)) return;
+    *cached = buffer;
+    glBindBuffer(target, buffer);
+}
+
+/* GL_BLEND or GL_DEPTH_TEST */
+static void gl_state_set_enabled(GLenum cap, bool enabled) {
+    GLuint value = enabled ? GL_TRUE : GL_FALSE;
+    GLuint* cached = cap == GL_BLEND ? &g_gl_state.blend : &g_gl_state.depth_test;
+    int kind = cap == GL_BLEND ? PF_GL_STATE_BLEND : PF_GL_STATE_DEPTH;
+    if (gl_state_filter(kind, *cached == value)) return;
+    *cached = value;
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+}
+
+static void gl_state_blend_func(GLenum src, GLenum dst) {
+    if (gl_state_filter(PF_GL_STATE_BLEND, g_gl_state.blend_src == src && g_gl_state.blend_dst == dst)) return;
+    g_gl_state.blend_src = src;
+    g_gl_state.blend_dst = dst;
+    glBlendFunc(src, dst);
+}
+
+static void gl_state_depth_func(GLenum func) {
+    if (gl_state_filter(PF_GL_STATE_DEPTH, g_gl_state.depth_func == func)) return;
+    g_gl_state.depth_func = func;
+    glDepthFunc(func);
+}
+
+static void gl_state_viewport(GLint x, GLint y, GLint width, GLint height) {
+    GLint* v = g_gl_state.viewport;
+    if (gl_state_filter(PF_GL_STATE_VIEWPORT, v[0] == x && v[1] == y && v[2] == width && v[3] == height)) return;
+    v[0] = x; v[1] = y; v[2] = width; v[3] = height;
+    glViewport(x, y, width, height);
+}
+
+static void gl_state_clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    GLfloat* c = g_gl_state.clear_color;
+    if (gl_state_filter(PF_GL_STATE_CLEAR_COLOR, c[0] == r && c[1] == g && c[2] == b && c[3] == a)) return;
+    c[0] = r; c[1] = g; c[2] = b; c[3] = a;
+    glClearColor(r, g, b, a);
+}
+
+static void gl_state_vertex_array(GLuint index, bool enabled) {
+    uint32_t bit = 1u << index;
+    bool redundant = (g_gl_state.vertex_arrays_known & bit)
+        && ((g_gl_state.vertex_arrays_enabled & bit) != 0) == enabled;
+    if (gl_state_filter(PF_GL_STATE_VERTEX_ARRAY, redundant)) return;
+    g_gl_state.vertex_arrays_known |= bit;
+    if (enabled) {
+        g_gl_state.vertex_arrays_enabled |= bit;
+        glEnableVertexAttribArray(index);
+    } else {
+        g_gl_state.vertex_arrays_enabled &= ~bit;
+        glDisableVertexAttribArray(index);
+    }
+}
+
+/* Deleting a bound object unbinds it in this context; the cache follows */
+static void gl_state_delete_texture(GLuint texture) {
+    glDeleteTextures(1, &texture);
+    for (int i = 0; i < PF_GL_STATE_TEXTURE_UNITS; i++) {
+        if (g_gl_state.textures[i] == texture) g_gl_state.textures[i] = 0;
+    }
+}
+
+static void gl_state_delete_buffers(GLsizei count, const GLuint* buffers) {
+    glDeleteBuffers(count, buffers);
+    for (GLsizei i = 0; i < count; i++) {
+        if (g_gl_state.array_buffer == buffers[i]) g_gl_state.array_buffer = 0;
+        if (g_gl_state.element_buffer == buffers[i]) g_gl_state.element_buffer = 0;
+    }
+}
+
+/* A deleted current program stays in use until replaced, but its name may be reused */
+static void gl_state_delete_program(GLuint program) {
+    glDeleteProgram(program);
+    if (g_gl_state.program == program) g_gl_state.program = PF_GL_STATE_UNKNOWN;
+}
+
+/* Called once per frame after the swap, on the thread that owns the context */
+static void gl_state_frame() {
+    if (!g_gl_state.ready) return;
+    static int s_marker_emitted = 0, s_marker_filtered = 0;
+
+    if (atomic_exchange(&g_gl_state.reset_requested, 0)) {
+        memset(g_gl_state.counts, 0, sizeof(g_gl_state.counts));
+        memset(&g_gl_state.frame_start, 0, sizeof(g_gl_state.frame_start));
+        g_gl_state.frames = 0;
+    }
+
+    GLStateStats stats = {0};
+    for (int i = 0; i < PF_GL_STATE_KIND_COUNT; i++) {
+        stats.kinds[i] = g_gl_state.counts[i];
+        stats.total.emitted += g_gl_state.counts[i].emitted;
+        stats.total.filtered += g_gl_state.counts[i].filtered;
+    }
+    stats.last_frame.emitted = stats.total.emitted - g_gl_state.frame_start.emitted;
+    stats.last_frame.filtered = stats.total.filtered - g_gl_state.frame_start.filtered;
+    stats.frames = ++g_gl_state.frames;
+    stats.enabled = !atomic_load(&g_gl_state.bypass);
+    g_gl_state.frame_start = stats.total;
+
+    pf_mutex_lock(&g_gl_state.lock);
+    g_gl_state.published = stats;
+    pf_mutex_unlock(&g_gl_state.lock);
+
+    if (atomic_load_explicit(&g_profiler.enabled, memory_order_relaxed)) {
+        if (!s_marker_emitted) s_marker_emitted = native_profiler_register_marker("gl_calls_emitted");
+        if (!s_marker_filtered) s_marker_filtered = native_profiler_register_marker("gl_calls_filtered");
+        profiler_counter(s_marker_emitted, (int)stats.last_frame.emitted);
+        profiler_counter(s_marker_filtered, (int)stats.last_frame.filtered);
+    }
+}
+
+/* Counters as of the last presented frame. Returns 0 before a window exists */
+int native_get_gl_state_stats(GLStateStats* stats) {
+    if (!stats) return 0;
+    if (!g_gl_state.ready) {
+        memset(stats, 0, sizeof(*stats));
+        return 0;
+    }
+    pf_mutex_lock(&g_gl_state.lock);
+    *stats = g_gl_state.published;
+    pf_mutex_unlock(&g_gl_state.lock);
+    return 1;
+}
+
+/* Takes effect at the next frame boundary */
+void native_reset_gl_state_stats() {
+    atomic_store(&g_gl_state.reset_requested, 1);
+}
+
+/* Off emits every call, for measuring what the cache saves; counting continues */
+void native_set_gl_state_cache(int enabled) {
+    atomic_store(&g_gl_state.bypass, enabled ? 0 : 1);
+}
+
+/* ============================================================================
+ * FRAME PACING
+ * With vsync the swap interval paces frames; otherwise native_present sleeps
+ * for the bulk of the remaining budget and spins the last stretch on the
+ * high-resolution clock. Deadlines are tracked in both modes.
+ * ============================================================================ */
+
+/* OS sleeps overshoot; stop sleeping this far before the deadline and spin */
+#ifdef _WIN32
+    #define PF_PACER_SPIN_TICKS (2 * 1000000LL)
+#else
+    #define PF_PACER_SPIN_TICKS (1 * 1000000LL)
+#endif
+
+typedef struct {
+    int64_t frames;
+    int64_t missed_deadlines;
+    double last_frame_ms;
+    double worst_frame_ms;
+    double target_frame_ms;
+    double sleep_ms;
+    int vsync;
+} FramePacingStats;
+
+typedef struct {
+    int64_t budget_ticks;     /* 0 = unlimited */
+    int64_t next_deadline;
+    int64_t last_present;
+    bool vsync_requested;
+    bool vsync_active;
+    bool timer_period_set;
+    FramePacingStats stats;   /* written on the presenting thread, read from the main thread */
+    pf_lazy_mutex stats_lock;
+} FramePacer;
+
+static FramePacer g_pacer = {0};
+
+static void cpu_relax() {
+    #if defined(_WIN32)
+        YieldProcessor();
+    #elif defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+    #endif
+}
+
+static void sleep_ticks(int64_t ticks) {
+    if (ticks <= 0) return;
     #ifdef _WIN32
-        return (double)GetTickCount() / 1000.0;
+        Sleep((DWORD)(ticks / 1000000LL));
     #else
         struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+        ts.tv_sec = (time_t)(ticks / PF_TICKS_PER_SECOND);
+        ts.tv_nsec = (long)(ticks % PF_TICKS_PER_SECOND);
+        nanosleep(&ts, NULL);
+    #endif
+}
+
+static void pacer_wait() {
+    if (g_pacer.budget_ticks <= 0 || g_pacer.vsync_active) return;
+
+    int64_t now = native_get_ticks();
+    if (g_pacer.next_deadline == 0) {
+        g_pacer.next_deadline = now + g_pacer.budget_ticks;
+        return;
+    }
+
+    int64_t remaining = g_pacer.next_deadline - now;
+    if (remaining > PF_PACER_SPIN_TICKS) {
+        int64_t before = now;
+        sleep_ticks(remaining - PF_PACER_SPIN_TICKS);
+        now = native_get_ticks();
+        pf_lazy_mutex_lock(&g_pacer.stats_lock);
+        g_pacer.stats.sleep_ms += (double)(now - before) / 1000000.0;
+        pf_lazy_mutex_unlock(&g_pacer.stats_lock);
+    }
+    while (now < g_pacer.next_deadline) {
+        cpu_relax();
+        now = native_get_ticks();
+    }
+}
+
+static void pacer_frame_presented() {
+    int64_t now = native_get_ticks();
+
+    pf_lazy_mutex_lock(&g_pacer.stats_lock);
+    if (g_pacer.last_present != 0) {
+        int64_t frame = now - g_pacer.last_present;
+        g_pacer.stats.last_frame_ms = (double)frame / 1000000.0;
+        if (g_pacer.stats.last_frame_ms > g_pacer.stats.worst_frame_ms) {
+            g_pacer.stats.worst_frame_ms = g_pacer.stats.last_frame_ms;
+        }
+
+        /* Half a millisecond of slack absorbs timer and vblank jitter */
+        if (g_pacer.budget_ticks > 0 && frame > g_pacer.budget_ticks + 500000LL) {
+            g_pacer.stats.missed_deadlines++;
+        }
+    }
+    g_pacer.last_present = now;
+    g_pacer.stats.frames++;
+    pf_lazy_mutex_unlock(&g_pacer.stats_lock);
+
+    if (g_pacer.budget_ticks > 0) {
+        g_pacer.next_deadline += g_pacer.budget_ticks;
+        /* After a miss, restart from now instead of racing to catch up */
+        if (g_pacer.next_deadline < now) {
+            g_pacer.next_deadline = now + g_pacer.budget_ticks;
+        }
+    }
+}
+
+static void render_call_set_target_fps(void* args) {
+    native_set_target_fps(*(double*)args);
+}
+
+void native_set_target_fps(double fps) {
+    /* The pacer runs where the swap happens */
+    if (render_deferred()) {
+        render_call(render_call_set_target_fps, &fps);
+        return;
+    }
+
+    g_pacer.budget_ticks = fps > 0.0 ? (int64_t)((double)PF_TICKS_PER_SECOND / fps) : 0;
+    g_pacer.next_deadline = 0;
+    pf_lazy_mutex_lock(&g_pacer.stats_lock);
+    g_pacer.stats.target_frame_ms = (double)g_pacer.budget_ticks / 1000000.0;
+    pf_lazy_mutex_unlock(&g_pacer.stats_lock);
+
+    #ifdef _WIN32
+        /* 1 ms scheduler granularity so Sleep() is usable for pacing */
+        if (g_pacer.budget_ticks > 0 && !g_pacer.timer_period_set) {
+            timeBeginPeriod(1);
+            g_pacer.timer_period_set = true;
+        } else if (g_pacer.budget_ticks == 0 && g_pacer.timer_period_set) {
+            timeEndPeriod(1);
+            g_pacer.timer_period_set = false;
+        }
     #endif
+}
+
+static void render_call_set_vsync(void* args) {
+    int* io = (int*)args;
+    *io = native_set_vsync(*io);
+}
+
+int native_set_vsync(int enabled) {
+    if (render_deferred()) {
+        render_call(render_call_set_vsync, &enabled);
+        return enabled;
+    }
+
+    g_pacer.vsync_requested = enabled != 0;
+    g_pacer.vsync_active = native_set_swap_interval(enabled ? 1 : 0) == 1 && enabled;
+    pf_lazy_mutex_lock(&g_pacer.stats_lock);
+    g_pacer.stats.vsync = g_pacer.vsync_active ? 1 : 0;
+    pf_lazy_mutex_unlock(&g_pacer.stats_lock);
+    g_pacer.next_deadline = 0;
+    return g_pacer.vsync_active ? 1 : 0;
+}
+
+/* Safe to call while the render thread presents */
+void native_get_frame_pacing_stats(FramePacingStats* stats) {
+    pf_lazy_mutex_lock(&g_pacer.stats_lock);
+    *stats = g_pacer.stats;
+    pf_lazy_mutex_unlock(&g_pacer.stats_lock);
+}
+
+void native_reset_frame_pacing_stats() {
+    pf_lazy_mutex_lock(&g_pacer.stats_lock);
+    double target = g_pacer.stats.target_frame_ms;
+    int vsync = g_pacer.stats.vsync;
+    memset(&g_pacer.stats, 0, sizeof(g_pacer.stats));
+    g_pacer.stats.target_frame_ms = target;
+    g_pacer.stats.vsync = vsync;
+    pf_lazy_mutex_unlock(&g_pacer.stats_lock);
+}
+
+/* ============================================================================
+ * FRAME STATISTICS
+ * Frame times go into log-linear (HDR-style) histograms in microseconds:
+ * exact below 128 us, then 64 sub-buckets per power of two (~1.5%
+ * precision) up to ~67 s. One histogram covers a rolling window of recent frames,
+ * another everything since the last reset. Percentile queries walk ~1300
+ * buckets and never allocate.
+ * ============================================================================ */
+
+#define PF_HIST_SUB_BITS 6
+#define PF_HIST_SUB_COUNT (1 << PF_HIST_SUB_BITS)
+#define PF_HIST_LINEAR (PF_HIST_SUB_COUNT * 2)
+#define PF_HIST_MIN_EXP (PF_HIST_SUB_BITS + 1)
+#define PF_HIST_MAX_EXP 26
+#define PF_HIST_BUCKETS (PF_HIST_LINEAR + (PF_HIST_MAX_EXP - PF_HIST_MIN_EXP) * PF_HIST_SUB_COUNT)
+#define PF_FRAME_WINDOW_DEFAULT 600
+#define PF_FRAME_WINDOW_MAX 65536
+
+typedef enum {
+    FRAME_STATS_WINDOW = 0,
+    FRAME_STATS_TOTAL = 1
+} FrameStatsScope;
+
+/* Layout shared with FrameStats in bindings.cs - keep in sync */
+typedef struct {
+    int64_t frames;
+    int64_t over_budget;
+    double budget_ms;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+} FrameStats;
+
+typedef struct {
+    uint32_t counts[PF_HIST_BUCKETS];
+    int64_t total;
+    int64_t sum_us;
+    int64_t over_budget;
+    uint32_t max_us;
+} FrameHistogram;
+
+typedef struct {
+    FrameHistogram window;
+    FrameHistogram total;
+    uint32_t* samples;        /* ring of the window's samples, for eviction; see PF_FRAME_OVER */
+    int capacity;
+    int head;
+    int count;
+    uint32_t budget_us;       /* 0 = follow the pacer target, else 60 Hz */
+} FrameStatistics;
+
+static FrameStatistics g_frame_stats = {0};
+
+/* Set on a ring sample that counted as over budget when recorded, so eviction
+ * undoes exactly what was added even after the target changes */
+#define PF_FRAME_OVER 0x80000000u
+#define PF_FRAME_US_MASK 0x7FFFFFFFu
+
+static int hist_bucket(uint32_t us) {
+    if (us < PF_HIST_LINEAR) return (int)us;
+
+    int msb = 31;
+    while (!(us & (1u << msb))) msb--;
+    if (msb >= PF_HIST_MAX_EXP) return PF_HIST_BUCKETS - 1;
+
+    int sub = (int)((us >> (msb - PF_HIST_SUB_BITS)) & (PF_HIST_SUB_COUNT - 1));
+    return PF_HIST_LINEAR + (msb - PF_HIST_MIN_EXP) * PF_HIST_SUB_COUNT + sub;
+}
+
+/* Highest value that maps to `bucket`, so percentiles never under-report */
+static uint32_t hist_bucket_upper(int bucket) {
+    if (bucket < PF_HIST_LINEAR) return (uint32_t)bucket;
+
+    int msb = PF_HIST_MIN_EXP + (bucket - PF_HIST_LINEAR) / PF_HIST_SUB_COUNT;
+    int sub = (bucket - PF_HIST_LINEAR) % PF_HIST_SUB_COUNT;
+    uint32_t step = 1u << (msb - PF_HIST_SUB_BITS);
+    return (1u << msb) + (uint32_t)(sub + 1) * step - 1;
+}
+
+static uint32_t frame_stats_budget_us() {
+    if (g_frame_stats.budget_us) return g_frame_stats.budget_us;
+    if (g_pacer.budget_ticks > 0) return (uint32_t)(g_pacer.budget_ticks / 1000);
+    return 16667;
+}
+
+static void hist_add(FrameHistogram* h, uint32_t us, uint32_t budget) {
+    h->counts[hist_bucket(us)]++;
+    h->total++;
+    h->sum_us += us;
+    if (us > budget) h->over_budget++;
+    if (us > h->max_us) h->max_us = us;
+}
+
+static bool frame_stats_alloc(int capacity) {
+    uint32_t* samples = (uint32_t*)malloc((size_t)capacity * sizeof(uint32_t));
+    if (!samples) return false;
+
+    free(g_frame_stats.samples);
+    g_frame_stats.samples = samples;
+    g_frame_stats.capacity = capacity;
+    g_frame_stats.head = 0;
+    g_frame_stats.count = 0;
+    memset(&g_frame_stats.window, 0, sizeof(FrameHistogram));
+    return true;
+}
+
+static void frame_stats_record(int64_t frame_ticks) {
+    if (frame_ticks <= 0) return;
+    if (!g_frame_stats.samples && !frame_stats_alloc(PF_FRAME_WINDOW_DEFAULT)) return;
+
+    int64_t us64 = frame_ticks / 1000;
+    uint32_t us = us64 > PF_FRAME_US_MASK ? PF_FRAME_US_MASK : (uint32_t)us64;
+    uint32_t budget = frame_stats_budget_us();
+
+    FrameHistogram* w = &g_frame_stats.window;
+    if (g_frame_stats.count == g_frame_stats.capacity) {
+        /* Evict the oldest sample from the rolling window */
+        uint32_t old = g_frame_stats.samples[g_frame_stats.head];
+        uint32_t old_us = old & PF_FRAME_US_MASK;
+        w->counts[hist_bucket(old_us)]--;
+        w->total--;
+        w->sum_us -= old_us;
+        if (old & PF_FRAME_OVER) w->over_budget--;
+    } else {
+        g_frame_stats.count++;
+    }
+
+    g_frame_stats.samples[g_frame_stats.head] = us | (us > budget ? PF_FRAME_OVER : 0);
+    g_frame_stats.head = (g_frame_stats.head + 1) % g_frame_stats.capacity;
+
+    hist_add(w, us, budget);
+    hist_add(&g_frame_stats.total, us, budget);
+}
+
+static double hist_percentile_ms(const FrameHistogram* h, double percentile) {
+    if (h->total == 0) return 0.0;
+
+    int64_t rank = (int64_t)ceil(percentile / 100.0 * (double)h->total);
+    if (rank < 1) rank = 1;
+
+    int64_t seen = 0;
+    for (int i = 0; i < PF_HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint32_t upper = hist_bucket_upper(i);
+            if (upper > h->max_us) upper = h->max_us;
+            return upper / 1000.0;
+        }
+    }
+    return h->max_us / 1000.0;
+}
+
+static void frame_stats_window_max() {
+    uint32_t max = 0;
+    for (int i = 0; i < g_frame_stats.count; i++) {
+        uint32_t us = g_frame_stats.samples[i] & PF_FRAME_US_MASK;
+        if (us > max) max = us;
+    }
+    g_frame_stats.window.max_us = max;
+}
+
+int native_get_frame_stats(int scope, FrameStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    FrameHistogram* h;
+    if (scope == FRAME_STATS_TOTAL) {
+        h = &g_frame_stats.total;
+    } else {
+        /* The window max can't be maintained under eviction; rescan the ring */
+        h = &g_frame_stats.window;
+        frame_stats_window_max();
+    }
+
+    stats->frames = h->total;
+    stats->over_budget = h->over_budget;
+    stats->budget_ms = frame_stats_budget_us() / 1000.0;
+    if (h->total == 0) return 0;
+
+    stats->mean_ms = (double)h->sum_us / (double)h->total / 1000.0;
+    stats->p50_ms = hist_percentile_ms(h, 50.0);
+    stats->p95_ms = hist_percentile_ms(h, 95.0);
+    stats->p99_ms = hist_percentile_ms(h, 99.0);
+    stats->max_ms = h->max_us / 1000.0;
+    return 1;
+}
+
+/* Rolling window length in frames; clears the window */
+void native_set_frame_stats_window(int frames) {
+    if (frames < 1) frames = 1;
+    if (frames > PF_FRAME_WINDOW_MAX) frames = PF_FRAME_WINDOW_MAX;
+    frame_stats_alloc(frames);
+}
+
+void native_reset_frame_stats() {
+    memset(&g_frame_stats.total, 0, sizeof(FrameHistogram));
+    memset(&g_frame_stats.window, 0, sizeof(FrameHistogram));
+    g_frame_stats.head = 0;
+    g_frame_stats.count = 0;
+}
+
+/* Over-budget threshold; <= 0 follows the target FPS. Counters restart */
+void native_set_frame_budget_ms(double budget_ms) {
+    g_frame_stats.budget_us = budget_ms > 0.0 ? (uint32_t)(budget_ms * 1000.0) : 0;
+    native_reset_frame_stats();
+}
+
+/* ============================================================================
+ * ASYNC PRESENTATION
+ * native_present_async hands SwapBuffers to a presentation thread so the
+ * vblank wait overlaps the next frame's simulation. WGL allows swapping an
+ * HDC from a thread the context is not current on; the main thread only
+ * blocks again at its next GL entry point (present_sync). Other platforms
+ * present synchronously.
+ * ============================================================================ */
+
+typedef struct {
+    bool running;
+    bool quit;
+    bool pending;
+    pf_thread thread;
+    pf_mutex lock;
+    pf_cond cond;
+} PresentThread;
+
+static PresentThread g_present = {0};
+
+/* Time to first frame ends when the first swap returns */
+static void startup_mark_present() {
+    if (atomic_load_explicit(&g_first_present, memory_order_relaxed) == 0) {
+        atomic_store(&g_first_present, native_get_ticks());
+    }
+}
+
+/* Blocks until no swap is in flight. Called before touching the back buffer */
+static void present_sync() {
+    if (!g_present.running) return;
+
+    pf_mutex_lock(&g_present.lock);
+    while (g_present.pending) {
+        pf_cond_wait(&g_present.cond, &g_present.lock);
+    }
+    pf_mutex_unlock(&g_present.lock);
+}
+
+#ifdef _WIN32
+static void present_thread_main(void* arg) {
+    (void)arg;
+    pf_mutex_lock(&g_present.lock);
+    for (;;) {
+        while (!g_present.pending && !g_present.quit) {
+            pf_cond_wait(&g_present.cond, &g_present.lock);
+        }
+        if (g_present.quit) break;
+
+        pf_mutex_unlock(&g_present.lock);
+        native_swap_buffers();
+        startup_mark_present();
+        pf_mutex_lock(&g_present.lock);
+
+        g_present.pending = false;
+        pf_cond_broadcast(&g_present.cond);
+    }
+    pf_mutex_unlock(&g_present.lock);
+}
+
+static bool present_thread_start() {
+    if (g_present.running) return true;
+
+    pf_mutex_init(&g_present.lock);
+    pf_cond_init(&g_present.cond);
+    g_present.quit = false;
+    g_present.pending = false;
+
+    if (!pf_thread_start(&g_present.thread, present_thread_main, NULL)) {
+        pf_cond_destroy(&g_present.cond);
+        pf_mutex_destroy(&g_present.lock);
+        return false;
+    }
+    g_present.running = true;
+    return true;
+}
+#endif
+
+static void present_thread_stop() {
+    if (!g_present.running) return;
+
+    pf_mutex_lock(&g_present.lock);
+    while (g_present.pending) {
+        pf_cond_wait(&g_present.cond, &g_present.lock);
+    }
+    g_present.quit = true;
+    pf_cond_broadcast(&g_present.cond);
+    pf_mutex_unlock(&g_present.lock);
+
+    pf_thread_join(g_present.thread);
+    pf_cond_destroy(&g_present.cond);
+    pf_mutex_destroy(&g_present.lock);
+    g_present.running = false;
+}
+
+/* ============================================================================
+ * RENDER THREAD
+ * Optional dedicated GL thread. While it runs, the main context is current
+ * on it and the draw entry points (clear, use_shader, submit_batch, GPU
+ * markers, deletions) record compact commands instead of calling GL. The
+ * command buffer is double-buffered: native_present hands frame N over and
+ * returns once frame N-1 has been executed and swapped, so simulation and
+ * GL submission overlap on two cores at the cost of one frame of latency.
+ * Entry points that must return a GL result (object creation, buffer
+ * mapping, queries) run synchronously on the render thread between
+ * commands. Recording is main-thread only, as GL calls were before.
+ * ============================================================================ */
+
+enum {
+    RENDER_CMD_CLEAR = 1,
+    RENDER_CMD_USE_SHADER,
+    RENDER_CMD_DELETE_SHADER,
+    RENDER_CMD_SUBMIT_BATCH,
+    RENDER_CMD_DELETE_TEXTURE,
+    RENDER_CMD_DESTROY_STREAM,
+    RENDER_CMD_GPU_MARKER_BEGIN,
+    RENDER_CMD_GPU_MARKER_END,
+    RENDER_CMD_VIEWPORT
+};
+
+typedef struct {
+    uint32_t type;
+    uint32_t size;          /* payload bytes that follow, multiple of 8 */
+} RenderCommand;
+
+typedef struct {
+    unsigned char* data;
+    size_t used;
+    size_t capacity;
+    int commands;
+} RenderCommandBuffer;
+
+/* Layout shared with RenderThreadStats in bindings.cs - keep in sync */
+typedef struct {
+    int64_t frames;
+    int64_t sync_calls;
+    int64_t command_bytes;  /* last frame */
+    int commands;           /* last frame */
+    int active;
+    double main_wait_ms;    /* last frame: main thread blocked handing the frame over */
+    double execute_ms;      /* last frame: command execution, without pacing and swap */
+} RenderThreadStats;
+
+typedef struct {
+    bool running;
+    bool starting;
+    bool start_failed;
+    bool quit;
+    bool frame_pending;     /* frames[1 - record] handed over, not yet executed */
+    pf_thread thread;
+    pf_mutex lock;
+    pf_cond cond;
+
+    RenderCommandBuffer frames[2];
+    int record;             /* buffer the main thread records into */
+
+    render_call_fn call;    /* one synchronous call in flight at a time */
+    void* call_args;
+    bool call_done;
+    _Atomic int call_pending;
+
+    _Atomic int last_draw_calls;
+    RenderThreadStats stats;
+} RenderThread;
+
+static RenderThread g_render = {0};
+static PF_THREAD_LOCAL bool t_render_thread = false;
+
+/* True when GL work has to go through the render thread */
+static bool render_deferred() {
+    return !t_render_thread && g_render.running;
+}
+
+/* Reserves a command in the frame being recorded; returns its payload or NULL */
+static void* render_record(uint32_t type, size_t bytes) {
+    RenderCommandBuffer* cb = &g_render.frames[g_render.record];
+    size_t payload = (bytes + 7) & ~(size_t)7;
+    size_t needed = cb->used + sizeof(RenderCommand) + payload;
+
+    if (needed > cb->capacity) {
+        size_t capacity = cb->capacity ? cb->capacity : 64 * 1024;
+        while (capacity < needed) capacity *= 2;
+        unsigned char* data = (unsigned char*)realloc(cb->data, capacity);
+        if (!data) return NULL;
+        cb->data = data;
+        cb->capacity = capacity;
+    }
+
+    RenderCommand* cmd = (RenderCommand*)(cb->data + cb->used);
+    cmd->type = type;
+    cmd->size = (uint32_t)payload;
+    cb->used = needed;
+    cb->commands++;
+    return cmd + 1;
+}
+
+static void render_record_id(uint32_t type, unsigned int id) {
+    unsigned int* p = (unsigned int*)render_record(type, sizeof(unsigned int));
+    if (p) *p = id;
+}
+
+static void render_record_gpu_marker(int marker, bool begin) {
+    render_record_id(begin ? RENDER_CMD_GPU_MARKER_BEGIN : RENDER_CMD_GPU_MARKER_END, (unsigned int)marker);
+}
+
+/* Window resizes arrive during native_poll_events on the main thread */
+static void render_viewport(int width, int height) {
+    if (!render_deferred()) {
+        gl_state_viewport(0, 0, width, height);
+        return;
+    }
+    int* p = (int*)render_record(RENDER_CMD_VIEWPORT, 2 * sizeof(int));
+    if (p) {
+        p[0] = width;
+        p[1] = height;
+    }
+}
+
+/* Runs fn(args) on the render thread and waits for it */
+static void render_call(render_call_fn fn, void* args) {
+    pf_mutex_lock(&g_render.lock);
+    while (g_render.call) {
+        pf_cond_wait(&g_render.cond, &g_render.lock);
+    }
+    g_render.call = fn;
+    g_render.call_args = args;
+    g_render.call_done = false;
+    g_render.stats.sync_calls++;
+    atomic_store_explicit(&g_render.call_pending, 1, memory_order_release);
+    pf_cond_broadcast(&g_render.cond);
+
+    while (!g_render.call_done) {
+        pf_cond_wait(&g_render.cond, &g_render.lock);
+    }
+    g_render.call = NULL;
+    pf_cond_broadcast(&g_render.cond);
+    pf_mutex_unlock(&g_render.lock);
+}
+
+/* Render thread: serve a waiting synchronous call, if any */
+static void render_serve_call() {
+    if (!atomic_load_explicit(&g_render.call_pending, memory_order_acquire)) return;
+
+    pf_mutex_lock(&g_render.lock);
+    render_call_fn fn = g_render.call;
+    void* args = g_render.call_args;
+    pf_mutex_unlock(&g_render.lock);
+
+    fn(args);
+
+    pf_mutex_lock(&g_render.lock);
+    atomic_store_explicit(&g_render.call_pending, 0, memory_order_relaxed);
+    g_render.call_done = true;
+    pf_cond_broadcast(&g_render.cond);
+    pf_mutex_unlock(&g_render.lock);
+}
+
+static void render_execute(RenderCommandBuffer* cb) {
+    size_t pos = 0;
+    while (pos < cb->used) {
+        /* Keeps creation calls from waiting out a whole frame of draws */
+        if (t_render_thread) render_serve_call();
+
+        RenderCommand* cmd = (RenderCommand*)(cb->data + pos);
+        const void* p = cmd + 1;
+        unsigned int id = *(const unsigned int*)p;
+
+        switch (cmd->type) {
+            case RENDER_CMD_CLEAR: {
+                const float* c = (const float*)p;
+                native_clear(c[0], c[1], c[2], c[3]);
+                break;
+            }
+            case RENDER_CMD_USE_SHADER:      native_use_shader(id); break;
+            case RENDER_CMD_DELETE_SHADER:   native_delete_shader(id); break;
+            case RENDER_CMD_SUBMIT_BATCH:    batcher_execute(p); break;
+            case RENDER_CMD_DELETE_TEXTURE:  gl_state_delete_texture(id); break;
+            case RENDER_CMD_DESTROY_STREAM:  native_destroy_stream_buffer((int)id); break;
+            case RENDER_CMD_GPU_MARKER_BEGIN: native_gpu_marker_begin((int)id); break;
+            case RENDER_CMD_GPU_MARKER_END:   native_gpu_marker_end((int)id); break;
+            case RENDER_CMD_VIEWPORT:         render_viewport(((const int*)p)[0], ((const int*)p)[1]); break;
+        }
+        pos += sizeof(RenderCommand) + cmd->size;
+    }
+    cb->used = 0;
+    cb->commands = 0;
+}
+
+static void render_frame(RenderCommandBuffer* cb) {
+    PF_PROFILE_BEGIN(s_marker_render, "render_frame");
+    int64_t start = native_get_ticks();
+    int commands = cb->commands;
+    size_t bytes = cb->used;
+
+    render_execute(cb);
+    int64_t executed = native_get_ticks();
+    present_now();
+    PF_PROFILE_END(s_marker_render);
+
+    pf_mutex_lock(&g_render.lock);
+    g_render.stats.frames++;
+    g_render.stats.commands = commands;
+    g_render.stats.command_bytes = (int64_t)bytes;
+    g_render.stats.execute_ms = (double)(executed - start) / 1000000.0;
+    pf_mutex_unlock(&g_render.lock);
+}
+
+static void render_thread_main(void* arg) {
+    (void)arg;
+    t_render_thread = true;
+    bool bound = platform_make_current(g_window.gl_context);
+
+    pf_mutex_lock(&g_render.lock);
+    g_render.starting = false;
+    g_render.start_failed = !bound;
+    pf_cond_broadcast(&g_render.cond);
+    if (!bound) {
+        pf_mutex_unlock(&g_render.lock);
+        return;
+    }
+
+    for (;;) {
+        while (!g_render.frame_pending && !g_render.quit &&
+               !atomic_load_explicit(&g_render.call_pending, memory_order_relaxed)) {
+            pf_cond_wait(&g_render.cond, &g_render.lock);
+        }
+
+        if (atomic_load_explicit(&g_render.call_pending, memory_order_relaxed)) {
+            pf_mutex_unlock(&g_render.lock);
+            render_serve_call();
+            pf_mutex_lock(&g_render.lock);
+            continue;
+        }
+
+        /* A handed-over frame is still executed when quitting */
+        if (g_render.frame_pending) {
+            RenderCommandBuffer* cb = &g_render.frames[1 - g_render.record];
+            pf_mutex_unlock(&g_render.lock);
+            render_frame(cb);
+            pf_mutex_lock(&g_render.lock);
+            g_render.frame_pending = false;
+            pf_cond_broadcast(&g_render.cond);
+            continue;
+        }
+
+        if (g_render.quit) break;
+    }
+    pf_mutex_unlock(&g_render.lock);
+
+    glFinish();
+    platform_make_current(NULL);
+}
+
+/* Main thread: hand the recorded frame to the render thread */
+static void render_submit_frame() {
+    int64_t start = native_get_ticks();
+
+    pf_mutex_lock(&g_render.lock);
+    while (g_render.frame_pending) {
+        pf_cond_wait(&g_render.cond, &g_render.lock);
+    }
+    g_render.record = 1 - g_render.record;
+    g_render.frame_pending = true;
+    g_render.stats.main_wait_ms = (double)(native_get_ticks() - start) / 1000000.0;
+    pf_cond_broadcast(&g_render.cond);
+    pf_mutex_unlock(&g_render.lock);
+}
+
+static bool render_thread_start() {
+    if (g_render.running) return true;
+    if (!g_window.is_open) return false;
+
+    /* The render thread swaps itself; a second swapping thread would race it */
+    present_thread_stop();
+
+    memset(&g_render, 0, sizeof(g_render));
+    pf_mutex_init(&g_render.lock);
+    pf_cond_init(&g_render.cond);
+    g_render.starting = true;
+
+    /* A context can only be current on one thread */
+    glFinish();
+    platform_make_current(NULL);
+
+    bool started = pf_thread_start(&g_render.thread, render_thread_main, NULL);
+    bool failed = !started;
+    if (started) {
+        pf_mutex_lock(&g_render.lock);
+        while (g_render.starting) {
+            pf_cond_wait(&g_render.cond, &g_render.lock);
+        }
+        failed = g_render.start_failed;
+        pf_mutex_unlock(&g_render.lock);
+        if (failed) pf_thread_join(g_render.thread);
+    }
+
+    if (failed) {
+        printf("Render thread could not bind the GL context; rendering on the main thread\n");
+        pf_cond_destroy(&g_render.cond);
+        pf_mutex_destroy(&g_render.lock);
+        platform_make_current(g_window.gl_context);
+        return false;
+    }
+
+    g_render.stats.active = 1;
+    g_render.running = true;
+    return true;
+}
+
+static void render_thread_stop() {
+    if (!g_render.running) return;
+
+    pf_mutex_lock(&g_render.lock);
+    g_render.quit = true;
+    pf_cond_broadcast(&g_render.cond);
+    pf_mutex_unlock(&g_render.lock);
+
+    pf_thread_join(g_render.thread);
+    g_render.running = false;
+    platform_make_current(g_window.gl_context);
+
+    /* Commands recorded since the last present still apply (deletions in particular) */
+    render_execute(&g_render.frames[g_render.record]);
+
+    for (int i = 0; i < 2; i++) free(g_render.frames[i].data);
+    pf_cond_destroy(&g_render.cond);
+    pf_mutex_destroy(&g_render.lock);
+
+    RenderThreadStats stats = g_render.stats;
+    memset(&g_render, 0, sizeof(g_render));
+    g_render.stats = stats;
+    g_render.stats.active = 0;
+}
+
+/* Returns 1 if the render thread is running afterwards */
+int native_set_render_thread(int enabled) {
+    if (enabled) return render_thread_start() ? 1 : 0;
+    render_thread_stop();
+    return 0;
+}
+
+int native_get_render_thread_stats(RenderThreadStats* stats) {
+    if (!stats) return 0;
+    if (!g_render.running) {
+        *stats = g_render.stats;
+        return 0;
+    }
+    pf_mutex_lock(&g_render.lock);
+    *stats = g_render.stats;
+    pf_mutex_unlock(&g_render.lock);
+    return 1;
+}
+
+/* ============================================================================
+ * PLATFORM-INDEPENDENT API
+ * ============================================================================ */
+
+static void shared_state_publish() {
+    g_shared.size = (int32_t)sizeof(SharedState);
+    g_shared.version = PF_SHARED_STATE_VERSION;
+    g_shared.update_ticks = g_window.last_ticks;
+    g_shared.tick_frequency = PF_TICKS_PER_SECOND;
+    g_shared.delta_time = g_window.delta_time;
+    g_shared.input = native_get_input_snapshot();
+    g_shared.width = g_window.width;
+    g_shared.height = g_window.height;
+    g_shared.is_open = g_window.is_open ? 1 : 0;
+    g_shared.headless = g_window.headless ? 1 : 0;
+}
+
+/* GL_VENDOR, GL_RENDERER, GL_VERSION captured at init, so any thread can read them */
+static char g_gl_info[3][128];
+
+static int window_init(WindowConfig* config) {
+    int width = config->width;
+    int height = config->height;
+    memset(&g_startup, 0, sizeof(g_startup));
+    atomic_store(&g_first_present, 0);
+    g_startup.init_begin = native_get_ticks();
+    if (!native_create_window(config)) {
+        return 0;
+    }
+
+    gl_load_extensions();
+    g_startup.context_ready = native_get_ticks();
+    gl_state_invalidate();
+    native_set_vsync(config->vsync ? 1 : 0);
+    texture_init();
+    shader_reload_init();
+
+    /* A freshly created window has focus; later changes come as events */
+    g_input.snapshots[0].focused = g_input.snapshots[1].focused = 1;
+
+    /* Initialize OpenGL state */
+    gl_state_viewport(0, 0, width, height);
+    gl_state_clear_color(0.2f, 0.2f, 0.25f, 1.0f);
+    gl_state_set_enabled(GL_BLEND, true);
+    gl_state_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    /* Enable depth testing for 3D */
+    gl_state_set_enabled(GL_DEPTH_TEST, true);
+    gl_state_depth_func(GL_LEQUAL);
+
+    g_shared.frame = 0;
+    shared_state_publish();
+    g_startup.init_end = native_get_ticks();
+
+    const GLenum info_names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; i++) {
+        const char* info = (const char*)glGetString(info_names[i]);
+        snprintf(g_gl_info[i], sizeof(g_gl_info[i]), "%s", info ? info : "");
+    }
+
+    printf("PyFlare Native %s Created: %dx%d\n", config->headless ? "Headless Context" : "Window", width, height);
+    printf("OpenGL Version: %s\n", g_gl_info[2]);
+    printf("OpenGL Vendor: %s\n", g_gl_info[0]);
+    printf("OpenGL Renderer: %s\n", g_gl_info[1]);
+
+    return 1;
+}
+
+int native_init_window(int width, int height, const char* title, int fullscreen, int vsync) {
+    WindowConfig config = {0};
+    config.width = width;
+    config.height = height;
+    config.title = title;
+    config.fullscreen = fullscreen != 0;
+    config.vsync = vsync != 0;
+    config.gl_major = 2;
+    config.gl_minor = 1;
+    return window_init(&config);
+}
+
+/*
+ * Offscreen context for benchmarks and tools: same GL path as a window, but nothing is
+ * shown, no input arrives, vsync is off and present finishes the frame instead of swapping
+ */
+int native_init_headless(int width, int height) {
+    WindowConfig config = {0};
+    config.width = width;
+    config.height = height;
+    config.title = "PyFlare (headless)";
+    config.headless = true;
+    config.gl_major = 2;
+    config.gl_minor = 1;
+    return window_init(&config);
+}
+
+void native_get_startup_stats(StartupStats* stats) {
+    *stats = g_startup;
+    stats->first_present = atomic_load(&g_first_present);
+}
+
+/* 0 vendor, 1 renderer, 2 version; empty before a context exists */
+const char* native_get_gl_info(int which) {
+    if (which < 0 || which > 2) return "";
+    return g_gl_info[which];
+}
+
+void native_destroy_window() {
+    render_thread_stop();
+    present_thread_stop();
+    texture_shutdown();
+    shader_reload_shutdown();
+    batcher_shutdown();
+    profiler_shutdown_gpu();
+
+    #ifdef _WIN32
+        if (g_window.gl_context) {
+            wglMakeCurrent(NULL, NULL);
+            wglDeleteContext((HGLRC)g_window.gl_context);
+        }
+        if (g_window.native_handle) {
+            DestroyWindow((HWND)g_window.native_handle);
+        }
+    #else
+        if (g_glx_context) {
+            glXMakeCurrent(g_display, None, NULL);
+            glXDestroyContext(g_display, g_glx_context);
+        }
+        if (g_x_window) {
+            XDestroyWindow(g_display, g_x_window);
+            g_x_window = 0;
+        }
+        if (g_glx_pbuffer) {
+            glXDestroyPbuffer(g_display, g_glx_pbuffer);
+            g_glx_pbuffer = 0;
+            g_glx_fbconfig = NULL;
+        }
+        g_glx_drawable = 0;
+        egl_destroy();
+        if (g_visual_info) {
+            XFree(g_visual_info);
+            g_visual_info = NULL;
+        }
+        if (g_display) {
+            XCloseDisplay(g_display);
+            g_display = NULL;
+        }
+    #endif
+
+    native_set_target_fps(0.0);
+    g_window.is_open = false;
+    g_window.headless = false;
+    shared_state_publish();
+    printf("PyFlare Native Window Destroyed\n");
+}
+
+void native_update() {
+    native_poll_events();
+    
+    /* Calculate delta time */
+    int64_t current_ticks = native_get_ticks();
+    int64_t frame_ticks = current_ticks - g_window.last_ticks;
+    g_window.delta_time = (double)frame_ticks / PF_TICKS_PER_SECOND;
+    g_window.last_ticks = current_ticks;
+
+    frame_stats_record(frame_ticks);
+    g_shared.frame++;
+    shared_state_publish();
+}
+
+/* Pace, swap and run the once-per-frame work, on whichever thread owns the context */
+static void present_now() {
+    PF_PROFILE_BEGIN(s_marker_present, "native_present");
+    present_sync();
+    pacer_wait();
+    native_swap_buffers();
+    startup_mark_present();
+    pacer_frame_presented();
+    profiler_frame();
+    gl_state_frame();
+    texture_frame();
+    shader_reload_frame();
+    PF_PROFILE_END(s_marker_present);
+}
+
+void native_present() {
+    if (render_deferred()) {
+        render_submit_frame();
+        return;
+    }
+    present_now();
+}
+
+void native_present_async() {
+    if (render_deferred()) {
+        /* Already asynchronous */
+        render_submit_frame();
+        return;
+    }
+
+    #ifdef _WIN32
+        /* Headless "swaps" are a glFinish, which needs the context current; on the
+         * present thread it would synchronize nothing */
+        if (g_window.headless || !present_thread_start()) {
+            native_present();
+            return;
+        }
+
+        present_sync();
+        pacer_wait();
+
+        /* The per-frame GL work runs before the handoff; once the swap is
+         * pending the context must stay untouched until present_sync */
+        profiler_frame();
+        gl_state_frame();
+        texture_frame();
+        shader_reload_frame();
+
+        /* Make sure the frame's commands are submitted before another thread swaps */
+        glFlush();
+
+        pf_mutex_lock(&g_present.lock);
+        g_present.pending = true;
+        pf_cond_broadcast(&g_present.cond);
+        pf_mutex_unlock(&g_present.lock);
+
+        pacer_frame_presented();
+    #else
+        native_present();
+    #endif
+}
+
+int native_is_window_open() {
+    return g_window.is_open ? 1 : 0;
+}
+
+void native_get_window_size(int* width, int* height) {
+    *width = g_window.width;
+    *height = g_window.height;
+}
+
+double native_get_delta_time() {
+    return g_window.delta_time;
+}
+
+/* Valid for the life of the process; contents refresh on every native_update */
+const SharedState* native_get_shared_state() {
+    if (g_shared.size == 0) shared_state_publish();
+    return &g_shared;
+}
+
+/* ============================================================================
+ * OPENGL UTILITY FUNCTIONS
+ * ============================================================================ */
+
+void native_clear(float r, float g, float b, float a) {
+    static int s_marker_clear = 0;
+    if (render_deferred()) {
+        float* c = (float*)render_record(RENDER_CMD_CLEAR, 4 * sizeof(float));
+        if (c) {
+            c[0] = r; c[1] = g; c[2] = b; c[3] = a;
+        }
+        return;
+    }
+
+    if (!s_marker_clear) s_marker_clear = native_profiler_register_marker("native_clear");
+
+    present_sync();
+    native_gpu_marker_begin(s_marker_clear);
+    gl_state_clear_color(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    native_gpu_marker_end(s_marker_clear);
+}
+
+/* Last compile or link error on this thread, for hot reload to report. The
+ * driver's info log is read straight in after the message prefix. */
+#define PF_SHADER_LOG_SIZE 2048
+static PF_THREAD_LOCAL char t_shader_log[PF_SHADER_LOG_SIZE];
+
+static GLuint shader_compile_stage(GLenum stage, const char* src) {
+    GLuint shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        int prefix = snprintf(t_shader_log, sizeof(t_shader_log), "%s shader compilation failed: ",
+            stage == GL_VERTEX_SHADER ? "Vertex" : "Fragment");
+        glGetShaderInfoLog(shader, (GLsizei)(sizeof(t_shader_log) - prefix), NULL, t_shader_log + prefix);
+        printf("%s\n", t_shader_log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+/* Compiles both stages into program and links it with the fixed attribute slots.
+ * Stages from an earlier link must already be detached. */
+static bool shader_link_program(GLuint program, const char* vertex_src, const char* fragment_src, bool retrievable) {
+    t_shader_log[0] = '\0';
+    GLuint vertex_shader = shader_compile_stage(GL_VERTEX_SHADER, vertex_src);
+    if (!vertex_shader) return false;
+
+    GLuint fragment_shader = shader_compile_stage(GL_FRAGMENT_SHADER, fragment_src);
+    if (!fragment_shader) {
+        glDeleteShader(vertex_shader);
+        return false;
+    }
+
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+
+    /* Fixed attribute slots so the sprite batcher works with any shader */
+    glBindAttribLocation(program, PF_ATTRIB_POSITION, "a_position");
+    glBindAttribLocation(program, PF_ATTRIB_TEXCOORD, "a_texcoord");
+    glBindAttribLocation(program, PF_ATTRIB_COLOR, "a_color");
+    if (retrievable) {
+        g_gl.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+
+    /* The linked executable does not need the stages */
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        int prefix = snprintf(t_shader_log, sizeof(t_shader_log), "Shader program linking failed: ");
+        glGetProgramInfoLog(program, (GLsizei)(sizeof(t_shader_log) - prefix), NULL, t_shader_log + prefix);
+        printf("%s\n", t_shader_log);
+        return false;
+    }
+    return true;
+}
+
+static GLuint shader_compile_program(const char* vertex_src, const char* fragment_src, bool retrievable) {
+    GLuint program = glCreateProgram();
+    if (!shader_link_program(program, vertex_src, fragment_src, retrievable)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+/* ============================================================================
+ * SHADER CACHE
+ * Identical source pairs share one linked program (reference counted), and
+ * linked binaries are kept on disk via ARB_get_program_binary when available.
+ * Disk entries are keyed by source plus GL vendor/renderer/version, so a
+ * driver update simply misses the cache.
+ * ============================================================================ */
+
+#define PF_SHADER_CACHE_MAGIC 0x42534650u /* "PFSB" */
+#define PF_SHADER_CACHE_VERSION 1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binary_format;
+    uint32_t length;
+} ShaderCacheHeader;
+
+typedef struct {
+    uint64_t key;
+    uint64_t check;         /* second hash of the sources; both must match to share */
+    GLuint program;
+    int refs;
+} ShaderCacheEntry;
+
+/* A binary read ahead of the GL context by native_shader_cache_prefetch */
+typedef struct {
+    uint64_t key;
+    uint32_t binary_format;
+    uint32_t length;
+    void* binary;
+} ShaderCacheBlob;
+
+typedef struct {
+    ShaderCacheEntry* entries;
+    int count;
+    int capacity;
+    char directory[512];
+    int memory_hits;
+    int disk_hits;
+    int compiles;
+
+    /* Prefetched binaries; any thread may add, the GL thread takes them */
+    pf_mutex prefetch_lock;
+    bool prefetch_lock_ready;
+    ShaderCacheBlob* prefetched;
+    int prefetched_count;
+    int prefetched_capacity;
+    int64_t prefetched_bytes;
+} ShaderCache;
+
+static ShaderCache g_shader_cache = {0};
+
+static uint64_t hash_fnv1a64(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#define PF_FNV_OFFSET 0xCBF29CE484222325ull
+
+static uint64_t shader_cache_key(const char* vertex_src, const char* fragment_src) {
+    const char* parts[5] = {
+        vertex_src, fragment_src,
+        (const char*)glGetString(GL_VENDOR),
+        (const char*)glGetString(GL_RENDERER),
+        (const char*)glGetString(GL_VERSION)
+    };
+
+    uint64_t hash = PF_FNV_OFFSET;
+    for (int i = 0; i < 5; i++) {
+        const char* part = parts[i] ? parts[i] : "";
+        /* Include the terminator so ("ab","c") and ("a","bc") differ */
+        hash = hash_fnv1a64(hash, part, strlen(part) + 1);
+    }
+    return hash;
+}
+
+/* Independent of FNV, so a key collision alone never shares the wrong program */
+static uint64_t shader_cache_check(const char* vertex_src, const char* fragment_src) {
+    const char* parts[2] = { vertex_src, fragment_src };
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 2; i++) {
+        const unsigned char* p = (const unsigned char*)parts[i];
+        do {
+            hash = (hash + *p) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 29;
+        } while (*p++);
+    }
+    return hash;
+}
+
+static ShaderCacheEntry* shader_cache_find_key(uint64_t key, uint64_t check) {
+    for (int i = 0; i < g_shader_cache.count; i++) {
+        ShaderCacheEntry* e = &g_shader_cache.entries[i];
+        if (e->key == key && e->check == check) return e;
+    }
+    return NULL;
+}
+
+static ShaderCacheEntry* shader_cache_find_program(GLuint program) {
+    for (int i = 0; i < g_shader_cache.count; i++) {
+        if (g_shader_cache.entries[i].program == program) return &g_shader_cache.entries[i];
+    }
+    return NULL;
+}
+
+static void shader_cache_insert(uint64_t key, uint64_t check, GLuint program) {
+    if (g_shader_cache.count == g_shader_cache.capacity) {
+        int capacity = g_shader_cache.capacity ? g_shader_cache.capacity * 2 : 32;
+        ShaderCacheEntry* entries = (ShaderCacheEntry*)realloc(g_shader_cache.entries, capacity * sizeof(ShaderCacheEntry));
+        if (!entries) return;
+        g_shader_cache.entries = entries;
+        g_shader_cache.capacity = capacity;
+    }
+
+    ShaderCacheEntry* e = &g_shader_cache.entries[g_shader_cache.count++];
+    e->key = key;
+    e->check = check;
+    e->program = program;
+    e->refs = 1;
+}
+
+static void shader_cache_path(char* out, size_t size, uint64_t key) {
+    snprintf(out, size, "%s/%016llx.pfsb", g_shader_cache.directory, (unsigned long long)key);
+}
+
+/* Reads a cache file; key 0 accepts whichever key the header names */
+static bool shader_cache_read_file(const char* path, uint64_t key, ShaderCacheBlob* blob) {
+    FILE* file = utf8_fopen(path, "rb");
+    if (!file) return false;
+
+    /* The length field is only trusted up to what the file actually holds */
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
+    rewind(file);
+
+    ShaderCacheHeader header;
+    void* binary = NULL;
+    bool ok = file_size >= (long)sizeof(header)
+        && fread(&header, sizeof(header), 1, file) == 1
+        && header.magic == PF_SHADER_CACHE_MAGIC
+        && header.version == PF_SHADER_CACHE_VERSION
+        && (key == 0 || header.key == key)
+        && header.length > 0
+        && (uint64_t)header.length <= (uint64_t)file_size - sizeof(header)
+        && (binary = malloc(header.length)) != NULL
+        && fread(binary, 1, header.length, file) == header.length;
+    fclose(file);
+
+    if (!ok) {
+        free(binary);
+        return false;
+    }
+    blob->key = header.key;
+    blob->binary_format = header.binary_format;
+    blob->length = header.length;
+    blob->binary = binary;
+    return true;
+}
+
+/* Takes a prefetched binary for key, if one was read */
+static bool shader_cache_take_prefetched(uint64_t key, ShaderCacheBlob* blob) {
+    if (!g_shader_cache.prefetch_lock_ready) return false;
+
+    bool found = false;
+    pf_mutex_lock(&g_shader_cache.prefetch_lock);
+    for (int i = 0; i < g_shader_cache.prefetched_count; i++) {
+        if (g_shader_cache.prefetched[i].key != key) continue;
+        *blob = g_shader_cache.prefetched[i];
+        g_shader_cache.prefetched_bytes -= blob->length;
+        g_shader_cache.prefetched[i] = g_shader_cache.prefetched[--g_shader_cache.prefetched_count];
+        found = true;
+        break;
+    }
+    pf_mutex_unlock(&g_shader_cache.prefetch_lock);
+    return found;
+}
+
+static GLuint shader_cache_load_binary(uint64_t key) {
+    ShaderCacheBlob blob;
+    if (!shader_cache_take_prefetched(key, &blob)) {
+        char path[600];
+        shader_cache_path(path, sizeof(path), key);
+        if (!shader_cache_read_file(path, key, &blob)) return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    g_gl.ProgramBinary(program, blob.binary_format, blob.binary, (GLsizei)blob.length);
+
+    /* Drivers may reject binaries at any time; treat that as a miss */
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+    free(blob.binary);
+    return program;
+}
+
+static void shader_cache_write_binary(uint64_t key, GLenum format, const void* binary, GLsizei length) {
+    if (length <= 0) return;
+
+    ShaderCacheHeader header;
+    header.magic = PF_SHADER_CACHE_MAGIC;
+    header.version = PF_SHADER_CACHE_VERSION;
+    header.key = key;
+    header.binary_format = format;
+    header.length = (uint32_t)length;
+
+    char path[600];
+    shader_cache_path(path, sizeof(path), key);
+
+    /* Written beside the target and renamed over it, so a crash or another
+     * process writing the same key never leaves a torn binary */
+    static atomic_uint s_temp_serial;
+    #ifdef _WIN32
+        unsigned long pid = (unsigned long)GetCurrentProcessId();
+    #else
+        unsigned long pid = (unsigned long)getpid();
+    #endif
+    char temp[640];
+    snprintf(temp, sizeof(temp), "%s.%lu.%u.tmp", path, pid, atomic_fetch_add(&s_temp_serial, 1));
+
+    FILE* file = utf8_fopen(temp, "wb");
+    if (!file) return;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(binary, 1, (size_t)length, file) == (size_t)length;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !utf8_replace_file(temp, path)) remove(temp);
+}
+
+/* Reads program's binary into a malloc'd buffer; NULL if the driver has none */
+static void* shader_get_binary(GLuint program, GLsizei* length, GLenum* format) {
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    *length = 0;
+    *format = 0;
+    if (size <= 0) return NULL;
+
+    void* binary = malloc((size_t)size);
+    if (!binary) return NULL;
+
+    g_gl.GetProgramBinary(program, size, length, format, binary);
+    if (*length <= 0) {
+        free(binary);
+        return NULL;
+    }
+    return binary;
+}
+
+static void shader_cache_store_binary(uint64_t key, GLuint program) {
+    GLsizei length;
+    GLenum format;
+    void* binary = shader_get_binary(program, &length, &format);
+    if (!binary) return;
+    shader_cache_write_binary(key, format, binary, length);
+    free(binary);
+}
+
+typedef struct {
+    const char* vertex_src;
+    const char* fragment_src;
+    unsigned int program;
+} CreateShaderCall;
+
+static void render_call_create_shader(void* args) {
+    CreateShaderCall* call = (CreateShaderCall*)args;
+    call->program = native_create_shader(call->vertex_src, call->fragment_src);
+}
+
+unsigned int native_create_shader(const char* vertex_src, const char* fragment_src) {
+    if (!vertex_src || !fragment_src) return 0;
+
+    if (render_deferred()) {
+        CreateShaderCall call = { vertex_src, fragment_src, 0 };
+        render_call(render_call_create_shader, &call);
+        return call.program;
+    }
+
+    uint64_t key = shader_cache_key(vertex_src, fragment_src);
+    uint64_t check = shader_cache_check(vertex_src, fragment_src);
+
+    ShaderCacheEntry* existing = shader_cache_find_key(key, check);
+    if (existing) {
+        existing->refs++;
+        g_shader_cache.memory_hits++;
+        return existing->program;
+    }
+
+    bool use_disk = g_gl.program_binary && g_shader_cache.directory[0] != '\0';
+
+    GLuint program = use_disk ? shader_cache_load_binary(key) : 0;
+    if (program) {
+        g_shader_cache.disk_hits++;
+    } else {
+        program = shader_compile_program(vertex_src, fragment_src, use_disk);
+        if (!program) return 0;
+        g_shader_cache.compiles++;
+        if (use_disk) shader_cache_store_binary(key, program);
+    }
+
+    shader_cache_insert(key, check, program);
+    return program;
+}
+
+void native_use_shader(unsigned int shader_id) {
+    if (render_deferred()) {
+        render_record_id(RENDER_CMD_USE_SHADER, shader_id);
+        return;
+    }
+    gl_state_use_program(shader_id);
+}
+
+/* With the render thread, the cache is only touched there; deletion is recorded
+ * so draws recorded earlier in the frame still see the program */
+void native_delete_shader(unsigned int shader_id) {
+    if (render_deferred()) {
+        render_record_id(RENDER_CMD_DELETE_SHADER, shader_id);
+        return;
+    }
+
+    ShaderCacheEntry* e = shader_cache_find_program(shader_id);
+    if (e) {
+        if (--e->refs > 0) return;
+        *e = g_shader_cache.entries[--g_shader_cache.count];
+    }
+    shader_reload_forget(shader_id);
+    gl_state_delete_program(shader_id);
+}
+
+/* Directory for program binaries; NULL or "" disables the disk cache */
+void native_set_shader_cache_dir(const char* directory) {
+    if (!g_shader_cache.prefetch_lock_ready) {
+        pf_mutex_init(&g_shader_cache.prefetch_lock);
+        g_shader_cache.prefetch_lock_ready = true;
+    }
+    if (!directory) directory = "";
+    snprintf(g_shader_cache.directory, sizeof(g_shader_cache.directory), "%s", directory);
+
+    size_t len = strlen(g_shader_cache.directory);
+    while (len > 0 && (g_shader_cache.directory[len - 1] == '/' || g_shader_cache.directory[len - 1] == '\\')) {
+        g_shader_cache.directory[--len] = '\0';
+    }
+}
+
+/* Prefetched bytes held at most; beyond this, binaries are read when first needed */
+#define PF_SHADER_PREFETCH_LIMIT (16 * 1024 * 1024)
+
+static void shader_cache_prefetch_file(const char* name) {
+    size_t length = strlen(name);
+    if (length < 5 || strcmp(name + length - 5, ".pfsb") != 0) return;
+
+    char path[600];
+    if (snprintf(path, sizeof(path), "%s/%s", g_shader_cache.directory, name) >= (int)sizeof(path)) return;
+
+    ShaderCacheBlob blob;
+    if (!shader_cache_read_file(path, 0, &blob)) return;
+
+    pf_mutex_lock(&g_shader_cache.prefetch_lock);
+    bool kept = false;
+    if (g_shader_cache.prefetched_bytes + blob.length <= PF_SHADER_PREFETCH_LIMIT) {
+        if (g_shader_cache.prefetched_count == g_shader_cache.prefetched_capacity) {
+            int capacity = g_shader_cache.prefetched_capacity ? g_shader_cache.prefetched_capacity * 2 : 32;
+            ShaderCacheBlob* grown = (ShaderCacheBlob*)realloc(g_shader_cache.prefetched, capacity * sizeof(ShaderCacheBlob));
+            if (grown) {
+                g_shader_cache.prefetched = grown;
+                g_shader_cache.prefetched_capacity = capacity;
+            }
+        }
+        if (g_shader_cache.prefetched_count < g_shader_cache.prefetched_capacity) {
+            g_shader_cache.prefetched[g_shader_cache.prefetched_count++] = blob;
+            g_shader_cache.prefetched_bytes += blob.length;
+            kept = true;
+        }
+    }
+    pf_mutex_unlock(&g_shader_cache.prefetch_lock);
+    if (!kept) free(blob.binary);
+}
+
+/*
+ * Reads every binary in the cache directory into memory, from any thread and without a GL
+ * context, so startup can overlap this disk I/O with window creation. native_create_shader
+ * then only hands the bytes to the driver. Call after native_set_shader_cache_dir and before
+ * the first shader; returns the number of binaries held.
+ */
+int native_shader_cache_prefetch() {
+    if (!g_shader_cache.prefetch_lock_ready || g_shader_cache.directory[0] == '\0') return 0;
+
+    #ifdef _WIN32
+        char pattern[600];
+        snprintf(pattern, sizeof(pattern), "%s/*.pfsb", g_shader_cache.directory);
+        wchar_t* wide = utf8_to_wide(pattern);
+        if (!wide) return 0;
+
+        WIN32_FIND_DATAW data;
+        HANDLE find = FindFirstFileW(wide, &data);
+        free(wide);
+        if (find != INVALID_HANDLE_VALUE) {
+            char name[MAX_PATH * 3];
+            do {
+                if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+                if (WideCharToMultiByte(CP_UTF8, 0, data.cFileName, -1, name, (int)sizeof(name), NULL, NULL) > 0)
+                    shader_cache_prefetch_file(name);
+            } while (FindNextFileW(find, &data));
+            FindClose(find);
+        }
+    #else
+        DIR* dir = opendir(g_shader_cache.directory);
+        if (!dir) return 0;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) shader_cache_prefetch_file(entry->d_name);
+        closedir(dir);
+    #endif
+
+    pf_mutex_lock(&g_shader_cache.prefetch_lock);
+    int count = g_shader_cache.prefetched_count;
+    pf_mutex_unlock(&g_shader_cache.prefetch_lock);
+    return count;
+}
+
+/* Frees prefetched binaries no shader asked for */
+void native_shader_cache_drop_prefetch() {
+    if (!g_shader_cache.prefetch_lock_ready) return;
+    pf_mutex_lock(&g_shader_cache.prefetch_lock);
+    for (int i = 0; i < g_shader_cache.prefetched_count; i++) free(g_shader_cache.prefetched[i].binary);
+    free(g_shader_cache.prefetched);
+    g_shader_cache.prefetched = NULL;
+    g_shader_cache.prefetched_count = g_shader_cache.prefetched_capacity = 0;
+    g_shader_cache.prefetched_bytes = 0;
+    pf_mutex_unlock(&g_shader_cache.prefetch_lock);
+}
+
+int native_shader_cache_supported() {
+    return g_gl.program_binary ? 1 : 0;
+}
+
+void native_get_shader_cache_stats(int* memory_hits, int* disk_hits, int* compiles) {
+    *memory_hits = g_shader_cache.memory_hits;
+    *disk_hits = g_shader_cache.disk_hits;
+    *compiles = g_shader_cache.compiles;
+}
+
+/* ============================================================================
+ * SHADER HOT RELOAD
+ * New sources for a live program are compiled and linked on a background
+ * thread with its own shared context, so an edit never stalls a frame. The
+ * result goes into the original program object after the swap in
+ * native_present: program ids held by sprites and Shader objects stay valid,
+ * and no frame draws with a half-updated program. The swap loads the binary
+ * the background link produced when ARB_get_program_binary is available, and
+ * otherwise relinks the original program from the already validated sources.
+ * Without a shared context the whole rebuild happens at the frame boundary.
+ * ============================================================================ */
+
+#define PF_SHADER_RELOAD_MAX 64
+
+/* Keep in sync with ShaderReloadStatus in bindings.cs */
+enum {
+    PF_SHADER_RELOAD_NONE = 0,
+    PF_SHADER_RELOAD_PENDING = 1,
+    PF_SHADER_RELOAD_APPLIED = 2,
+    PF_SHADER_RELOAD_FAILED = 3     /* old program kept */
+};
+
+typedef struct {
+    GLuint program;         /* 0 = free slot */
+    int status;
+    bool compiling;         /* sources are out with the reload thread */
+    bool compiled;          /* validated, waiting for the frame boundary */
+    char* vertex_src;
+    char* fragment_src;
+    void* binary;
+    GLsizei binary_length;
+    GLenum binary_format;
+    char error[PF_SHADER_LOG_SIZE];
+} ShaderReload;
+
+typedef struct {
+    bool initialized;
+    pf_mutex lock;
+    pf_cond cond;
+    pf_thread thread;
+    bool thread_enabled;
+    bool thread_running;
+    bool thread_quit;
+    void* shared_context;
+    ShaderReload entries[PF_SHADER_RELOAD_MAX];
+    int queued;             /* entries with sources the thread has not taken */
+    int ready;              /* entries with compiled set */
+} ShaderReloader;
+
+static ShaderReloader g_shader_reload = {0};
+
+static char* shader_reload_strdup(const char* text) {
+    size_t length = strlen(text) + 1;
+    char* copy = (char*)malloc(length);
+    if (copy) memcpy(copy, text, length);
+    return copy;
+}
+
+/* Caller holds the lock */
+static void shader_reload_clear(ShaderReload* e) {
+    free(e->vertex_src);
+    free(e->fragment_src);
+    free(e->binary);
+    e->vertex_src = e->fragment_src = NULL;
+    e->binary = NULL;
+    e->binary_length = 0;
+}
+
+/*
+ * Compiles and links the sources into a scratch program to validate them, keeping its
+ * binary when the driver can hand one out. Runs on whichever thread has a context.
+ */
+static bool shader_reload_build(const char* vertex_src, const char* fragment_src,
+                                void** binary, GLsizei* length, GLenum* format, char* error, size_t error_size) {
+    *binary = NULL;
+    *length = 0;
+    *format = 0;
+
+    GLuint scratch = shader_compile_program(vertex_src, fragment_src, g_gl.program_binary);
+    if (!scratch) {
+        snprintf(error, error_size, "%s", t_shader_log[0] ? t_shader_log : "Shader build failed");
+        return false;
+    }
+    if (g_gl.program_binary) *binary = shader_get_binary(scratch, length, format);
+    glDeleteProgram(scratch);
+    return true;
+}
+
+static void shader_reload_thread_main(void* arg) {
+    (void)arg;
+    if (!platform_make_current(g_shader_reload.shared_context)) {
+        printf("Shader reload thread could not bind its context; rebuilding at the frame boundary\n");
+        pf_mutex_lock(&g_shader_reload.lock);
+        g_shader_reload.thread_enabled = false;
+        pf_mutex_unlock(&g_shader_reload.lock);
+        return;
+    }
+
+    char error[PF_SHADER_LOG_SIZE];
+    pf_mutex_lock(&g_shader_reload.lock);
+    for (;;) {
+        while (!g_shader_reload.thread_quit && g_shader_reload.queued == 0) {
+            pf_cond_wait(&g_shader_reload.cond, &g_shader_reload.lock);
+        }
+        if (g_shader_reload.thread_quit) break;
+
+        int index = 0;
+        while (index < PF_SHADER_RELOAD_MAX) {
+            ShaderReload* e = &g_shader_reload.entries[index];
+            if (e->program && e->vertex_src && !e->compiled && !e->compiling) break;
+            index++;
+        }
+        if (index == PF_SHADER_RELOAD_MAX) {
+            g_shader_reload.queued = 0;
+            continue;
+        }
+
+        /* Take the sources so a newer request can land while this one builds */
+        ShaderReload* e = &g_shader_reload.entries[index];
+        GLuint program = e->program;
+        char* vertex_src = e->vertex_src;
+        char* fragment_src = e->fragment_src;
+        e->vertex_src = e->fragment_src = NULL;
+        e->compiling = true;
+        g_shader_reload.queued--;
+        pf_mutex_unlock(&g_shader_reload.lock);
+
+        void* binary;
+        GLsizei length;
+        GLenum format;
+        bool ok = shader_reload_build(vertex_src, fragment_src, &binary, &length, &format, error, sizeof(error));
+
+        pf_mutex_lock(&g_shader_reload.lock);
+        e->compiling = false;
+        if (e->program != program || e->vertex_src) {
+            /* Forgotten, or superseded by newer sources while building */
+            free(vertex_src);
+            free(fragment_src);
+            free(binary);
+            continue;
+        }
+
+        if (ok) {
+            e->vertex_src = vertex_src;
+            e->fragment_src = fragment_src;
+            e->binary = binary;
+            e->binary_length = length;
+            e->binary_format = format;
+            e->compiled = true;
+            g_shader_reload.ready++;
+        } else {
+            free(vertex_src);
+            free(fragment_src);
+            e->status = PF_SHADER_RELOAD_FAILED;
+            memcpy(e->error, error, sizeof(e->error));
+        }
+    }
+    pf_mutex_unlock(&g_shader_reload.lock);
+    platform_make_current(NULL);
+}
+
+static void shader_reload_init() {
+    if (g_shader_reload.initialized) return;
+    pf_mutex_init(&g_shader_reload.lock);
+    pf_cond_init(&g_shader_reload.cond);
+    g_shader_reload.shared_context = platform_create_shared_context();
+    g_shader_reload.thread_enabled = g_shader_reload.shared_context != NULL;
+    g_shader_reload.initialized = true;
+}
+
+static void shader_reload_shutdown() {
+    if (!g_shader_reload.initialized) return;
+
+    pf_mutex_lock(&g_shader_reload.lock);
+    bool running = g_shader_reload.thread_running;
+    g_shader_reload.thread_quit = true;
+    pf_cond_broadcast(&g_shader_reload.cond);
+    pf_mutex_unlock(&g_shader_reload.lock);
+    if (running) pf_thread_join(g_shader_reload.thread);
+
+    for (int i = 0; i < PF_SHADER_RELOAD_MAX; i++) shader_reload_clear(&g_shader_reload.entries[i]);
+    platform_destroy_shared_context(g_shader_reload.shared_context);
+    pf_cond_destroy(&g_shader_reload.cond);
+    pf_mutex_destroy(&g_shader_reload.lock);
+    memset(&g_shader_reload, 0, sizeof(g_shader_reload));
+}
+
+/* Caller holds the lock. Reuses the program's slot, else a free or finished one */
+static ShaderReload* shader_reload_slot(GLuint program) {
+    ShaderReload* reuse = NULL;
+    for (int i = 0; i < PF_SHADER_RELOAD_MAX; i++) {
+        ShaderReload* e = &g_shader_reload.entries[i];
+        if (e->program == program) return e;
+        if (reuse && reuse->program == 0) continue;
+        bool finished = !e->compiling && !e->vertex_src;
+        if (e->program == 0 || finished) reuse = e;
+    }
+    if (reuse) {
+        shader_reload_clear(reuse);
+        memset(reuse, 0, sizeof(*reuse));
+    }
+    return reuse;
+}
+
+/* Swaps a validated build into its program. GL thread, lock held */
+static bool shader_reload_load_binary(GLuint program, const ShaderReload* e) {
+    g_gl.ProgramBinary(program, e->binary_format, e->binary, e->binary_length);
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+static void shader_reload_apply(ShaderReload* e) {
+    GLuint program = e->program;
+
+    /* A failed glProgramBinary or link throws away a program's executable, so
+     * the new version is proven on a scratch program first; the live one is
+     * only touched with something that is known to link */
+    GLuint scratch = glCreateProgram();
+    bool valid = e->binary && shader_reload_load_binary(scratch, e);
+    if (!valid) {
+        glDeleteProgram(scratch);
+        scratch = shader_compile_program(e->vertex_src, e->fragment_src, g_gl.program_binary);
+        valid = scratch != 0;
+        if (valid && g_gl.program_binary) {
+            free(e->binary);
+            e->binary = shader_get_binary(scratch, &e->binary_length, &e->binary_format);
+        }
+    }
+    if (!valid) {
+        e->status = PF_SHADER_RELOAD_FAILED;
+        snprintf(e->error, sizeof(e->error), "%s", t_shader_log[0] ? t_shader_log : "Shader relink failed");
+        return;
+    }
+
+    bool linked = e->binary && shader_reload_load_binary(program, e);
+    if (!linked) {
+        /* Programs made by shader_compile_program have no stages attached, but be safe */
+        GLuint attached[4];
+        GLsizei count = 0;
+        glGetAttachedShaders(program, 4, &count, attached);
+        for (GLsizei i = 0; i < count; i++) glDetachShader(program, attached[i]);
+        linked = shader_link_program(program, e->vertex_src, e->fragment_src, g_gl.program_binary);
+    }
+    glDeleteProgram(scratch);
+
+    if (!linked) {
+        /* The same sources just linked on the scratch program; only a driver fault lands here */
+        e->status = PF_SHADER_RELOAD_FAILED;
+        snprintf(e->error, sizeof(e->error), "%s", t_shader_log[0] ? t_shader_log : "Shader relink failed");
+        return;
+    }
+
+    /* Identical sources now find this program; the disk cache learns the new binary */
+    uint64_t key = shader_cache_key(e->vertex_src, e->fragment_src);
+    ShaderCacheEntry* cached = shader_cache_find_program(program);
+    if (cached) {
+        cached->key = key;
+        cached->check = shader_cache_check(e->vertex_src, e->fragment_src);
+    }
+    if (g_gl.program_binary && g_shader_cache.directory[0] != '\0') {
+        if (e->binary) shader_cache_write_binary(key, e->binary_format, e->binary, e->binary_length);
+        else shader_cache_store_binary(key, program);
+    }
+
+    e->status = PF_SHADER_RELOAD_APPLIED;
+    e->error[0] = '\0';
+}
+
+/* Once per frame after the swap, on the GL thread */
+static void shader_reload_frame() {
+    if (!g_shader_reload.initialized) return;
+
+    pf_mutex_lock(&g_shader_reload.lock);
+    bool inline_build = !g_shader_reload.thread_enabled && g_shader_reload.queued > 0;
+    if (g_shader_reload.ready == 0 && !inline_build) {
+        pf_mutex_unlock(&g_shader_reload.lock);
+        return;
+    }
+
+    PF_PROFILE_BEGIN(s_marker_reload, "shader_reload");
+    for (int i = 0; i < PF_SHADER_RELOAD_MAX; i++) {
+        ShaderReload* e = &g_shader_reload.entries[i];
+        if (!e->program || e->compiling) continue;
+
+        if (inline_build && e->vertex_src && !e->compiled) {
+            g_shader_reload.queued--;
+            e->compiled = shader_reload_build(e->vertex_src, e->fragment_src, &e->binary,
+                &e->binary_length, &e->binary_format, e->error, sizeof(e->error));
+            if (!e->compiled) {
+                e->status = PF_SHADER_RELOAD_FAILED;
+                shader_reload_clear(e);
+                continue;
+            }
+            g_shader_reload.ready++;
+        }
+        if (!e->compiled) continue;
+
+        shader_reload_apply(e);
+        e->compiled = false;
+        g_shader_reload.ready--;
+        shader_reload_clear(e);
+    }
+    pf_mutex_unlock(&g_shader_reload.lock);
+    PF_PROFILE_END(s_marker_reload);
+}
+
+/* A deleted program's name can be recycled; drop whatever was queued for it */
+static void shader_reload_forget(GLuint program) {
+    if (!g_shader_reload.initialized) return;
+    pf_mutex_lock(&g_shader_reload.lock);
+    for (int i = 0; i < PF_SHADER_RELOAD_MAX; i++) {
+        ShaderReload* e = &g_shader_reload.entries[i];
+        if (e->program != program) continue;
+        if (e->vertex_src && !e->compiled && !e->compiling) g_shader_reload.queued--;
+        if (e->compiled) g_shader_reload.ready--;
+        shader_reload_clear(e);
+        memset(e, 0, sizeof(*e));
+    }
+    pf_mutex_unlock(&g_shader_reload.lock);
+}
+
+/* ---- Public API ---- */
+
+/*
+ * Queues new sources for a live program; any thread. The old program keeps drawing until
+ * the rebuilt one is swapped in after a present. Newer sources replace a pending request
+ * for the same program. Returns 0 if the reload could not be queued.
+ */
+int native_shader_reload(unsigned int program, const char* vertex_src, const char* fragment_src) {
+    if (!program || !vertex_src || !fragment_src || !g_shader_reload.initialized) return 0;
+
+    char* vertex_copy = shader_reload_strdup(vertex_src);
+    char* fragment_copy = shader_reload_strdup(fragment_src);
+    if (!vertex_copy || !fragment_copy) {
+        free(vertex_copy);
+        free(fragment_copy);
+        return 0;
+    }
+
+    pf_mutex_lock(&g_shader_reload.lock);
+    ShaderReload* e = shader_reload_slot((GLuint)program);
+    if (!e) {
+        pf_mutex_unlock(&g_shader_reload.lock);
+        free(vertex_copy);
+        free(fragment_copy);
+        return 0;
+    }
+
+    bool queued = e->vertex_src && !e->compiled && !e->compiling;
+    if (e->compiled) g_shader_reload.ready--;
+    shader_reload_clear(e);
+
+    e->program = (GLuint)program;
+    e->compiled = false;
+    e->vertex_src = vertex_copy;
+    e->fragment_src = fragment_copy;
+    e->status = PF_SHADER_RELOAD_PENDING;
+    e->error[0] = '\0';
+    if (!queued) g_shader_reload.queued++;
+
+    if (g_shader_reload.thread_enabled && !g_shader_reload.thread_running) {
+        g_shader_reload.thread_quit = false;
+        if (pf_thread_start(&g_shader_reload.thread, shader_reload_thread_main, NULL)) {
+            g_shader_reload.thread_running = true;
+        } else {
+            g_shader_reload.thread_enabled = false;
+        }
+    }
+    pf_cond_broadcast(&g_shader_reload.cond);
+    pf_mutex_unlock(&g_shader_reload.lock);
+    return 1;
+}
+
+/* PF_SHADER_RELOAD_* for the program's latest reload */
+int native_shader_reload_status(unsigned int program) {
+    if (!program || !g_shader_reload.initialized) return PF_SHADER_RELOAD_NONE;
+    int status = PF_SHADER_RELOAD_NONE;
+    pf_mutex_lock(&g_shader_reload.lock);
+    for (int i = 0; i < PF_SHADER_RELOAD_MAX; i++) {
+        if (g_shader_reload.entries[i].program == (GLuint)program) {
+            status = g_shader_reload.entries[i].status;
+            break;
+        }
+    }
+    pf_mutex_unlock(&g_shader_reload.lock);
+    return status;
+}
+
+/* Copies the compile or link log of a failed reload; returns its length */
+int native_shader_reload_error(unsigned int program, char* buffer, int size) {
+    if (!buffer || size <= 0) return 0;
+    buffer[0] = '\0';
+    if (!program || !g_shader_reload.initialized) return 0;
+
+    pf_mutex_lock(&g_shader_reload.lock);
+    for (int i = 0; i < PF_SHADER_RELOAD_MAX; i++) {
+        ShaderReload* e = &g_shader_reload.entries[i];
+        if (e->program == (GLuint)program && e->status == PF_SHADER_RELOAD_FAILED) {
+            snprintf(buffer, (size_t)size, "%s", e->error);
+            break;
+        }
+    }
+    pf_mutex_unlock(&g_shader_reload.lock);
+    return (int)strlen(buffer);
+}
+
+/* ============================================================================
+ * STREAMING VERTEX BUFFERS
+ * A ring of GL buffers for per-frame dynamic geometry. Writes never touch
+ * storage the GPU may still be reading:
+ *   - persistent: ARB_buffer_storage mapping, fenced per ring slot
+ *   - map range:  glMapBufferRange with unsynchronized appends, invalidated on wrap
+ *   - orphan:     GL 2.1 glBufferData(NULL) + glBufferSubData from a staging copy
+ * ============================================================================ */
+
+#define PF_MAX_STREAM_BUFFERS 16
+#define PF_STREAM_MAX_RING 8
+
+typedef enum {
+    STREAM_MODE_ORPHAN = 0,
+    STREAM_MODE_MAP_RANGE = 1,
+    STREAM_MODE_PERSISTENT = 2
+} StreamMode;
+
+typedef struct {
+    bool in_use;
+    StreamMode mode;
+    int ring_count;
+    int current;
+    GLsizeiptr size;
+    GLsizeiptr offset;
+    GLsizeiptr mapped_size;
+    bool mapped;
+    GLuint buffers[PF_STREAM_MAX_RING];
+    GLsync fences[PF_STREAM_MAX_RING];
+    unsigned char* persistent[PF_STREAM_MAX_RING];
+    unsigned char* staging;
+} StreamBuffer;
+
+static StreamBuffer g_stream_buffers[PF_MAX_STREAM_BUFFERS] = {0};
+
+static StreamBuffer* stream_buffer_get(int handle) {
+    if (handle <= 0 || handle > PF_MAX_STREAM_BUFFERS) return NULL;
+    StreamBuffer* sb = &g_stream_buffers[handle - 1];
+    return sb->in_use ? sb : NULL;
+}
+
+static void stream_buffer_wait(StreamBuffer* sb, int slot) {
+    if (!sb->fences[slot]) return;
+
+    /* Normally signalled long ago; only blocks if the GPU is a full ring behind */
+    GLbitfield flags = 0;
+    while (g_gl.ClientWaitSync(sb->fences[slot], flags, 1000000) == GL_TIMEOUT_EXPIRED) {
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+    g_gl.DeleteSync(sb->fences[slot]);
+    sb->fences[slot] = NULL;
+}
+
+static void stream_buffer_advance(StreamBuffer* sb) {
+    if (sb->mode == STREAM_MODE_PERSISTENT) {
+        /* Every draw reading the old slot has been issued by now */
+        sb->fences[sb->current] = g_gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    sb->current = (sb->current + 1) % sb->ring_count;
+    sb->offset = 0;
+
+    if (sb->mode == STREAM_MODE_PERSISTENT) {
+        stream_buffer_wait(sb, sb->current);
+    }
+}
+
+static int stream_buffer_create(int size, int ring_count) {
+    if (size <= 0) return 0;
+    if (ring_count < 1) ring_count = 1;
+    if (ring_count > PF_STREAM_MAX_RING) ring_count = PF_STREAM_MAX_RING;
+
+    int handle = 0;
+    for (int i = 0; i < PF_MAX_STREAM_BUFFERS; i++) {
+        if (!g_stream_buffers[i].in_use) {
+            handle = i + 1;
+            break;
+        }
+    }
+    if (!handle) {
+        printf("Out of stream buffer slots\n");
+        return 0;
+    }
+
+    StreamBuffer* sb = &g_stream_buffers[handle - 1];
+    memset(sb, 0, sizeof(*sb));
+    sb->size = size;
+    sb->ring_count = ring_count;
+
+    if (g_gl.buffer_storage) {
+        sb->mode = STREAM_MODE_PERSISTENT;
+    } else if (g_gl.map_buffer_range) {
+        sb->mode = STREAM_MODE_MAP_RANGE;
+    } else {
+        sb->mode = STREAM_MODE_ORPHAN;
+        sb->staging = (unsigned char*)malloc((size_t)size);
+        if (!sb->staging) return 0;
+    }
+
+    glGenBuffers(ring_count, sb->buffers);
+    for (int i = 0; i < ring_count; i++) {
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, sb->buffers[i]);
+        if (sb->mode == STREAM_MODE_PERSISTENT) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            g_gl.BufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+            sb->persistent[i] = (unsigned char*)g_gl.MapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+    }
+
+    sb->in_use = true;
+    return handle;
+}
+
+static void* stream_buffer_map(StreamBuffer* sb, int bytes) {
+    if (sb->mapped || bytes <= 0 || bytes > sb->size) return NULL;
+
+    if (sb->offset + bytes > sb->size) {
+        stream_buffer_advance(sb);
+    }
+
+    void* ptr = NULL;
+    switch (sb->mode) {
+        case STREAM_MODE_PERSISTENT:
+            ptr = sb->persistent[sb->current] + sb->offset;
+            break;
+        case STREAM_MODE_MAP_RANGE: {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+            if (sb->offset == 0) flags |= GL_MAP_INVALIDATE_BUFFER_BIT;
+            gl_state_bind_buffer(GL_ARRAY_BUFFER, sb->buffers[sb->current]);
+            ptr = g_gl.MapBufferRange(GL_ARRAY_BUFFER, sb->offset, bytes, flags);
+            break;
+        }
+        case STREAM_MODE_ORPHAN:
+            ptr = sb->staging;
+            break;
+    }
+
+    if (ptr) {
+        sb->mapped = true;
+        sb->mapped_size = bytes;
+    }
+    return ptr;
+}
+
+/* Returns the offset of the committed data in the buffer left bound to GL_ARRAY_BUFFER */
+static int stream_buffer_commit(StreamBuffer* sb, int bytes) {
+    if (!sb->mapped) return -1;
+    if (bytes < 0 || bytes > sb->mapped_size) bytes = (int)sb->mapped_size;
+
+    GLsizeiptr offset = sb->offset;
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, sb->buffers[sb->current]);
+
+    switch (sb->mode) {
+        case STREAM_MODE_PERSISTENT:
+            break;
+        case STREAM_MODE_MAP_RANGE:
+            g_gl.UnmapBuffer(GL_ARRAY_BUFFER);
+            break;
+        case STREAM_MODE_ORPHAN:
+            if (offset == 0) {
+                glBufferData(GL_ARRAY_BUFFER, sb->size, NULL, GL_STREAM_DRAW);
+            }
+            if (bytes > 0) {
+                glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, sb->staging);
+            }
+            break;
+    }
+
+    /* Keep every sub-allocation 16-byte aligned for attribute fetch */
+    sb->offset += ((GLsizeiptr)bytes + 15) & ~(GLsizeiptr)15;
+    sb->mapped = false;
+    sb->mapped_size = 0;
+    return (int)offset;
+}
+
+static void stream_buffer_destroy(StreamBuffer* sb) {
+    for (int i = 0; i < sb->ring_count; i++) {
+        if (sb->fences[i]) g_gl.DeleteSync(sb->fences[i]);
+        if (sb->persistent[i]) {
+            gl_state_bind_buffer(GL_ARRAY_BUFFER, sb->buffers[i]);
+            g_gl.UnmapBuffer(GL_ARRAY_BUFFER);
+        }
+    }
+    if (sb->mapped && sb->mode == STREAM_MODE_MAP_RANGE) {
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, sb->buffers[sb->current]);
+        g_gl.UnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    gl_state_delete_buffers(sb->ring_count, sb->buffers);
+    free(sb->staging);
+    memset(sb, 0, sizeof(*sb));
+}
+
+/* Stream buffer calls return GL results, so with the render thread they run there synchronously */
+typedef struct {
+    int handle;
+    int bytes;
+    int result;
+    void* ptr;
+} StreamBufferCall;
+
+static void render_call_create_stream(void* args) {
+    StreamBufferCall* call = (StreamBufferCall*)args;
+    call->result = stream_buffer_create(call->bytes, call->handle);
+}
+
+static void render_call_map_ring(void* args) {
+    StreamBufferCall* call = (StreamBufferCall*)args;
+    StreamBuffer* sb = stream_buffer_get(call->handle);
+    call->ptr = sb ? stream_buffer_map(sb, call->bytes) : NULL;
+}
+
+static void render_call_commit_ring(void* args) {
+    StreamBufferCall* call = (StreamBufferCall*)args;
+    StreamBuffer* sb = stream_buffer_get(call->handle);
+    call->result = sb ? stream_buffer_commit(sb, call->bytes) : -1;
+}
+
+int native_create_stream_buffer(int size, int ring_count) {
+    if (render_deferred()) {
+        StreamBufferCall call = { ring_count, size, 0, NULL };
+        render_call(render_call_create_stream, &call);
+        return call.result;
+    }
+    return stream_buffer_create(size, ring_count);
+}
+
+void* native_map_ring(int handle, int bytes) {
+    if (render_deferred()) {
+        StreamBufferCall call = { handle, bytes, 0, NULL };
+        render_call(render_call_map_ring, &call);
+        return call.ptr;
+    }
+    StreamBuffer* sb = stream_buffer_get(handle);
+    return sb ? stream_buffer_map(sb, bytes) : NULL;
+}
+
+int native_commit_ring(int handle, int bytes_written) {
+    if (render_deferred()) {
+        StreamBufferCall call = { handle, bytes_written, -1, NULL };
+        render_call(render_call_commit_ring, &call);
+        return call.result;
+    }
+    StreamBuffer* sb = stream_buffer_get(handle);
+    return sb ? stream_buffer_commit(sb, bytes_written) : -1;
+}
+
+unsigned int native_get_ring_buffer_id(int handle) {
+    StreamBuffer* sb = stream_buffer_get(handle);
+    return sb ? sb->buffers[sb->current] : 0;
+}
+
+int native_get_stream_buffer_mode(int handle) {
+    StreamBuffer* sb = stream_buffer_get(handle);
+    return sb ? (int)sb->mode : -1;
+}
+
+void native_destroy_stream_buffer(int handle) {
+    if (render_deferred()) {
+        render_record_id(RENDER_CMD_DESTROY_STREAM, (unsigned int)handle);
+        return;
+    }
+    StreamBuffer* sb = stream_buffer_get(handle);
+    if (sb) stream_buffer_destroy(sb);
+}
+
+/* ============================================================================
+ * TEXTURES
+ * Pixel data reaches the GPU through pixel buffer objects: the bytes are
+ * copied into a PBO and glTexImage2D sources from it, so the transfer to
+ * video memory is the driver's DMA rather than a synchronous client copy.
+ * Uploads are queued and drained up to a per-frame byte budget, by a
+ * background thread with its own shared context when one can be created,
+ * otherwise after the swap in native_present. Compressed formats (DXT, ETC2)
+ * are uploaded as stored; there is no CPU decode. Each upload defines a whole
+ * mip level.
+ * ============================================================================ */
+
+/* Keep in sync with TextureFormat in bindings.cs and build.py */
+enum {
+    PF_TEXTURE_RGBA8 = 0,
+    PF_TEXTURE_RGB8 = 1,
+    PF_TEXTURE_DXT1 = 2,
+    PF_TEXTURE_DXT3 = 3,
+    PF_TEXTURE_DXT5 = 4,
+    PF_TEXTURE_ETC2_RGB = 5,
+    PF_TEXTURE_ETC2_RGBA = 6,
+    PF_TEXTURE_FORMAT_COUNT
+};
+
+#define PF_GL_COMPRESSED_RGBA_S3TC_DXT1 0x83F1
+#define PF_GL_COMPRESSED_RGBA_S3TC_DXT3 0x83F2
+#define PF_GL_COMPRESSED_RGBA_S3TC_DXT5 0x83F3
+#define PF_GL_COMPRESSED_RGB8_ETC2 0x9274
+#define PF_GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+
+#define PF_TEXTURE_STAGING_BUFFERS 3
+#define PF_TEXTURE_DEFAULT_BUDGET (2 * 1024 * 1024)
+
+typedef struct {
+    GLenum internal_format;
+    GLenum format;          /* 0 for compressed */
+    int block_bytes;        /* bytes per 4x4 block, 0 for uncompressed */
+    int pixel_bytes;
+} TextureFormatInfo;
+
+static const TextureFormatInfo g_texture_formats[PF_TEXTURE_FORMAT_COUNT] = {
+    { GL_RGBA8, GL_RGBA, 0, 4 },
+    { GL_RGB8, GL_RGB, 0, 3 },
+    { PF_GL_COMPRESSED_RGBA_S3TC_DXT1, 0, 8, 0 },
+    { PF_GL_COMPRESSED_RGBA_S3TC_DXT3, 0, 16, 0 },
+    { PF_GL_COMPRESSED_RGBA_S3TC_DXT5, 0, 16, 0 },
+    { PF_GL_COMPRESSED_RGB8_ETC2, 0, 8, 0 },
+    { PF_GL_COMPRESSED_RGBA8_ETC2_EAC, 0, 16, 0 },
+};
+
+typedef struct {
+    GLuint texture;
+    int level;
+    int width;
+    int height;
+    int format;
+    const void* data;
+    int64_t bytes;
+    bool owned;             /* data is our copy, freed after upload */
+} TextureUpload;
+
+typedef struct {
+    GLuint texture;
+    int width;
+    int height;
+    int format;
+    int levels;
+    int pending;            /* queued or in-flight uploads, guarded by the lock */
+} TextureRecord;
+
+/* Per-context PBO ring; buffer bindings are context state */
+typedef struct {
+    GLuint buffers[PF_TEXTURE_STAGING_BUFFERS];
+    int next;
+    bool ready;
+} TextureStager;
+
+/* Layout shared with TextureStats in bindings.cs - keep in sync */
+typedef struct {
+    int64_t uploaded_bytes;
+    int64_t uploads;
+    int64_t queued_bytes;
+    int queued;
+    int background;         /* 1 if a shared-context thread does the uploads */
+} TextureStats;
+
+typedef struct {
+    bool initialized;
+    pf_mutex lock;
+    pf_cond cond;
+
+    TextureRecord* records;
+    int record_count;
+    int record_capacity;
+
+    TextureUpload* queue;   /* FIFO: [head, count) */
+    int head;
+    int count;
+    int capacity;
+
+    int64_t budget_bytes;
+    int64_t frame;
+    TextureStats stats;
+    TextureStager main_stager;
+
+    void* shared_context;
+    bool thread_enabled;
+    bool thread_running;
+    bool thread_quit;
+    bool thread_failed;     /* thread exited on its own; join from the main thread */
+    pf_thread thread;
+} TextureSystem;
+
+static TextureSystem g_textures = {0};
+
+static int64_t texture_level_bytes(int format, int width, int height) {
+    if (format < 0 || format >= PF_TEXTURE_FORMAT_COUNT) return 0;
+    const TextureFormatInfo* info = &g_texture_formats[format];
+    if (width < 1) width = 1;
+    if (height < 1) height = 1;
+    if (info->block_bytes) {
+        return (int64_t)((width + 3) / 4) * ((height + 3) / 4) * info->block_bytes;
+    }
+    return (int64_t)width * height * info->pixel_bytes;
+}
+
+/* Caller holds the lock */
+static TextureRecord* texture_find(GLuint texture) {
+    for (int i = 0; i < g_textures.record_count; i++) {
+        if (g_textures.records[i].texture == texture) return &g_textures.records[i];
+    }
+    return NULL;
+}
+
+static void texture_stager_init(TextureStager* stager) {
+    if (stager->ready) return;
+    glGenBuffers(PF_TEXTURE_STAGING_BUFFERS, stager->buffers);
+    stager->next = 0;
+    stager->ready = true;
+    /* RGB8 rows are not 4-byte aligned */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+}
+
+static void texture_stager_destroy(TextureStager* stager) {
+    if (!stager->ready) return;
+    glDeleteBuffers(PF_TEXTURE_STAGING_BUFFERS, stager->buffers);
+    stager->ready = false;
+}
+
+/* Stages one level through the next PBO and defines it from there */
+static void texture_upload_level(TextureStager* stager, const TextureUpload* up) {
+    const TextureFormatInfo* info = &g_texture_formats[up->format];
+    GLuint pbo = stager->buffers[stager->next];
+    stager->next = (stager->next + 1) % PF_TEXTURE_STAGING_BUFFERS;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    /* Orphan first: the driver hands back fresh storage instead of waiting on
+     * a previous upload still reading this buffer */
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)up->bytes, NULL, GL_STREAM_DRAW);
+
+    void* dst = NULL;
+    if (g_gl.map_buffer_range) {
+        dst = g_gl.MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)up->bytes,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+    if (dst) {
+        memcpy(dst, up->data, (size_t)up->bytes);
+        g_gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)up->bytes, up->data);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, up->texture);
+    if (info->block_bytes) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, up->level, info->internal_format,
+                               up->width, up->height, 0, (GLsizei)up->bytes, (const void*)0);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, up->level, (GLint)info->internal_format,
+                     up->width, up->height, 0, info->format, GL_UNSIGNED_BYTE, (const void*)0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/* Caller holds the lock. Pops up to the frame budget (at least one upload) into out */
+static int texture_take_batch(TextureUpload* out, int max) {
+    int64_t budget = g_textures.budget_bytes;
+    int taken = 0;
+    while (g_textures.count > 0 && taken < max && (taken == 0 || budget > 0)) {
+        TextureUpload* up = &g_textures.queue[g_textures.head];
+        out[taken++] = *up;
+        budget -= up->bytes;
+        g_textures.head++;
+        g_textures.count--;
+        g_textures.stats.queued_bytes -= up->bytes;
+    }
+    if (g_textures.count == 0) g_textures.head = 0;
+    g_textures.stats.queued = g_textures.count;
+    return taken;
+}
+
+/* Caller holds the lock */
+static void texture_batch_done(TextureUpload* batch, int count) {
+    for (int i = 0; i < count; i++) {
+        TextureRecord* record = texture_find(batch[i].texture);
+        if (record) record->pending--;
+        g_textures.stats.uploaded_bytes += batch[i].bytes;
+        g_textures.stats.uploads++;
+        if (batch[i].owned) free((void*)batch[i].data);
+    }
+    pf_cond_broadcast(&g_textures.cond);
+}
+
+#define PF_TEXTURE_BATCH_MAX 64
+
+static void texture_upload_thread_main(void* arg) {
+    (void)arg;
+    if (!platform_make_current(g_textures.shared_context)) {
+        printf("Texture upload thread could not bind its context; uploading on the main thread\n");
+        pf_mutex_lock(&g_textures.lock);
+        g_textures.thread_enabled = false;
+        g_textures.thread_failed = true;
+        g_textures.stats.background = 0;
+        pf_mutex_unlock(&g_textures.lock);
+        return;
+    }
+
+    TextureStager stager = {0};
+    texture_stager_init(&stager);
+
+    TextureUpload batch[PF_TEXTURE_BATCH_MAX];
+    int64_t last_frame = -1;
+
+    pf_mutex_lock(&g_textures.lock);
+    for (;;) {
+        /* One budget's worth per presented frame */
+        while (!g_textures.thread_quit && (g_textures.count == 0 || g_textures.frame == last_frame)) {
+            pf_cond_wait(&g_textures.cond, &g_textures.lock);
+        }
+        if (g_textures.thread_quit) break;
+
+        last_frame = g_textures.frame;
+        int count = texture_take_batch(batch, PF_TEXTURE_BATCH_MAX);
+        pf_mutex_unlock(&g_textures.lock);
+
+        for (int i = 0; i < count; i++) texture_upload_level(&stager, &batch[i]);
+        /* The main context may sample these as soon as pending drops */
+        glFinish();
+
+        pf_mutex_lock(&g_textures.lock);
+        texture_batch_done(batch, count);
+    }
+    pf_mutex_unlock(&g_textures.lock);
+
+    texture_stager_destroy(&stager);
+    platform_make_current(NULL);
+}
+
+static void texture_init() {
+    if (g_textures.initialized) return;
+    pf_mutex_init(&g_textures.lock);
+    pf_cond_init(&g_textures.cond);
+    g_textures.budget_bytes = PF_TEXTURE_DEFAULT_BUDGET;
+    g_textures.shared_context = platform_create_shared_context();
+    g_textures.thread_enabled = g_textures.shared_context != NULL;
+    g_textures.initialized = true;
+}
+
+/* Caller holds the lock */
+static void texture_start_thread_locked() {
+    if (g_textures.thread_running || !g_textures.thread_enabled) return;
+    g_textures.thread_quit = false;
+    g_textures.thread_failed = false;
+    if (pf_thread_start(&g_textures.thread, texture_upload_thread_main, NULL)) {
+        g_textures.thread_running = true;
+        g_textures.stats.background = 1;
+    } else {
+        g_textures.thread_enabled = false;
+    }
+}
+
+static void texture_stop_thread() {
+    pf_mutex_lock(&g_textures.lock);
+    bool running = g_textures.thread_running;
+    g_textures.thread_quit = true;
+    pf_cond_broadcast(&g_textures.cond);
+    pf_mutex_unlock(&g_textures.lock);
+
+    if (running) pf_thread_join(g_textures.thread);
+    g_textures.thread_running = false;
+    g_textures.stats.background = 0;
+}
+
+/* Once per frame after the swap: releases the upload thread's next budget,
+ * or does the uploads here when there is no thread */
+static void texture_frame() {
+    if (!g_textures.initialized) return;
+
+    pf_mutex_lock(&g_textures.lock);
+    if (g_textures.thread_failed) {
+        pf_mutex_unlock(&g_textures.lock);
+        pf_thread_join(g_textures.thread);
+        pf_mutex_lock(&g_textures.lock);
+        g_textures.thread_running = false;
+        g_textures.thread_failed = false;
+    }
+
+    g_textures.frame++;
+    if (g_textures.thread_running || g_textures.count == 0) {
+        pf_cond_broadcast(&g_textures.cond);
+        pf_mutex_unlock(&g_textures.lock);
+        return;
+    }
+
+    PF_PROFILE_BEGIN(s_marker_upload, "texture_upload");
+    TextureUpload batch[PF_TEXTURE_BATCH_MAX];
+    int count = texture_take_batch(batch, PF_TEXTURE_BATCH_MAX);
+    pf_mutex_unlock(&g_textures.lock);
+
+    texture_stager_init(&g_textures.main_stager);
+    for (int i = 0; i < count; i++) texture_upload_level(&g_textures.main_stager, &batch[i]);
+    /* texture_upload_level binds directly so it can run on the upload context too */
+    gl_state_set_bound_texture(0);
+
+    pf_mutex_lock(&g_textures.lock);
+    texture_batch_done(batch, count);
+    pf_mutex_unlock(&g_textures.lock);
+    PF_PROFILE_END(s_marker_upload);
+}
+
+static void texture_shutdown() {
+    if (!g_textures.initialized) return;
+    texture_stop_thread();
+
+    for (int i = 0; i < g_textures.count; i++) {
+        TextureUpload* up = &g_textures.queue[g_textures.head + i];
+        if (up->owned) free((void*)up->data);
+    }
+    free(g_textures.queue);
+    free(g_textures.records);
+    texture_stager_destroy(&g_textures.main_stager);
+    platform_destroy_shared_context(g_textures.shared_context);
+
+    pf_cond_destroy(&g_textures.cond);
+    pf_mutex_destroy(&g_textures.lock);
+    memset(&g_textures, 0, sizeof(g_textures));
+}
+
+/* ---- Public API ---- */
+
+int native_texture_format_supported(int format) {
+    switch (format) {
+        case PF_TEXTURE_RGBA8:
+        case PF_TEXTURE_RGB8:
+            return 1;
+        case PF_TEXTURE_DXT1:
+        case PF_TEXTURE_DXT3:
+        case PF_TEXTURE_DXT5:
+            return g_gl.texture_s3tc ? 1 : 0;
+        case PF_TEXTURE_ETC2_RGB:
+        case PF_TEXTURE_ETC2_RGBA:
+            return g_gl.texture_etc2 ? 1 : 0;
+    }
+    return 0;
+}
+
+int64_t native_texture_level_size(int format, int width, int height) {
+    return texture_level_bytes(format, width, height);
+}
+
+typedef struct {
+    int width;
+    int height;
+    int format;
+    int levels;
+    unsigned int texture;
+} CreateTextureCall;
+
+static void render_call_create_texture(void* args) {
+    CreateTextureCall* call = (CreateTextureCall*)args;
+    call->texture = native_create_texture(call->width, call->height, call->format, call->levels);
+}
+
+/* Creates the texture object; levels are defined by native_texture_upload */
+unsigned int native_create_texture(int width, int height, int format, int levels) {
+    if (!g_textures.initialized || width <= 0 || height <= 0 || !native_texture_format_supported(format)) return 0;
+    if (levels < 1) levels = 1;
+
+    if (render_deferred()) {
+        CreateTextureCall call = { width, height, format, levels, 0 };
+        render_call(render_call_create_texture, &call);
+        return call.texture;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    gl_state_bind_texture(0, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    /* Only the levels we will upload count toward completeness */
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    pf_mutex_lock(&g_textures.lock);
+    if (g_textures.record_count == g_textures.record_capacity) {
+        int capacity = g_textures.record_capacity ? g_textures.record_capacity * 2 : 64;
+        TextureRecord* records = (TextureRecord*)realloc(g_textures.records, capacity * sizeof(TextureRecord));
+        if (!records) {
+            pf_mutex_unlock(&g_textures.lock);
+            gl_state_delete_texture(texture);
+            return 0;
+        }
+        g_textures.records = records;
+        g_textures.record_capacity = capacity;
+    }
+    TextureRecord* record = &g_textures.records[g_textures.record_count++];
+    record->texture = texture;
+    record->width = width;
+    record->height = height;
+    record->format = format;
+    record->levels = levels;
+    record->pending = 0;
+    pf_mutex_unlock(&g_textures.lock);
+
+    return texture;
+}
+
+/*
+ * Queues a whole mip level. With copy = 0 the data is used in place and must
+ * stay valid until native_texture_pending reports 0 (e.g. a mapped archive);
+ * otherwise it is copied now. Returns 1 if queued.
+ */
+int native_texture_upload(unsigned int texture, int level, const void* data, int64_t bytes, int copy) {
+    if (!g_textures.initialized || !data || bytes <= 0) return 0;
+
+    pf_mutex_lock(&g_textures.lock);
+    TextureRecord* record = texture_find(texture);
+    if (!record || level < 0 || level >= record->levels) {
+        pf_mutex_unlock(&g_textures.lock);
+        return 0;
+    }
+
+    TextureUpload up;
+    up.texture = texture;
+    up.level = level;
+    up.width = record->width >> level;
+    up.height = record->height >> level;
+    if (up.width < 1) up.width = 1;
+    if (up.height < 1) up.height = 1;
+    up.format = record->format;
+    up.bytes = bytes;
+
+    if (bytes != texture_level_bytes(up.format, up.width, up.height)) {
+        pf_mutex_unlock(&g_textures.lock);
+        printf("Texture %u level %d: expected %lld bytes, got %lld\n", texture, level,
+               (long long)texture_level_bytes(up.format, up.width, up.height), (long long)bytes);
+        return 0;
+    }
+
+    up.owned = copy != 0;
+    up.data = data;
+    if (up.owned) {
+        void* owned = malloc((size_t)bytes);
+        if (!owned) {
+            pf_mutex_unlock(&g_textures.lock);
+            return 0;
+        }
+        memcpy(owned, data, (size_t)bytes);
+        up.data = owned;
+    }
+
+    if (g_textures.head + g_textures.count == g_textures.capacity) {
+        if (g_textures.head > 0) {
+            memmove(g_textures.queue, g_textures.queue + g_textures.head, g_textures.count * sizeof(TextureUpload));
+            g_textures.head = 0;
+        } else {
+            int capacity = g_textures.capacity ? g_textures.capacity * 2 : 64;
+            TextureUpload* queue = (TextureUpload*)realloc(g_textures.queue, capacity * sizeof(TextureUpload));
+            if (!queue) {
+                if (up.owned) free((void*)up.data);
+                pf_mutex_unlock(&g_textures.lock);
+                return 0;
+            }
+            g_textures.queue = queue;
+            g_textures.capacity = capacity;
+        }
+    }
+
+    g_textures.queue[g_textures.head + g_textures.count++] = up;
+    g_textures.stats.queued = g_textures.count;
+    g_textures.stats.queued_bytes += bytes;
+    record->pending++;
+    texture_start_thread_locked();
+    pf_mutex_unlock(&g_textures.lock);
+    return 1;
+}
+
+/* Uploads not yet visible to the main context; 0 means the texture is ready */
+int native_texture_pending(unsigned int texture) {
+    if (!g_textures.initialized) return 0;
+    pf_mutex_lock(&g_textures.lock);
+    TextureRecord* record = texture_find(texture);
+    int pending = record ? record->pending : 0;
+    pf_mutex_unlock(&g_textures.lock);
+    return pending;
+}
+
+void native_delete_texture(unsigned int texture) {
+    if (!g_textures.initialized || texture == 0) return;
+
+    pf_mutex_lock(&g_textures.lock);
+    TextureRecord* record = texture_find(texture);
+    if (record) {
+        /* Drop queued uploads, then wait out any the thread has already taken */
+        int kept = 0;
+        for (int i = 0; i < g_textures.count; i++) {
+            TextureUpload* up = &g_textures.queue[g_textures.head + i];
+            if (up->texture == texture) {
+                if (up->owned) free((void*)up->data);
+                g_textures.stats.queued_bytes -= up->bytes;
+                record->pending--;
+            } else {
+                g_textures.queue[g_textures.head + kept++] = *up;
+            }
+        }
+        g_textures.count = kept;
+        g_textures.stats.queued = kept;
+
+        while (record->pending > 0) {
+            pf_cond_wait(&g_textures.cond, &g_textures.lock);
+            record = texture_find(texture);
+        }
+        *record = g_textures.records[--g_textures.record_count];
+    }
+    pf_mutex_unlock(&g_textures.lock);
+
+    /* Frames already recorded may still draw with it */
+    if (render_deferred()) {
+        render_record_id(RENDER_CMD_DELETE_TEXTURE, texture);
+        return;
+    }
+    gl_state_delete_texture(texture);
+}
+
+void native_set_texture_upload_budget(int64_t bytes_per_frame) {
+    if (!g_textures.initialized) return;
+    pf_mutex_lock(&g_textures.lock);
+    g_textures.budget_bytes = bytes_per_frame > 0 ? bytes_per_frame : PF_TEXTURE_DEFAULT_BUDGET;
+    pf_mutex_unlock(&g_textures.lock);
+}
+
+/* Background uploads are on by default where a shared context exists; some
+ * old drivers are unreliable with shared contexts and can opt out */
+void native_set_texture_upload_thread(int enabled) {
+    if (!g_textures.initialized) return;
+    if (!enabled) {
+        texture_stop_thread();
+        pf_mutex_lock(&g_textures.lock);
+        g_textures.thread_enabled = false;
+        pf_mutex_unlock(&g_textures.lock);
+        return;
+    }
+
+    pf_mutex_lock(&g_textures.lock);
+    g_textures.thread_enabled = g_textures.shared_context != NULL;
+    if (g_textures.count > 0) texture_start_thread_locked();
+    pf_mutex_unlock(&g_textures.lock);
+}
+
+int native_get_texture_stats(TextureStats* stats) {
+    if (!stats) return 0;
+    if (!g_textures.initialized) {
+        memset(stats, 0, sizeof(*stats));
+        return 0;
+    }
+    pf_mutex_lock(&g_textures.lock);
+    *stats = g_textures.stats;
+    pf_mutex_unlock(&g_textures.lock);
+    return 1;
+}
+
+/* ============================================================================
+ * SPRITE BATCHING
+ * One call per frame from C#: sprites are sorted by layer/shader/texture and
+ * expanded into quads, so each run of equal state becomes a single draw call.
+ * ============================================================================ */
+
+/* Layout shared with SpriteInstance in bindings.cs - keep in sync */
+typedef struct {
+    float x, y;
+    float width, height;
+    float u0, v0, u1, v1;
+    float rotation;        /* radians, around the sprite centre */
+    unsigned int color;    /* packed RGBA8, red in the low byte */
+    unsigned int texture;  /* 0 = untextured (white) */
+    unsigned int shader;   /* 0 = built-in sprite shader */
+    int layer;             /* lower layers are drawn first */
+} SpriteInstance;
+
+typedef struct {
+    float x, y;
+    float u, v;
+    unsigned int color;
+} SpriteVertex;
+
+typedef struct {
+    int layer;
+    unsigned int shader;
+    unsigned int texture;
+    int index;
+} SpriteSortKey;
+
+/* 16-bit indices limit a single draw call to 16384 quads */
+#define PF_BATCH_MAX_QUADS 16384
+
+/* Three ring slots of 2 MB fit the largest single draw (16384 quads) */
+#define PF_BATCH_STREAM_SIZE (2 * 1024 * 1024)
+#define PF_BATCH_STREAM_RING 3
+
+typedef struct {
+    bool initialized;
+    int stream;
+    GLuint index_buffer;
+    GLuint default_shader;
+    GLuint white_texture;
+    SpriteSortKey* keys;
+    int capacity;
+    GLuint location_program;    /* program screen_size_location was looked up in */
+    GLint screen_size_location;
+} SpriteBatcher;
+
+static SpriteBatcher g_batcher = {0};
+
+static const char* g_sprite_vertex_src =
+    "#version 120\n"
+    "attribute vec2 a_position;\n"
+    "attribute vec2 a_texcoord;\n"
+    "attribute vec4 a_color;\n"
+    "uniform vec2 u_screen_size;\n"
+    "varying vec2 v_texcoord;\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "    vec2 ndc = a_position / u_screen_size * 2.0 - 1.0;\n"
+    "    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);\n"
+    "    v_texcoord = a_texcoord;\n"
+    "    v_color = a_color;\n"
+    "}\n";
+
+static const char* g_sprite_fragment_src =
+    "#version 120\n"
+    "uniform sampler2D u_texture;\n"
+    "varying vec2 v_texcoord;\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "    gl_FragColor = texture2D(u_texture, v_texcoord) * v_color;\n"
+    "}\n";
+
+static bool batcher_init() {
+    if (g_batcher.initialized) return true;
+
+    g_batcher.default_shader = native_create_shader(g_sprite_vertex_src, g_sprite_fragment_src);
+    if (!g_batcher.default_shader) {
+        printf("Failed to create default sprite shader\n");
+        return false;
+    }
+
+    /* Static index buffer shared by every batch: two triangles per quad */
+    unsigned short* indices = (unsigned short*)malloc(PF_BATCH_MAX_QUADS * 6 * sizeof(unsigned short));
+    if (!indices) return false;
+    for (int i = 0; i < PF_BATCH_MAX_QUADS; i++) {
+        unsigned short base = (unsigned short)(i * 4);
+        indices[i * 6 + 0] = base + 0;
+        indices[i * 6 + 1] = base + 1;
+        indices[i * 6 + 2] = base + 2;
+        indices[i * 6 + 3] = base + 2;
+        indices[i * 6 + 4] = base + 3;
+        indices[i * 6 + 5] = base + 0;
+    }
+
+    glGenBuffers(1, &g_batcher.index_buffer);
+    gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, g_batcher.index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, PF_BATCH_MAX_QUADS * 6 * sizeof(unsigned short), indices, GL_STATIC_DRAW);
+    free(indices);
+
+    g_batcher.stream = stream_buffer_create(PF_BATCH_STREAM_SIZE, PF_BATCH_STREAM_RING);
+    if (!g_batcher.stream) return false;
+
+    /* 1x1 white texture so untextured sprites can share the textured shader */
+    unsigned int white = 0xFFFFFFFFu;
+    glGenTextures(1, &g_batcher.white_texture);
+    gl_state_bind_texture(0, g_batcher.white_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+
+    g_batcher.location_program = 0;
+    g_batcher.screen_size_location = -1;
+    g_batcher.initialized = true;
+    return true;
+}
+
+static bool batcher_reserve(int count) {
+    if (count <= g_batcher.capacity) return true;
+
+    int capacity = g_batcher.capacity > 0 ? g_batcher.capacity : 1024;
+    while (capacity < count) capacity *= 2;
+
+    SpriteSortKey* keys = (SpriteSortKey*)realloc(g_batcher.keys, (size_t)capacity * sizeof(SpriteSortKey));
+    if (!keys) return false;
+    g_batcher.keys = keys;
+
+    g_batcher.capacity = capacity;
+    return true;
+}
+
+static int sprite_key_compare(const void* a, const void* b) {
+    const SpriteSortKey* ka = (const SpriteSortKey*)a;
+    const SpriteSortKey* kb = (const SpriteSortKey*)b;
+    if (ka->layer != kb->layer) return ka->layer < kb->layer ? -1 : 1;
+    if (ka->shader != kb->shader) return ka->shader < kb->shader ? -1 : 1;
+    if (ka->texture != kb->texture) return ka->texture < kb->texture ? -1 : 1;
+    /* Keep submission order inside a state group */
+    return ka->index - kb->index;
+}
+
+static void sprite_write_quad(SpriteVertex* v, const SpriteInstance* s) {
+    float x0 = s->x, y0 = s->y;
+    float x1 = s->x + s->width, y1 = s->y + s->height;
+
+    if (s->rotation == 0.0f) {
+        v[0].x = x0; v[0].y = y0;
+        v[1].x = x1; v[1].y = y0;
+        v[2].x = x1; v[2].y = y1;
+        v[3].x = x0; v[3].y = y1;
+    } else {
+        float cx = s->x + s->width * 0.5f;
+        float cy = s->y + s->height * 0.5f;
+        float hw = s->width * 0.5f, hh = s->height * 0.5f;
+        float c = cosf(s->rotation), sn = sinf(s->rotation);
+        float corners[4][2] = { {-hw, -hh}, {hw, -hh}, {hw, hh}, {-hw, hh} };
+        for (int i = 0; i < 4; i++) {
+            v[i].x = cx + corners[i][0] * c - corners[i][1] * sn;
+            v[i].y = cy + corners[i][0] * sn + corners[i][1] * c;
+        }
+    }
+
+    v[0].u = s->u0; v[0].v = s->v0;
+    v[1].u = s->u1; v[1].v = s->v0;
+    v[2].u = s->u1; v[2].v = s->v1;
+    v[3].u = s->u0; v[3].v = s->v1;
+    v[0].color = v[1].color = v[2].color = v[3].color = s->color;
+}
+
+static bool batcher_flush(const SpriteInstance* sprites, const SpriteSortKey* keys, int quad_count) {
+    GLuint program = keys[0].shader;
+    gl_state_use_program(program);
+    if (program != g_batcher.location_program) {
+        g_batcher.location_program = program;
+        g_batcher.screen_size_location = glGetUniformLocation(program, "u_screen_size");
+    }
+    if (g_batcher.screen_size_location >= 0) {
+        glUniform2f(g_batcher.screen_size_location, (float)g_window.width, (float)g_window.height);
+    }
+
+    gl_state_bind_texture(0, keys[0].texture);
+
+    /* Quads are expanded straight into the mapped ring slot - no intermediate copy */
+    StreamBuffer* sb = stream_buffer_get(g_batcher.stream);
+    int bytes = quad_count * 4 * (int)sizeof(SpriteVertex);
+    SpriteVertex* vertices = (SpriteVertex*)stream_buffer_map(sb, bytes);
+    if (!vertices) return false;
+
+    for (int i = 0; i < quad_count; i++) {
+        sprite_write_quad(&vertices[i * 4], &sprites[keys[i].index]);
+    }
+
+    int offset = stream_buffer_commit(sb, bytes);
+    if (offset < 0) return false;
+
+    const char* base = (const char*)(size_t)offset;
+    glVertexAttribPointer(PF_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), base + offsetof(SpriteVertex, x));
+    glVertexAttribPointer(PF_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), base + offsetof(SpriteVertex, u));
+    glVertexAttribPointer(PF_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), base + offsetof(SpriteVertex, color));
+
+    glDrawElements(GL_TRIANGLES, quad_count * 6, GL_UNSIGNED_SHORT, NULL);
+    return true;
+}
+
+static int batcher_submit(const SpriteInstance* sprites, int count) {
+    if (!batcher_init() || !batcher_reserve(count)) return -1;
+
+    /* Program names are recycled after deletion, so look the uniform up again */
+    g_batcher.location_program = 0;
+
+    /* Build sort keys; skip the sort entirely when input is already ordered */
+    bool sorted = true;
+    for (int i = 0; i < count; i++) {
+        SpriteSortKey* k = &g_batcher.keys[i];
+        k->layer = sprites[i].layer;
+        k->shader = sprites[i].shader ? sprites[i].shader : g_batcher.default_shader;
+        k->texture = sprites[i].texture ? sprites[i].texture : g_batcher.white_texture;
+        k->index = i;
+        if (sorted && i > 0 && sprite_key_compare(&g_batcher.keys[i - 1], k) > 0) {
+            sorted = false;
+        }
+    }
+    if (!sorted) {
+        qsort(g_batcher.keys, (size_t)count, sizeof(SpriteSortKey), sprite_key_compare);
+    }
+
+    /* The arrays stay enabled between batches; nothing else draws with attributes */
+    gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, g_batcher.index_buffer);
+    gl_state_vertex_array(PF_ATTRIB_POSITION, true);
+    gl_state_vertex_array(PF_ATTRIB_TEXCOORD, true);
+    gl_state_vertex_array(PF_ATTRIB_COLOR, true);
+
+    /* Emit one draw per run of equal shader/texture */
+    int draw_calls = 0;
+    int run_start = 0;
+    for (int i = 1; i <= count; i++) {
+        bool split = i == count
+            || g_batcher.keys[i].shader != g_batcher.keys[run_start].shader
+            || g_batcher.keys[i].texture != g_batcher.keys[run_start].texture
+            || i - run_start == PF_BATCH_MAX_QUADS;
+        if (split) {
+            if (!batcher_flush(sprites, &g_batcher.keys[run_start], i - run_start)) {
+                draw_calls = -1;
+                break;
+            }
+            draw_calls++;
+            run_start = i;
+        }
+    }
+
+    return draw_calls;
+}
+
+/*
+ * Draws `count` sprites. Returns the number of draw calls issued, or -1 on error.
+ * With the render thread the sprites are copied into the frame's commands and
+ * the result is that of the most recently executed batch.
+ */
+int native_submit_batch(const SpriteInstance* sprites, int count) {
+    if (!sprites || count <= 0) return 0;
+
+    if (render_deferred()) {
+        unsigned char* p = (unsigned char*)render_record(RENDER_CMD_SUBMIT_BATCH,
+            8 + (size_t)count * sizeof(SpriteInstance));
+        if (!p) return -1;
+        *(int*)p = count;
+        memcpy(p + 8, sprites, (size_t)count * sizeof(SpriteInstance));
+        return atomic_load_explicit(&g_render.last_draw_calls, memory_order_relaxed);
+    }
+
+    PF_PROFILE_BEGIN(s_marker_batch, "native_submit_batch");
+    present_sync();
+    native_gpu_marker_begin(s_marker_batch);
+    int draw_calls = batcher_submit(sprites, count);
+    native_gpu_marker_end(s_marker_batch);
+    PF_PROFILE_END(s_marker_batch);
+
+    return draw_calls;
+}
+
+/* RENDER_CMD_SUBMIT_BATCH payload: int count, 4 bytes padding, then the sprites */
+static void batcher_execute(const void* payload) {
+    const unsigned char* p = (const unsigned char*)payload;
+    int draw_calls = native_submit_batch((const SpriteInstance*)(p + 8), *(const int*)p);
+    atomic_store_explicit(&g_render.last_draw_calls, draw_calls, memory_order_relaxed);
+}
+
+static void batcher_shutdown() {
+    if (g_batcher.initialized) {
+        native_destroy_stream_buffer(g_batcher.stream);
+        gl_state_delete_buffers(1, &g_batcher.index_buffer);
+        gl_state_delete_texture(g_batcher.white_texture);
+        native_delete_shader(g_batcher.default_shader);
+    }
+    free(g_batcher.keys);
+    memset(&g_batcher, 0, sizeof(g_batcher));
+}
+
+/* ============================================================================
+ * JOB SYSTEM
+ * One worker per core; the thread that calls native_jobs_init is worker 0
+ * and only runs jobs while it waits. Each worker owns a Chase-Lev deque:
+ * the owner pushes and pops at the bottom, idle workers steal from the top.
+ * Threads that are not workers submit through a locked injection queue.
+ * A job submitted with a counter increments it and decrements it when done;
+ * a job submitted from inside a job without a counter joins its parent's,
+ * so waiting on a counter waits for the whole tree. Waiting never blocks
+ * while there is work: the waiter runs jobs itself. Jobs pinned to the main
+ * thread (for GL entry points without the render thread, or main-thread
+ * managed state) go to a queue only the main thread drains, in its waits
+ * and in native_jobs_run_main. Background jobs (file IO, long decodes) go to
+ * a queue only the other workers drain, so a main-thread wait never picks up
+ * a job that would stall the frame.
+ * ============================================================================ */
+
+#define PF_JOB_MAX_WORKERS 32
+#define PF_JOB_DEQUE_SIZE 4096      /* per worker, power of two */
+#define PF_JOB_POOL_SIZE 4096       /* job records per worker, power of two */
+#define PF_JOB_SPINS 64             /* failed searches before a worker sleeps */
+
+#define PF_JOB_PIN_MAIN 1
+#define PF_JOB_BACKGROUND 2
+
+typedef void (*pf_job_fn)(void* data, int index);
+
+typedef struct {
+    _Atomic int value;
+} JobCounter;
+
+typedef struct {
+    pf_job_fn fn;
+    void* data;
+    JobCounter* counter;
+    int index;
+    _Atomic int active;         /* pool slot in use; cleared by whoever ran it */
+} Job;
+
+typedef struct {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    _Atomic(Job*) jobs[PF_JOB_DEQUE_SIZE];
+} JobDeque;
+
+typedef struct {
+    JobDeque deque;
+    Job pool[PF_JOB_POOL_SIZE];
+    uint32_t pool_next;
+    uint32_t rng;
+    int index;
+    pf_thread thread;
+} JobWorker;
+
+/* Locked FIFO of jobs by value, for injection and main-thread pinning */
+typedef struct {
+    pf_mutex lock;
+    Job* jobs;
+    int head;
+    int count;
+    int capacity;
+    _Atomic int size;           /* count, readable without the lock */
+} JobQueue;
+
+/* Layout shared with JobStats in bindings.cs - keep in sync */
+typedef struct {
+    int workers;                /* including the main thread */
+    int reserved;
+    int64_t executed;
+    int64_t stolen;
+    int64_t inline_runs;        /* deque or pool full: ran in the submitter */
+    int64_t main_runs;          /* pinned jobs run by the main thread */
+} JobStats;
+
+typedef struct {
+    bool initialized;
+    int worker_count;
+    JobWorker* workers[PF_JOB_MAX_WORKERS];
+    JobQueue injected;
+    JobQueue main;
+    JobQueue background;
+
+    pf_mutex sleep_lock;
+    pf_cond sleep_cond;
+    _Atomic int queued;         /* jobs submitted and not yet taken */
+    _Atomic int sleeping;
+    _Atomic int quit;
+
+    _Atomic int64_t executed;
+    _Atomic int64_t stolen;
+    _Atomic int64_t inline_runs;
+    _Atomic int64_t main_runs;
+} JobSystem;
+
+static JobSystem g_jobs = {0};
+static PF_THREAD_LOCAL JobWorker* t_job_worker = NULL;
+static PF_THREAD_LOCAL JobCounter* t_job_counter = NULL;   /* counter of the running job */
+static PF_THREAD_LOCAL bool t_job_main = false;
+
+static int job_cpu_count() {
+    #ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (int)info.dwNumberOfProcessors;
+    #else
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (int)count : 1;
+    #endif
+}
+
+static void job_yield() {
+    #ifdef _WIN32
+        SwitchToThread();
+    #else
+        sched_yield();
+    #endif
+}
+
+/* ---- Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models") ---- */
+
+static bool deque_push(JobDeque* d, Job* job) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - t >= PF_JOB_DEQUE_SIZE) return false;
+
+    atomic_store_explicit(&d->jobs[b & (PF_JOB_DEQUE_SIZE - 1)], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+static Job* deque_pop(JobDeque* d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    Job* job = atomic_load_explicit(&d->jobs[b & (PF_JOB_DEQUE_SIZE - 1)], memory_order_relaxed);
+    if (t == b) {
+        /* Last job: race the stealers for it */
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                memory_order_seq_cst, memory_order_relaxed)) {
+            job = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+static Job* deque_steal(JobDeque* d) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+
+    Job* job = atomic_load_explicit(&d->jobs[t & (PF_JOB_DEQUE_SIZE - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return job;
+}
+
+/* ---- Locked queues ---- */
+
+static void job_queue_init(JobQueue* q) {
+    memset(q, 0, sizeof(*q));
+    pf_mutex_init(&q->lock);
+}
+
+static void job_queue_destroy(JobQueue* q) {
+    free(q->jobs);
+    pf_mutex_destroy(&q->lock);
+    memset(q, 0, sizeof(*q));
+}
+
+static bool job_queue_push(JobQueue* q, const Job* job) {
+    pf_mutex_lock(&q->lock);
+    if (q->head + q->count == q->capacity) {
+        if (q->head > 0) {
+            memmove(q->jobs, q->jobs + q->head, q->count * sizeof(Job));
+            q->head = 0;
+        } else {
+            int capacity = q->capacity ? q->capacity * 2 : 256;
+            Job* jobs = (Job*)realloc(q->jobs, capacity * sizeof(Job));
+            if (!jobs) {
+                pf_mutex_unlock(&q->lock);
+                return false;
+            }
+            q->jobs = jobs;
+            q->capacity = capacity;
+        }
+    }
+    q->jobs[q->head + q->count++] = *job;
+    atomic_store_explicit(&q->size, q->count, memory_order_release);
+    pf_mutex_unlock(&q->lock);
+    return true;
+}
+
+static bool job_queue_pop(JobQueue* q, Job* out) {
+    if (atomic_load_explicit(&q->size, memory_order_acquire) == 0) return false;
+
+    pf_mutex_lock(&q->lock);
+    bool found = q->count > 0;
+    if (found) {
+        *out = q->jobs[q->head++];
+        if (--q->count == 0) q->head = 0;
+        atomic_store_explicit(&q->size, q->count, memory_order_release);
+    }
+    pf_mutex_unlock(&q->lock);
+    return found;
+}
+
+/* ---- Execution ---- */
+
+static void job_run(pf_job_fn fn, void* data, int index, JobCounter* counter) {
+    JobCounter* parent = t_job_counter;
+    t_job_counter = counter;
+    fn(data, index);
+    t_job_counter = parent;
+
+    atomic_fetch_add_explicit(&g_jobs.executed, 1, memory_order_relaxed);
+    if (counter) atomic_fetch_sub_explicit(&counter->value, 1, memory_order_acq_rel);
+}
+
+static void job_run_record(Job* job) {
+    pf_job_fn fn = job->fn;
+    void* data = job->data;
+    int index = job->index;
+    JobCounter* counter = job->counter;
+    /* The owner may reuse the slot as soon as it is released */
+    atomic_store_explicit(&job->active, 0, memory_order_release);
+    job_run(fn, data, index, counter);
+}
+
+static void job_wake() {
+    if (atomic_load(&g_jobs.sleeping) == 0) return;
+    pf_mutex_lock(&g_jobs.sleep_lock);
+    pf_cond_broadcast(&g_jobs.sleep_cond);
+    pf_mutex_unlock(&g_jobs.sleep_lock);
+}
+
+/* Finds and runs one job: own deque, injected jobs, background jobs (off the
+ * main thread), then a steal from a random victim */
+static bool job_run_one() {
+    JobWorker* self = t_job_worker;
+
+    if (t_job_main) {
+        Job pinned;
+        if (job_queue_pop(&g_jobs.main, &pinned)) {
+            atomic_fetch_add_explicit(&g_jobs.main_runs, 1, memory_order_relaxed);
+            job_run(pinned.fn, pinned.data, pinned.index, pinned.counter);
+            return true;
+        }
+    }
+
+    if (self) {
+        Job* job = deque_pop(&self->deque);
+        if (job) {
+            atomic_fetch_sub(&g_jobs.queued, 1);
+            job_run_record(job);
+            return true;
+        }
+    }
+
+    Job injected;
+    if (job_queue_pop(&g_jobs.injected, &injected)) {
+        atomic_fetch_sub(&g_jobs.queued, 1);
+        job_run(injected.fn, injected.data, injected.index, injected.counter);
+        return true;
+    }
+
+    Job background;
+    if (!t_job_main && job_queue_pop(&g_jobs.background, &background)) {
+        atomic_fetch_sub(&g_jobs.queued, 1);
+        job_run(background.fn, background.data, background.index, background.counter);
+        return true;
+    }
+
+    int count = g_jobs.worker_count;
+    uint32_t start = 0;
+    if (self) {
+        /* xorshift; only needs to spread the victims */
+        self->rng ^= self->rng << 13;
+        self->rng ^= self->rng >> 17;
+        self->rng ^= self->rng << 5;
+        start = self->rng;
+    }
+    for (int i = 0; i < count; i++) {
+        JobWorker* victim = g_jobs.workers[(start + (uint32_t)i) % (uint32_t)count];
+        if (victim == self) continue;
+        Job* job = deque_steal(&victim->deque);
+        if (job) {
+            atomic_fetch_sub(&g_jobs.queued, 1);
+            atomic_fetch_add_explicit(&g_jobs.stolen, 1, memory_order_relaxed);
+            job_run_record(job);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void job_worker_main(void* arg) {
+    JobWorker* self = (JobWorker*)arg;
+    t_job_worker = self;
+
+    for (;;) {
+        int idle = 0;
+        while (job_run_one()) {}
+
+        while (idle < PF_JOB_SPINS && atomic_load(&g_jobs.queued) == 0 && !atomic_load(&g_jobs.quit)) {
+            cpu_relax();
+            idle++;
+        }
+        if (atomic_load(&g_jobs.queued) > 0) continue;
+
+        pf_mutex_lock(&g_jobs.sleep_lock);
+        atomic_fetch_add(&g_jobs.sleeping, 1);
+        while (atomic_load(&g_jobs.queued) == 0 && !atomic_load(&g_jobs.quit)) {
+            pf_cond_wait(&g_jobs.sleep_cond, &g_jobs.sleep_lock);
+        }
+        atomic_fetch_sub(&g_jobs.sleeping, 1);
+        bool quit = atomic_load(&g_jobs.quit) && atomic_load(&g_jobs.queued) == 0;
+        pf_mutex_unlock(&g_jobs.sleep_lock);
+        if (quit) break;
+    }
+    t_job_worker = NULL;
+}
+
+/* ---- Public API ---- */
+
+/* Starts the workers; worker_count <= 0 means one per core. Returns the total including the caller */
+int native_jobs_init(int worker_count) {
+    if (g_jobs.initialized) return g_jobs.worker_count;
+
+    if (worker_count <= 0) worker_count = job_cpu_count();
+    /* Even on one core a worker thread is needed, or jobs nobody waits on never run */
+    if (worker_count < 2) worker_count = 2;
+    if (worker_count > PF_JOB_MAX_WORKERS) worker_count = PF_JOB_MAX_WORKERS;
+
+    job_queue_init(&g_jobs.injected);
+    job_queue_init(&g_jobs.main);
+    job_queue_init(&g_jobs.background);
+    pf_mutex_init(&g_jobs.sleep_lock);
+    pf_cond_init(&g_jobs.sleep_cond);
+    atomic_store(&g_jobs.quit, 0);
+
+    int created = 0;
+    for (int i = 0; i < worker_count; i++) {
+        JobWorker* worker = (JobWorker*)calloc(1, sizeof(JobWorker));
+        if (!worker) break;
+        worker->index = i;
+        worker->rng = 0x9E3779B9u * (uint32_t)(i + 1);
+        g_jobs.workers[created++] = worker;
+    }
+    if (created == 0) {
+        job_queue_destroy(&g_jobs.injected);
+        job_queue_destroy(&g_jobs.main);
+        job_queue_destroy(&g_jobs.background);
+        return 0;
+    }
+    g_jobs.worker_count = created;
+
+    /* The caller is worker 0; it runs jobs only while it waits */
+    t_job_worker = g_jobs.workers[0];
+    t_job_main = true;
+    g_jobs.initialized = true;
+
+    for (int i = 1; i < g_jobs.worker_count; i++) {
+        if (!pf_thread_start(&g_jobs.workers[i]->thread, job_worker_main, g_jobs.workers[i])) {
+            printf("Job worker %d failed to start\n", i);
+            free(g_jobs.workers[i]);
+            g_jobs.worker_count = i;
+            break;
+        }
+    }
+    return g_jobs.worker_count;
+}
+
+/* Runs every outstanding job, then stops the workers. Call from the main thread */
+void native_jobs_shutdown() {
+    if (!g_jobs.initialized) return;
+
+    while (atomic_load(&g_jobs.queued) > 0 || atomic_load(&g_jobs.main.size) > 0) {
+        if (!job_run_one()) job_yield();
+    }
+
+    atomic_store(&g_jobs.quit, 1);
+    pf_mutex_lock(&g_jobs.sleep_lock);
+    pf_cond_broadcast(&g_jobs.sleep_cond);
+    pf_mutex_unlock(&g_jobs.sleep_lock);
+
+    for (int i = 1; i < g_jobs.worker_count; i++) {
+        pf_thread_join(g_jobs.workers[i]->thread);
+    }
+    for (int i = 0; i < g_jobs.worker_count; i++) {
+        free(g_jobs.workers[i]);
+    }
+
+    job_queue_destroy(&g_jobs.injected);
+    job_queue_destroy(&g_jobs.main);
+    job_queue_destroy(&g_jobs.background);
+    pf_cond_destroy(&g_jobs.sleep_cond);
+    pf_mutex_destroy(&g_jobs.sleep_lock);
+    memset(&g_jobs, 0, sizeof(g_jobs));
+    t_job_worker = NULL;
+    t_job_main = false;
+}
+
+JobCounter* native_job_counter_create() {
+    return (JobCounter*)calloc(1, sizeof(JobCounter));
+}
+
+void native_job_counter_destroy(JobCounter* counter) {
+    free(counter);
+}
+
+int native_job_counter_value(JobCounter* counter) {
+    return counter ? atomic_load_explicit(&counter->value, memory_order_acquire) : 0;
+}
+
+/*
+ * Queues fn(data, index). counter may be NULL; inside a job, NULL means the
+ * running job's counter. Without workers (or when the pool is exhausted)
+ * the job runs before this returns. Returns 1 if queued, 0 if run inline.
+ */
+int native_job_submit(pf_job_fn fn, void* data, int index, JobCounter* counter, int flags) {
+    if (!fn) return 0;
+    if (!counter) counter = t_job_counter;
+    if (counter) atomic_fetch_add_explicit(&counter->value, 1, memory_order_relaxed);
+
+    if (!g_jobs.initialized) {
+        job_run(fn, data, index, counter);
+        return 0;
+    }
+
+    if (flags & PF_JOB_PIN_MAIN) {
+        Job pinned = { fn, data, counter, index, 0 };
+        if (t_job_main || !job_queue_push(&g_jobs.main, &pinned)) {
+            /* Already on the main thread: no need to defer */
+            atomic_fetch_add_explicit(&g_jobs.main_runs, 1, memory_order_relaxed);
+            job_run(fn, data, index, counter);
+            return 0;
+        }
+        return 1;
+    }
+
+    /* Background jobs need a worker besides the main thread to ever run */
+    if ((flags & PF_JOB_BACKGROUND) && g_jobs.worker_count > 1) {
+        Job background = { fn, data, counter, index, 0 };
+        atomic_fetch_add(&g_jobs.queued, 1);
+        if (job_queue_push(&g_jobs.background, &background)) {
+            job_wake();
+            return 1;
+        }
+        atomic_fetch_sub(&g_jobs.queued, 1);
+    }
+
+    JobWorker* self = t_job_worker;
+    if (self) {
+        Job* job = &self->pool[self->pool_next & (PF_JOB_POOL_SIZE - 1)];
+        if (!atomic_load_explicit(&job->active, memory_order_acquire)) {
+            self->pool_next++;
+            job->fn = fn;
+            job->data = data;
+            job->index = index;
+            job->counter = counter;
+            atomic_store_explicit(&job->active, 1, memory_order_relaxed);
+            atomic_fetch_add(&g_jobs.queued, 1);
+            if (deque_push(&self->deque, job)) {
+                job_wake();
+                return 1;
+            }
+            atomic_fetch_sub(&g_jobs.queued, 1);
+            atomic_store_explicit(&job->active, 0, memory_order_relaxed);
+        }
+    } else {
+        Job injected = { fn, data, counter, index, 0 };
+        atomic_fetch_add(&g_jobs.queued, 1);
+        if (job_queue_push(&g_jobs.injected, &injected)) {
+            job_wake();
+            return 1;
+        }
+        atomic_fetch_sub(&g_jobs.queued, 1);
+    }
+
+    atomic_fetch_add_explicit(&g_jobs.inline_runs, 1, memory_order_relaxed);
+    job_run(fn, data, index, counter);
+    return 0;
+}
+
+/* Queues fn(data, i) for i in [0, count): the usual fan-out for parallel loops */
+void native_job_submit_range(pf_job_fn fn, void* data, int count, JobCounter* counter) {
+    for (int i = 0; i < count; i++) {
+        native_job_submit(fn, data, i, counter, 0);
+    }
+}
+
+/* Returns once the counter reaches zero, running other jobs meanwhile */
+void native_job_wait(JobCounter* counter) {
+    if (!counter) return;
+
+    int idle = 0;
+    while (atomic_load_explicit(&counter->value, memory_order_acquire) > 0) {
+        if (job_run_one()) {
+            idle = 0;
+        } else if (++idle < PF_JOB_SPINS) {
+            cpu_relax();
+        } else {
+            /* The remaining jobs are running elsewhere */
+            job_yield();
+        }
+    }
+}
+
+/* Main thread: runs pinned jobs for up to max_ms (0 = until the queue is empty). Returns the count run */
+int native_jobs_run_main(double max_ms) {
+    if (!g_jobs.initialized || !t_job_main) return 0;
+
+    int64_t deadline = max_ms > 0.0 ? native_get_ticks() + (int64_t)(max_ms * 1000000.0) : 0;
+    int ran = 0;
+    Job pinned;
+    while (job_queue_pop(&g_jobs.main, &pinned)) {
+        atomic_fetch_add_explicit(&g_jobs.main_runs, 1, memory_order_relaxed);
+        job_run(pinned.fn, pinned.data, pinned.index, pinned.counter);
+        ran++;
+        if (deadline && native_get_ticks() >= deadline) break;
+    }
+    return ran;
+}
+
+/* Runs one queued job on the calling thread if there is one, for threads that wait on something else */
+int native_jobs_try_run() {
+    return g_jobs.initialized && job_run_one() ? 1 : 0;
+}
+
+int native_jobs_worker_count() {
+    return g_jobs.initialized ? g_jobs.worker_count : 0;
+}
+
+/* Worker index of the calling thread (0 = main), or -1 for other threads */
+int native_jobs_current_worker() {
+    return t_job_worker ? t_job_worker->index : -1;
+}
+
+int native_jobs_get_stats(JobStats* stats) {
+    if (!stats) return 0;
+    memset(stats, 0, sizeof(*stats));
+    if (!g_jobs.initialized) return 0;
+    stats->workers = g_jobs.worker_count;
+    stats->executed = atomic_load(&g_jobs.executed);
+    stats->stolen = atomic_load(&g_jobs.stolen);
+    stats->inline_runs = atomic_load(&g_jobs.inline_runs);
+    stats->main_runs = atomic_load(&g_jobs.main_runs);
+    return 1;
+}
+
+/* ============================================================================
+ * SLAB ALLOCATOR
+ * Fixed-size block pools carved out of contiguous OS pages, off the managed
+ * heap. Free blocks form an intrusive singly linked list, so alloc and free
+ * are O(1) pointer swaps. Blocks are 16-byte aligned and not zeroed.
+ * Pools are not thread-safe; callers serialize access per pool.
+ * ============================================================================ */
+
+#define PF_MAX_POOLS 32
+#define PF_SLAB_PAGE_SIZE (64 * 1024)
+#define PF_SLAB_MIN_BLOCKS_PER_PAGE 8
+
+/* Page records live outside the pages so blocks tile them exactly */
+typedef struct SlabPage {
+    struct SlabPage* next;
+    void* base;
+    size_t size;
+} SlabPage;
+
+typedef struct SlabFreeBlock {
+    struct SlabFreeBlock* next;
+} SlabFreeBlock;
+
+/* Layout shared with PoolStats in bindings.cs - keep in sync */
+typedef struct {
+    int block_size;
+    int allocated_blocks;
+    int free_blocks;
+    int pages;
+    int64_t reserved_bytes;
+} PoolStats;
+
+typedef struct {
+    bool in_use;
+    size_t block_size;
+    size_t page_size;
+    SlabPage* pages;
+    SlabFreeBlock* free_list;
+    PoolStats stats;
+} SlabPool;
+
+static SlabPool g_pools[PF_MAX_POOLS] = {0};
+
+/* Raw page memory straight from the OS; fresh pages are zero-filled */
+static void* os_reserve_pages(size_t size) {
+    #ifdef _WIN32
+        return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    #else
+        void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr == MAP_FAILED ? NULL : ptr;
+    #endif
+}
+
+static void os_release_pages(void* ptr, size_t size) {
+    #ifdef _WIN32
+        (void)size;
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    #else
+        munmap(ptr, size);
+    #endif
+}
+
+static SlabPool* slab_pool_get(int handle) {
+    if (handle <= 0 || handle > PF_MAX_POOLS) return NULL;
+    SlabPool* pool = &g_pools[handle - 1];
+    return pool->in_use ? pool : NULL;
+}
+
+static bool slab_pool_grow(SlabPool* pool) {
+    SlabPage* page = (SlabPage*)malloc(sizeof(SlabPage));
+    if (!page) return false;
+
+    page->base = os_reserve_pages(pool->page_size);
+    if (!page->base) {
+        free(page);
+        return false;
+    }
+    page->next = pool->pages;
+    page->size = pool->page_size;
+    pool->pages = page;
+
+    /* Thread the new blocks onto the free list in address order */
+    unsigned char* first = (unsigned char*)page->base;
+    int count = (int)(pool->page_size / pool->block_size);
+
+    for (int i = count - 1; i >= 0; i--) {
+        SlabFreeBlock* block = (SlabFreeBlock*)(first + (size_t)i * pool->block_size);
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+
+    pool->stats.free_blocks += count;
+    pool->stats.pages++;
+    pool->stats.reserved_bytes += (int64_t)pool->page_size;
+    return true;
+}
+
+int native_pool_create(int block_size, int initial_blocks) {
+    if (block_size <= 0) return 0;
+
+    int handle = 0;
+    for (int i = 0; i < PF_MAX_POOLS; i++) {
+        if (!g_pools[i].in_use) {
+            handle = i + 1;
+            break;
+        }
+    }
+    if (!handle) {
+        printf("Out of memory pool slots\n");
+        return 0;
+    }
+
+    SlabPool* pool = &g_pools[handle - 1];
+    memset(pool, 0, sizeof(*pool));
+    pool->block_size = ((size_t)block_size + 15) & ~(size_t)15;
+    if (pool->block_size < sizeof(SlabFreeBlock)) pool->block_size = sizeof(SlabFreeBlock);
+
+    /* Large blocks get bigger pages so a page always holds a useful number */
+    size_t page_size = PF_SLAB_PAGE_SIZE;
+    while (page_size / pool->block_size < PF_SLAB_MIN_BLOCKS_PER_PAGE) {
+        page_size *= 2;
+    }
+    pool->page_size = page_size;
+    pool->stats.block_size = (int)pool->block_size;
+    pool->in_use = true;
+
+    while (pool->stats.free_blocks < initial_blocks) {
+        if (!slab_pool_grow(pool)) break;
+    }
+    return handle;
+}
+
+void* native_pool_alloc(int handle) {
+    SlabPool* pool = slab_pool_get(handle);
+    if (!pool) return NULL;
+
+    if (!pool->free_list && !slab_pool_grow(pool)) return NULL;
+
+    SlabFreeBlock* block = pool->free_list;
+    pool->free_list = block->next;
+    pool->stats.free_blocks--;
+    pool->stats.allocated_blocks++;
+    return block;
+}
+
+void native_pool_free(int handle, void* ptr) {
+    SlabPool* pool = slab_pool_get(handle);
+    if (!pool || !ptr) return;
+
+    SlabFreeBlock* block = (SlabFreeBlock*)ptr;
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->stats.free_blocks++;
+    pool->stats.allocated_blocks--;
+}
+
+void native_pool_get_stats(int handle, PoolStats* stats) {
+    SlabPool* pool = slab_pool_get(handle);
+    if (pool) {
+        *stats = pool->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+void native_pool_destroy(int handle) {
+    SlabPool* pool = slab_pool_get(handle);
+    if (!pool) return;
+
+    SlabPage* page = pool->pages;
+    while (page) {
+        SlabPage* next = page->next;
+        os_release_pages(page->base, page->size);
+        free(page);
+        page = next;
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+/* ----------------------------------------------------------------------------
+ * Large blocks: power-of-two classes from 32 KB, recycled through per-class
+ * intrusive free lists. Up to PF_LARGE_CACHE_LIMIT bytes of freed blocks are
+ * kept for reuse; beyond that memory goes back to the OS.
+ * ---------------------------------------------------------------------------- */
+
+#define PF_LARGE_MIN_SHIFT 15
+#define PF_LARGE_MAX_SHIFT 30
+#define PF_LARGE_CLASSES (PF_LARGE_MAX_SHIFT - PF_LARGE_MIN_SHIFT + 1)
+#define PF_LARGE_CACHE_LIMIT (32ll * 1024 * 1024)
+
+typedef struct {
+    SlabFreeBlock* free_lists[PF_LARGE_CLASSES];
+    int64_t cached_bytes;
+    int64_t live_bytes;
+    pf_lazy_mutex lock;
+} LargeAllocator;
+
+static LargeAllocator g_large = {0};
+
+static int large_class(int64_t size) {
+    int shift = PF_LARGE_MIN_SHIFT;
+    while (shift <= PF_LARGE_MAX_SHIFT && ((int64_t)1 << shift) < size) shift++;
+    return shift <= PF_LARGE_MAX_SHIFT ? shift - PF_LARGE_MIN_SHIFT : -1;
+}
+
+/* Returns the class size a request rounds up to, or 0 if too large */
+int64_t native_large_block_size(int64_t size) {
+    int c = large_class(size);
+    return c >= 0 ? (int64_t)1 << (c + PF_LARGE_MIN_SHIFT) : 0;
+}
+
+/* Thread-safe; large allocations are rare enough for a lock */
+void* native_large_alloc(int64_t size) {
+    int c = large_class(size);
+    if (c < 0) return NULL;
+
+    size_t block_size = (size_t)1 << (c + PF_LARGE_MIN_SHIFT);
+    void* ptr = NULL;
+
+    pf_lazy_mutex_lock(&g_large.lock);
+    if (g_large.free_lists[c]) {
+        SlabFreeBlock* block = g_large.free_lists[c];
+        g_large.free_lists[c] = block->next;
+        g_large.cached_bytes -= (int64_t)block_size;
+        ptr = block;
+    }
+    if (ptr) g_large.live_bytes += (int64_t)block_size;
+    pf_lazy_mutex_unlock(&g_large.lock);
+
+    if (!ptr) {
+        ptr = os_reserve_pages(block_size);
+        if (ptr) {
+            pf_lazy_mutex_lock(&g_large.lock);
+            g_large.live_bytes += (int64_t)block_size;
+            pf_lazy_mutex_unlock(&g_large.lock);
+        }
+    }
+    return ptr;
+}
+
+void native_large_free(void* ptr, int64_t size) {
+    int c = large_class(size);
+    if (!ptr || c < 0 || !pf_lazy_mutex_ready(&g_large.lock)) return;
+
+    size_t block_size = (size_t)1 << (c + PF_LARGE_MIN_SHIFT);
+    bool cached = false;
+
+    pf_lazy_mutex_lock(&g_large.lock);
+    g_large.live_bytes -= (int64_t)block_size;
+    if (g_large.cached_bytes + (int64_t)block_size <= PF_LARGE_CACHE_LIMIT) {
+        SlabFreeBlock* block = (SlabFreeBlock*)ptr;
+        block->next = g_large.free_lists[c];
+        g_large.free_lists[c] = block;
+        g_large.cached_bytes += (int64_t)block_size;
+        cached = true;
+    }
+    pf_lazy_mutex_unlock(&g_large.lock);
+
+    if (!cached) os_release_pages(ptr, block_size);
+}
+
+void native_large_get_stats(int64_t* live_bytes, int64_t* cached_bytes) {
+    *live_bytes = 0;
+    *cached_bytes = 0;
+    if (!pf_lazy_mutex_ready(&g_large.lock)) return;
+
+    pf_lazy_mutex_lock(&g_large.lock);
+    *live_bytes = g_large.live_bytes;
+    *cached_bytes = g_large.cached_bytes;
+    pf_lazy_mutex_unlock(&g_large.lock);
+}
+
+/* Returns every cached large block to the OS */
+void native_large_trim() {
+    if (!pf_lazy_mutex_ready(&g_large.lock)) return;
+
+    pf_lazy_mutex_lock(&g_large.lock);
+    for (int c = 0; c < PF_LARGE_CLASSES; c++) {
+        SlabFreeBlock* block = g_large.free_lists[c];
+        while (block) {
+            SlabFreeBlock* next = block->next;
+            os_release_pages(block, (size_t)1 << (c + PF_LARGE_MIN_SHIFT));
+            block = next;
+        }
+        g_large.free_lists[c] = NULL;
+    }
+    g_large.cached_bytes = 0;
+    pf_lazy_mutex_unlock(&g_large.lock);
+}
+
+/* ============================================================================
+ * ASSET ARCHIVES
+ * Read-only packs written by `build.py pack`, mapped whole into the address
+ * space. Layout: header, index sorted by path hash, then entry data with each
+ * entry starting on a 4 KB boundary. Lookups binary-search the index and
+ * return pointers straight into the mapping, so nothing is copied; pages
+ * come in on first touch. Paths are hashed with FNV-1a 64 after turning '\\'
+ * into '/' and dropping any leading "./".
+ *
+ * Compressed entries (PF_COMPRESSION_LZ4_CHUNKED) are split into chunks of up
+ * to chunk_size raw bytes, each an independent LZ4 block, so callers can
+ * decode chunks on separate threads:
+ *   uint32 chunk_count, uint32 chunk_size, uint32 stored_size[chunk_count],
+ *   then the chunk payloads back to back. A stored_size with the top bit set
+ *   marks a chunk kept uncompressed because LZ4 didn't shrink it.
+ * ============================================================================ */
+
+#define PF_ARCHIVE_MAGIC 0x4B504650u /* "PFPK" */
+#define PF_ARCHIVE_VERSION 1u
+#define PF_ARCHIVE_ALIGN 4096
+#define PF_MAX_ARCHIVES 16
+
+#define PF_COMPRESSION_NONE 0
+#define PF_COMPRESSION_LZ4_CHUNKED 1
+#define PF_CHUNK_STORED 0x80000000u
+
+/* On-disk layout, little endian - keep in sync with tools/build/build.py */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+    uint64_t index_offset;
+    uint64_t file_size;
+} ArchiveHeader;
+
+typedef struct {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;          /* bytes stored in the archive */
+    uint64_t raw_size;      /* bytes after decompression */
+    uint32_t compression;   /* 0 = stored */
+    uint32_t reserved;
+} ArchiveEntry;
+
+/* LZ4 block format decoder. Bounds-checked against both buffers, since the
+ * input comes from disk. Returns bytes written, or -1 on malformed input. */
+int native_lz4_decompress(const void* src, int src_size, void* dst, int dst_capacity) {
+    const unsigned char* ip = (const unsigned char*)src;
+    const unsigned char* const ip_end = ip + src_size;
+    unsigned char* op = (unsigned char*)dst;
+    unsigned char* const op_start = op;
+    unsigned char* const op_end = op + dst_capacity;
+
+    if (src_size <= 0) return -1;
+
+    for (;;) {
+        if (ip >= ip_end) return -1;
+        unsigned token = *ip++;
+
+        /* Literals */
+        size_t length = token >> 4;
+        if (length == 15) {
+            unsigned b;
+            do {
+                if (ip >= ip_end) return -1;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+        }
+        if (length > (size_t)(ip_end - ip) || length > (size_t)(op_end - op)) return -1;
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+
+        /* The last sequence is literals only */
+        if (ip == ip_end) break;
+
+        /* Match */
+        if (ip_end - ip < 2) return -1;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - op_start)) return -1;
+
+        length = (token & 15) + 4;
+        if ((token & 15) == 15) {
+            unsigned b;
+            do {
+                if (ip >= ip_end) return -1;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+        }
+        if (length > (size_t)(op_end - op)) return -1;
+
+        const unsigned char* match = op - offset;
+        if (offset >= 8 && (size_t)(op_end - op) >= length + 8) {
+            /* Non-overlapping enough for word copies; may write up to 7 bytes past the
+             * match, which the next sequence overwrites */
+            unsigned char* end = op + length;
+            while (op < end) {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            }
+            op = end;
+        } else {
+            /* Overlapping match (run-length style): byte at a time */
+            for (size_t i = 0; i < length; i++) op[i] = match[i];
+            op += length;
+        }
+    }
+
+    return (int)(op - op_start);
+}
+
+/* Layout shared with ArchiveEntryInfo in bindings.cs - keep in sync */
+typedef struct {
+    const void* data;
+    int64_t size;
+    int64_t raw_size;
+    int compression;
+    int index;
+} ArchiveEntryInfo;
+
+typedef struct {
+    bool in_use;
+    const unsigned char* base;
+    size_t size;
+    const ArchiveEntry* entries;
+    uint32_t count;
+    #ifdef _WIN32
+        HANDLE file;
+        HANDLE mapping;
+    #endif
+} MappedArchive;
+
+static MappedArchive g_archives[PF_MAX_ARCHIVES] = {0};
+/* Slots are claimed atomically so archives can be opened from several workers at once */
+static atomic_bool g_archive_claimed[PF_MAX_ARCHIVES];
+
+static uint64_t archive_hash_path(const char* path, size_t length) {
+    while (length >= 2 && path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+        length -= 2;
+    }
+
+    uint64_t hash = PF_FNV_OFFSET;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char b = (unsigned char)(path[i] == '\\' ? '/' : path[i]);
+        hash = hash_fnv1a64(hash, &b, 1);
+    }
+    return hash;
+}
+
+static MappedArchive* archive_get(int handle) {
+    if (handle <= 0 || handle > PF_MAX_ARCHIVES) return NULL;
+    MappedArchive* archive = &g_archives[handle - 1];
+    return archive->in_use ? archive : NULL;
+}
+
+static void archive_unmap(MappedArchive* archive) {
+    #ifdef _WIN32
+        if (archive->base) UnmapViewOfFile(archive->base);
+        if (archive->mapping) CloseHandle(archive->mapping);
+        if (archive->file && archive->file != INVALID_HANDLE_VALUE) CloseHandle(archive->file);
+    #else
+        if (archive->base) munmap((void*)archive->base, archive->size);
+    #endif
+    memset(archive, 0, sizeof(*archive));
+}
+
+static bool archive_map(MappedArchive* archive, const char* path) {
+    #ifdef _WIN32
+        wchar_t* wide_path = utf8_to_wide(path);
+        if (!wide_path) return false;
+        archive->file = CreateFileW(wide_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                    FILE_FLAG_RANDOM_ACCESS, NULL);
+        free(wide_path);
+        if (archive->file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(archive->file, &size) || size.QuadPart == 0) return false;
+        archive->size = (size_t)size.QuadPart;
+
+        archive->mapping = CreateFileMappingA(archive->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!archive->mapping) return false;
+        archive->base = (const unsigned char*)MapViewOfFile(archive->mapping, FILE_MAP_READ, 0, 0, 0);
+        return archive->base != NULL;
+    #else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        archive->size = (size_t)st.st_size;
+
+        /* The mapping keeps the file referenced; the descriptor isn't needed */
+        void* base = mmap(NULL, archive->size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) return false;
+        archive->base = (const unsigned char*)base;
+        return true;
+    #endif
+}
+
+static bool archive_validate(MappedArchive* archive) {
+    if (archive->size < sizeof(ArchiveHeader)) return false;
+
+    const ArchiveHeader* header = (const ArchiveHeader*)archive->base;
+    if (header->magic != PF_ARCHIVE_MAGIC || header->version != PF_ARCHIVE_VERSION) return false;
+    if (header->file_size != archive->size) return false;   /* truncated or appended to */
+
+    uint64_t index_bytes = (uint64_t)header->entry_count * sizeof(ArchiveEntry);
+    if (header->index_offset > archive->size || index_bytes > archive->size - header->index_offset) return false;
+    if (header->index_offset % 8 != 0) return false;
+
+    const ArchiveEntry* entries = (const ArchiveEntry*)(archive->base + header->index_offset);
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        if (entries[i].offset > archive->size || entries[i].size > archive->size - entries[i].offset) return false;
+        if (i > 0 && entries[i].hash <= entries[i - 1].hash) return false;
+    }
+
+    archive->entries = entries;
+    archive->count = header->entry_count;
+    return true;
+}
+
+static void archive_fill_info(const MappedArchive* archive, int index, ArchiveEntryInfo* info) {
+    const ArchiveEntry* e = &archive->entries[index];
+    info->data = archive->base + e->offset;
+    info->size = (int64_t)e->size;
+    info->raw_size = (int64_t)e->raw_size;
+    info->compression = (int)e->compression;
+    info->index = index;
+}
+
+/* Returns a handle > 0, or 0 if the file is missing or not a valid archive */
+int native_archive_open(const char* path) {
+    int slot = -1;
+    for (int i = 0; i < PF_MAX_ARCHIVES; i++) {
+        if (!atomic_exchange(&g_archive_claimed[i], true)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        printf("Too many archives open (max %d)\n", PF_MAX_ARCHIVES);
+        return 0;
+    }
+
+    MappedArchive* archive = &g_archives[slot];
+    memset(archive, 0, sizeof(*archive));
+    if (!archive_map(archive, path)) {
+        archive_unmap(archive);
+        atomic_store(&g_archive_claimed[slot], false);
+        return 0;
+    }
+    if (!archive_validate(archive)) {
+        printf("Invalid archive: %s\n", path);
+        archive_unmap(archive);
+        atomic_store(&g_archive_claimed[slot], false);
+        return 0;
+    }
+
+    archive->in_use = true;
+    return slot + 1;
+}
+
+void native_archive_close(int handle) {
+    MappedArchive* archive = archive_get(handle);
+    if (!archive) return;
+    archive_unmap(archive);
+    atomic_store(&g_archive_claimed[handle - 1], false);
+}
+
+int native_archive_entry_count(int handle) {
+    MappedArchive* archive = archive_get(handle);
+    return archive ? (int)archive->count : 0;
+}
+
+/* Returns the entry index, or -1 if the path isn't in the archive. path is UTF-8, length in bytes */
+int native_archive_find_span(int handle, const char* path, int length, ArchiveEntryInfo* info) {
+    MappedArchive* archive = archive_get(handle);
+    if (!archive || !path || length < 0) return -1;
+
+    uint64_t hash = archive_hash_path(path, (size_t)length);
+    uint32_t lo = 0, hi = archive->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (archive->entries[mid].hash < hash) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == archive->count || archive->entries[lo].hash != hash) return -1;
+
+    if (info) archive_fill_info(archive, (int)lo, info);
+    return (int)lo;
+}
+
+int native_archive_find(int handle, const char* path, ArchiveEntryInfo* info) {
+    return path ? native_archive_find_span(handle, path, (int)strlen(path), info) : -1;
+}
+
+int native_archive_get_entry(int handle, int index, ArchiveEntryInfo* info) {
+    MappedArchive* archive = archive_get(handle);
+    if (!archive || index < 0 || (uint32_t)index >= archive->count || !info) return 0;
+    archive_fill_info(archive, index, info);
+    return 1;
+}
+
+/* Chunk table of a compressed entry; NULL for stored entries or a bad table */
+static const uint32_t* archive_chunk_table(const MappedArchive* archive, int index,
+                                           uint32_t* chunk_count, uint32_t* chunk_size) {
+    const ArchiveEntry* e = &archive->entries[index];
+    if (e->compression != PF_COMPRESSION_LZ4_CHUNKED || e->size < 8) return NULL;
+
+    const uint32_t* table = (const uint32_t*)(archive->base + e->offset);
+    *chunk_count = table[0];
+    *chunk_size = table[1];
+    if (*chunk_size == 0 || (uint64_t)*chunk_count * 4 + 8 > e->size) return NULL;
+    /* Exactly enough chunks for raw_size; an extra one would decode past the output */
+    if (*chunk_count != e->raw_size / *chunk_size + (e->raw_size % *chunk_size != 0)) return NULL;
+    return table + 2;
+}
+
+/* Number of independently decodable chunks; 0 for stored entries */
+int native_archive_chunk_count(int handle, int index) {
+    MappedArchive* archive = archive_get(handle);
+    if (!archive || index < 0 || (uint32_t)index >= archive->count) return 0;
+
+    uint32_t count, size;
+    return archive_chunk_table(archive, index, &count, &size) ? (int)count : 0;
+}
+
+/*
+ * Decodes chunks [first, first + count) of a compressed entry into dst, which
+ * must be the whole raw_size output buffer; each chunk lands at its own offset,
+ * so threads can decode disjoint ranges into the same buffer. Returns 1 on success.
+ */
+int native_archive_decode_chunks(int handle, int index, int first, int count, void* dst, int64_t dst_size) {
+    MappedArchive* archive = archive_get(handle);
+    if (!archive || index < 0 || (uint32_t)index >= archive->count || !dst) return 0;
+
+    const ArchiveEntry* e = &archive->entries[index];
+    if ((uint64_t)dst_size < e->raw_size) return 0;
+
+    uint32_t chunk_count, chunk_size;
+    const uint32_t* sizes = archive_chunk_table(archive, index, &chunk_count, &chunk_size);
+    if (!sizes || first < 0 || count < 0 || (uint32_t)first + (uint32_t)count > chunk_count) return 0;
+
+    /* Payload offset of the first chunk: sum of the sizes before it */
+    uint64_t offset = 8 + (uint64_t)chunk_count * 4;
+    for (int c = 0; c < first; c++) offset += sizes[c] & ~PF_CHUNK_STORED;
+
+    for (int c = first; c < first + count; c++) {
+        uint32_t stored = sizes[c] & ~PF_CHUNK_STORED;
+        if (offset + stored > e->size) return 0;
+
+        uint64_t raw_offset = (uint64_t)c * chunk_size;
+        uint64_t raw = e->raw_size - raw_offset < chunk_size ? e->raw_size - raw_offset : chunk_size;
+        const unsigned char* src = archive->base + e->offset + offset;
+        unsigned char* out = (unsigned char*)dst + raw_offset;
+
+        if (sizes[c] & PF_CHUNK_STORED) {
+            if (stored != raw) return 0;
+            memcpy(out, src, raw);
+        } else if (native_lz4_decompress(src, (int)stored, out, (int)raw) != (int)raw) {
+            return 0;
+        }
+        offset += stored;
+    }
+    return 1;
+}
+
+/* Asks the OS to start reading an entry's pages ahead of the first touch */
+void native_archive_prefetch(int handle, int index) {
+    MappedArchive* archive = archive_get(handle);
+    if (!archive || index < 0 || (uint32_t)index >= archive->count) return;
+
+    const ArchiveEntry* e = &archive->entries[index];
+    if (e->size == 0) return;
+
+    #ifdef _WIN32
+        /* PrefetchVirtualMemory is Windows 8+; touching one byte per page works everywhere
+         * but would block here, so older systems simply fault pages in on use */
+        (void)e;
+    #else
+        /* Entry offsets are page aligned by the packer */
+        madvise((void*)(archive->base + e->offset), (size_t)e->size, MADV_WILLNEED);
+    #endif
+}
+
+/* ============================================================================
+ * FILE WATCHING
+ * Change notifications for asset directories, for hot reload. A watcher
+ * thread turns inotify (Linux) or ReadDirectoryChangesW (Windows) records
+ * into fixed-size events handed out by native_watch_poll. Consecutive
+ * duplicates (editors often write a file several times per save) are merged
+ * here; the managed side debounces the rest. When the queue fills, one
+ * overflow event tells the caller to rescan. Other platforms report no
+ * support, and hot reload falls back to polling timestamps.
+ * ============================================================================ */
+
+#ifndef __APPLE__
+    #define PF_WATCH_NATIVE
+#endif
+
+#define PF_WATCH_MAX 16
+#define PF_WATCH_PATH_MAX 512
+#define PF_WATCH_QUEUE 256
+
+/* Keep in sync with WatchAction in bindings.cs */
+enum {
+    PF_WATCH_MODIFIED = 1,      /* written, created or moved in */
+    PF_WATCH_REMOVED = 2,       /* deleted or moved out */
+    PF_WATCH_OVERFLOW = 3       /* events were lost; path is empty */
+};
+
+/* Layout must match WatchEvent in bindings.cs */
+typedef struct {
+    int64_t ticks;
+    int32_t watch;
+    int32_t action;
+    char path[PF_WATCH_PATH_MAX];   /* UTF-8, '/' separated: the watched directory, then the file */
+} WatchEvent;
+
+typedef struct {
+    bool in_use;
+    bool recursive;
+    char root[PF_WATCH_PATH_MAX];
+    #ifdef _WIN32
+        HANDLE directory;
+        OVERLAPPED overlapped;
+        DWORD* buffer;          /* ReadDirectoryChangesW wants DWORD alignment */
+        bool armed;
+        bool closing;           /* the thread cancels and closes it */
+    #endif
+} WatchRoot;
+
+#if defined(PF_WATCH_NATIVE) && !defined(_WIN32)
+typedef struct {
+    int wd;
+    int watch;
+    char* path;
+} WatchDir;
+#endif
+
+typedef struct {
+    bool initialized;
+    pf_mutex lock;
+    pf_thread thread;
+    bool thread_running;
+    bool thread_quit;
+    WatchRoot roots[PF_WATCH_MAX];
+    WatchEvent* queue;
+    int head;
+    int count;
+    bool overflowed;
+    #ifdef _WIN32
+        HANDLE wake;
+    #elif defined(PF_WATCH_NATIVE)
+        int inotify_fd;
+        int wake_pipe[2];
+        WatchDir* dirs;
+        int dir_count;
+        int dir_capacity;
+    #endif
+} FileWatcher;
+
+static FileWatcher g_watch = {0};
+
+#ifdef PF_WATCH_NATIVE
+
+/* Caller holds the lock */
+static void watch_push(int watch, int action, const char* path) {
+    if (g_watch.count > 0) {
+        WatchEvent* last = &g_watch.queue[(g_watch.head + g_watch.count - 1) % PF_WATCH_QUEUE];
+        if (last->watch == watch && last->action == action && strcmp(last->path, path) == 0) {
+            last->ticks = native_get_ticks();
+            return;
+        }
+    }
+    if (g_watch.count == PF_WATCH_QUEUE) {
+        g_watch.overflowed = true;
+        return;
+    }
+
+    WatchEvent* e = &g_watch.queue[(g_watch.head + g_watch.count++) % PF_WATCH_QUEUE];
+    e->ticks = native_get_ticks();
+    e->watch = watch;
+    e->action = action;
+    snprintf(e->path, sizeof(e->path), "%s", path);
+}
+
+#ifdef _WIN32
+
+#define PF_WATCH_BUFFER_SIZE (64 * 1024)    /* the limit for network shares */
+#define PF_WATCH_FILTER (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE)
+
+static bool watch_platform_init() {
+    g_watch.wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    return g_watch.wake != NULL;
+}
+
+static void watch_wake() {
+    SetEvent(g_watch.wake);
+}
+
+static void watch_close_root(WatchRoot* root) {
+    if (root->armed) {
+        DWORD bytes;
+        CancelIoEx(root->directory, &root->overlapped);
+        GetOverlappedResult(root->directory, &root->overlapped, &bytes, TRUE);
+    }
+    if (root->directory != INVALID_HANDLE_VALUE && root->directory) CloseHandle(root->directory);
+    if (root->overlapped.hEvent) CloseHandle(root->overlapped.hEvent);
+    free(root->buffer);
+    memset(root, 0, sizeof(*root));
+}
+
+/* Main thread, lock held; the watcher thread issues the first read */
+static bool watch_platform_add(int watch, WatchRoot* root) {
+    wchar_t* wide = utf8_to_wide(root->root);
+    if (!wide) return false;
+    root->directory = CreateFileW(wide, FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    free(wide);
+    if (root->directory == INVALID_HANDLE_VALUE) return false;
+
+    root->overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    root->buffer = (DWORD*)malloc(PF_WATCH_BUFFER_SIZE);
+    if (!root->overlapped.hEvent || !root->buffer) {
+        watch_close_root(root);
+        return false;
+    }
+    (void)watch;
+    return true;
+}
+
+static void watch_platform_remove(int watch, WatchRoot* root) {
+    (void)watch;
+    root->closing = true;
+    root->in_use = false;
+}
+
+/* Watcher thread, lock held */
+static void watch_parse(int watch, WatchRoot* root, DWORD bytes) {
+    char name[PF_WATCH_PATH_MAX];
+    char path[PF_WATCH_PATH_MAX];
+    const BYTE* cursor = (const BYTE*)root->buffer;
+
+    for (;;) {
+        const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)cursor;
+        int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, (int)(info->FileNameLength / sizeof(WCHAR)),
+            name, (int)sizeof(name) - 1, NULL, NULL);
+        if (length > 0) {
+            name[length] = '\0';
+            for (int i = 0; i < length; i++) if (name[i] == '\\') name[i] = '/';
+            snprintf(path, sizeof(path), "%s/%s", root->root, name);
+
+            switch (info->Action) {
+                case FILE_ACTION_ADDED:
+                case FILE_ACTION_MODIFIED:
+                case FILE_ACTION_RENAMED_NEW_NAME:
+                    watch_push(watch, PF_WATCH_MODIFIED, path);
+                    break;
+                case FILE_ACTION_REMOVED:
+                case FILE_ACTION_RENAMED_OLD_NAME:
+                    watch_push(watch, PF_WATCH_REMOVED, path);
+                    break;
+            }
+        }
+        if (info->NextEntryOffset == 0 || (DWORD)(cursor - (const BYTE*)root->buffer) + info->NextEntryOffset >= bytes) break;
+        cursor += info->NextEntryOffset;
+    }
+}
+
+static void watch_thread_main(void* arg) {
+    (void)arg;
+    HANDLE handles[PF_WATCH_MAX + 1];
+    int owners[PF_WATCH_MAX + 1];
+
+    for (;;) {
+        int count = 0;
+        handles[count++] = g_watch.wake;
+
+        pf_mutex_lock(&g_watch.lock);
+        if (g_watch.thread_quit) {
+            pf_mutex_unlock(&g_watch.lock);
+            break;
+        }
+        for (int i = 0; i < PF_WATCH_MAX; i++) {
+            WatchRoot* root = &g_watch.roots[i];
+            if (root->closing) {
+                watch_close_root(root);
+                continue;
+            }
+            if (!root->in_use) continue;
+            if (!root->armed) {
+                ResetEvent(root->overlapped.hEvent);
+                root->armed = ReadDirectoryChangesW(root->directory, root->buffer, PF_WATCH_BUFFER_SIZE,
+                    root->recursive, PF_WATCH_FILTER, NULL, &root->overlapped, NULL) != 0;
+                /* Armed again on the next pass; a vanished directory simply stops reporting */
+                if (!root->armed) continue;
+            }
+            owners[count] = i;
+            handles[count++] = root->overlapped.hEvent;
+        }
+        pf_mutex_unlock(&g_watch.lock);
+
+        DWORD result = WaitForMultipleObjects((DWORD)count, handles, FALSE, INFINITE);
+        if (result == WAIT_FAILED) break;
+        int index = (int)(result - WAIT_OBJECT_0);
+        if (index <= 0 || index >= count) continue;
+
+        int watch = owners[index];
+        WatchRoot* root = &g_watch.roots[watch];
+        DWORD bytes = 0;
+        BOOL ok = GetOverlappedResult(root->directory, &root->overlapped, &bytes, FALSE);
+
+        pf_mutex_lock(&g_watch.lock);
+        root->armed = false;
+        if (!root->closing) {
+            if (!ok || bytes == 0) g_watch.overflowed = true;     /* the kernel buffer overflowed */
+            else watch_parse(watch + 1, root, bytes);
+        }
+        pf_mutex_unlock(&g_watch.lock);
+    }
+}
+
+static void watch_platform_shutdown() {
+    for (int i = 0; i < PF_WATCH_MAX; i++) {
+        if (g_watch.roots[i].in_use || g_watch.roots[i].closing) watch_close_root(&g_watch.roots[i]);
+    }
+    CloseHandle(g_watch.wake);
+}
+
+#else
+
+#define PF_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE)
+
+static bool watch_platform_init() {
+    g_watch.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g_watch.inotify_fd < 0) return false;
+    if (pipe(g_watch.wake_pipe) != 0) {
+        close(g_watch.inotify_fd);
+        return false;
+    }
+    /* Wakes only need to register; a full pipe already has one pending */
+    fcntl(g_watch.wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(g_watch.wake_pipe[1], F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+static void watch_wake() {
+    char byte = 1;
+    ssize_t written = write(g_watch.wake_pipe[1], &byte, 1);
+    (void)written;
+}
+
+static WatchDir* watch_find_dir(int wd) {
+    for (int i = 0; i < g_watch.dir_count; i++) {
+        if (g_watch.dirs[i].wd == wd) return &g_watch.dirs[i];
+    }
+    return NULL;
+}
+
+static void watch_drop_dir(WatchDir* dir) {
+    free(dir->path);
+    *dir = g_watch.dirs[--g_watch.dir_count];
+}
+
+/*
+ * Caller holds the lock. Watches path and, for recursive roots, every directory below it.
+ * report_files queues the files found, for directories that appeared after the watch was
+ * set up and may have been filled before their own watch existed.
+ */
+static bool watch_add_tree(int watch, const char* path, bool recursive, bool report_files) {
+    int wd = inotify_add_watch(g_watch.inotify_fd, path, PF_WATCH_MASK);
+    if (wd < 0) return false;
+
+    WatchDir* dir = watch_find_dir(wd);
+    if (!dir) {
+        if (g_watch.dir_count == g_watch.dir_capacity) {
+            int capacity = g_watch.dir_capacity ? g_watch.dir_capacity * 2 : 64;
+            WatchDir* dirs = (WatchDir*)realloc(g_watch.dirs, (size_t)capacity * sizeof(WatchDir));
+            if (!dirs) return false;
+            g_watch.dirs = dirs;
+            g_watch.dir_capacity = capacity;
+        }
+        dir = &g_watch.dirs[g_watch.dir_count++];
+        dir->path = NULL;
+    }
+    free(dir->path);
+    dir->wd = wd;
+    dir->watch = watch;
+    dir->path = strdup(path);
+    if (!dir->path) {
+        inotify_rm_watch(g_watch.inotify_fd, wd);
+        *dir = g_watch.dirs[--g_watch.dir_count];
+        return false;
+    }
+    if (!recursive && !report_files) return true;
+
+    DIR* handle = opendir(path);
+    if (!handle) return true;
+
+    char child[PF_WATCH_PATH_MAX];
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        if (snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= (int)sizeof(child)) continue;
+
+        bool is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = stat(child, &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (is_dir) {
+            if (recursive) watch_add_tree(watch, child, true, report_files);
+        } else if (report_files) {
+            watch_push(watch, PF_WATCH_MODIFIED, child);
+        }
+    }
+    closedir(handle);
+    return true;
+}
+
+static bool watch_platform_add(int watch, WatchRoot* root) {
+    return watch_add_tree(watch, root->root, root->recursive, false);
+}
+
+static void watch_platform_remove(int watch, WatchRoot* root) {
+    for (int i = g_watch.dir_count - 1; i >= 0; i--) {
+        if (g_watch.dirs[i].watch != watch) continue;
+        inotify_rm_watch(g_watch.inotify_fd, g_watch.dirs[i].wd);
+        watch_drop_dir(&g_watch.dirs[i]);
+    }
+    root->in_use = false;
+}
+
+/* Watcher thread, lock held */
+static void watch_handle(const struct inotify_event* event) {
+    if (event->mask & IN_Q_OVERFLOW) {
+        g_watch.overflowed = true;
+        return;
+    }
+
+    WatchDir* dir = watch_find_dir(event->wd);
+    if (!dir) return;
+    if (event->mask & IN_IGNORED) {
+        /* Directory deleted or unwatched */
+        watch_drop_dir(dir);
+        return;
+    }
+    if (event->len == 0) return;
+
+    char path[PF_WATCH_PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", dir->path, event->name) >= (int)sizeof(path)) return;
+
+    int watch = dir->watch;
+    if (event->mask & IN_ISDIR) {
+        WatchRoot* root = &g_watch.roots[watch - 1];
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && root->in_use && root->recursive) {
+            watch_add_tree(watch, path, true, true);
+        }
+        return;
+    }
+
+    /* IN_CREATE alone is an empty file; its IN_CLOSE_WRITE follows */
+    if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) watch_push(watch, PF_WATCH_MODIFIED, path);
+    else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) watch_push(watch, PF_WATCH_REMOVED, path);
+}
+
+static void watch_thread_main(void* arg) {
+    (void)arg;
+    /* Aligned for struct inotify_event */
+    int64_t buffer[4096 / sizeof(int64_t)];
+    struct pollfd fds[2];
+    fds[0].fd = g_watch.inotify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = g_watch.wake_pipe[0];
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) {
+            char drain[16];
+            ssize_t ignored = read(g_watch.wake_pipe[0], drain, sizeof(drain));
+            (void)ignored;
+            pf_mutex_lock(&g_watch.lock);
+            bool quit = g_watch.thread_quit;
+            pf_mutex_unlock(&g_watch.lock);
+            if (quit) break;
+        }
+
+        for (;;) {
+            ssize_t length = read(g_watch.inotify_fd, buffer, sizeof(buffer));
+            if (length <= 0) break;
+
+            pf_mutex_lock(&g_watch.lock);
+            const char* cursor = (const char*)buffer;
+            while (cursor < (const char*)buffer + length) {
+                const struct inotify_event* event = (const struct inotify_event*)cursor;
+                watch_handle(event);
+                cursor += sizeof(struct inotify_event) + event->len;
+            }
+            pf_mutex_unlock(&g_watch.lock);
+        }
+    }
+}
+
+static void watch_platform_shutdown() {
+    for (int i = 0; i < g_watch.dir_count; i++) free(g_watch.dirs[i].path);
+    free(g_watch.dirs);
+    close(g_watch.inotify_fd);
+    close(g_watch.wake_pipe[0]);
+    close(g_watch.wake_pipe[1]);
+}
+
+#endif /* _WIN32 */
+
+#endif /* PF_WATCH_NATIVE */
+
+/* ---- Public API ---- */
+
+int native_watch_supported() {
+    #ifdef PF_WATCH_NATIVE
+        return 1;
+    #else
+        return 0;
+    #endif
+}
+
+/*
+ * Starts watching a directory; recursive includes everything below it. Returns a handle,
+ * or 0 if the directory cannot be watched or the platform has no watcher.
+ */
+int native_watch_add(const char* directory, int recursive) {
+    if (!directory || !directory[0] || !native_watch_supported()) return 0;
+
+    #ifdef PF_WATCH_NATIVE
+        if (!g_watch.initialized) {
+            g_watch.queue = (WatchEvent*)malloc(PF_WATCH_QUEUE * sizeof(WatchEvent));
+            if (!g_watch.queue || !watch_platform_init()) {
+                free(g_watch.queue);
+                g_watch.queue = NULL;
+                return 0;
+            }
+            pf_mutex_init(&g_watch.lock);
+            g_watch.initialized = true;
+        }
+
+        pf_mutex_lock(&g_watch.lock);
+        int watch = 0;
+        for (int i = 0; i < PF_WATCH_MAX && !watch; i++) {
+            WatchRoot* root = &g_watch.roots[i];
+            #ifdef _WIN32
+                if (root->closing) continue;
+            #endif
+            if (root->in_use) continue;
+
+            memset(root, 0, sizeof(*root));
+            snprintf(root->root, sizeof(root->root), "%s", directory);
+            size_t length = strlen(root->root);
+            while (length > 1 && (root->root[length - 1] == '/' || root->root[length - 1] == '\\')) {
+                root->root[--length] = '\0';
+            }
+            root->recursive = recursive != 0;
+            if (!watch_platform_add(i + 1, root)) break;
+            root->in_use = true;
+            watch = i + 1;
+        }
+
+        if (watch && !g_watch.thread_running) {
+            g_watch.thread_quit = false;
+            g_watch.thread_running = pf_thread_start(&g_watch.thread, watch_thread_main, NULL);
+        }
+        pf_mutex_unlock(&g_watch.lock);
+
+        if (watch) watch_wake();
+        return watch;
+    #else
+        (void)recursive;
+        return 0;
+    #endif
+}
+
+void native_watch_remove(int watch) {
+    if (!g_watch.initialized || watch < 1 || watch > PF_WATCH_MAX) return;
+    #ifdef PF_WATCH_NATIVE
+        pf_mutex_lock(&g_watch.lock);
+        WatchRoot* root = &g_watch.roots[watch - 1];
+        if (root->in_use) watch_platform_remove(watch, root);
+        pf_mutex_unlock(&g_watch.lock);
+        watch_wake();
+    #endif
+}
+
+/* Copies up to max queued events, oldest first; returns the count */
+int native_watch_poll(WatchEvent* events, int max) {
+    if (!g_watch.initialized || !events || max <= 0) return 0;
+
+    int n = 0;
+    pf_mutex_lock(&g_watch.lock);
+    if (g_watch.overflowed) {
+        memset(&events[n], 0, sizeof(WatchEvent));
+        events[n].ticks = native_get_ticks();
+        events[n].action = PF_WATCH_OVERFLOW;
+        g_watch.overflowed = false;
+        n++;
+    }
+    while (n < max && g_watch.count > 0) {
+        events[n++] = g_watch.queue[g_watch.head];
+        g_watch.head = (g_watch.head + 1) % PF_WATCH_QUEUE;
+        g_watch.count--;
+    }
+    pf_mutex_unlock(&g_watch.lock);
+    return n;
+}
+
+/* Stops the watcher thread and drops every watch */
+void native_watch_shutdown() {
+    if (!g_watch.initialized) return;
+    #ifdef PF_WATCH_NATIVE
+        pf_mutex_lock(&g_watch.lock);
+        bool running = g_watch.thread_running;
+        g_watch.thread_quit = true;
+        pf_mutex_unlock(&g_watch.lock);
+
+        watch_wake();
+        if (running) pf_thread_join(g_watch.thread);
+        watch_platform_shutdown();
+    #endif
+    free(g_watch.queue);
+    pf_mutex_destroy(&g_watch.lock);
+    memset(&g_watch, 0, sizeof(g_watch));
+}
+
+/* ============================================================================
+ * AUDIO MIXER
+ * A mixer thread renders every voice into a fixed ring of clipped float
+ * stereo frames, staying a set latency ahead of the device side that drains
+ * it: a WASAPI event thread on Windows, an AudioQueue callback on macOS, an
+ * ALSA writer thread on Linux (libasound is loaded with dlopen), or a paced
+ * null device when none opens. The managed side reaches the mixer only
+ * through a single-producer/single-consumer command queue; streamed sources
+ * get their own SPSC rings, filled by decode jobs. Neither the mixer nor the
+ * device side allocates or takes a lock: released sounds and streams are
+ * handed back and freed by native_audio_update on the main thread.
+ * ============================================================================ */
+
+#define PF_AUDIO_DEFAULT_RATE 48000
+#define PF_AUDIO_DEFAULT_LATENCY_MS 20
+#define PF_AUDIO_BLOCK 256              /* frames per mix pass; the ring fills in whole blocks */
+#define PF_AUDIO_RING_FRAMES 8192       /* power of two and a multiple of the block */
+#define PF_AUDIO_MAX_VOICES 64
+#define PF_AUDIO_MAX_SOUNDS 1024
+#define PF_AUDIO_MAX_STREAMS 16
+#define PF_AUDIO_COMMANDS 1024          /* power of two */
+#define PF_AUDIO_RETIRE 2048            /* power of two above sounds + streams, so it never fills */
+#define PF_AUDIO_UNITY_STEP (1ULL << 32)
+
+/* Keep in sync with AudioCommandType in bindings.cs */
+enum {
+    PF_AUDIO_CMD_PLAY = 1,              /* source, volume, pan, pitch, flags */
+    PF_AUDIO_CMD_STOP = 2,              /* fade */
+    PF_AUDIO_CMD_VOLUME = 3,
+    PF_AUDIO_CMD_PAN = 4,
+    PF_AUDIO_CMD_PITCH = 5,
+    PF_AUDIO_CMD_PAUSE = 6,             /* flags: 1 pauses, 0 resumes */
+    PF_AUDIO_CMD_MASTER_VOLUME = 7,     /* volume; no voice */
+    PF_AUDIO_CMD_STOP_ALL = 8,          /* fade; no voice */
+    PF_AUDIO_CMD_RELEASE_SOUND = 9,     /* sent by native_audio_sound_release */
+    PF_AUDIO_CMD_RELEASE_STREAM = 10    /* sent by native_audio_stream_release */
+};
+
+/* Keep in sync with AudioPlayFlags in bindings.cs */
+enum {
+    PF_AUDIO_PLAY_LOOP = 1,
+    PF_AUDIO_PLAY_STREAM = 2,           /* source is a stream handle rather than a sound */
+    PF_AUDIO_PLAY_PAUSED = 4
+};
+
+/* Keep in sync with AudioBackend in bindings.cs */
+enum {
+    PF_AUDIO_BACKEND_NONE = 0,
+    PF_AUDIO_BACKEND_NULL = 1,          /* no device: frames are consumed in real time and dropped */
+    PF_AUDIO_BACKEND_WASAPI = 2,
+    PF_AUDIO_BACKEND_ALSA = 3,
+    PF_AUDIO_BACKEND_COREAUDIO = 4
+};
+
+/* Layout must match AudioCommand in bindings.cs */
+typedef struct {
+    int32_t type;               /* PF_AUDIO_CMD_* */
+    uint32_t voice;             /* chosen by the caller, never 0 */
+    int32_t source;             /* sound or stream handle */
+    int32_t flags;              /* PF_AUDIO_PLAY_* */
+    float volume;
+    float pan;                  /* -1 left .. 1 right */
+    float pitch;                /* playback rate multiplier */
+    float fade;                 /* seconds */
+} AudioCommand;
+
+/* Layout must match AudioStats in bindings.cs */
+typedef struct {
+    int32_t backend;            /* PF_AUDIO_BACKEND_* */
+    int32_t sample_rate;
+    int32_t latency_frames;     /* how far the mixer stays ahead of the device */
+    int32_t active_voices;
+    int64_t frames_mixed;
+    int64_t underruns;          /* device reads that found the ring short, after the first fill */
+    int64_t commands;
+    int64_t commands_dropped;   /* pushes that found the queue full */
+    int64_t voices_rejected;    /* plays with every voice busy or a dead source */
+    int64_t stream_starved;     /* frames of silence inserted because a stream ran dry */
+    double mix_avg_us;          /* per block */
+    double mix_peak_us;
+} AudioStats;
+
+typedef struct {
+    float* samples;             /* interleaved; NULL = free slot */
+    int32_t frames;
+    int32_t channels;           /* 1 or 2 */
+    int32_t rate;
+    bool releasing;             /* main thread: release queued, not yet retired */
+} MixerSound;
+
+typedef struct {
+    float* ring;                /* capacity * channels; NULL = free slot */
+    uint32_t capacity;          /* frames, power of two */
+    int32_t channels;
+    int32_t rate;
+    atomic_uint write;          /* frames ever written, advanced by the decode job */
+    atomic_uint read;           /* frames ever consumed, advanced by the mixer */
+    atomic_bool ended;          /* the decoder has written its last frame */
+    bool releasing;
+} MixerStream;
+
+/* Mixer thread only */
+typedef struct {
+    uint32_t id;                /* 0 = free */
+    int32_t sound;              /* slot, or -1 */
+    int32_t stream;             /* slot, or -1 */
+    uint64_t position;          /* 32.32 frames; relative to the read cursor for streams */
+    uint64_t step;              /* 32.32 source frames per output frame */
+    float volume;
+    float pan;
+    float pitch;
+    float fade;                 /* 1 until stopped, then down to 0 */
+    float fade_step;            /* per block */
+    float gain[2];              /* left/right reached at the end of the last block */
+    bool loop;
+    bool paused;
+    bool stopping;
+} MixerVoice;
+
+typedef struct {
+    bool initialized;           /* main thread */
+    int backend;
+    int rate;
+    uint32_t latency_frames;
+    atomic_bool quit;
+    pf_thread mixer_thread;
+    pf_thread device_thread;    /* ALSA writer, WASAPI event loop or null device */
+    bool device_thread_running;
+
+    /* Each index has one writer; the padding keeps the two sides off each other's cache line */
+    AudioCommand commands[PF_AUDIO_COMMANDS];
+    atomic_uint command_read;   /* mixer */
+    char pad0[64];
+    atomic_uint command_write;  /* main thread */
+    char pad1[64];
+
+    int32_t retired[PF_AUDIO_RETIRE];   /* sound handles, stream handles negated; mixer -> main */
+    atomic_uint retired_read;
+    atomic_uint retired_write;
+    char pad2[64];
+
+    float ring[PF_AUDIO_RING_FRAMES * 2];
+    atomic_uint ring_read;      /* device side */
+    char pad3[64];
+    atomic_uint ring_write;     /* mixer */
+    atomic_bool primed;         /* the mixer has reached its fill target once */
+
+    MixerSound sounds[PF_AUDIO_MAX_SOUNDS];
+    MixerStream streams[PF_AUDIO_MAX_STREAMS];
+    MixerVoice voices[PF_AUDIO_MAX_VOICES];
+    atomic_uint voice_ids[PF_AUDIO_MAX_VOICES];     /* published copy of voices[i].id */
+    atomic_uint last_play;      /* voice id of the last PLAY the mixer ran */
+    float master;               /* mixer thread */
+    float mix[PF_AUDIO_BLOCK * 2];
+
+    atomic_llong frames_mixed;
+    atomic_llong underruns;
+    atomic_llong commands_done;
+    atomic_llong commands_dropped;
+    atomic_llong voices_rejected;
+    atomic_llong stream_starved;
+    atomic_llong mix_ticks;
+    atomic_llong mix_blocks;
+    atomic_llong mix_peak_ticks;
+    atomic_int active_voices;
+
+    #ifdef _WIN32
+        bool com_initialized;
+        IAudioClient* client;
+        IAudioRenderClient* render;
+        HANDLE event;
+        UINT32 device_frames;
+    #elif defined(__APPLE__)
+        AudioQueueRef queue;
+    #endif
+} AudioMixer;
+
+static AudioMixer g_audio = {0};
+
+/* Best effort: audio threads should preempt game work, but not getting the priority is no error */
+static void audio_raise_priority() {
+    #ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    #else
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    #endif
+}
+
+/* Device side: copies up to frames out of the ring and pads with silence */
+static void audio_ring_read(float* out, uint32_t frames) {
+    uint32_t read = atomic_load_explicit(&g_audio.ring_read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&g_audio.ring_write, memory_order_acquire);
+    uint32_t n = write - read;
+    if (n > frames) n = frames;
+
+    uint32_t start = read & (PF_AUDIO_RING_FRAMES - 1);
+    uint32_t first = PF_AUDIO_RING_FRAMES - start;
+    if (first > n) first = n;
+    memcpy(out, g_audio.ring + start * 2, first * 2 * sizeof(float));
+    memcpy(out + first * 2, g_audio.ring, (n - first) * 2 * sizeof(float));
+
+    if (n < frames) {
+        memset(out + n * 2, 0, (frames - n) * 2 * sizeof(float));
+        if (atomic_load_explicit(&g_audio.primed, memory_order_relaxed))
+            atomic_fetch_add_explicit(&g_audio.underruns, 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_audio.ring_read, read + n, memory_order_release);
+}
+
+/*
+ * out (stereo) += src * gain, the gain ramping linearly from (l, r) by (dl, dr) per frame.
+ * src is mono or interleaved stereo. Two output frames per vector.
+ */
+static void audio_mix_span(float* out, const float* src, int channels, int frames,
+                           float l, float r, float dl, float dr) {
+    int i = 0;
+    #if defined(PF_SIMD_SSE2)
+        __m128 gain = _mm_setr_ps(l, r, l + dl, r + dr);
+        __m128 step = _mm_setr_ps(2.0f * dl, 2.0f * dr, 2.0f * dl, 2.0f * dr);
+        if (channels == 2) {
+            for (; i + 2 <= frames; i += 2) {
+                __m128 s = _mm_loadu_ps(src + i * 2);
+                __m128 o = _mm_loadu_ps(out + i * 2);
+                _mm_storeu_ps(out + i * 2, _mm_add_ps(o, _mm_mul_ps(s, gain)));
+                gain = _mm_add_ps(gain, step);
+            }
+        } else {
+            for (; i + 2 <= frames; i += 2) {
+                __m128 m = _mm_castpd_ps(_mm_load_sd((const double*)(src + i)));
+                __m128 s = _mm_unpacklo_ps(m, m);
+                __m128 o = _mm_loadu_ps(out + i * 2);
+                _mm_storeu_ps(out + i * 2, _mm_add_ps(o, _mm_mul_ps(s, gain)));
+                gain = _mm_add_ps(gain, step);
+            }
+        }
+    #elif defined(PF_SIMD_NEON)
+        const float gain_init[4] = {l, r, l + dl, r + dr};
+        const float step_init[4] = {2.0f * dl, 2.0f * dr, 2.0f * dl, 2.0f * dr};
+        float32x4_t gain = vld1q_f32(gain_init);
+        float32x4_t step = vld1q_f32(step_init);
+        if (channels == 2) {
+            for (; i + 2 <= frames; i += 2) {
+                float32x4_t s = vld1q_f32(src + i * 2);
+                vst1q_f32(out + i * 2, vmlaq_f32(vld1q_f32(out + i * 2), s, gain));
+                gain = vaddq_f32(gain, step);
+            }
+        } else {
+            for (; i + 2 <= frames; i += 2) {
+                float32x2_t m = vld1_f32(src + i);
+                float32x2x2_t pair = vzip_f32(m, m);
+                float32x4_t s = vcombine_f32(pair.val[0], pair.val[1]);
+                vst1q_f32(out + i * 2, vmlaq_f32(vld1q_f32(out + i * 2), s, gain));
+                gain = vaddq_f32(gain, step);
+            }
+        }
+    #endif
+
+    l += dl * (float)i;
+    r += dr * (float)i;
+    for (; i < frames; i++) {
+        out[i * 2] += src[i * channels] * l;
+        out[i * 2 + 1] += src[i * channels + channels - 1] * r;
+        l += dl;
+        r += dr;
+    }
+}
+
+/* Clamps mixed samples to [-1, 1] on their way into the ring */
+static void audio_clip(float* dst, const float* src, int count) {
+    int i = 0;
+    #if defined(PF_SIMD_SSE2)
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(dst + i, _mm_max_ps(lo, _mm_min_ps(hi, _mm_loadu_ps(src + i))));
+    #elif defined(PF_SIMD_NEON)
+        const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(dst + i, vmaxq_f32(lo, vminq_f32(hi, vld1q_f32(src + i))));
+    #endif
+    for (; i < count; i++)
+        dst[i] = src[i] < -1.0f ? -1.0f : (src[i] > 1.0f ? 1.0f : src[i]);
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+/* Clipped float to 16-bit PCM, for devices without float formats */
+static void audio_to_s16(int16_t* dst, const float* src, int count) {
+    int i = 0;
+    #if defined(PF_SIMD_SSE2)
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= count; i += 8) {
+            __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+            __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+        }
+    #elif defined(PF_SIMD_NEON)
+        const float32x4_t scale = vdupq_n_f32(32767.0f);
+        for (; i + 4 <= count; i += 4)
+            vst1_s16(dst + i, vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(src + i), scale))));
+    #endif
+    for (; i < count; i++)
+        dst[i] = (int16_t)lrintf(src[i] * 32767.0f);
+}
+#endif
+
+static void audio_voice_target(const MixerVoice* v, float gain[2]) {
+    float level = v->paused ? 0.0f : v->volume * v->fade * g_audio.master;
+    /* Equal-power pan keeps loudness constant across the field */
+    float angle = (v->pan + 1.0f) * 0.78539816f;
+    gain[0] = level * cosf(angle);
+    gain[1] = level * sinf(angle);
+}
+
+/* Returns false once a one-shot sound has played out */
+static bool audio_mix_sound(MixerVoice* v, float* out, int frames, float l, float r, float dl, float dr) {
+    const MixerSound* s = &g_audio.sounds[v->sound];
+    const int ch = s->channels;
+    const uint64_t length = (uint64_t)s->frames << 32;
+
+    if (v->step == PF_AUDIO_UNITY_STEP) {
+        int done = 0;
+        while (done < frames) {
+            if (v->position >= length) {
+                if (!v->loop) return false;
+                v->position -= length;
+            }
+            int64_t at = (int64_t)(v->position >> 32);
+            int n = frames - done;
+            if (n > s->frames - at) n = (int)(s->frames - at);
+            audio_mix_span(out + done * 2, s->samples + at * ch, ch, n,
+                           l + dl * (float)done, r + dr * (float)done, dl, dr);
+            v->position += (uint64_t)n << 32;
+            done += n;
+        }
+        return true;
+    }
+
+    /* Resampled: linear interpolation, scalar */
+    for (int i = 0; i < frames; i++) {
+        if (v->position >= length) {
+            if (!v->loop) return false;
+            v->position %= length;
+        }
+        uint32_t at = (uint32_t)(v->position >> 32);
+        uint32_t next = at + 1 < (uint32_t)s->frames ? at + 1 : (v->loop ? 0 : at);
+        float t = (float)(uint32_t)v->position * (1.0f / 4294967296.0f);
+        const float* a = s->samples + (size_t)at * ch;
+        const float* b = s->samples + (size_t)next * ch;
+        out[i * 2] += (a[0] + (b[0] - a[0]) * t) * (l + dl * (float)i);
+        out[i * 2 + 1] += (a[ch - 1] + (b[ch - 1] - a[ch - 1]) * t) * (r + dr * (float)i);
+        v->position += v->step;
+    }
+    return true;
+}
+
+/* Returns false once the stream has ended and drained; running dry before that is silence */
+static bool audio_mix_stream(MixerVoice* v, float* out, int frames, float l, float r, float dl, float dr) {
+    MixerStream* st = &g_audio.streams[v->stream];
+    const int ch = st->channels;
+    const uint32_t mask = st->capacity - 1;
+    /* ended first: once it is seen, write is final */
+    bool ended = atomic_load_explicit(&st->ended, memory_order_acquire);
+    uint32_t read = atomic_load_explicit(&st->read, memory_order_relaxed);
+    uint32_t avail = atomic_load_explicit(&st->write, memory_order_acquire) - read;
+    uint32_t consumed;
+    int done = 0;
+
+    if (v->step == PF_AUDIO_UNITY_STEP) {
+        consumed = avail < (uint32_t)frames ? avail : (uint32_t)frames;
+        while (done < (int)consumed) {
+            uint32_t at = (read + (uint32_t)done) & mask;
+            int n = (int)consumed - done;
+            if (n > (int)(st->capacity - at)) n = (int)(st->capacity - at);
+            audio_mix_span(out + done * 2, st->ring + (size_t)at * ch, ch, n,
+                           l + dl * (float)done, r + dr * (float)done, dl, dr);
+            done += n;
+        }
+    } else {
+        for (; done < frames; done++) {
+            uint32_t at = (uint32_t)(v->position >> 32);
+            /* Interpolation needs the next frame too, unless there will be none */
+            if (at >= avail || (at + 1 >= avail && !ended)) break;
+            const float* a = st->ring + (size_t)((read + at) & mask) * ch;
+            const float* b = at + 1 < avail ? st->ring + (size_t)((read + at + 1) & mask) * ch : a;
+            float t = (float)(uint32_t)v->position * (1.0f / 4294967296.0f);
+            out[done * 2] += (a[0] + (b[0] - a[0]) * t) * (l + dl * (float)done);
+            out[done * 2 + 1] += (a[ch - 1] + (b[ch - 1] - a[ch - 1]) * t) * (r + dr * (float)done);
+            v->position += v->step;
+        }
+        consumed = (uint32_t)(v->position >> 32);
+        if (consumed > avail) consumed = avail;
+        v->position -= (uint64_t)consumed << 32;
+    }
+    atomic_store_explicit(&st->read, read + consumed, memory_order_release);
+
+    if (done < frames) {
+        if (ended && consumed == avail) return false;
+        atomic_fetch_add_explicit(&g_audio.stream_starved, frames - done, memory_order_relaxed);
+    }
+    return true;
+}
+
+/* Returns false when the voice is finished and its slot can be reused */
+static bool audio_mix_voice(MixerVoice* v, float* out, int frames) {
+    if (v->stopping) {
+        v->fade -= v->fade_step;
+        if (v->fade < 0.0f) v->fade = 0.0f;
+    }
+
+    float target[2];
+    audio_voice_target(v, target);
+    /* Paused voices ramp down over one block, then hold their place; a stop
+     * overrides the hold, since a silent voice has nothing left to fade */
+    if (v->paused && v->gain[0] == 0.0f && v->gain[1] == 0.0f) return !v->stopping;
+
+    float dl = (target[0] - v->gain[0]) / (float)frames;
+    float dr = (target[1] - v->gain[1]) / (float)frames;
+    bool alive = v->stream >= 0
+        ? audio_mix_stream(v, out, frames, v->gain[0], v->gain[1], dl, dr)
+        : audio_mix_sound(v, out, frames, v->gain[0], v->gain[1], dl, dr);
+    v->gain[0] = target[0];
+    v->gain[1] = target[1];
+    return alive && !(v->stopping && v->fade == 0.0f);
+}
+
+static void audio_free_voice(int index) {
+    g_audio.voices[index].id = 0;
+    atomic_store_explicit(&g_audio.voice_ids[index], 0, memory_order_release);
+}
+
+static MixerVoice* audio_find_voice(uint32_t id) {
+    if (id == 0) return NULL;
+    for (int i = 0; i < PF_AUDIO_MAX_VOICES; i++) {
+        if (g_audio.voices[i].id == id) return &g_audio.voices[i];
+    }
+    return NULL;
+}
+
+static uint64_t audio_step(int source_rate, float pitch) {
+    if (!(pitch >= 1.0f / 16.0f)) pitch = 1.0f / 16.0f;
+    if (pitch > 16.0f) pitch = 16.0f;
+    double ratio = (double)source_rate / (double)g_audio.rate * (double)pitch;
+    return (uint64_t)(ratio * 4294967296.0 + 0.5);
+}
+
+static int audio_voice_rate(const MixerVoice* v) {
+    return v->stream >= 0 ? g_audio.streams[v->stream].rate : g_audio.sounds[v->sound].rate;
+}
+
+static void audio_stop_voice(MixerVoice* v, float fade_seconds) {
+    float frames = fade_seconds * (float)g_audio.rate;
+    v->stopping = true;
+    /* At least one block of fade, so stopping never clicks */
+    v->fade_step = frames > PF_AUDIO_BLOCK ? (float)PF_AUDIO_BLOCK / frames : 1.0f;
+}
+
+/* Mixer thread; the retire ring has one producer and is sized never to fill */
+static void audio_retire(int32_t handle) {
+    uint32_t write = atomic_load_explicit(&g_audio.retired_write, memory_order_relaxed);
+    g_audio.retired[write & (PF_AUDIO_RETIRE - 1)] = handle;
+    atomic_store_explicit(&g_audio.retired_write, write + 1, memory_order_release);
+}
+
+static float audio_clamp(float value, float lo, float hi) {
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+static void audio_run_command(const AudioCommand* c) {
+    MixerVoice* v = NULL;
+    if (c->type >= PF_AUDIO_CMD_STOP && c->type <= PF_AUDIO_CMD_PAUSE) {
+        v = audio_find_voice(c->voice);
+        if (!v) return;     /* already finished */
+    }
+
+    switch (c->type) {
+        case PF_AUDIO_CMD_PLAY: {
+            bool stream = (c->flags & PF_AUDIO_PLAY_STREAM) != 0;
+            int source = c->source - 1;
+            bool valid = c->voice != 0 && (stream
+                ? source >= 0 && source < PF_AUDIO_MAX_STREAMS && g_audio.streams[source].ring
+                : source >= 0 && source < PF_AUDIO_MAX_SOUNDS && g_audio.sounds[source].samples);
+            int slot = -1;
+            for (int i = 0; valid && i < PF_AUDIO_MAX_VOICES; i++) {
+                /* A stream ring has one consumer; a second voice on it is refused */
+                if (stream && g_audio.voices[i].id != 0 && g_audio.voices[i].stream == source) {
+                    slot = -1;
+                    break;
+                }
+                if (slot < 0 && g_audio.voices[i].id == 0) {
+                    slot = i;
+                    if (!stream) break;
+                }
+            }
+
+            if (slot < 0) {
+                atomic_fetch_add_explicit(&g_audio.voices_rejected, 1, memory_order_relaxed);
+            } else {
+                v = &g_audio.voices[slot];
+                memset(v, 0, sizeof(*v));
+                v->id = c->voice;
+                v->sound = stream ? -1 : source;
+                v->stream = stream ? source : -1;
+                v->volume = c->volume > 0.0f ? c->volume : 0.0f;
+                v->pan = audio_clamp(c->pan, -1.0f, 1.0f);
+                v->pitch = c->pitch;
+                v->step = audio_step(audio_voice_rate(v), c->pitch);
+                v->fade = 1.0f;
+                v->loop = (c->flags & PF_AUDIO_PLAY_LOOP) != 0;
+                v->paused = (c->flags & PF_AUDIO_PLAY_PAUSED) != 0;
+                atomic_store_explicit(&g_audio.voice_ids[slot], c->voice, memory_order_release);
+            }
+            /* After the id is published, so a reader never sees the play as done before it starts */
+            atomic_store_explicit(&g_audio.last_play, c->voice, memory_order_release);
+            break;
+        }
+        case PF_AUDIO_CMD_STOP:
+            audio_stop_voice(v, c->fade);
+            break;
+        case PF_AUDIO_CMD_VOLUME:
+            v->volume = c->volume > 0.0f ? c->volume : 0.0f;
+            break;
+        case PF_AUDIO_CMD_PAN:
+            v->pan = audio_clamp(c->pan, -1.0f, 1.0f);
+            break;
+        case PF_AUDIO_CMD_PITCH:
+            v->pitch = c->pitch;
+            v->step = audio_step(audio_voice_rate(v), c->pitch);
+            break;
+        case PF_AUDIO_CMD_PAUSE:
+            v->paused = c->flags != 0;
+            break;
+        case PF_AUDIO_CMD_MASTER_VOLUME:
+            g_audio.master = c->volume > 0.0f ? c->volume : 0.0f;
+            break;
+        case PF_AUDIO_CMD_STOP_ALL:
+            for (int i = 0; i < PF_AUDIO_MAX_VOICES; i++) {
+                if (g_audio.voices[i].id != 0) audio_stop_voice(&g_audio.voices[i], c->fade);
+            }
+            break;
+        case PF_AUDIO_CMD_RELEASE_SOUND:
+        case PF_AUDIO_CMD_RELEASE_STREAM: {
+            bool stream = c->type == PF_AUDIO_CMD_RELEASE_STREAM;
+            for (int i = 0; i < PF_AUDIO_MAX_VOICES; i++) {
+                MixerVoice* voice = &g_audio.voices[i];
+                if (voice->id != 0 && (stream ? voice->stream : voice->sound) == c->source - 1)
+                    audio_free_voice(i);
+            }
+            audio_retire(stream ? -c->source : c->source);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void audio_drain_commands() {
+    uint32_t read = atomic_load_explicit(&g_audio.command_read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&g_audio.command_write, memory_order_acquire);
+    if (read == write) return;
+
+    for (uint32_t i = read; i != write; i++)
+        audio_run_command(&g_audio.commands[i & (PF_AUDIO_COMMANDS - 1)]);
+    atomic_store_explicit(&g_audio.command_read, write, memory_order_release);
+    atomic_fetch_add_explicit(&g_audio.commands_done, (long long)(write - read), memory_order_relaxed);
+}
+
+static void audio_mix_block(float* dst) {
+    int64_t begin = native_get_ticks();
+    memset(g_audio.mix, 0, sizeof(g_audio.mix));
+
+    int active = 0;
+    for (int i = 0; i < PF_AUDIO_MAX_VOICES; i++) {
+        MixerVoice* v = &g_audio.voices[i];
+        if (v->id == 0) continue;
+        if (audio_mix_voice(v, g_audio.mix, PF_AUDIO_BLOCK)) active++;
+        else audio_free_voice(i);
+    }
+    audio_clip(dst, g_audio.mix, PF_AUDIO_BLOCK * 2);
+
+    int64_t elapsed = native_get_ticks() - begin;
+    atomic_store_explicit(&g_audio.active_voices, active, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_audio.frames_mixed, PF_AUDIO_BLOCK, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_audio.mix_ticks, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_audio.mix_blocks, 1, memory_order_relaxed);
+    if (elapsed > atomic_load_explicit(&g_audio.mix_peak_ticks, memory_order_relaxed))
+        atomic_store_explicit(&g_audio.mix_peak_ticks, elapsed, memory_order_relaxed);
+}
+
+/* Keeps the ring latency_frames ahead of the device, one block at a time */
+static void audio_mixer_main(void* arg) {
+    (void)arg;
+    audio_raise_priority();
+    const int64_t idle = (int64_t)PF_AUDIO_BLOCK * PF_TICKS_PER_SECOND / g_audio.rate / 4;
+
+    while (!atomic_load_explicit(&g_audio.quit, memory_order_acquire)) {
+        audio_drain_commands();
+
+        uint32_t write = atomic_load_explicit(&g_audio.ring_write, memory_order_relaxed);
+        uint32_t read = atomic_load_explicit(&g_audio.ring_read, memory_order_acquire);
+        if (write - read + PF_AUDIO_BLOCK > g_audio.latency_frames) {
+            atomic_store_explicit(&g_audio.primed, true, memory_order_relaxed);
+            sleep_ticks(idle);
+            continue;
+        }
+
+        /* Blocks never straddle the wrap: the ring is a whole number of them */
+        audio_mix_block(g_audio.ring + (write & (PF_AUDIO_RING_FRAMES - 1)) * 2);
+        atomic_store_explicit(&g_audio.ring_write, write + PF_AUDIO_BLOCK, memory_order_release);
+    }
+}
+
+/* Stands in for a device: drains the ring at the output rate */
+static void audio_null_device_main(void* arg) {
+    (void)arg;
+    float block[PF_AUDIO_BLOCK * 2];
+    const int64_t period = (int64_t)PF_AUDIO_BLOCK * PF_TICKS_PER_SECOND / g_audio.rate;
+    int64_t next = native_get_ticks();
+
+    while (!atomic_load_explicit(&g_audio.quit, memory_order_acquire)) {
+        audio_ring_read(block, PF_AUDIO_BLOCK);
+        next += period;
+        int64_t wait = next - native_get_ticks();
+        if (wait > 0) sleep_ticks(wait);
+        else if (wait < -8 * period) next = native_get_ticks();     /* far behind: don't burst */
+    }
+}
+
+#ifdef _WIN32
+
+/* Shared-mode WASAPI, event driven. The GUIDs are spelled out to avoid linking uuid.lib */
+static const GUID pf_CLSID_MMDeviceEnumerator =
+    {0xBCDE0395, 0xE52F, 0x467C, {0x8E, 0x3D, 0xC4, 0x57, 0x92, 0x91, 0x69, 0x2E}};
+static const GUID pf_IID_IMMDeviceEnumerator =
+    {0xA95664D2, 0x9614, 0x4F35, {0xA7, 0x46, 0xDE, 0x8D, 0xB6, 0x36, 0x17, 0xE6}};
+static const GUID pf_IID_IAudioClient =
+    {0x1CB9AD4C, 0xDBFA, 0x4C32, {0xB1, 0x78, 0xC2, 0xF5, 0x68, 0xA7, 0x03, 0xB2}};
+static const GUID pf_IID_IAudioRenderClient =
+    {0xF294ACFC, 0x3146, 0x4483, {0xA7, 0xBF, 0xAD, 0xDC, 0xA7, 0xC2, 0x60, 0xE2}};
+
+#ifndef AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM
+    #define AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM 0x80000000
+#endif
+#ifndef AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY
+    #define AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY 0x08000000
+#endif
+
+static void wasapi_close() {
+    if (g_audio.render) IAudioRenderClient_Release(g_audio.render);
+    if (g_audio.client) IAudioClient_Release(g_audio.client);
+    if (g_audio.event) CloseHandle(g_audio.event);
+    if (g_audio.com_initialized) CoUninitialize();
+    g_audio.render = NULL;
+    g_audio.client = NULL;
+    g_audio.event = NULL;
+    g_audio.com_initialized = false;
+}
+
+/* Float stereo at the shared-mode rate; Windows converts to the device's own layout */
+static bool wasapi_open(int latency_ms) {
+    /* Fails harmlessly when the thread is already in another apartment */
+    g_audio.com_initialized = SUCCEEDED(CoInitializeEx(NULL, COINIT_MULTITHREADED));
+
+    IMMDeviceEnumerator* enumerator = NULL;
+    IMMDevice* device = NULL;
+    HRESULT hr = CoCreateInstance(&pf_CLSID_MMDeviceEnumerator, NULL, CLSCTX_ALL,
+                                  &pf_IID_IMMDeviceEnumerator, (void**)&enumerator);
+    if (SUCCEEDED(hr)) {
+        hr = IMMDeviceEnumerator_GetDefaultAudioEndpoint(enumerator, eRender, eConsole, &device);
+        IMMDeviceEnumerator_Release(enumerator);
+    }
+    if (SUCCEEDED(hr)) {
+        hr = IMMDevice_Activate(device, &pf_IID_IAudioClient, CLSCTX_ALL, NULL, (void**)&g_audio.client);
+        IMMDevice_Release(device);
+    }
+    if (FAILED(hr)) {
+        wasapi_close();
+        return false;
+    }
+
+    WAVEFORMATEX* mix_format = NULL;
+    if (SUCCEEDED(IAudioClient_GetMixFormat(g_audio.client, &mix_format))) {
+        g_audio.rate = (int)mix_format->nSamplesPerSec;
+        CoTaskMemFree(mix_format);
+    }
+
+    WAVEFORMATEX format;
+    memset(&format, 0, sizeof(format));
+    format.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    format.nChannels = 2;
+    format.nSamplesPerSec = (DWORD)g_audio.rate;
+    format.wBitsPerSample = 32;
+    format.nBlockAlign = (WORD)(2 * sizeof(float));
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+    REFERENCE_TIME duration = (REFERENCE_TIME)latency_ms * 10000;
+    hr = IAudioClient_Initialize(g_audio.client, AUDCLNT_SHAREMODE_SHARED,
+                                 AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+                                 AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
+                                 duration, 0, &format, NULL);
+    if (SUCCEEDED(hr)) {
+        g_audio.event = CreateEventW(NULL, FALSE, FALSE, NULL);
+        hr = g_audio.event ? IAudioClient_SetEventHandle(g_audio.client, g_audio.event) : E_FAIL;
+    }
+    if (SUCCEEDED(hr)) hr = IAudioClient_GetBufferSize(g_audio.client, &g_audio.device_frames);
+    if (SUCCEEDED(hr)) hr = IAudioClient_GetService(g_audio.client, &pf_IID_IAudioRenderClient, (void**)&g_audio.render);
+    if (FAILED(hr)) {
+        printf("WASAPI initialization failed (0x%08lx)\n", (unsigned long)hr);
+        wasapi_close();
+        return false;
+    }
+    return true;
+}
+
+static void wasapi_render_main(void* arg) {
+    (void)arg;
+    bool com = SUCCEEDED(CoInitializeEx(NULL, COINIT_MULTITHREADED));
+    audio_raise_priority();
+    IAudioClient_Start(g_audio.client);
+
+    while (!atomic_load_explicit(&g_audio.quit, memory_order_acquire)) {
+        if (WaitForSingleObject(g_audio.event, 100) != WAIT_OBJECT_0) continue;
+
+        UINT32 padding = 0;
+        BYTE* data = NULL;
+        /* A lost device leaves the stream silent rather than spinning */
+        if (FAILED(IAudioClient_GetCurrentPadding(g_audio.client, &padding))) break;
+        UINT32 frames = g_audio.device_frames - padding;
+        if (frames == 0 || FAILED(IAudioRenderClient_GetBuffer(g_audio.render, frames, &data))) continue;
+        audio_ring_read((float*)data, frames);
+        IAudioRenderClient_ReleaseBuffer(g_audio.render, frames, 0);
+    }
+
+    IAudioClient_Stop(g_audio.client);
+    if (com) CoUninitialize();
+}
+
+#elif defined(__APPLE__)
+
+#define PF_AUDIO_QUEUE_BUFFERS 3
+
+/* AudioQueue's own thread; refills and requeues each buffer it hands back */
+static void coreaudio_callback(void* user, AudioQueueRef queue, AudioQueueBufferRef buffer) {
+    (void)user;
+    uint32_t frames = buffer->mAudioDataBytesCapacity / (2 * sizeof(float));
+    audio_ring_read((float*)buffer->mAudioData, frames);
+    buffer->mAudioDataByteSize = frames * 2 * sizeof(float);
+    AudioQueueEnqueueBuffer(queue, buffer, 0, NULL);
+}
+
+static void coreaudio_close() {
+    if (!g_audio.queue) return;
+    AudioQueueStop(g_audio.queue, true);
+    AudioQueueDispose(g_audio.queue, true);
+    g_audio.queue = NULL;
+}
+
+static bool coreaudio_open() {
+    AudioStreamBasicDescription format;
+    memset(&format, 0, sizeof(format));
+    format.mSampleRate = g_audio.rate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kLinearPCMFormatFlagIsFloat | kLinearPCMFormatFlagIsPacked;
+    format.mFramesPerPacket = 1;
+    format.mChannelsPerFrame = 2;
+    format.mBitsPerChannel = 32;
+    format.mBytesPerFrame = 2 * sizeof(float);
+    format.mBytesPerPacket = format.mBytesPerFrame;
+
+    /* NULL run loop: callbacks come on the queue's internal thread */
+    if (AudioQueueNewOutput(&format, coreaudio_callback, NULL, NULL, NULL, 0, &g_audio.queue) != noErr) {
+        g_audio.queue = NULL;
+        return false;
+    }
+
+    uint32_t frames = g_audio.latency_frames / 2 > PF_AUDIO_BLOCK ? g_audio.latency_frames / 2 : PF_AUDIO_BLOCK;
+    UInt32 bytes = frames * format.mBytesPerFrame;
+    for (int i = 0; i < PF_AUDIO_QUEUE_BUFFERS; i++) {
+        AudioQueueBufferRef buffer = NULL;
+        if (AudioQueueAllocateBuffer(g_audio.queue, bytes, &buffer) != noErr) {
+            coreaudio_close();
+            return false;
+        }
+        memset(buffer->mAudioData, 0, bytes);
+        buffer->mAudioDataByteSize = bytes;
+        AudioQueueEnqueueBuffer(g_audio.queue, buffer, 0, NULL);
+    }
+    if (AudioQueueStart(g_audio.queue, NULL) != noErr) {
+        coreaudio_close();
+        return false;
+    }
+    return true;
+}
+
+#else
+
+/*
+ * ALSA through dlopen, like libEGL: machines without libasound run on the null
+ * device instead of failing to load the engine. 16-bit stereo via the "default"
+ * PCM, which routes through PulseAudio/PipeWire where they run.
+ */
+#define PF_SND_PCM_STREAM_PLAYBACK 0
+#define PF_SND_PCM_FORMAT_S16_LE 2
+#define PF_SND_PCM_ACCESS_RW_INTERLEAVED 3
+
+typedef struct {
+    void* library;
+    void* pcm;
+    int (*pcm_open)(void** pcm, const char* name, int stream, int mode);
+    int (*pcm_set_params)(void* pcm, int format, int access, unsigned int channels, unsigned int rate,
+                          int soft_resample, unsigned int latency_us);
+    long (*pcm_writei)(void* pcm, const void* buffer, unsigned long frames);
+    int (*pcm_recover)(void* pcm, int err, int silent);
+    int (*pcm_close)(void* pcm);
+} AlsaState;
+
+static AlsaState g_alsa = {0};
+
+static void alsa_close() {
+    if (g_alsa.pcm) g_alsa.pcm_close(g_alsa.pcm);
+    if (g_alsa.library) dlclose(g_alsa.library);
+    memset(&g_alsa, 0, sizeof(g_alsa));
+}
+
+static bool alsa_open() {
+    g_alsa.library = dlopen("libasound.so.2", RTLD_NOW | RTLD_LOCAL);
+    if (!g_alsa.library) return false;
+
+    #define PF_ALSA_LOAD(field, name) *(void**)&g_alsa.field = dlsym(g_alsa.library, name)
+    PF_ALSA_LOAD(pcm_open, "snd_pcm_open");
+    PF_ALSA_LOAD(pcm_set_params, "snd_pcm_set_params");
+    PF_ALSA_LOAD(pcm_writei, "snd_pcm_writei");
+    PF_ALSA_LOAD(pcm_recover, "snd_pcm_recover");
+    PF_ALSA_LOAD(pcm_close, "snd_pcm_close");
+    #undef PF_ALSA_LOAD
+
+    if (!g_alsa.pcm_open || !g_alsa.pcm_set_params || !g_alsa.pcm_writei ||
+        !g_alsa.pcm_recover || !g_alsa.pcm_close) {
+        alsa_close();
+        return false;
+    }
+    if (g_alsa.pcm_open(&g_alsa.pcm, "default", PF_SND_PCM_STREAM_PLAYBACK, 0) < 0) {
+        g_alsa.pcm = NULL;
+        alsa_close();
+        return false;
+    }
+
+    unsigned int latency_us = (unsigned int)((uint64_t)g_audio.latency_frames * 1000000 / (uint64_t)g_audio.rate);
+    if (g_alsa.pcm_set_params(g_alsa.pcm, PF_SND_PCM_FORMAT_S16_LE, PF_SND_PCM_ACCESS_RW_INTERLEAVED,
+                              2, (unsigned int)g_audio.rate, 1, latency_us) < 0) {
+        printf("ALSA: default device rejected %d Hz stereo\n", g_audio.rate);
+        alsa_close();
+        return false;
+    }
+    return true;
+}
+
+/* Blocking writes pace this thread to the device */
+static void alsa_writer_main(void* arg) {
+    (void)arg;
+    float block[PF_AUDIO_BLOCK * 2];
+    int16_t pcm[PF_AUDIO_BLOCK * 2];
+    audio_raise_priority();
+
+    while (!atomic_load_explicit(&g_audio.quit, memory_order_acquire)) {
+        audio_ring_read(block, PF_AUDIO_BLOCK);
+        audio_to_s16(pcm, block, PF_AUDIO_BLOCK * 2);
+
+        const int16_t* at = pcm;
+        long left = PF_AUDIO_BLOCK;
+        while (left > 0 && !atomic_load_explicit(&g_audio.quit, memory_order_relaxed)) {
+            long written = g_alsa.pcm_writei(g_alsa.pcm, at, (unsigned long)left);
+            if (written < 0) {
+                /* Underrun (-EPIPE) or suspend: recover and rewrite; otherwise drop the block */
+                if (g_alsa.pcm_recover(g_alsa.pcm, (int)written, 1) < 0) break;
+                continue;
+            }
+            at += written * 2;
+            left -= written;
+        }
+    }
+}
+
+#endif
+
+static void audio_device_close() {
+    #ifdef _WIN32
+        wasapi_close();
+    #elif defined(__APPLE__)
+        coreaudio_close();
+    #else
+        alsa_close();
+    #endif
+}
+
+static uint32_t audio_latency_frames(int latency_ms) {
+    uint32_t frames = (uint32_t)((int64_t)g_audio.rate * latency_ms / 1000);
+    frames = (frames + PF_AUDIO_BLOCK - 1) / PF_AUDIO_BLOCK * PF_AUDIO_BLOCK;
+    if (frames < 2 * PF_AUDIO_BLOCK) frames = 2 * PF_AUDIO_BLOCK;
+    if (frames > PF_AUDIO_RING_FRAMES - 2 * PF_AUDIO_BLOCK) frames = PF_AUDIO_RING_FRAMES - 2 * PF_AUDIO_BLOCK;
+    return frames;
+}
+
+/*
+ * Opens the default output device and starts the mixer. latency_ms is how far the mixer
+ * renders ahead of the device (0 = 20 ms). null_device skips the hardware, for headless runs;
+ * without a usable device the null device is used as well. Returns the PF_AUDIO_BACKEND_*
+ * in use, 0 on failure.
+ */
+int native_audio_init(int latency_ms, int null_device) {
+    if (g_audio.initialized) return g_audio.backend;
+    if (latency_ms <= 0) latency_ms = PF_AUDIO_DEFAULT_LATENCY_MS;
+
+    g_audio.rate = PF_AUDIO_DEFAULT_RATE;
+    g_audio.master = 1.0f;
+    g_audio.latency_frames = audio_latency_frames(latency_ms);
+    atomic_store(&g_audio.quit, false);
+
+    int backend = PF_AUDIO_BACKEND_NULL;
+    if (!null_device) {
+        #ifdef _WIN32
+            if (wasapi_open(latency_ms)) {
+                backend = PF_AUDIO_BACKEND_WASAPI;
+                g_audio.latency_frames = audio_latency_frames(latency_ms);     /* the device picks the rate */
+            }
+        #elif defined(__APPLE__)
+            if (coreaudio_open()) backend = PF_AUDIO_BACKEND_COREAUDIO;
+        #else
+            if (alsa_open()) backend = PF_AUDIO_BACKEND_ALSA;
+        #endif
+        if (backend == PF_AUDIO_BACKEND_NULL) printf("Audio: no output device, using the null device\n");
+    }
+
+    if (!pf_thread_start(&g_audio.mixer_thread, audio_mixer_main, NULL)) {
+        printf("Failed to start the audio mixer thread\n");
+        audio_device_close();
+        memset(&g_audio, 0, sizeof(g_audio));
+        return 0;
+    }
+
+    pf_thread_fn device_main = NULL;
+    if (backend == PF_AUDIO_BACKEND_NULL) device_main = audio_null_device_main;
+    #ifdef _WIN32
+        if (backend == PF_AUDIO_BACKEND_WASAPI) device_main = wasapi_render_main;
+    #elif !defined(__APPLE__)
+        if (backend == PF_AUDIO_BACKEND_ALSA) device_main = alsa_writer_main;
+    #endif
+    if (device_main)
+        g_audio.device_thread_running = pf_thread_start(&g_audio.device_thread, device_main, NULL);
+
+    g_audio.backend = backend;
+    g_audio.initialized = true;
+    return backend;
+}
+
+/* Stops the threads and frees every sound and stream */
+void native_audio_shutdown() {
+    if (!g_audio.initialized) return;
+    atomic_store(&g_audio.quit, true);
+    pf_thread_join(g_audio.mixer_thread);
+    if (g_audio.device_thread_running) pf_thread_join(g_audio.device_thread);
+    audio_device_close();
+
+    for (int i = 0; i < PF_AUDIO_MAX_SOUNDS; i++) free(g_audio.sounds[i].samples);
+    for (int i = 0; i < PF_AUDIO_MAX_STREAMS; i++) free(g_audio.streams[i].ring);
+    memset(&g_audio, 0, sizeof(g_audio));
+}
+
+/* Main thread only: the command queue has a single producer. Returns 0 when the queue is full */
+int native_audio_push(const AudioCommand* command) {
+    if (!g_audio.initialized) return 0;
+    uint32_t write = atomic_load_explicit(&g_audio.command_write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&g_audio.command_read, memory_order_acquire);
+    if (write - read == PF_AUDIO_COMMANDS) {
+        atomic_fetch_add_explicit(&g_audio.commands_dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+    g_audio.commands[write & (PF_AUDIO_COMMANDS - 1)] = *command;
+    atomic_store_explicit(&g_audio.command_write, write + 1, memory_order_release);
+    return 1;
+}
+
+/* Frees what the mixer has let go of. Main thread, once per frame; returns how many */
+int native_audio_update() {
+    uint32_t read = atomic_load_explicit(&g_audio.retired_read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&g_audio.retired_write, memory_order_acquire);
+    int freed = 0;
+    for (; read != write; read++, freed++) {
+        int32_t handle = g_audio.retired[read & (PF_AUDIO_RETIRE - 1)];
+        if (handle > 0) {
+            MixerSound* sound = &g_audio.sounds[handle - 1];
+            free(sound->samples);
+            memset(sound, 0, sizeof(*sound));
+        } else {
+            MixerStream* stream = &g_audio.streams[-handle - 1];
+            free(stream->ring);
+            memset(stream, 0, sizeof(*stream));
+        }
+    }
+    atomic_store_explicit(&g_audio.retired_read, read, memory_order_release);
+    return freed;
+}
+
+/* 1 while the voice is queued or playing; 0 once it has finished, been stopped or was rejected */
+int native_audio_voice_active(uint32_t voice) {
+    if (!g_audio.initialized || voice == 0) return 0;
+    uint32_t last = atomic_load_explicit(&g_audio.last_play, memory_order_acquire);
+    if ((int32_t)(voice - last) > 0) return 1;     /* the mixer hasn't reached its PLAY yet */
+    for (int i = 0; i < PF_AUDIO_MAX_VOICES; i++) {
+        if (atomic_load_explicit(&g_audio.voice_ids[i], memory_order_acquire) == voice) return 1;
+    }
+    return 0;
+}
+
+/* Copies frames of interleaved mono or stereo samples. Main thread only; returns a handle or 0 */
+int native_audio_sound_create(const float* samples, int frames, int channels, int rate) {
+    if (!samples || frames <= 0 || (channels != 1 && channels != 2) || rate <= 0) return 0;
+
+    for (int i = 0; i < PF_AUDIO_MAX_SOUNDS; i++) {
+        MixerSound* sound = &g_audio.sounds[i];
+        if (sound->samples || sound->releasing) continue;
+
+        size_t bytes = (size_t)frames * (size_t)channels * sizeof(float);
+        sound->samples = (float*)malloc(bytes);
+        if (!sound->samples) return 0;
+        memcpy(sound->samples, samples, bytes);
+        sound->frames = frames;
+        sound->channels = channels;
+        sound->rate = rate;
+        return i + 1;
+    }
+    printf("Too many sounds loaded (max %d)\n", PF_AUDIO_MAX_SOUNDS);
+    return 0;
+}
+
+/*
+ * Stops voices playing the sound and frees it once the mixer lets go (see native_audio_update).
+ * Returns 0 if the command queue is full; call again later.
+ */
+int native_audio_sound_release(int sound) {
+    if (sound <= 0 || sound > PF_AUDIO_MAX_SOUNDS) return 1;
+    MixerSound* s = &g_audio.sounds[sound - 1];
+    if (!s->samples || s->releasing) return 1;
+
+    if (!g_audio.initialized) {
+        free(s->samples);
+        memset(s, 0, sizeof(*s));
+        return 1;
+    }
+    AudioCommand command;
+    memset(&command, 0, sizeof(command));
+    command.type = PF_AUDIO_CMD_RELEASE_SOUND;
+    command.source = sound;
+    if (!native_audio_push(&command)) return 0;
+    s->releasing = true;
+    return 1;
+}
+
+static MixerStream* audio_get_stream(int stream) {
+    if (stream <= 0 || stream > PF_AUDIO_MAX_STREAMS) return NULL;
+    MixerStream* st = &g_audio.streams[stream - 1];
+    return st->ring && !st->releasing ? st : NULL;
+}
+
+/* A ring of at least capacity_frames for a decoder to fill. Main thread only; returns a handle or 0 */
+int native_audio_stream_create(int channels, int rate, int capacity_frames) {
+    if ((channels != 1 && channels != 2) || rate <= 0) return 0;
+    uint32_t capacity = 4 * PF_AUDIO_BLOCK;
+    while (capacity < (uint32_t)capacity_frames && capacity < (1u << 24)) capacity <<= 1;
+
+    for (int i = 0; i < PF_AUDIO_MAX_STREAMS; i++) {
+        MixerStream* st = &g_audio.streams[i];
+        if (st->ring || st->releasing) continue;
+
+        st->ring = (float*)calloc((size_t)capacity * (size_t)channels, sizeof(float));
+        if (!st->ring) return 0;
+        st->capacity = capacity;
+        st->channels = channels;
+        st->rate = rate;
+        atomic_store(&st->write, 0);
+        atomic_store(&st->read, 0);
+        atomic_store(&st->ended, false);
+        return i + 1;
+    }
+    printf("Too many audio streams (max %d)\n", PF_AUDIO_MAX_STREAMS);
+    return 0;
+}
+
+/* Free frames in the ring */
+int native_audio_stream_space(int stream) {
+    MixerStream* st = audio_get_stream(stream);
+    if (!st) return 0;
+    uint32_t used = atomic_load_explicit(&st->write, memory_order_relaxed) -
+                    atomic_load_explicit(&st->read, memory_order_acquire);
+    return (int)(st->capacity - used);
+}
+
+/* Producer side, one writer at a time (the stream's decode job). Returns the frames accepted */
+int native_audio_stream_write(int stream, const float* samples, int frames) {
+    MixerStream* st = audio_get_stream(stream);
+    if (!st || !samples || frames <= 0) return 0;
+
+    uint32_t write = atomic_load_explicit(&st->write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&st->read, memory_order_acquire);
+    uint32_t n = st->capacity - (write - read);
+    if (n > (uint32_t)frames) n = (uint32_t)frames;
+
+    uint32_t start = write & (st->capacity - 1);
+    uint32_t first = st->capacity - start;
+    if (first > n) first = n;
+    size_t frame_bytes = (size_t)st->channels * sizeof(float);
+    memcpy(st->ring + (size_t)start * st->channels, samples, first * frame_bytes);
+    memcpy(st->ring, samples + (size_t)first * st->channels, (n - first) * frame_bytes);
+
+    atomic_store_explicit(&st->write, write + n, memory_order_release);
+    return (int)n;
+}
+
+/* Marks the last frame written: voices finish when they reach it instead of waiting for more */
+void native_audio_stream_end(int stream) {
+    MixerStream* st = audio_get_stream(stream);
+    if (st) atomic_store_explicit(&st->ended, true, memory_order_release);
+}
+
+/* As native_audio_sound_release; the caller must have stopped writing to it */
+int native_audio_stream_release(int stream) {
+    MixerStream* st = audio_get_stream(stream);
+    if (!st) return 1;
+
+    if (!g_audio.initialized) {
+        free(st->ring);
+        memset(st, 0, sizeof(*st));
+        return 1;
+    }
+    AudioCommand command;
+    memset(&command, 0, sizeof(command));
+    command.type = PF_AUDIO_CMD_RELEASE_STREAM;
+    command.source = stream;
+    if (!native_audio_push(&command)) return 0;
+    st->releasing = true;
+    return 1;
+}
+
+void native_audio_get_stats(AudioStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!g_audio.initialized) return;
+
+    double us_per_tick = 1000000.0 / (double)native_get_tick_frequency();
+    long long blocks = atomic_load(&g_audio.mix_blocks);
+    stats->backend = g_audio.backend;
+    stats->sample_rate = g_audio.rate;
+    stats->latency_frames = (int32_t)g_audio.latency_frames;
+    stats->active_voices = atomic_load(&g_audio.active_voices);
+    stats->frames_mixed = atomic_load(&g_audio.frames_mixed);
+    stats->underruns = atomic_load(&g_audio.underruns);
+    stats->commands = atomic_load(&g_audio.commands_done);
+    stats->commands_dropped = atomic_load(&g_audio.commands_dropped);
+    stats->voices_rejected = atomic_load(&g_audio.voices_rejected);
+    stats->stream_starved = atomic_load(&g_audio.stream_starved);
+    stats->mix_avg_us = blocks > 0 ? (double)atomic_load(&g_audio.mix_ticks) * us_per_tick / (double)blocks : 0.0;
+    stats->mix_peak_us = (double)atomic_load(&g_audio.mix_peak_ticks) * us_per_tick;
+}
+
+/* ============================================================================
+ * MEMORY AND PERFORMANCE UTILITIES
+ * ============================================================================ */
+
+/* Layout shared with MemoryStats in bindings.cs - keep in sync. -1 = unknown */
+typedef struct {
+    int64_t resident_bytes;
+    int64_t peak_resident_bytes;
+    int64_t virtual_bytes;
+    int64_t committed_bytes;
+    int64_t gpu_total_bytes;
+    int64_t gpu_available_bytes;
+} MemoryStats;
+
+/* GL_NVX_gpu_memory_info / GL_ATI_meminfo tokens (values in KB) */
+#define PF_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define PF_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define PF_TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+static void render_call_memory_stats_gpu(void* args);
+
+static void memory_stats_gpu(MemoryStats* stats) {
+    /* Needs a current context; the queries themselves are cheap */
+    if (!g_window.is_open) return;
+
+    if (render_deferred()) {
+        render_call(render_call_memory_stats_gpu, stats);
+        return;
+    }
+
+    if (g_gl.gpu_memory_nvx) {
+        GLint total_kb = 0, available_kb = 0;
+        glGetIntegerv(PF_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total_kb);
+        glGetIntegerv(PF_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available_kb);
+        stats->gpu_total_bytes = (int64_t)total_kb * 1024;
+        stats->gpu_available_bytes = (int64_t)available_kb * 1024;
+    } else if (g_gl.gpu_memory_ati) {
+        /* [0] = total free in the pool; ATI exposes no total size */
+        GLint info[4] = {0};
+        glGetIntegerv(PF_TEXTURE_FREE_MEMORY_ATI, info);
+        stats->gpu_available_bytes = (int64_t)info[0] * 1024;
+    }
+}
+
+static void render_call_memory_stats_gpu(void* args) {
+    memory_stats_gpu((MemoryStats*)args);
+}
+
+int native_get_memory_stats(MemoryStats* stats) {
+    stats->resident_bytes = -1;
+    stats->peak_resident_bytes = -1;
+    stats->virtual_bytes = -1;
+    stats->committed_bytes = -1;
+    stats->gpu_total_bytes = -1;
+    stats->gpu_available_bytes = -1;
+
+    int ok = 0;
+
+    #ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS_EX pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
+            stats->resident_bytes = (int64_t)pmc.WorkingSetSize;
+            stats->peak_resident_bytes = (int64_t)pmc.PeakWorkingSetSize;
+            stats->committed_bytes = (int64_t)pmc.PrivateUsage;
+            ok = 1;
+        }
+        MEMORYSTATUSEX status;
+        status.dwLength = sizeof(status);
+        if (GlobalMemoryStatusEx(&status)) {
+            stats->virtual_bytes = (int64_t)(status.ullTotalVirtual - status.ullAvailVirtual);
+        }
+    #elif __APPLE__
+        mach_task_basic_info_data_t info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+            stats->resident_bytes = (int64_t)info.resident_size;
+            stats->peak_resident_bytes = (int64_t)info.resident_size_max;
+            stats->virtual_bytes = (int64_t)info.virtual_size;
+            ok = 1;
+        }
+    #else
+        /* statm: size resident shared text lib data dt, in pages */
+        FILE* file = fopen("/proc/self/statm", "r");
+        if (file) {
+            long long size = 0, resident = 0, shared = 0, text = 0, lib = 0, data = 0;
+            if (fscanf(file, "%lld %lld %lld %lld %lld %lld", &size, &resident, &shared, &text, &lib, &data) == 6) {
+                int64_t page = (int64_t)sysconf(_SC_PAGESIZE);
+                stats->virtual_bytes = size * page;
+                stats->resident_bytes = resident * page;
+                stats->committed_bytes = data * page;
+                ok = 1;
+            }
+            fclose(file);
+        }
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            stats->peak_resident_bytes = (int64_t)usage.ru_maxrss * 1024;
+        }
+    #endif
+
+    memory_stats_gpu(stats);
+    return ok;
+}
+
+long native_get_memory_usage() {
+    MemoryStats stats;
+    if (!native_get_memory_stats(&stats) || stats.resident_bytes < 0) return 0;
+    return (long)stats.resident_bytes;
+}
+
+double native_get_time() {
+    return (double)native_get_ticks() / PF_TICKS_PER_SECOND;
 }
\ No newline at end of file
@@ -1 +1,398 @@
-// Rendering system placeholder
+/*
+ * PyFlare Engine - Rendering System
+ * 2D sprite batching, view culling and textures on top of the native platform layer
+ */
+
+using System;
+using System.Buffers.Binary;
+using System.Numerics;
+using System.Threading;
+using PyFlare.Engine.Core;
+using PyFlare.Engine.Platform;
+
+namespace PyFlare.Engine.Rendering
+{
+    /// <summary>
+    /// Collects sprites for a frame and hands them to native code in a single call.
+    /// Sorting by layer/shader/texture happens natively, so draw order within a layer is submission order.
+    /// </summary>
+    public class SpriteBatch
+    {
+        private SpriteInstance[] sprites;
+        private int count;
+        private int lastDrawCalls;
+
+        public SpriteBatch(int initialCapacity = 1024)
+        {
+            sprites = new SpriteInstance[Math.Max(16, initialCapacity)];
+            count = 0;
+            lastDrawCalls = 0;
+        }
+
+        public void Draw(float x, float y, float width, float height,
+            uint texture = 0, uint color = 0xFFFFFFFF, int layer = 0)
+        {
+            Draw(x, y, width, height, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, texture, color, layer, 0);
+        }
+
+        public void Draw(float x, float y, float width, float height,
+            float u0, float v0, float u1, float v1, float rotation,
+            uint texture, uint color, int layer, uint shader)
+        {
+            if (count == sprites.Length)
+                Array.Resize(ref sprites, sprites.Length * 2);
+
+            ref SpriteInstance s = ref sprites[count++];
+            s.x = x;
+            s.y = y;
+            s.width = width;
+            s.height = height;
+            s.u0 = u0;
+            s.v0 = v0;
+            s.u1 = u1;
+            s.v1 = v1;
+            s.rotation = rotation;
+            s.color = color;
+            s.texture = texture;
+            s.shader = shader;
+            s.layer = layer;
+        }
+
+        public void Draw(ref SpriteInstance sprite)
+        {
+            if (count == sprites.Length)
+                Array.Resize(ref sprites, sprites.Length * 2);
+
+            sprites[count++] = sprite;
+        }
+
+        /// <summary>Appends n uninitialized slots for the caller to fill, e.g. from jobs</summary>
+        internal SpriteInstance[] Append(int n, out int start)
+        {
+            if (count + n > sprites.Length)
+                Array.Resize(ref sprites, Math.Max(sprites.Length * 2, count + n));
+            start = count;
+            count += n;
+            return sprites;
+        }
+
+        /// <summary>
+        /// Submits every queued sprite with one P/Invoke and clears the batch.
+        /// With the render thread the sprites are copied and the draw-call count is the previous frame's.
+        /// </summary>
+        public int Flush()
+        {
+            if (count == 0 || !Platform.Platform.IsInitialized())
+            {
+                count = 0;
+                return 0;
+            }
+
+            unsafe
+            {
+                fixed (SpriteInstance* data = sprites)
+                    lastDrawCalls = NativeCalls.SubmitBatch(data, count);
+            }
+            count = 0;
+
+            if (lastDrawCalls < 0)
+                Console.WriteLine("Sprite batch submission failed");
+
+            return lastDrawCalls;
+        }
+
+        public int GetSpriteCount() => count;
+        public int GetLastDrawCalls() => lastDrawCalls;
+    }
+
+    /// <summary>
+    /// Hands a SpriteBatch only the sprites that overlap the view. Entities with Transform2D and
+    /// SpriteComponent are tracked in a loose grid keyed by entity index. Position is the sprite's
+    /// center and Size is scaled by Transform2D.Scale. Draw order within a layer is unspecified.
+    /// </summary>
+    public sealed class SpriteCuller
+    {
+        // Below this many visible sprites the batch is filled on the calling thread
+        private const int ParallelFillThreshold = 4096;
+
+        private readonly World world;
+        private readonly Query query;
+        private readonly SpatialGrid2D grid;
+        private readonly VisibleSet visible = new VisibleSet();
+        private readonly Action<Chunk> updateChunk;
+        private int[] proxyOf = new int[1024];    // grid proxy + 1 per entity index, 0 = not tracked
+        private int[] seenIn = new int[1024];     // UpdateBounds pass that last saw the entity
+        private int pass = 0;
+
+        public SpriteCuller(World world, float cellSize = 128.0f)
+        {
+            this.world = world;
+            query = world.CreateQuery<Transform2D, SpriteComponent>();
+            grid = new SpatialGrid2D(cellSize);
+            updateChunk = UpdateChunk;
+        }
+
+        public SpatialGrid2D Grid => grid;
+        public VisibleSet Visible => visible;
+        public CullStats LastCull => grid.LastCull;
+
+        public static Aabb2 GetBounds(in Transform2D transform, in SpriteComponent sprite)
+        {
+            Vector2 half = Vector2.Abs(sprite.Size * transform.Scale) * 0.5f;
+            if (transform.Rotation != 0.0f)
+            {
+                float c = MathF.Abs(MathF.Cos(transform.Rotation));
+                float s = MathF.Abs(MathF.Sin(transform.Rotation));
+                half = new Vector2(c * half.X + s * half.Y, s * half.X + c * half.Y);
+            }
+            return Aabb2.FromCenter(transform.Position, half);
+        }
+
+        /// <summary>
+        /// Brings the grid in line with the world: new sprites are inserted, moved ones updated
+        /// (in place unless they change cell) and vanished ones removed. Call once per frame,
+        /// after whatever moves things.
+        /// </summary>
+        public void UpdateBounds()
+        {
+            pass++;
+            query.ForEachChunk(updateChunk);
+
+            for (int i = 0; i < proxyOf.Length; i++)
+            {
+                if (proxyOf[i] != 0 && seenIn[i] != pass)
+                {
+                    grid.Remove(proxyOf[i] - 1);
+                    proxyOf[i] = 0;
+                }
+            }
+        }
+
+        private void UpdateChunk(Chunk chunk)
+        {
+            Span<Transform2D> transforms = chunk.GetSpan<Transform2D>();
+            Span<SpriteComponent> sprites = chunk.GetSpan<SpriteComponent>();
+            int[] entities = chunk.entities;
+
+            for (int i = 0; i < transforms.Length; i++)
+            {
+                int index = entities[i];
+                if (index >= proxyOf.Length)
+                {
+                    int size = Math.Max(proxyOf.Length * 2, index + 1);
+                    Array.Resize(ref proxyOf, size);
+                    Array.Resize(ref seenIn, size);
+                }
+
+                Aabb2 bounds = GetBounds(transforms[i], sprites[i]);
+                if (proxyOf[index] == 0)
+                    proxyOf[index] = grid.Insert(bounds, index) + 1;
+                else
+                    grid.Update(proxyOf[index] - 1, bounds);
+                seenIn[index] = pass;
+            }
+        }
+
+        /// <summary>
+        /// Culls against view (world units) and queues what is visible, with view.Min at the
+        /// screen origin. Returns the number of sprites queued.
+        /// </summary>
+        public int Draw(SpriteBatch batch, in Aabb2 view)
+        {
+            grid.Cull(view, visible);
+            int n = visible.Count;
+            if (n == 0)
+                return 0;
+
+            SpriteInstance[] output = batch.Append(n, out int start);
+            int[] values = visible.values;
+            Vector2 origin = view.Min;
+
+            if (n < ParallelFillThreshold || Jobs.WorkerCount <= 1)
+            {
+                for (int i = 0; i < n; i++)
+                    Fill(ref output[start + i], values[i], origin);
+            }
+            else
+            {
+                Jobs.ParallelFor(n, i => Fill(ref output[start + i], values[i], origin));
+            }
+            return n;
+        }
+
+        private void Fill(ref SpriteInstance s, int index, Vector2 origin)
+        {
+            // Destroyed since UpdateBounds: the slot is already in the batch, so leave it empty
+            if (!world.TryLocate(index, out Chunk chunk, out int row) || !chunk.Archetype.Has(ComponentType<SpriteComponent>.Id))
+            {
+                s = default;
+                return;
+            }
+
+            ref Transform2D t = ref chunk.GetSpan<Transform2D>()[row];
+            ref SpriteComponent sprite = ref chunk.GetSpan<SpriteComponent>()[row];
+            Vector2 size = sprite.Size * t.Scale;
+            s.x = t.Position.X - size.X * 0.5f - origin.X;
+            s.y = t.Position.Y - size.Y * 0.5f - origin.Y;
+            s.width = size.X;
+            s.height = size.Y;
+            s.u0 = sprite.UV.X;
+            s.v0 = sprite.UV.Y;
+            s.u1 = sprite.UV.Z;
+            s.v1 = sprite.UV.W;
+            s.rotation = t.Rotation;
+            s.color = sprite.Color;
+            s.texture = sprite.Texture;
+            s.shader = sprite.Shader;
+            s.layer = sprite.Layer;
+        }
+    }
+
+    /// <summary>
+    /// Texture loaded from a .pftx file (written by `build.py texture`), mips included.
+    /// LoadData only parses the header; pixel data stays where OpenData put it, which for
+    /// packed assets is the archive mapping itself. Upload queues every level for the native
+    /// PBO uploader, so the texture becomes usable a frame or more later (see IsResident).
+    /// </summary>
+    public class Texture : Resource
+    {
+        public const uint Magic = 0x58544650;   // "PFTX"
+        public const uint Version = 1;
+        private const int HeaderSize = 32;
+
+        private uint textureId;
+        private int width;
+        private int height;
+        private int levels;
+        private TextureFormat format;
+        private ResourceData data;
+        private int[] levelOffsets;
+        private int[] levelSizes;
+
+        public override void LoadData(string path, CancellationToken token)
+        {
+            base.LoadData(path, token);
+
+            data = ResourceLoader.OpenData(path);
+            if (!data.IsValid)
+                throw new System.IO.FileNotFoundException($"Texture not found: {path}");
+
+            ReadOnlySpan<byte> bytes = data.Span;
+            if (bytes.Length < HeaderSize ||
+                BinaryPrimitives.ReadUInt32LittleEndian(bytes) != Magic ||
+                BinaryPrimitives.ReadUInt32LittleEndian(bytes.Slice(4)) != Version)
+                throw new InvalidOperationException($"Not a version {Version} .pftx file: {path}");
+
+            width = (int)BinaryPrimitives.ReadUInt32LittleEndian(bytes.Slice(8));
+            height = (int)BinaryPrimitives.ReadUInt32LittleEndian(bytes.Slice(12));
+            format = (TextureFormat)BinaryPrimitives.ReadUInt32LittleEndian(bytes.Slice(16));
+            levels = (int)BinaryPrimitives.ReadUInt32LittleEndian(bytes.Slice(20));
+            if (width <= 0 || height <= 0 || levels <= 0 || levels > 16)
+                throw new InvalidOperationException($"Bad texture header: {path}");
+
+            levelOffsets = new int[levels];
+            levelSizes = new int[levels];
+            int offset = HeaderSize + 4 * levels;
+            long total = 0;
+            for (int i = 0; i < levels; i++)
+            {
+                levelSizes[i] = (int)BinaryPrimitives.ReadUInt32LittleEndian(bytes.Slice(HeaderSize + 4 * i));
+                levelOffsets[i] = offset;
+                offset += levelSizes[i];
+                total += levelSizes[i];
+            }
+            if (offset > bytes.Length)
+                throw new InvalidOperationException($"Truncated texture: {path}");
+
+            Interlocked.Exchange(ref memoryUsage, total);
+        }
+
+        public override unsafe void Upload()
+        {
+            if (NativePlatform.native_texture_format_supported((int)format) == 0)
+                throw new NotSupportedException($"{format} textures are not supported by this GPU: {resourcePath}");
+
+            textureId = NativePlatform.native_create_texture(width, height, (int)format, levels);
+            if (textureId == 0)
+                throw new InvalidOperationException($"Failed to create texture: {resourcePath}");
+
+            UploadLevels();
+            base.Upload();
+        }
+
+        private unsafe void UploadLevels()
+        {
+            // Mapped archive pages outlive the upload, so they go in place; arrays get copied
+            int copy = data.IsMapped ? 0 : 1;
+            fixed (byte* basePtr = data.Span)
+            {
+                for (int i = 0; i < levels; i++)
+                {
+                    NativePlatform.native_texture_upload(textureId, i,
+                        (IntPtr)(basePtr + levelOffsets[i]), levelSizes[i], copy);
+                }
+            }
+            data = default;
+        }
+
+        /// <summary>
+        /// With the same size, format and mip count the new levels are uploaded into the existing
+        /// texture, so anything holding GetId() picks them up; otherwise the texture is recreated.
+        /// </summary>
+        protected internal override void ApplyReload(Resource fresh)
+        {
+            var update = (Texture)fresh;
+            bool sameShape = textureId != 0 && update.width == width && update.height == height &&
+                update.format == format && update.levels == levels;
+            if (!sameShape)
+                Unload();
+
+            width = update.width;
+            height = update.height;
+            format = update.format;
+            levels = update.levels;
+            data = update.data;
+            levelOffsets = update.levelOffsets;
+            levelSizes = update.levelSizes;
+            Interlocked.Exchange(ref memoryUsage, update.GetMemoryUsage());
+            update.data = default;
+
+            if (sameShape)
+                UploadLevels();
+            else
+                Upload();
+        }
+
+        public override void Unload()
+        {
+            if (textureId != 0)
+            {
+                NativePlatform.native_delete_texture(textureId);
+                textureId = 0;
+            }
+            data = default;
+            base.Unload();
+        }
+
+        /// <summary>True once every level has reached the GPU</summary>
+        public bool IsResident() => textureId != 0 && NativePlatform.native_texture_pending(textureId) == 0;
+
+        public uint GetId() => textureId;
+        public int GetWidth() => width;
+        public int GetHeight() => height;
+        public int GetLevelCount() => levels;
+        public TextureFormat GetFormat() => format;
+
+        public static bool IsFormatSupported(TextureFormat format) =>
+            NativePlatform.native_texture_format_supported((int)format) != 0;
+
+        public static void SetUploadBudget(long bytesPerFrame) =>
+            NativePlatform.native_set_texture_upload_budget(bytesPerFrame);
+
+        public static TextureStats GetUploadStats()
+        {
+            NativePlatform.native_get_texture_stats(out TextureStats stats);
+            return stats;
+        }
+    }
+}
@@ -0,0 +1,744 @@
+/*
+ * PyFlare Benchmark
+ * Headless, reproducible performance suite: sprite throughput, signal dispatch, memory
+ * manager, resource loading, shader compiles and audio voice commands. Every scenario runs warmup iterations,
+ * then timed samples; the summary goes to stdout and to a JSON file for regression tracking
+ *
+ *   python tools/build/build.py bench [-- args]     builds the native library and runs this
+ *
+ *   --out <file>          JSON results (default bench_results.json)
+ *   --filter <a,b>        only scenarios whose name contains one of the substrings
+ *   --quick               a quarter of the samples, for smoke runs
+ *   --window              render to a visible window instead of a headless context
+ *   --no-render-thread    issue GL from the main thread
+ *   --label <text>        stored in the JSON, e.g. a commit or machine name
+ *   --list                print scenario names and exit
+ */
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+using PyFlare.Engine.Audio;
+using PyFlare.Engine.Core;
+using PyFlare.Engine.Platform;
+using PyFlare.Engine.Rendering;
+
+namespace PyFlare.Benchmark
+{
+    /// <summary>
+    /// Summary of one scenario. Values are in Unit per Per (e.g. ms per frame, ns per emit)
+    /// </summary>
+    public sealed class BenchResult
+    {
+        public string Name;
+        public string Unit;
+        public string Per;
+        public int Samples;
+        public double Min, Mean, StdDev, P50, P90, P95, P99, Max;
+        public double Throughput;           // operations per second at the mean
+        public string ThroughputUnit;
+        public string Skipped;              // reason, when the scenario could not run
+        public readonly Dictionary<string, double> Extra = new Dictionary<string, double>();
+
+        /// <summary>Linear interpolation between closest ranks, as numpy's default percentile</summary>
+        private static double Percentile(double[] sorted, double p)
+        {
+            if (sorted.Length == 1) return sorted[0];
+            double rank = p * (sorted.Length - 1);
+            int lo = (int)rank;
+            int hi = Math.Min(lo + 1, sorted.Length - 1);
+            return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+        }
+
+        public static BenchResult FromSamples(string name, string unit, string per, double[] values,
+            double opsPerSample, double secondsPerUnit, string throughputUnit)
+        {
+            var result = new BenchResult { Name = name, Unit = unit, Per = per, Samples = values.Length };
+            if (values.Length == 0) return result;
+
+            double[] sorted = (double[])values.Clone();
+            Array.Sort(sorted);
+
+            double sum = 0;
+            foreach (double v in sorted) sum += v;
+            double mean = sum / sorted.Length;
+            double sq = 0;
+            foreach (double v in sorted) sq += (v - mean) * (v - mean);
+
+            result.Min = sorted[0];
+            result.Max = sorted[sorted.Length - 1];
+            result.Mean = mean;
+            result.StdDev = Math.Sqrt(sq / sorted.Length);
+            result.P50 = Percentile(sorted, 0.50);
+            result.P90 = Percentile(sorted, 0.90);
+            result.P95 = Percentile(sorted, 0.95);
+            result.P99 = Percentile(sorted, 0.99);
+
+            // values are per-op when Per names an op; opsPerSample then converts back to the sample
+            double secondsPerSample = mean * secondsPerUnit * (per == "sample" || per == "frame" ? 1.0 : opsPerSample);
+            result.Throughput = secondsPerSample > 0 ? opsPerSample / secondsPerSample : 0;
+            result.ThroughputUnit = throughputUnit;
+            return result;
+        }
+
+        public static BenchResult Skip(string name, string reason) => new BenchResult { Name = name, Skipped = reason };
+    }
+
+    /// <summary>
+    /// Minimal resource for loader benchmarks: reads the bytes and checksums them like a decoder would
+    /// </summary>
+    public sealed class BlobResource : Resource
+    {
+        public int Length;
+        public uint Checksum;
+
+        public override void LoadData(string path, CancellationToken token)
+        {
+            base.LoadData(path, token);
+            ResourceData data = ResourceLoader.OpenData(path);
+            ReadOnlySpan<byte> bytes = data.Span;
+            uint sum = 0;
+            for (int i = 0; i < bytes.Length; i += 64)
+                sum = sum * 31 + bytes[i];
+            Length = bytes.Length;
+            Checksum = sum;
+            Interlocked.Exchange(ref memoryUsage, bytes.Length);
+        }
+    }
+
+    public static class Program
+    {
+        private sealed class Scenario
+        {
+            public string Name;
+            public bool NeedsGL;
+            public Func<BenchResult> Run;
+        }
+
+        private const int FrameWidth = 1280;
+        private const int FrameHeight = 720;
+
+        // Fixed seed: every run draws the same sprites and allocation sizes
+        private const int Seed = 12345;
+
+        private static double sampleScale = 1.0;
+        private static bool glAvailable;
+
+        // ====================================================================
+        // MEASUREMENT
+        // ====================================================================
+
+        private static int Samples(int full) => Math.Max(5, (int)(full * sampleScale));
+
+        /// <summary>
+        /// Times body `samples` times after `warmup` untimed runs. setup runs before every call and
+        /// is not timed. Each value is the sample's time in `unit` divided by opsPerSample
+        /// (pass per = "frame" or "sample" to keep whole-sample times). afterWarmup runs once
+        /// between the warmup and the first timed sample, e.g. to reset native counters.
+        /// </summary>
+        private static BenchResult Measure(string name, string unit, string per, int warmup, int samples,
+            int opsPerSample, string throughputUnit, Action body, Action setup = null, Action afterWarmup = null)
+        {
+            double secondsPerUnit = unit == "ns" ? 1e-9 : unit == "us" ? 1e-6 : 1e-3;
+            bool perOp = per != "frame" && per != "sample";
+            var values = new double[samples];
+
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            for (int i = 0; i < warmup; i++)
+            {
+                setup?.Invoke();
+                body();
+            }
+            afterWarmup?.Invoke();
+
+            for (int i = 0; i < samples; i++)
+            {
+                setup?.Invoke();
+                long start = Stopwatch.GetTimestamp();
+                body();
+                long elapsed = Stopwatch.GetTimestamp() - start;
+
+                double seconds = (double)elapsed / Stopwatch.Frequency;
+                values[i] = seconds / secondsPerUnit / (perOp ? opsPerSample : 1);
+            }
+
+            return BenchResult.FromSamples(name, unit, per, values, opsPerSample, secondsPerUnit, throughputUnit);
+        }
+
+        // ====================================================================
+        // SPRITES
+        // ====================================================================
+
+        private static BenchResult SpriteFrames(int count)
+        {
+            var random = new Random(Seed);
+            var sprites = new SpriteInstance[count];
+            var velocity = new float[count * 2];
+            for (int i = 0; i < count; i++)
+            {
+                float size = 8 + (float)random.NextDouble() * 24;
+                sprites[i] = new SpriteInstance
+                {
+                    x = (float)random.NextDouble() * FrameWidth,
+                    y = (float)random.NextDouble() * FrameHeight,
+                    width = size,
+                    height = size,
+                    u0 = 0, v0 = 0, u1 = 1, v1 = 1,
+                    rotation = (float)random.NextDouble() * 6.28f,
+                    color = SpriteInstance.PackColor((float)random.NextDouble(), (float)random.NextDouble(), (float)random.NextDouble(), 0.8f),
+                    layer = i & 3
+                };
+                velocity[i * 2] = (float)random.NextDouble() * 4 - 2;
+                velocity[i * 2 + 1] = (float)random.NextDouble() * 4 - 2;
+            }
+
+            var batch = new SpriteBatch(count);
+            int drawCalls = 0;
+
+            BenchResult result = Measure($"sprites/{count}", "ms", "frame", 30, Samples(300), count, "sprites/s", () =>
+            {
+                Platform.Update();
+                Platform.Clear(0.1f, 0.1f, 0.12f);
+                for (int i = 0; i < count; i++)
+                {
+                    ref SpriteInstance s = ref sprites[i];
+                    s.x += velocity[i * 2];
+                    s.y += velocity[i * 2 + 1];
+                    if (s.x < 0 || s.x > FrameWidth) velocity[i * 2] = -velocity[i * 2];
+                    if (s.y < 0 || s.y > FrameHeight) velocity[i * 2 + 1] = -velocity[i * 2 + 1];
+                    batch.Draw(ref s);
+                }
+                drawCalls = batch.Flush();
+                Platform.Present();
+            }, afterWarmup: () =>
+            {
+                // Native counters cover the timed frames only
+                Performance.ResetFrameStats();
+                Profiler.ResetGLStateStats();
+            });
+
+            // Native view of the same frames: native_update to native_update, so it includes the swap wait
+            Performance.GetFrameStats(FrameStatsScope.Total, out FrameStats native);
+            GLStateStats gl = Profiler.GetGLStateStats();
+            result.Extra["draw_calls"] = drawCalls;
+            result.Extra["native_p50_ms"] = native.p50Ms;
+            result.Extra["native_p99_ms"] = native.p99Ms;
+            result.Extra["gl_calls_per_frame"] = gl.frames > 0 ? (double)gl.total.emitted / gl.frames : 0;
+            result.Extra["gl_filtered_ratio"] = gl.total.FilteredRatio;
+            return result;
+        }
+
+        // ====================================================================
+        // SIGNALS
+        // ====================================================================
+
+        private static readonly SignalId BenchSignal = SignalId.Intern("bench_signal");
+
+        private static BenchResult SignalImmediate(int listeners)
+        {
+            const int Emits = 100000;
+            var source = new PyFlareObject();
+            source.AddSignal(BenchSignal);
+            long total = 0;
+            for (int i = 0; i < listeners; i++)
+                source.Connect<int>(BenchSignal, v => total += v);
+
+            BenchResult result = Measure($"signals/immediate/{listeners}", "ns", "emit", 3, Samples(40), Emits, "emits/s", () =>
+            {
+                for (int i = 0; i < Emits; i++)
+                    source.EmitSignal(BenchSignal, i);
+            });
+            result.Extra["listeners"] = listeners;
+            return result;
+        }
+
+        private static BenchResult SignalDeferred()
+        {
+            const int Objects = 10000;
+            var targets = new PyFlareObject[Objects];
+            long total = 0;
+            for (int i = 0; i < Objects; i++)
+            {
+                targets[i] = new PyFlareObject();
+                targets[i].AddSignal(BenchSignal);
+                targets[i].Connect<int>(BenchSignal, v => total += v);
+            }
+
+            // One deferred emit per object per frame, delivered by the end-of-frame flush
+            BenchResult result = Measure("signals/deferred", "ns", "emit", 3, Samples(40), Objects, "emits/s", () =>
+            {
+                for (int i = 0; i < Objects; i++)
+                    targets[i].EmitDeferred(BenchSignal, i);
+                SignalQueue.Flush();
+            });
+            result.Extra["objects"] = Objects;
+            return result;
+        }
+
+        // ====================================================================
+        // MEMORY
+        // ====================================================================
+
+        private static BenchResult MemoryPooled()
+        {
+            const int Blocks = 10000;
+            var random = new Random(Seed);
+            var sizes = new int[Blocks];
+            var order = new int[Blocks];
+            for (int i = 0; i < Blocks; i++)
+            {
+                // Skewed towards small blocks, as game allocations are
+                double r = random.NextDouble();
+                sizes[i] = 1 + (int)(r * r * r * 16383);
+                order[i] = i;
+            }
+            random.Shuffle(order);
+
+            var blocks = new PoolBlock[Blocks];
+            MemoryManager memory = MemoryManager.Instance;
+
+            return Measure("memory/pooled", "ns", "alloc+free", 3, Samples(60), Blocks, "pairs/s", () =>
+            {
+                for (int i = 0; i < Blocks; i++)
+                    blocks[i] = memory.Allocate(sizes[i]);
+                for (int i = 0; i < Blocks; i++)
+                    memory.Free(blocks[order[i]]);
+            });
+        }
+
+        private static BenchResult MemoryLarge()
+        {
+            const int Blocks = 256;
+            var random = new Random(Seed);
+            var sizes = new int[Blocks];
+            for (int i = 0; i < Blocks; i++)
+                sizes[i] = 32 * 1024 + random.Next(4 * 1024 * 1024);
+
+            var blocks = new PoolBlock[Blocks];
+            MemoryManager memory = MemoryManager.Instance;
+
+            return Measure("memory/large", "ns", "alloc+free", 3, Samples(60), Blocks, "pairs/s", () =>
+            {
+                for (int i = 0; i < Blocks; i++)
+                    blocks[i] = memory.Allocate(sizes[i]);
+                for (int i = Blocks - 1; i >= 0; i--)
+                    memory.Free(blocks[i]);
+            });
+        }
+
+        private static BenchResult MemoryFrameArena()
+        {
+            const int Allocations = 10000;
+            MemoryManager memory = MemoryManager.Instance;
+
+            return Measure("memory/frame_arena", "ns", "alloc", 3, Samples(60), Allocations, "allocs/s", () =>
+            {
+                memory.ResetFrameArena();
+                for (int i = 0; i < Allocations; i++)
+                    memory.AllocateFrame(16 + (i & 255));
+            });
+        }
+
+        // ====================================================================
+        // RESOURCES
+        // ====================================================================
+
+        private const int ResourceFiles = 64;
+        private const int ResourceFileSize = 256 * 1024;
+        private static string[] resourcePaths;
+
+        private static string[] ResourceFileSet()
+        {
+            if (resourcePaths != null) return resourcePaths;
+
+            string dir = Path.Combine(Path.GetTempPath(), $"pyflare_bench_{Environment.ProcessId}");
+            Directory.CreateDirectory(dir);
+            var random = new Random(Seed);
+            var bytes = new byte[ResourceFileSize];
+            resourcePaths = new string[ResourceFiles];
+            for (int i = 0; i < ResourceFiles; i++)
+            {
+                random.NextBytes(bytes);
+                resourcePaths[i] = Path.Combine(dir, $"blob_{i:D3}.bin");
+                File.WriteAllBytes(resourcePaths[i], bytes);
+            }
+            return resourcePaths;
+        }
+
+        private static void DeleteResourceFiles()
+        {
+            if (resourcePaths == null) return;
+            try { Directory.Delete(Path.GetDirectoryName(resourcePaths[0]), true); }
+            catch (IOException) { }
+            resourcePaths = null;
+        }
+
+        /// <summary>
+        /// Cache misses: every load reads and decodes the file. The OS page cache stays warm,
+        /// so this is the engine's cost, not the disk's.
+        /// </summary>
+        private static BenchResult ResourceCold()
+        {
+            string[] paths = ResourceFileSet();
+            BenchResult result = Measure("resources/cold", "us", "load", 2, Samples(40), paths.Length, "loads/s", () =>
+            {
+                foreach (string path in paths)
+                    ResourceLoader.Load<BlobResource>(path);
+            }, setup: ResourceLoader.ClearCache);
+            result.Extra["file_bytes"] = ResourceFileSize;
+            return result;
+        }
+
+        private static BenchResult ResourceWarm()
+        {
+            string[] paths = ResourceFileSet();
+            ResourceLoader.ClearCache();
+            foreach (string path in paths)
+                ResourceLoader.Load<BlobResource>(path);
+
+            BenchResult result = Measure("resources/warm", "ns", "load", 3, Samples(60), paths.Length * 16, "loads/s", () =>
+            {
+                for (int pass = 0; pass < 16; pass++)
+                    foreach (string path in paths)
+                        ResourceLoader.Load<BlobResource>(path);
+            });
+            ResourceCacheStats stats = ResourceLoader.GetCacheStats();
+            result.Extra["hit_rate"] = stats.HitRate;
+            return result;
+        }
+
+        /// <summary>Whole-batch latency of background loads, pumped the way Engine.Update does</summary>
+        private static BenchResult ResourceAsync()
+        {
+            string[] paths = ResourceFileSet();
+            var futures = new ResourceFuture<BlobResource>[paths.Length];
+
+            BenchResult result = Measure("resources/async_batch", "ms", "sample", 2, Samples(40), paths.Length, "loads/s", () =>
+            {
+                for (int i = 0; i < paths.Length; i++)
+                    futures[i] = ResourceLoader.LoadAsync<BlobResource>(paths[i]);
+
+                for (int i = 0; i < paths.Length; i++)
+                {
+                    while (!futures[i].IsDone)
+                    {
+                        ResourceLoader.PumpUploads();
+                        if (!Jobs.TryRunOne())
+                            Thread.Yield();
+                    }
+                }
+                ResourceLoader.PumpUploads();
+            }, setup: ResourceLoader.ClearCache);
+            result.Extra["files"] = paths.Length;
+            result.Extra["workers"] = Jobs.WorkerCount;
+            return result;
+        }
+
+        // ====================================================================
+        // SHADERS
+        // ====================================================================
+
+        private const string VertexSource = @"#version 120
+attribute vec2 a_position;
+attribute vec2 a_uv;
+varying vec2 v_uv;
+uniform vec2 u_screen;
+void main() {
+    v_uv = a_uv;
+    gl_Position = vec4(a_position / u_screen * 2.0 - 1.0, 0.0, 1.0);
+}
+";
+
+        private static string FragmentSource(int variant) => @"#version 120
+varying vec2 v_uv;
+uniform sampler2D u_texture;
+void main() {
+    vec4 c = texture2D(u_texture, v_uv);
+    float l = dot(c.rgb, vec3(0.299, 0.587, 0.114));
+    gl_FragColor = vec4(mix(c.rgb, vec3(l), " + (variant % 997 / 997.0).ToString("F6", CultureInfo.InvariantCulture) + @"), c.a);
+}
+// variant " + variant.ToString(CultureInfo.InvariantCulture) + "\n";
+
+        private static int shaderVariant;
+
+        /// <summary>Unique sources, so neither the engine's cache nor the driver's can answer</summary>
+        private static BenchResult ShaderCompile()
+        {
+            string fragment = null;
+            BenchResult result = Measure("shaders/compile", "ms", "shader", 2, Samples(40), 1, "shaders/s", () =>
+            {
+                var shader = new Shader(VertexSource, fragment);
+                shader.Dispose();
+            }, setup: () => fragment = FragmentSource(++shaderVariant));
+            NativePlatform.native_get_shader_cache_stats(out int memoryHits, out int diskHits, out int compiles);
+            result.Extra["compiles"] = compiles;
+            return result;
+        }
+
+        private static BenchResult ShaderCacheHit()
+        {
+            string fragment = FragmentSource(-1);
+            new Shader(VertexSource, fragment).Dispose();
+
+            return Measure("shaders/cache_hit", "us", "shader", 3, Samples(60), 1, "shaders/s", () =>
+            {
+                var shader = new Shader(VertexSource, fragment);
+                shader.Dispose();
+            });
+        }
+
+        // ====================================================================
+        // AUDIO
+        // ====================================================================
+
+        /// <summary>16-bit mono sine, written where the resource files live</summary>
+        private static string WriteWav(string name, int frames)
+        {
+            const int Rate = 48000;
+            string path = Path.Combine(Path.GetDirectoryName(ResourceFileSet()[0]), name);
+            using var writer = new BinaryWriter(File.Create(path));
+            writer.Write("RIFF"u8); writer.Write(36 + frames * 2); writer.Write("WAVE"u8);
+            writer.Write("fmt "u8); writer.Write(16); writer.Write((short)1); writer.Write((short)1);
+            writer.Write(Rate); writer.Write(Rate * 2); writer.Write((short)2); writer.Write((short)16);
+            writer.Write("data"u8); writer.Write(frames * 2);
+            for (int i = 0; i < frames; i++)
+                writer.Write((short)(Math.Sin(i * 2 * Math.PI * 440 / Rate) * 16000));
+            return path;
+        }
+
+        /// <summary>
+        /// Play, pause, then stop a looping clip and a music stream, until the mixer has freed both.
+        /// Paused voices must still honour a stop: stuck_voices counts those that never ended.
+        /// </summary>
+        private static BenchResult AudioPauseStop()
+        {
+            if (!AudioMixer.Initialize(nullDevice: true))
+                return BenchResult.Skip("audio/pause_stop", "no audio mixer");
+
+            var sound = ResourceLoader.Load<Sound>(WriteWav("clip.wav", 4800));
+            var music = new Music(WriteWav("music.wav", 96000));
+            int stuck = 0;
+
+            BenchResult result = Measure("audio/pause_stop", "ms", "sample", 2, Samples(40), 2, "voices/s", () =>
+            {
+                Voice clip = sound.Play(loop: true);
+                Voice stream = music.Play();
+                AudioMixer.Update();
+                clip.Pause();
+                stream.Pause();
+                Thread.Sleep(5);    // let the mixer ramp both down to the paused hold
+                clip.Stop();
+                stream.Stop();
+
+                long deadline = Stopwatch.GetTimestamp() + Stopwatch.Frequency;
+                while ((clip.IsPlaying || stream.IsPlaying) && Stopwatch.GetTimestamp() < deadline)
+                {
+                    AudioMixer.Update();
+                    Thread.Sleep(1);
+                }
+                if (clip.IsPlaying || !clip.IsValid) stuck++;
+                if (stream.IsPlaying || !stream.IsValid) stuck++;
+                AudioMixer.Update();
+            });
+
+            result.Extra["stuck_voices"] = stuck;
+            result.Extra["active_voices_after"] = AudioMixer.GetStats().activeVoices;
+            sound.Unload();
+            AudioMixer.Shutdown();
+            return result;
+        }
+
+        // ====================================================================
+        // DRIVER
+        // ====================================================================
+
+        private static List<Scenario> BuildScenarios()
+        {
+            return new List<Scenario>
+            {
+                new Scenario { Name = "sprites/1000", NeedsGL = true, Run = () => SpriteFrames(1000) },
+                new Scenario { Name = "sprites/10000", NeedsGL = true, Run = () => SpriteFrames(10000) },
+                new Scenario { Name = "sprites/50000", NeedsGL = true, Run = () => SpriteFrames(50000) },
+                new Scenario { Name = "signals/immediate/1", Run = () => SignalImmediate(1) },
+                new Scenario { Name = "signals/immediate/8", Run = () => SignalImmediate(8) },
+                new Scenario { Name = "signals/deferred", Run = SignalDeferred },
+                new Scenario { Name = "memory/pooled", Run = MemoryPooled },
+                new Scenario { Name = "memory/large", Run = MemoryLarge },
+                new Scenario { Name = "memory/frame_arena", Run = MemoryFrameArena },
+                new Scenario { Name = "resources/cold", Run = ResourceCold },
+                new Scenario { Name = "resources/warm", Run = ResourceWarm },
+                new Scenario { Name = "resources/async_batch", Run = ResourceAsync },
+                new Scenario { Name = "shaders/compile", NeedsGL = true, Run = ShaderCompile },
+                new Scenario { Name = "shaders/cache_hit", NeedsGL = true, Run = ShaderCacheHit },
+                new Scenario { Name = "audio/pause_stop", Run = AudioPauseStop },
+            };
+        }
+
+        private static string Arg(string[] args, string name, string fallback)
+        {
+            int i = Array.IndexOf(args, name);
+            return i >= 0 && i + 1 < args.Length ? args[i + 1] : fallback;
+        }
+
+        public static int Main(string[] args)
+        {
+            bool HasFlag(string name) => Array.IndexOf(args, name) >= 0;
+
+            List<Scenario> scenarios = BuildScenarios();
+            if (HasFlag("--list"))
+            {
+                foreach (Scenario s in scenarios)
+                    Console.WriteLine(s.Name + (s.NeedsGL ? " (gl)" : ""));
+                return 0;
+            }
+
+            string outPath = Arg(args, "--out", "bench_results.json");
+            string label = Arg(args, "--label", "");
+            string[] filters = Arg(args, "--filter", "").Split(',', StringSplitOptions.RemoveEmptyEntries);
+            if (HasFlag("--quick")) sampleScale = 0.25;
+
+            // Pacing and vsync would measure the display, not the engine
+            Platform.SetTargetFPS(0);
+            Platform.SetRenderThread(!HasFlag("--no-render-thread"));
+            glAvailable = HasFlag("--window")
+                ? Platform.Initialize(FrameWidth, FrameHeight, "PyFlare Benchmark", false, false)
+                : Platform.InitializeHeadless(FrameWidth, FrameHeight);
+            if (glAvailable && HasFlag("--window"))
+                Platform.SetVSync(false);
+            if (!glAvailable)
+                Console.WriteLine("No GL context: GPU scenarios will be skipped");
+
+            Jobs.Initialize();
+            ResourceLoader.Initialize();
+
+            var results = new List<BenchResult>();
+            foreach (Scenario scenario in scenarios)
+            {
+                if (filters.Length > 0 && !Array.Exists(filters, f => scenario.Name.Contains(f, StringComparison.Ordinal)))
+                    continue;
+
+                BenchResult result;
+                if (scenario.NeedsGL && !glAvailable)
+                    result = BenchResult.Skip(scenario.Name, "no GL context");
+                else
+                    result = scenario.Run();
+                results.Add(result);
+                PrintResult(result);
+            }
+
+            DeleteResourceFiles();
+            WriteJson(outPath, label, results);
+            Console.WriteLine($"Wrote {results.Count} results to {outPath}");
+
+            ResourceLoader.Shutdown();
+            Jobs.Shutdown();
+            Platform.Shutdown();
+            return 0;
+        }
+
+        private static void PrintResult(BenchResult r)
+        {
+            if (r.Skipped != null)
+            {
+                Console.WriteLine($"{r.Name,-26} skipped: {r.Skipped}");
+                return;
+            }
+            Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+                "{0,-26} p50 {1,10:F3} p95 {2,10:F3} p99 {3,10:F3} {4}/{5}  ({6:N0} {7})",
+                r.Name, r.P50, r.P95, r.P99, r.Unit, r.Per, r.Throughput, r.ThroughputUnit));
+        }
+
+        // ====================================================================
+        // JSON OUTPUT
+        // ====================================================================
+
+        private static string Json(string value)
+        {
+            var sb = new StringBuilder(value.Length + 2);
+            sb.Append('"');
+            foreach (char c in value)
+            {
+                switch (c)
+                {
+                    case '"': sb.Append("\\\""); break;
+                    case '\\': sb.Append("\\\\"); break;
+                    case '\n': sb.Append("\\n"); break;
+                    case '\r': sb.Append("\\r"); break;
+                    case '\t': sb.Append("\\t"); break;
+                    default:
+                        if (c < 0x20) sb.Append($"\\u{(int)c:X4}");
+                        else sb.Append(c);
+                        break;
+                }
+            }
+            sb.Append('"');
+            return sb.ToString();
+        }
+
+        private static string Json(double value)
+        {
+            if (double.IsNaN(value) || double.IsInfinity(value)) return "null";
+            return value.ToString("R", CultureInfo.InvariantCulture);
+        }
+
+        private static void WriteJson(string path, string label, List<BenchResult> results)
+        {
+            var sb = new StringBuilder();
+            sb.Append("{\n  \"schema\": 1,\n");
+            sb.Append($"  \"label\": {Json(label)},\n");
+            sb.Append($"  \"timestamp\": {Json(DateTime.UtcNow.ToString("yyyy-MM-ddTHH:mm:ssZ", CultureInfo.InvariantCulture))},\n");
+            sb.Append("  \"environment\": {\n");
+            sb.Append($"    \"os\": {Json(RuntimeInformation.OSDescription)},\n");
+            sb.Append($"    \"arch\": {Json(RuntimeInformation.OSArchitecture.ToString())},\n");
+            sb.Append($"    \"runtime\": {Json(RuntimeInformation.FrameworkDescription)},\n");
+            sb.Append($"    \"cpus\": {Environment.ProcessorCount},\n");
+            sb.Append($"    \"job_workers\": {Jobs.WorkerCount},\n");
+            sb.Append($"    \"gl_vendor\": {Json(glAvailable ? Platform.GetGLVendor() : "")},\n");
+            sb.Append($"    \"gl_renderer\": {Json(glAvailable ? Platform.GetGLRenderer() : "")},\n");
+            sb.Append($"    \"gl_version\": {Json(glAvailable ? Platform.GetGLVersion() : "")},\n");
+            sb.Append($"    \"headless\": {(Platform.IsHeadless() ? "true" : "false")},\n");
+            sb.Append($"    \"render_thread\": {(glAvailable && Platform.IsRenderThreadEnabled() ? "true" : "false")},\n");
+            StartupStats startup = Platform.GetStartupStats();
+            double tickMs = 1000.0 / Platform.GetTickFrequency();
+            sb.Append($"    \"context_init_ms\": {Json(startup.contextReady == 0 ? 0.0 : (startup.contextReady - startup.initBegin) * tickMs)},\n");
+            sb.Append($"    \"native_init_ms\": {Json(startup.initEnd == 0 ? 0.0 : (startup.initEnd - startup.initBegin) * tickMs)},\n");
+            sb.Append($"    \"sample_scale\": {Json(sampleScale)}\n");
+            sb.Append("  },\n  \"scenarios\": [");
+
+            for (int i = 0; i < results.Count; i++)
+            {
+                BenchResult r = results[i];
+                sb.Append(i == 0 ? "\n" : ",\n");
+                sb.Append($"    {{\"name\": {Json(r.Name)}");
+                if (r.Skipped != null)
+                {
+                    sb.Append($", \"skipped\": {Json(r.Skipped)}}}");
+                    continue;
+                }
+                sb.Append($", \"unit\": {Json(r.Unit)}, \"per\": {Json(r.Per)}, \"samples\": {r.Samples}");
+                sb.Append($", \"min\": {Json(r.Min)}, \"mean\": {Json(r.Mean)}, \"stddev\": {Json(r.StdDev)}");
+                sb.Append($", \"p50\": {Json(r.P50)}, \"p90\": {Json(r.P90)}, \"p95\": {Json(r.P95)}, \"p99\": {Json(r.P99)}, \"max\": {Json(r.Max)}");
+                sb.Append($", \"throughput\": {Json(r.Throughput)}, \"throughput_unit\": {Json(r.ThroughputUnit)}");
+                sb.Append(", \"extra\": {");
+                bool first = true;
+                foreach (var kvp in r.Extra)
+                {
+                    sb.Append(first ? "" : ", ");
+                    sb.Append($"{Json(kvp.Key)}: {Json(kvp.Value)}");
+                    first = false;
+                }
+                sb.Append("}}");
+            }
+            sb.Append("\n  ]\n}\n");
+
+            File.WriteAllText(path, sb.ToString(), new UTF8Encoding(false));
+        }
+    }
+}
@@ -1 +1,780 @@
-# Build script placeholder
+# PyFlare build script
+#
+#   python build.py pack <asset_dir> <out.pfpk>    pack assets into a mappable archive
+#   python build.py list <archive.pfpk>            print an archive's index
+#   python build.py texture <in.png> <out.pftx>    convert an image, mips included
+#   python build.py bench [-- benchmark args]       build and run projects/benchmark headless
+#   python build.py bench-compare <base> <new>      flag percentile regressions between two runs
+#   python build.py registry <out.g.cs> [dirs...]    generate the class registry from C# sources
+
+import argparse
+import json
+import os
+import re
+import struct
+import subprocess
+import sys
+import zlib
+
+# ============================================================================
+# ASSET ARCHIVE (.pfpk)
+# Layout must match ArchiveHeader / ArchiveEntry in engine/platform/native/native.c
+# ============================================================================
+
+ARCHIVE_MAGIC = 0x4B504650  # "PFPK"
+ARCHIVE_VERSION = 1
+ARCHIVE_ALIGN = 4096
+
+HEADER = struct.Struct("<IIIIQQ")   # magic, version, entry_count, reserved, index_offset, file_size
+ENTRY = struct.Struct("<QQQQII")    # hash, offset, size, raw_size, compression, reserved
+
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4_CHUNKED = 1
+
+CHUNK_SIZE = 64 * 1024
+CHUNK_STORED = 0x80000000
+MIN_SAVING = 0.95   # keep an entry stored unless compression saves at least 5%
+
+FNV_OFFSET = 0xCBF29CE484222325
+FNV_PRIME = 0x100000001B3
+
+
+# ============================================================================
+# LZ4 BLOCK COMPRESSION
+# Greedy single-probe compressor producing standard LZ4 blocks; the runtime
+# decoder is native_lz4_decompress. Runs offline, so plain Python is fine.
+# ============================================================================
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5     # the block must end with at least 5 literals
+LZ4_MF_LIMIT = 12         # no match may start within 12 bytes of the end
+LZ4_MAX_OFFSET = 65535
+
+
+def _lz4_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def _lz4_sequence(out, literals, offset, match_length):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_length:
+        token |= min(match_length - LZ4_MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        _lz4_length(out, lit_len - 15)
+    out += literals
+    if match_length:
+        out += offset.to_bytes(2, "little")
+        if match_length - LZ4_MIN_MATCH >= 15:
+            _lz4_length(out, match_length - LZ4_MIN_MATCH - 15)
+
+
+def lz4_compress_block(src):
+    src = bytes(src)
+    n = len(src)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    limit = n - LZ4_MF_LIMIT
+    match_end_limit = n - LZ4_LAST_LITERALS
+
+    while i < limit:
+        key = src[i:i + 4]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > LZ4_MAX_OFFSET:
+            i += 1
+            continue
+
+        length = LZ4_MIN_MATCH
+        while i + length < match_end_limit and src[candidate + length] == src[i + length]:
+            length += 1
+
+        _lz4_sequence(out, src[anchor:i], i - candidate, length)
+        i += length
+        anchor = i
+
+        # Seed the table inside the match so the next probe has recent positions
+        if i - 2 < limit:
+            table[src[i - 2:i + 2]] = i - 2
+
+    _lz4_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+
+def compress_chunked(data):
+    """Returns the PF_COMPRESSION_LZ4_CHUNKED payload, or None if it isn't worth it."""
+    sizes = []
+    payloads = []
+    for start in range(0, len(data), CHUNK_SIZE):
+        raw = data[start:start + CHUNK_SIZE]
+        packed = lz4_compress_block(raw)
+        if len(packed) >= len(raw):
+            sizes.append(len(raw) | CHUNK_STORED)
+            payloads.append(raw)
+        else:
+            sizes.append(len(packed))
+            payloads.append(packed)
+
+    header = struct.pack(f"<II{len(sizes)}I", len(sizes), CHUNK_SIZE, *sizes)
+    blob = header + b"".join(payloads)
+    return blob if len(blob) < len(data) * MIN_SAVING else None
+
+
+def normalize_path(path):
+    path = path.replace("\\", "/")
+    while path.startswith("./"):
+        path = path[2:]
+    return path
+
+
+def hash_path(path):
+    h = FNV_OFFSET
+    for b in normalize_path(path).encode("utf-8"):
+        h ^= b
+        h = (h * FNV_PRIME) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def align(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+
+def collect_assets(asset_dir):
+    assets = []
+    for root, dirs, files in os.walk(asset_dir):
+        dirs.sort()
+        for name in sorted(files):
+            full = os.path.join(root, name)
+            rel = normalize_path(os.path.relpath(full, asset_dir))
+            assets.append((rel, full))
+    return assets
+
+
+def pack(asset_dir, out_path, verbose=False, compress=True):
+    assets = collect_assets(asset_dir)
+
+    by_hash = {}
+    for rel, _ in assets:
+        h = hash_path(rel)
+        if h in by_hash:
+            sys.exit(f"error: hash collision between '{by_hash[h]}' and '{rel}'; rename one of them")
+        by_hash[h] = rel
+
+    index_offset = HEADER.size
+    offset = align(index_offset + ENTRY.size * len(assets), ARCHIVE_ALIGN)
+
+    # Data goes in directory order so related assets share read-ahead;
+    # the index is sorted by hash for the native binary search
+    entries = []
+    with open(out_path, "wb") as out:
+        out.seek(offset)
+        for rel, full in assets:
+            with open(full, "rb") as f:
+                raw = f.read()
+
+            stored = compress_chunked(raw) if compress and raw else None
+            compression = COMPRESSION_LZ4_CHUNKED if stored is not None else COMPRESSION_NONE
+            data = stored if stored is not None else raw
+
+            out.seek(offset)
+            out.write(data)
+            entries.append((hash_path(rel), offset, len(data), len(raw), compression, 0))
+            if verbose:
+                ratio = f", lz4 {len(data) / len(raw):.0%}" if compression else ""
+                print(f"  {rel} ({len(raw)} bytes{ratio})")
+            offset = align(offset + len(data), ARCHIVE_ALIGN)
+
+        # Pad the tail so the last entry can be mapped as whole pages
+        out.truncate(offset)
+        file_size = offset
+
+        entries.sort(key=lambda e: e[0])
+        out.seek(0)
+        out.write(HEADER.pack(ARCHIVE_MAGIC, ARCHIVE_VERSION, len(entries), 0, index_offset, file_size))
+        for e in entries:
+            out.write(ENTRY.pack(*e))
+
+    print(f"Packed {len(entries)} assets into {out_path} ({file_size / (1024 * 1024):.2f} MB)")
+
+
+def read_index(path):
+    with open(path, "rb") as f:
+        header = HEADER.unpack(f.read(HEADER.size))
+        magic, version, count, _, index_offset, file_size = header
+        if magic != ARCHIVE_MAGIC or version != ARCHIVE_VERSION:
+            sys.exit(f"error: {path} is not a version {ARCHIVE_VERSION} archive")
+        f.seek(index_offset)
+        entries = [ENTRY.unpack(f.read(ENTRY.size)) for _ in range(count)]
+    return file_size, entries
+
+
+def list_archive(path):
+    file_size, entries = read_index(path)
+    print(f"{path}: {len(entries)} entries, {file_size} bytes")
+    for h, offset, size, raw_size, compression, _ in entries:
+        print(f"  {h:016x}  offset {offset:>10}  size {size:>10}  raw {raw_size:>10}  comp {compression}")
+
+
+# ============================================================================
+# TEXTURES (.pftx)
+# Layout read by Texture in engine/rendering/Renderer.cs: 32-byte header,
+# uint32 size per mip level, then the levels largest first. Mips are box
+# filtered here so the runtime never generates them; block-compressed levels
+# are uploaded to the GPU as stored.
+# ============================================================================
+
+TEXTURE_MAGIC = 0x58544650  # "PFTX"
+TEXTURE_VERSION = 1
+TEXTURE_HEADER = struct.Struct("<IIIIIIII")   # magic, version, width, height, format, levels, reserved x2
+
+# Values must match TextureFormat in bindings.cs. ETC2 is accepted at runtime
+# but there is no encoder here.
+TEXTURE_FORMATS = {"rgba8": 0, "rgb8": 1, "dxt1": 2, "dxt5": 4}
+
+
+def read_png(path):
+    """Minimal PNG reader: 8-bit greyscale/RGB/RGBA (+alpha), non-interlaced. Returns (w, h, rgba bytes)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        sys.exit(f"error: {path} is not a PNG file")
+
+    pos = 8
+    idat = bytearray()
+    width = height = color_type = None
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+            if depth != 8 or interlace != 0 or color_type not in (0, 2, 4, 6):
+                sys.exit(f"error: {path}: only 8-bit non-interlaced grey/RGB/RGBA PNGs are supported")
+        elif kind == b"IDAT":
+            idat += chunk
+        elif kind == b"IEND":
+            break
+
+    channels = {0: 1, 2: 3, 4: 2, 6: 4}[color_type]
+    raw = zlib.decompress(bytes(idat))
+    stride = width * channels
+    rows = []
+    prev = bytearray(stride)
+    p = 0
+    for _ in range(height):
+        kind = raw[p]
+        line = bytearray(raw[p + 1:p + 1 + stride])
+        p += 1 + stride
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 255
+            elif kind == 2:
+                line[i] = (line[i] + b) & 255
+            elif kind == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 255
+            elif kind == 4:
+                pa, pb, pc = abs(b - c), abs(a - c), abs(a + b - 2 * c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 255
+        rows.append(line)
+        prev = line
+
+    rgba = bytearray(width * height * 4)
+    o = 0
+    for line in rows:
+        for x in range(width):
+            px = line[x * channels:(x + 1) * channels]
+            if channels == 1:
+                rgba[o:o + 4] = bytes((px[0], px[0], px[0], 255))
+            elif channels == 2:
+                rgba[o:o + 4] = bytes((px[0], px[0], px[0], px[1]))
+            elif channels == 3:
+                rgba[o:o + 4] = bytes((px[0], px[1], px[2], 255))
+            else:
+                rgba[o:o + 4] = px
+            o += 4
+    return width, height, bytes(rgba)
+
+
+def downsample(width, height, rgba):
+    """2x2 box filter; odd edges reuse the last row/column."""
+    nw, nh = max(1, width // 2), max(1, height // 2)
+    out = bytearray(nw * nh * 4)
+    for y in range(nh):
+        y0 = min(2 * y, height - 1)
+        y1 = min(2 * y + 1, height - 1)
+        for x in range(nw):
+            x0 = min(2 * x, width - 1)
+            x1 = min(2 * x + 1, width - 1)
+            for c in range(4):
+                total = (rgba[(y0 * width + x0) * 4 + c] + rgba[(y0 * width + x1) * 4 + c] +
+                         rgba[(y1 * width + x0) * 4 + c] + rgba[(y1 * width + x1) * 4 + c])
+                out[(y * nw + x) * 4 + c] = (total + 2) >> 2
+    return nw, nh, bytes(out)
+
+
+def _block(width, height, rgba, bx, by):
+    """4x4 texels starting at (bx, by), clamped at the edges."""
+    texels = []
+    for y in range(by, by + 4):
+        yy = min(y, height - 1)
+        for x in range(bx, bx + 4):
+            xx = min(x, width - 1)
+            i = (yy * width + xx) * 4
+            texels.append(rgba[i:i + 4])
+    return texels
+
+
+def _to565(c):
+    return ((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3)
+
+
+def _from565(v):
+    r, g, b = (v >> 11) & 31, (v >> 5) & 63, v & 31
+    return ((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))
+
+
+def _encode_color_block(texels):
+    """DXT color block from the bounding-box endpoints, always in 4-color mode."""
+    lo = [min(t[c] for t in texels) for c in range(3)]
+    hi = [max(t[c] for t in texels) for c in range(3)]
+    c0, c1 = _to565(hi), _to565(lo)
+    if c0 < c1:
+        c0, c1 = c1, c0
+    if c0 == c1:
+        return struct.pack("<HHI", c0, c1, 0)
+
+    e0, e1 = _from565(c0), _from565(c1)
+    palette = [e0, e1,
+               tuple((2 * a + b + 1) // 3 for a, b in zip(e0, e1)),
+               tuple((a + 2 * b + 1) // 3 for a, b in zip(e0, e1))]
+    indices = 0
+    for i, t in enumerate(texels):
+        best = min(range(4), key=lambda k: sum((t[c] - palette[k][c]) ** 2 for c in range(3)))
+        indices |= best << (2 * i)
+    return struct.pack("<HHI", c0, c1, indices)
+
+
+def _encode_alpha_block(texels):
+    """DXT5 alpha block in 8-value interpolation mode."""
+    a0 = max(t[3] for t in texels)
+    a1 = min(t[3] for t in texels)
+    if a0 == a1:
+        return struct.pack("<BB", a0, a1) + bytes(6)
+
+    palette = [a0, a1] + [((7 - k) * a0 + k * a1 + 3) // 7 for k in range(1, 7)]
+    bits = 0
+    for i, t in enumerate(texels):
+        best = min(range(8), key=lambda k: abs(t[3] - palette[k]))
+        bits |= best << (3 * i)
+    return struct.pack("<BB", a0, a1) + bits.to_bytes(6, "little")
+
+
+def encode_level(fmt, width, height, rgba):
+    if fmt == "rgba8":
+        return rgba
+    if fmt == "rgb8":
+        return bytes(b for i, b in enumerate(rgba) if i % 4 != 3)
+
+    out = bytearray()
+    for by in range(0, height, 4):
+        for bx in range(0, width, 4):
+            texels = _block(width, height, rgba, bx, by)
+            if fmt == "dxt5":
+                out += _encode_alpha_block(texels)
+            out += _encode_color_block(texels)
+    return bytes(out)
+
+
+def convert_texture(in_path, out_path, fmt, mips=True):
+    width, height, rgba = read_png(in_path)
+    levels = []
+    w, h, pixels = width, height, rgba
+    while True:
+        levels.append(encode_level(fmt, w, h, pixels))
+        if not mips or (w == 1 and h == 1):
+            break
+        w, h, pixels = downsample(w, h, pixels)
+
+    with open(out_path, "wb") as out:
+        out.write(TEXTURE_HEADER.pack(TEXTURE_MAGIC, TEXTURE_VERSION, width, height,
+                                      TEXTURE_FORMATS[fmt], len(levels), 0, 0))
+        out.write(struct.pack(f"<{len(levels)}I", *(len(level) for level in levels)))
+        for level in levels:
+            out.write(level)
+
+    total = sum(len(level) for level in levels)
+    print(f"Wrote {out_path}: {width}x{height} {fmt}, {len(levels)} levels, {total} bytes")
+
+
+# ============================================================================
+# CLASS REGISTRY
+# Finds every top-level, non-generic class deriving from PyFlareObject and writes
+# ClassRegistry.g.cs, which ClassRegistry in engine/core/Core.cs loads on first
+# lookup instead of registering classes by reflection at startup.
+# ============================================================================
+
+REGISTRY_ROOT = "PyFlareObject"
+
+_CS_TOKEN = re.compile(
+    r"(?P<open>\{)|(?P<close>\})"
+    r"|\bnamespace\s+(?P<ns>[\w.]+)\s*(?P<ns_end>[;{])"
+    r"|(?P<mods>(?:\b(?:public|internal|private|protected|abstract|sealed|static|partial|unsafe|new)\s+)*)"
+    r"\bclass\s+(?P<name>\w+)\s*(?P<generic><)?(?P<tail>[^{;]*)")
+
+
+def _strip_cs(text):
+    """Blanks comments, strings and char literals so braces and keywords in them are not scanned"""
+    out = []
+    i, n = 0, len(text)
+    while i < n:
+        c = text[i]
+        if text.startswith("//", i):
+            j = text.find("\n", i)
+            i = n if j < 0 else j
+        elif text.startswith("/*", i):
+            j = text.find("*/", i + 2)
+            j = n if j < 0 else j + 2
+            out.append(re.sub(r"[^\n]", " ", text[i:j]))
+            i = j
+        elif c == '"' or (c in "@$" and text.startswith('"', i + 1)) or text.startswith(('$@"', '@$"'), i):
+            verbatim = "@" in text[i:i + 2]
+            j = text.index('"', i) + 1
+            while j < n:
+                if verbatim and text.startswith('""', j):
+                    j += 2
+                elif not verbatim and text[j] == "\\":
+                    j += 2
+                elif text[j] == '"':
+                    j += 1
+                    break
+                else:
+                    j += 1
+            out.append(" " * (j - i))
+            i = j
+        elif c == "'":
+            j = i + 1
+            while j < n and text[j] != "'":
+                j += 2 if text[j] == "\\" else 1
+            out.append(" " * (j + 1 - i))
+            i = j + 1
+        else:
+            out.append(c)
+            i += 1
+    return "".join(out)
+
+
+def _class_body_end(text, open_index):
+    depth = 0
+    for i in range(open_index, len(text)):
+        if text[i] == "{":
+            depth += 1
+        elif text[i] == "}":
+            depth -= 1
+            if depth == 0:
+                return i
+    return len(text)
+
+
+def _default_constructible(name, body):
+    """True if the class declares no instance constructor or a public/internal parameterless one"""
+    found = False
+    pattern = r"(?<![\w.])((?:(?:public|internal|private|protected|static|unsafe)\s+)*)" + name + r"\s*\(([^)]*)\)\s*(?::\s*(?:base|this)\s*\([^)]*\)\s*)?\{"
+    for m in re.finditer(pattern, body):
+        before = body[:m.start()].rstrip()
+        if before.endswith("new"):
+            continue
+        mods = m.group(1).split()
+        if "static" in mods:
+            continue
+        found = True
+        if not m.group(2).strip() and ("public" in mods or "internal" in mods):
+            return True
+    return not found
+
+
+def scan_classes(path):
+    with open(path, encoding="utf-8-sig") as f:
+        text = _strip_cs(f.read())
+
+    classes = []
+    scopes = []         # one entry per open brace: namespace name or None
+    file_ns = []
+    for m in _CS_TOKEN.finditer(text):
+        if m.group("open"):
+            scopes.append(None)
+        elif m.group("close"):
+            if scopes:
+                scopes.pop()
+        elif m.group("ns"):
+            if m.group("ns_end") == "{":
+                scopes.append(m.group("ns"))
+            else:
+                file_ns = [m.group("ns")]
+        elif m.group("name"):
+            if any(scope is None for scope in scopes) or m.group("generic"):
+                continue
+            tail = m.group("tail")
+            bases = tail.split("where")[0].split(":", 1)[1] if ":" in tail else ""
+            first = re.sub(r"<.*", "", bases.split(",")[0]).strip()
+            mods = m.group("mods").split()
+            brace = m.end()
+            while brace < len(text) and text[brace] != "{":
+                brace += 1
+            body = text[brace + 1:_class_body_end(text, brace)]
+            classes.append({
+                "name": m.group("name"),
+                "namespace": ".".join(file_ns + [s for s in scopes if s]),
+                "base": first.split(".")[-1] if first else None,
+                "abstract": "abstract" in mods,
+                "static": "static" in mods,
+                "constructible": _default_constructible(m.group("name"), body),
+                "file": path,
+            })
+    if scopes:
+        print(f"warning: unbalanced braces in {path}")
+    return classes
+
+
+def generate_registry(out_path, source_dirs):
+    by_name = {}
+    for source_dir in source_dirs:
+        for root, dirs, files in os.walk(source_dir):
+            dirs[:] = sorted(d for d in dirs if d not in ("bin", "obj"))
+            for name in sorted(files):
+                if not name.endswith(".cs") or name.endswith(".g.cs"):
+                    continue
+                for cls in scan_classes(os.path.join(root, name)):
+                    # partial classes show up once per file; the first declaration with a base wins
+                    key = (cls["namespace"], cls["name"])
+                    known = by_name.setdefault(cls["name"], {})
+                    if key not in known or (known[key]["base"] is None and cls["base"]):
+                        known[key] = cls
+
+    for name, decls in sorted(by_name.items()):
+        if len(decls) > 1:
+            where = ", ".join(f"{ns}.{n}" if ns else n for ns, n in sorted(decls))
+            print(f"warning: class name {name} is ambiguous ({where}); the registry keys by name")
+
+    def derives(cls, seen=()):
+        if cls["name"] == REGISTRY_ROOT:
+            return True
+        base = cls["base"]
+        if not base or base in seen or base not in by_name:
+            return False
+        return any(derives(b, seen + (cls["name"],)) for b in by_name[base].values())
+
+    entries = []
+    for name, decls in by_name.items():
+        for cls in decls.values():
+            if cls["static"] or not derives(cls):
+                continue
+            full = f"global::{cls['namespace']}.{name}" if cls["namespace"] else f"global::{name}"
+            factory = f"() => new {full}()" if cls["constructible"] and not cls["abstract"] else "null"
+            entries.append((name, cls["namespace"], full, factory))
+    entries.sort()
+
+    lines = [
+        "// <auto-generated>",
+        "// Written by tools/build/build.py registry; regenerate rather than edit.",
+        "// </auto-generated>",
+        "",
+        "namespace PyFlare.Engine.Core",
+        "{",
+        "    public static partial class ClassRegistry",
+        "    {",
+        "        static partial void RegisterGenerated()",
+        "        {",
+    ]
+    lines += [f"            Add(typeof({full}), {factory});" for _, _, full, factory in entries]
+    lines += ["        }", "    }", "}", ""]
+
+    os.makedirs(os.path.dirname(os.path.abspath(out_path)), exist_ok=True)
+    with open(out_path, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+    print(f"Registered {len(entries)} classes in {out_path}")
+    return len(entries)
+
+
+# ============================================================================
+# BENCHMARKS
+# The native library and projects/benchmark are built into build/bench; the
+# project file is generated there, so the tree itself carries no manifests.
+# ============================================================================
+
+REPO_ROOT = os.path.abspath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+
+BENCH_PROJECT = """<Project Sdk="Microsoft.NET.Sdk">
+  <PropertyGroup>
+    <OutputType>Exe</OutputType>
+    <TargetFramework>net8.0</TargetFramework>
+    <AssemblyName>benchmark</AssemblyName>
+    <AllowUnsafeBlocks>true</AllowUnsafeBlocks>
+    <Nullable>disable</Nullable>
+    <ImplicitUsings>disable</ImplicitUsings>
+    <EnableDefaultCompileItems>false</EnableDefaultCompileItems>
+    <Optimize>true</Optimize>
+    <ServerGarbageCollection>false</ServerGarbageCollection>
+    <ConcurrentGarbageCollection>false</ConcurrentGarbageCollection>
+  </PropertyGroup>
+  <ItemGroup>
+    <Compile Include="{root}/engine/**/*.cs" />
+    <Compile Include="{root}/projects/benchmark/**/*.cs" />
+    <Compile Include="{build}/ClassRegistry.g.cs" />
+  </ItemGroup>
+</Project>
+"""
+
+
+def build_native(out_dir):
+    src = os.path.join(REPO_ROOT, "engine", "platform", "native", "native.c")
+    cc = os.environ.get("CC", "clang" if sys.platform == "win32" else "cc")
+    flags = ["-std=c11", "-O2", "-DGL_GLEXT_PROTOTYPES"]
+    if sys.platform == "win32":
+        out = os.path.join(out_dir, "native.dll")
+        cmd = [cc, "-shared", *flags, src, "-o", out, "-lopengl32", "-lgdi32", "-luser32", "-lwinmm", "-lpsapi", "-lole32"]
+    elif sys.platform == "darwin":
+        out = os.path.join(out_dir, "libnative.dylib")
+        cmd = [cc, "-dynamiclib", *flags, src, "-o", out, "-framework", "OpenGL", "-framework", "AudioToolbox"]
+    else:
+        out = os.path.join(out_dir, "libnative.so")
+        cmd = [cc, "-shared", "-fPIC", *flags, src, "-o", out, "-lGL", "-lX11", "-lm", "-lpthread", "-ldl"]
+    print(" ".join(cmd))
+    subprocess.run(cmd, check=True)
+    return out
+
+
+def git_label():
+    try:
+        return subprocess.run(["git", "-C", REPO_ROOT, "describe", "--always", "--dirty"],
+                              capture_output=True, text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+
+
+def bench(build_dir, bench_args, skip_build=False):
+    build_dir = os.path.abspath(build_dir)
+    out_dir = os.path.join(build_dir, "bin")
+    os.makedirs(out_dir, exist_ok=True)
+
+    if not skip_build:
+        project = os.path.join(build_dir, "benchmark.csproj")
+        with open(project, "w") as f:
+            f.write(BENCH_PROJECT.format(root=REPO_ROOT.replace("\\", "/"), build=build_dir.replace("\\", "/")))
+        generate_registry(os.path.join(build_dir, "ClassRegistry.g.cs"),
+                          [os.path.join(REPO_ROOT, "engine"), os.path.join(REPO_ROOT, "projects", "benchmark")])
+        build_native(out_dir)
+        subprocess.run(["dotnet", "build", project, "-c", "Release", "-nologo", "-v", "q", "-o", out_dir],
+                       check=True)
+
+    if "--label" not in bench_args:
+        bench_args = ["--label", git_label(), *bench_args]
+    # Run from the caller's directory so a relative --out lands where they expect
+    return subprocess.run(["dotnet", os.path.join(out_dir, "benchmark.dll"), *bench_args]).returncode
+
+
+def load_results(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {s["name"]: s for s in data["scenarios"] if "skipped" not in s}
+
+
+def bench_compare(base_path, new_path, threshold):
+    """Prints p50/p99 changes per scenario; returns 1 if any p50 is more than threshold% slower"""
+    base = load_results(base_path)
+    new = load_results(new_path)
+    regressed = []
+
+    print(f"{'scenario':<28}{'p50 base':>12}{'p50 new':>12}{'change':>9}{'p99 change':>12}")
+    for name, cur in new.items():
+        old = base.get(name)
+        if old is None or old["unit"] != cur["unit"]:
+            print(f"{name:<28}{'':>12}{cur['p50']:>12.3f}     (new)")
+            continue
+
+        def change(key):
+            return (cur[key] - old[key]) / old[key] * 100.0 if old[key] else 0.0
+
+        p50, p99 = change("p50"), change("p99")
+        mark = ""
+        if p50 > threshold:
+            regressed.append(name)
+            mark = "  REGRESSED"
+        print(f"{name:<28}{old['p50']:>12.3f}{cur['p50']:>12.3f}{p50:>+8.1f}%{p99:>+11.1f}%{mark}")
+
+    for name in base:
+        if name not in new:
+            print(f"{name:<28}  missing from {new_path}")
+
+    if regressed:
+        print(f"{len(regressed)} scenario(s) regressed by more than {threshold:g}% at p50")
+        return 1
+    return 0
+
+
+# ============================================================================
+# COMMAND LINE
+# ============================================================================
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="PyFlare build tools")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("pack", help="pack an asset directory into a .pfpk archive")
+    p.add_argument("asset_dir")
+    p.add_argument("output")
+    p.add_argument("-v", "--verbose", action="store_true")
+    p.add_argument("--no-compress", action="store_true", help="store every entry uncompressed")
+
+    p = commands.add_parser("list", help="print the index of a .pfpk archive")
+    p.add_argument("archive")
+
+    p = commands.add_parser("texture", help="convert a PNG into a .pftx texture with mips")
+    p.add_argument("image")
+    p.add_argument("output")
+    p.add_argument("-f", "--format", choices=sorted(TEXTURE_FORMATS), default="dxt5")
+    p.add_argument("--no-mips", action="store_true")
+
+    p = commands.add_parser("bench", help="build and run the headless benchmark suite")
+    p.add_argument("--build-dir", default=os.path.join(REPO_ROOT, "build", "bench"))
+    p.add_argument("--no-build", action="store_true", help="run the previous build")
+    p.add_argument("bench_args", nargs=argparse.REMAINDER,
+                   help="passed through after --, e.g. -- --quick --out results.json")
+
+    p = commands.add_parser("registry", help="generate ClassRegistry.g.cs from C# sources")
+    p.add_argument("output")
+    p.add_argument("sources", nargs="*", help="directories to scan (default: engine and projects)")
+
+    p = commands.add_parser("bench-compare", help="compare two benchmark JSON files")
+    p.add_argument("base")
+    p.add_argument("new")
+    p.add_argument("-t", "--threshold", type=float, default=5.0, help="allowed p50 slowdown in percent")
+
+    args = parser.parse_args(argv)
+    if args.command == "pack":
+        pack(args.asset_dir, args.output, args.verbose, not args.no_compress)
+    elif args.command == "list":
+        list_archive(args.archive)
+    elif args.command == "texture":
+        convert_texture(args.image, args.output, args.format, not args.no_mips)
+    elif args.command == "bench":
+        bench_args = args.bench_args[1:] if args.bench_args[:1] == ["--"] else args.bench_args
+        sys.exit(bench(args.build_dir, bench_args, args.no_build))
+    elif args.command == "registry":
+        generate_registry(args.output, args.sources or [os.path.join(REPO_ROOT, "engine"),
+                                                        os.path.join(REPO_ROOT, "projects")])
+    elif args.command == "bench-compare":
+        sys.exit(bench_compare(args.base, args.new, args.threshold))
+
+
+if __name__ == "__main__":
+    main()